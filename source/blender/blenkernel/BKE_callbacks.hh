@@ -118,9 +118,16 @@ struct bCallbackFuncStore {
   void (*func)(Main *, PointerRNA **, int num_pointers, void *arg);
   void *arg;
   short alloc;
+  /** Optional, returns false when calling #func would currently do nothing. */
+  bool (*is_used)(void *arg);
 };
 
 void BKE_callback_exec(Main *bmain, PointerRNA **pointers, int num_pointers, eCbEvent evt);
+/**
+ * Check whether executing callbacks for the event could have any effect, for example to skip
+ * work that is only needed for the callbacks.
+ */
+bool BKE_callback_is_used(eCbEvent evt);
 void BKE_callback_exec_null(Main *bmain, eCbEvent evt);
 void BKE_callback_exec_id(Main *bmain, ID *id, eCbEvent evt);
 void BKE_callback_exec_id_depsgraph(Main *bmain, ID *id, Depsgraph *depsgraph, eCbEvent evt);
@@ -13,9 +13,13 @@
  */
 
 #include <array>
+#include <memory>
+#include <mutex>
 
 #include "BLI_array.hh"
 #include "BLI_math_vector_types.hh"
+#include "BLI_span.hh"
+#include "BLI_vector.hh"
 
 #include "DNA_customdata_types.h"
 
@@ -23,6 +27,7 @@
 
 struct BMLoop;
 struct BMPartialUpdate;
+struct BMVert;
 struct BMesh;
 struct BMeshCalcTessellation_Params;
 struct Depsgraph;
@@ -30,6 +35,36 @@ struct Mesh;
 struct Object;
 struct Scene;
 
+/**
+ * Vertices of the edit-mesh that were moved since the evaluated mesh was built, by an operation
+ * that changed nothing but their positions (transform for example). This allows keeping the draw
+ * cache of the previous evaluated mesh, so that only the parts of its GPU buffers that depend on
+ * the moved vertices are updated instead of extracting everything again.
+ *
+ * Cleared whenever the evaluated mesh is built, and by #EDBM_update since any other change to
+ * the edit-mesh can't be handled this way.
+ */
+struct BMEditMeshDeformUpdate {
+  /** Evaluated meshes of multiple objects may use the same edit-mesh. */
+  std::mutex mutex;
+  /** Indices of the moved vertices, may contain duplicates. */
+  blender::Vector<int> verts;
+  /** The triangulation of faces using the moved vertices changed. */
+  bool looptris_changed = false;
+  /** Element counts when the vertices were tagged, to detect untagged topology changes. */
+  int totvert = 0;
+  int totedge = 0;
+  int totloop = 0;
+  int totface = 0;
+  /**
+   * #MeshRuntime::batch_cache of the freed evaluated mesh, until it is used by the new one.
+   * Freed along with this struct otherwise.
+   */
+  void *batch_cache = nullptr;
+
+  ~BMEditMeshDeformUpdate();
+};
+
 /**
  * This structure is used for mesh edit-mode.
  *
@@ -64,6 +99,9 @@ struct BMEditMesh {
    * Set #Main.is_memfile_undo_flush_needed when enabling.
    */
   char needs_flush_to_id;
+
+  /** Only set while vertices are moved, see #BMEditMeshDeformUpdate. */
+  std::shared_ptr<BMEditMeshDeformUpdate> deform_update;
 };
 
 /* editmesh.cc */
@@ -100,6 +138,22 @@ BMEditMesh *BKE_editmesh_from_object(Object *ob);
  */
 void BKE_editmesh_free_data(BMEditMesh *em);
 
+/**
+ * Tag vertices that were moved without any other change to the edit-mesh, so that the draw cache
+ * only updates the data that depends on them, see #BMEditMeshDeformUpdate.
+ *
+ * \param looptris_changed: The triangulation of faces using the vertices was recalculated and
+ * is different now.
+ */
+void BKE_editmesh_deform_update_tag(BMEditMesh *em,
+                                    blender::Span<BMVert *> verts,
+                                    bool looptris_changed);
+/**
+ * Discard vertices tagged by #BKE_editmesh_deform_update_tag,
+ * needed when anything but vertex positions changed.
+ */
+void BKE_editmesh_deform_update_clear(BMEditMesh *em);
+
 blender::Array<blender::float3> BKE_editmesh_vert_coords_alloc(Depsgraph *depsgraph,
                                                                BMEditMesh *em,
                                                                Scene *scene,
@@ -501,9 +501,17 @@ void BKE_mesh_eval_geometry(Depsgraph *depsgraph, Mesh *mesh);
 
 /* Draw Cache */
 void BKE_mesh_batch_cache_dirty_tag(Mesh *mesh, eMeshBatchDirtyMode mode);
+/**
+ * Tag the parts of the draw cache that depend on the positions of the given edit-mesh vertices,
+ * when nothing else changed since it was created. See #BMEditMeshDeformUpdate.
+ */
+void BKE_mesh_batch_cache_deform_tag(Mesh *mesh, blender::Span<int> verts, bool looptris_changed);
 void BKE_mesh_batch_cache_free(void *batch_cache);
 
 extern void (*BKE_mesh_batch_cache_dirty_tag_cb)(Mesh *mesh, eMeshBatchDirtyMode mode);
+extern void (*BKE_mesh_batch_cache_deform_tag_cb)(Mesh *mesh,
+                                                  blender::Span<int> verts,
+                                                  bool looptris_changed);
 extern void (*BKE_mesh_batch_cache_free_cb)(void *batch_cache);
 
 /* `mesh_debug.cc` */
@@ -43,6 +43,17 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh);
  */
 void BKE_mesh_runtime_clear_cache(Mesh *mesh);
 
+/**
+ * Keep the draw cache of an evaluated edit-mode mesh that is about to be freed, when only vertex
+ * positions of the edit-mesh changed since it was built. See #BMEditMeshDeformUpdate.
+ */
+void BKE_mesh_runtime_batch_cache_stash_for_deform(Mesh *mesh);
+/**
+ * Give the draw cache kept by #BKE_mesh_runtime_batch_cache_stash_for_deform to the new evaluated
+ * edit-mode mesh if possible, and clear the vertices tagged as moved.
+ */
+void BKE_mesh_runtime_batch_cache_restore_for_deform(Mesh *mesh);
+
 namespace blender::bke {
 
 void mesh_get_mapped_verts_coords(Mesh *mesh_eval, MutableSpan<float3> r_cos);
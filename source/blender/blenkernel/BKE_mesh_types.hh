@@ -33,6 +33,9 @@ struct EditMeshData;
 namespace blender::bke::bake {
 struct BakeMaterialsList;
 }
+namespace blender::draw {
+struct MeshTopologyCache;
+}
 
 /** #MeshRuntime.wrapper_type */
 enum eMeshWrapperType {
@@ -152,6 +155,12 @@ struct MeshRuntime {
    * the same mesh is used in many objects or instances. See `draw_cache_impl_mesh.cc`.
    */
   void *batch_cache = nullptr;
+  /**
+   * Parts of the #batch_cache that only depend on the topology, like the triangle index buffer
+   * sorted by material. They are shared between meshes with the same topology, so that meshes
+   * which are only deformed (e.g. by an armature during playback) don't have to rebuild them.
+   */
+  SharedCache<std::shared_ptr<draw::MeshTopologyCache>> draw_topology_cache;
 
   /** Cache for derived triangulation of the mesh, accessed with #Mesh::corner_tris(). */
   TrianglesCache corner_tris_cache;
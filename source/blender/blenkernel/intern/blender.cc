@@ -39,6 +39,7 @@
 #include "BKE_writeffmpeg.hh"
 
 #include "DEG_depsgraph.hh"
+#include "DEG_depsgraph_debug.hh"
 
 #include "RE_texture.h"
 
@@ -68,6 +69,7 @@ void BKE_blender_free()
 
   IMB_exit();
   BKE_cachefiles_exit();
+  DEG_debug_trace_end();
   DEG_free_node_types();
 
   BKE_brush_system_exit();
@@ -44,6 +44,10 @@
 
 #include "DEG_depsgraph.hh"
 
+#include "CLG_log.h"
+
+static CLG_LogRef LOG = {"bke.undosys"};
+
 /* -------------------------------------------------------------------- */
 /** \name Global Undo
  * \{ */
@@ -133,6 +137,11 @@ MemFileUndoData *BKE_memfile_undo_encode(Main *bmain, MemFileUndoData *mfu_prev)
     }
     /* success = */ /* UNUSED */ BLO_write_file_mem(bmain, prevfile, &mfu->memfile, fileflags);
     mfu->undo_size = mfu->memfile.size;
+    CLOG_INFO(&LOG,
+              1,
+              "memfile undo step: %zu bytes stored, %zu bytes shared with other chunks",
+              mfu->memfile.size,
+              mfu->memfile.size_deduplicated);
   }
 
   bmain->is_memfile_undo_written = true;
@@ -1496,6 +1496,8 @@ void BKE_brush_calc_curve_factors(const eBrushCurvePreset preset,
 {
   BLI_assert(factors.size() == distances.size());
 
+  /* Apart from the custom curve, the factors are computed without branches so that the loops can
+   * be vectorized. The factor is clamped to avoid invalid values outside of the radius. */
   const float radius_rcp = blender::math::rcp(brush_radius);
   switch (preset) {
     case BRUSH_CURVE_CUSTOM: {
@@ -1512,60 +1514,44 @@ void BKE_brush_calc_curve_factors(const eBrushCurvePreset preset,
     case BRUSH_CURVE_SHARP: {
       for (const int i : distances.index_range()) {
         const float distance = distances[i];
-        if (distance >= brush_radius) {
-          factors[i] = 0.0f;
-          continue;
-        }
-        const float factor = 1.0f - distance * radius_rcp;
-        factors[i] *= factor * factor;
+        const float factor = std::max(1.0f - distance * radius_rcp, 0.0f);
+        const float strength = factor * factor;
+        factors[i] = distance >= brush_radius ? 0.0f : factors[i] * strength;
       }
       break;
     }
     case BRUSH_CURVE_SMOOTH: {
       for (const int i : distances.index_range()) {
         const float distance = distances[i];
-        if (distance >= brush_radius) {
-          factors[i] = 0.0f;
-          continue;
-        }
-        const float factor = 1.0f - distance * radius_rcp;
-        factors[i] *= 3.0f * factor * factor - 2.0f * factor * factor * factor;
+        const float factor = std::max(1.0f - distance * radius_rcp, 0.0f);
+        const float strength = 3.0f * factor * factor - 2.0f * factor * factor * factor;
+        factors[i] = distance >= brush_radius ? 0.0f : factors[i] * strength;
       }
       break;
     }
     case BRUSH_CURVE_SMOOTHER: {
       for (const int i : distances.index_range()) {
         const float distance = distances[i];
-        if (distance >= brush_radius) {
-          factors[i] = 0.0f;
-          continue;
-        }
-        const float factor = 1.0f - distance * radius_rcp;
-        factors[i] *= pow3f(factor) * (factor * (factor * 6.0f - 15.0f) + 10.0f);
+        const float factor = std::max(1.0f - distance * radius_rcp, 0.0f);
+        const float strength = pow3f(factor) * (factor * (factor * 6.0f - 15.0f) + 10.0f);
+        factors[i] = distance >= brush_radius ? 0.0f : factors[i] * strength;
       }
       break;
     }
     case BRUSH_CURVE_ROOT: {
       for (const int i : distances.index_range()) {
         const float distance = distances[i];
-        if (distance >= brush_radius) {
-          factors[i] = 0.0f;
-          continue;
-        }
-        const float factor = 1.0f - distance * radius_rcp;
-        factors[i] *= sqrtf(factor);
+        const float factor = std::max(1.0f - distance * radius_rcp, 0.0f);
+        const float strength = sqrtf(factor);
+        factors[i] = distance >= brush_radius ? 0.0f : factors[i] * strength;
       }
       break;
     }
     case BRUSH_CURVE_LIN: {
       for (const int i : distances.index_range()) {
         const float distance = distances[i];
-        if (distance >= brush_radius) {
-          factors[i] = 0.0f;
-          continue;
-        }
-        const float factor = 1.0f - distance * radius_rcp;
-        factors[i] *= factor;
+        const float factor = std::max(1.0f - distance * radius_rcp, 0.0f);
+        factors[i] = distance >= brush_radius ? 0.0f : factors[i] * factor;
       }
       break;
     }
@@ -1575,36 +1561,27 @@ void BKE_brush_calc_curve_factors(const eBrushCurvePreset preset,
     case BRUSH_CURVE_SPHERE: {
       for (const int i : distances.index_range()) {
         const float distance = distances[i];
-        if (distance >= brush_radius) {
-          factors[i] = 0.0f;
-          continue;
-        }
-        const float factor = 1.0f - distance * radius_rcp;
-        factors[i] *= sqrtf(2 * factor - factor * factor);
+        const float factor = std::max(1.0f - distance * radius_rcp, 0.0f);
+        const float strength = sqrtf(2 * factor - factor * factor);
+        factors[i] = distance >= brush_radius ? 0.0f : factors[i] * strength;
       }
       break;
     }
     case BRUSH_CURVE_POW4: {
       for (const int i : distances.index_range()) {
         const float distance = distances[i];
-        if (distance >= brush_radius) {
-          factors[i] = 0.0f;
-          continue;
-        }
-        const float factor = 1.0f - distance * radius_rcp;
-        factors[i] *= factor * factor * factor * factor;
+        const float factor = std::max(1.0f - distance * radius_rcp, 0.0f);
+        const float strength = factor * factor * factor * factor;
+        factors[i] = distance >= brush_radius ? 0.0f : factors[i] * strength;
       }
       break;
     }
     case BRUSH_CURVE_INVSQUARE: {
       for (const int i : distances.index_range()) {
         const float distance = distances[i];
-        if (distance >= brush_radius) {
-          factors[i] = 0.0f;
-          continue;
-        }
-        const float factor = 1.0f - distance * radius_rcp;
-        factors[i] *= factor * (2.0f - factor);
+        const float factor = std::max(1.0f - distance * radius_rcp, 0.0f);
+        const float strength = factor * (2.0f - factor);
+        factors[i] = distance >= brush_radius ? 0.0f : factors[i] * strength;
       }
       break;
     }
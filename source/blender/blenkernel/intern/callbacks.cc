@@ -36,6 +36,18 @@ void BKE_callback_exec(Main *bmain, PointerRNA **pointers, const int num_pointer
   }
 }
 
+bool BKE_callback_is_used(eCbEvent evt)
+{
+  ASSERT_CALLBACKS_INITIALIZED();
+  const ListBase *lb = &callback_slots[evt];
+  LISTBASE_FOREACH (const bCallbackFuncStore *, funcstore, lb) {
+    if (funcstore->is_used == nullptr || funcstore->is_used(funcstore->arg)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void BKE_callback_exec_null(Main *bmain, eCbEvent evt)
 {
   BKE_callback_exec(bmain, nullptr, 0, evt);
@@ -52,6 +52,7 @@ BMEditMesh *BKE_editmesh_copy(BMEditMesh *em)
    * in that case it makes more sense to do the
    * tessellation only when/if that copy ends up getting used. */
   em_copy->looptris = {};
+  em_copy->deform_update.reset();
 
   /* Copy various settings. */
   em_copy->selectmode = em->selectmode;
@@ -120,12 +121,50 @@ void BKE_editmesh_looptris_and_normals_calc_with_partial(BMEditMesh *em, BMParti
 void BKE_editmesh_free_data(BMEditMesh *em)
 {
   em->looptris = {};
+  em->deform_update.reset();
 
   if (em->bm) {
     BM_mesh_free(em->bm);
   }
 }
 
+BMEditMeshDeformUpdate::~BMEditMeshDeformUpdate()
+{
+  if (batch_cache) {
+    BKE_mesh_batch_cache_free(batch_cache);
+  }
+}
+
+void BKE_editmesh_deform_update_tag(BMEditMesh *em,
+                                    const Span<BMVert *> verts,
+                                    const bool looptris_changed)
+{
+  BMesh *bm = em->bm;
+  if (!em->deform_update) {
+    em->deform_update = std::make_shared<BMEditMeshDeformUpdate>();
+  }
+  BMEditMeshDeformUpdate &update = *em->deform_update;
+  std::lock_guard lock(update.mutex);
+  if (update.verts.is_empty()) {
+    update.totvert = bm->totvert;
+    update.totedge = bm->totedge;
+    update.totloop = bm->totloop;
+    update.totface = bm->totface;
+  }
+
+  BM_mesh_elem_index_ensure(bm, BM_VERT);
+  update.verts.reserve(update.verts.size() + verts.size());
+  for (const BMVert *v : verts) {
+    update.verts.append(BM_elem_index_get(v));
+  }
+  update.looptris_changed |= looptris_changed;
+}
+
+void BKE_editmesh_deform_update_clear(BMEditMesh *em)
+{
+  em->deform_update.reset();
+}
+
 struct CageUserData {
   int totvert;
   blender::MutableSpan<float3> positions_cage;
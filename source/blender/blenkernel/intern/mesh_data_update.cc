@@ -1069,6 +1069,9 @@ static void editbmesh_build_data(Depsgraph &depsgraph,
     }
   }
 
+  /* Keep the draw cache of the previous evaluated mesh when only vertices were moved. */
+  BKE_mesh_runtime_batch_cache_restore_for_deform(me_final);
+
   const bool is_mesh_eval_owned = (me_final != mesh->runtime->mesh_eval);
   BKE_object_eval_assign_data(&obedit, &me_final->id, is_mesh_eval_owned);
 
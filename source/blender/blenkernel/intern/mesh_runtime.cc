@@ -15,6 +15,7 @@
 #include "BKE_bake_data_block_id.hh"
 #include "BKE_bvhutils.hh"
 #include "BKE_customdata.hh"
+#include "BKE_editmesh.hh"
 #include "BKE_editmesh_cache.hh"
 #include "BKE_lib_id.hh"
 #include "BKE_mesh.hh"
@@ -328,6 +329,7 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
   mesh->runtime->corner_tris_cache.data.tag_dirty();
   mesh->runtime->corner_tri_faces_cache.tag_dirty();
   mesh->runtime->shrinkwrap_boundary_cache.tag_dirty();
+  mesh->runtime->draw_topology_cache.tag_dirty();
   mesh->runtime->subsurf_face_dot_tags.clear_and_shrink();
   mesh->runtime->subsurf_optimal_display_edges.clear_and_shrink();
   mesh->flag &= ~ME_NO_OVERLAPPING_TOPOLOGY;
@@ -360,6 +362,7 @@ void Mesh::tag_edges_split()
   this->runtime->subsurf_face_dot_tags.clear_and_shrink();
   this->runtime->subsurf_optimal_display_edges.clear_and_shrink();
   this->runtime->shrinkwrap_boundary_cache.tag_dirty();
+  this->runtime->draw_topology_cache.tag_dirty();
 }
 
 void Mesh::tag_sharpness_changed()
@@ -419,6 +422,9 @@ void Mesh::tag_topology_changed()
 /* Draw Engine */
 
 void (*BKE_mesh_batch_cache_dirty_tag_cb)(Mesh *mesh, eMeshBatchDirtyMode mode) = nullptr;
+void (*BKE_mesh_batch_cache_deform_tag_cb)(Mesh *mesh,
+                                           Span<int> verts,
+                                           bool looptris_changed) = nullptr;
 void (*BKE_mesh_batch_cache_free_cb)(void *batch_cache) = nullptr;
 
 void BKE_mesh_batch_cache_dirty_tag(Mesh *mesh, eMeshBatchDirtyMode mode)
@@ -427,6 +433,14 @@ void BKE_mesh_batch_cache_dirty_tag(Mesh *mesh, eMeshBatchDirtyMode mode)
     BKE_mesh_batch_cache_dirty_tag_cb(mesh, mode);
   }
 }
+void BKE_mesh_batch_cache_deform_tag(Mesh *mesh,
+                                     const Span<int> verts,
+                                     const bool looptris_changed)
+{
+  if (mesh->runtime->batch_cache) {
+    BKE_mesh_batch_cache_deform_tag_cb(mesh, verts, looptris_changed);
+  }
+}
 void BKE_mesh_batch_cache_free(void *batch_cache)
 {
   BKE_mesh_batch_cache_free_cb(batch_cache);
@@ -434,6 +448,73 @@ void BKE_mesh_batch_cache_free(void *batch_cache)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Mesh Batch Cache Reuse for Edit-Mode Deformation
+ * \{ */
+
+/**
+ * The draw cache can only be kept when the evaluated mesh draws the edit-mesh directly, without
+ * any modifier changing positions or anything else.
+ */
+static bool mesh_is_undeformed_edit_mesh(const Mesh &mesh)
+{
+  const blender::bke::MeshRuntime &runtime = *mesh.runtime;
+  return runtime.edit_mesh && runtime.wrapper_type == ME_WRAPPER_TYPE_BMESH &&
+         runtime.is_original_bmesh &&
+         (!runtime.edit_data || runtime.edit_data->vert_positions.is_empty());
+}
+
+static bool deform_update_topology_matches(const BMEditMeshDeformUpdate &update, const BMesh &bm)
+{
+  return update.totvert == bm.totvert && update.totedge == bm.totedge &&
+         update.totloop == bm.totloop && update.totface == bm.totface;
+}
+
+void BKE_mesh_runtime_batch_cache_stash_for_deform(Mesh *mesh)
+{
+  blender::bke::MeshRuntime &runtime = *mesh->runtime;
+  if (!runtime.batch_cache || !mesh_is_undeformed_edit_mesh(*mesh)) {
+    return;
+  }
+  BMEditMeshDeformUpdate *update = runtime.edit_mesh->deform_update.get();
+  if (!update) {
+    return;
+  }
+  std::lock_guard lock(update->mutex);
+  if (update->verts.is_empty() || update->batch_cache) {
+    return;
+  }
+  update->batch_cache = std::exchange(runtime.batch_cache, nullptr);
+}
+
+void BKE_mesh_runtime_batch_cache_restore_for_deform(Mesh *mesh)
+{
+  blender::bke::MeshRuntime &runtime = *mesh->runtime;
+  if (!runtime.edit_mesh) {
+    return;
+  }
+  BMEditMeshDeformUpdate *update = runtime.edit_mesh->deform_update.get();
+  if (!update) {
+    return;
+  }
+  std::lock_guard lock(update->mutex);
+  if (void *batch_cache = std::exchange(update->batch_cache, nullptr)) {
+    if (!runtime.batch_cache && mesh_is_undeformed_edit_mesh(*mesh) &&
+        deform_update_topology_matches(*update, *runtime.edit_mesh->bm))
+    {
+      runtime.batch_cache = batch_cache;
+      BKE_mesh_batch_cache_deform_tag(mesh, update->verts, update->looptris_changed);
+    }
+    else {
+      BKE_mesh_batch_cache_free(batch_cache);
+    }
+  }
+  update->verts.clear();
+  update->looptris_changed = false;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Mesh Runtime Validation
  * \{ */
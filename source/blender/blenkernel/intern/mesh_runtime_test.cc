@@ -0,0 +1,189 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "BLI_vector.hh"
+
+#include "BKE_editmesh.hh"
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_mesh.h"
+#include "BKE_mesh_runtime.hh"
+#include "BKE_mesh_types.hh"
+#include "BKE_mesh_wrapper.hh"
+
+#include "DNA_mesh_types.h"
+
+#include "bmesh.hh"
+
+namespace blender::bke::tests {
+
+/* Batch caches passed to the draw callbacks, the caches are just unique addresses here. */
+static Vector<void *> freed_batch_caches;
+static Vector<int> deform_tagged_verts;
+static int deform_tag_count = 0;
+static bool deform_tag_looptris_changed = false;
+
+static void test_batch_cache_free(void *batch_cache)
+{
+  freed_batch_caches.append(batch_cache);
+}
+
+static void test_batch_cache_deform_tag(Mesh * /*mesh*/,
+                                        const Span<int> verts,
+                                        const bool looptris_changed)
+{
+  deform_tagged_verts.extend(verts);
+  deform_tag_looptris_changed = looptris_changed;
+  deform_tag_count++;
+}
+
+class MeshBatchCacheDeformTest : public ::testing::Test {
+ protected:
+  Mesh *mesh_orig_ = nullptr;
+  std::shared_ptr<BMEditMesh> em_;
+  Vector<BMVert *> verts_;
+  int batch_cache_a_ = 0;
+  int batch_cache_b_ = 0;
+
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+
+  void SetUp() override
+  {
+    BKE_mesh_batch_cache_free_cb = test_batch_cache_free;
+    BKE_mesh_batch_cache_deform_tag_cb = test_batch_cache_deform_tag;
+    freed_batch_caches.clear();
+    deform_tagged_verts.clear();
+    deform_tag_count = 0;
+    deform_tag_looptris_changed = false;
+
+    mesh_orig_ = static_cast<Mesh *>(BKE_id_new_nomain(ID_ME, nullptr));
+    BMeshCreateParams params{};
+    params.use_toolflags = false;
+    em_ = std::make_shared<BMEditMesh>();
+    em_->bm = BM_mesh_create(&bm_mesh_allocsize_default, &params);
+    for (const int i : IndexRange(4)) {
+      const float co[3] = {float(i), 0.0f, 0.0f};
+      verts_.append(BM_vert_create(em_->bm, co, nullptr, BM_CREATE_NOP));
+    }
+  }
+
+  void TearDown() override
+  {
+    BKE_editmesh_free_data(em_.get());
+    em_.reset();
+    BKE_id_free(nullptr, mesh_orig_);
+    BKE_mesh_batch_cache_free_cb = nullptr;
+    BKE_mesh_batch_cache_deform_tag_cb = nullptr;
+  }
+
+  /** Create an evaluated mesh that uses the edit-mesh directly, like without modifiers. */
+  Mesh *evaluated_mesh_create()
+  {
+    return BKE_mesh_wrapper_from_editmesh(em_, nullptr, mesh_orig_);
+  }
+};
+
+TEST_F(MeshBatchCacheDeformTest, StashAndRestore)
+{
+  Mesh *mesh_a = this->evaluated_mesh_create();
+  mesh_a->runtime->batch_cache = &batch_cache_a_;
+
+  BKE_editmesh_deform_update_tag(em_.get(), {verts_[0], verts_[2]}, false);
+  BKE_editmesh_deform_update_tag(em_.get(), {verts_[3]}, true);
+
+  /* Freeing the evaluated mesh keeps its batch cache. */
+  BKE_id_free(nullptr, mesh_a);
+  EXPECT_TRUE(freed_batch_caches.is_empty());
+  EXPECT_EQ(em_->deform_update->batch_cache, &batch_cache_a_);
+
+  /* The next evaluated mesh takes it over and tags the moved vertices. */
+  Mesh *mesh_b = this->evaluated_mesh_create();
+  BKE_mesh_runtime_batch_cache_restore_for_deform(mesh_b);
+  EXPECT_EQ(mesh_b->runtime->batch_cache, &batch_cache_a_);
+  EXPECT_EQ(em_->deform_update->batch_cache, nullptr);
+  EXPECT_EQ(deform_tag_count, 1);
+  EXPECT_EQ(deform_tagged_verts.as_span(), Span<int>({0, 2, 3}));
+  EXPECT_TRUE(deform_tag_looptris_changed);
+  EXPECT_TRUE(em_->deform_update->verts.is_empty());
+  EXPECT_FALSE(em_->deform_update->looptris_changed);
+
+  /* Without moved vertices since the last evaluation, the cache is freed with the mesh. */
+  BKE_id_free(nullptr, mesh_b);
+  EXPECT_EQ(freed_batch_caches.as_span(), Span<void *>({&batch_cache_a_}));
+  EXPECT_EQ(em_->deform_update->batch_cache, nullptr);
+}
+
+TEST_F(MeshBatchCacheDeformTest, NoTaggedVerts)
+{
+  Mesh *mesh_a = this->evaluated_mesh_create();
+  mesh_a->runtime->batch_cache = &batch_cache_a_;
+  BKE_id_free(nullptr, mesh_a);
+  EXPECT_EQ(freed_batch_caches.as_span(), Span<void *>({&batch_cache_a_}));
+  EXPECT_EQ(em_->deform_update, nullptr);
+
+  Mesh *mesh_b = this->evaluated_mesh_create();
+  BKE_mesh_runtime_batch_cache_restore_for_deform(mesh_b);
+  EXPECT_EQ(mesh_b->runtime->batch_cache, nullptr);
+  EXPECT_EQ(deform_tag_count, 0);
+  BKE_id_free(nullptr, mesh_b);
+}
+
+TEST_F(MeshBatchCacheDeformTest, TopologyChanged)
+{
+  Mesh *mesh_a = this->evaluated_mesh_create();
+  mesh_a->runtime->batch_cache = &batch_cache_a_;
+  BKE_editmesh_deform_update_tag(em_.get(), {verts_[1]}, false);
+  BKE_id_free(nullptr, mesh_a);
+  EXPECT_TRUE(freed_batch_caches.is_empty());
+
+  /* A vertex was added without clearing the tagged vertices, the cache can't be used anymore. */
+  const float co[3] = {0.0f, 1.0f, 0.0f};
+  BM_vert_create(em_->bm, co, nullptr, BM_CREATE_NOP);
+
+  Mesh *mesh_b = this->evaluated_mesh_create();
+  BKE_mesh_runtime_batch_cache_restore_for_deform(mesh_b);
+  EXPECT_EQ(mesh_b->runtime->batch_cache, nullptr);
+  EXPECT_EQ(freed_batch_caches.as_span(), Span<void *>({&batch_cache_a_}));
+  EXPECT_EQ(deform_tag_count, 0);
+  EXPECT_TRUE(em_->deform_update->verts.is_empty());
+  BKE_id_free(nullptr, mesh_b);
+}
+
+TEST_F(MeshBatchCacheDeformTest, ExistingCacheIsKept)
+{
+  Mesh *mesh_a = this->evaluated_mesh_create();
+  mesh_a->runtime->batch_cache = &batch_cache_a_;
+  BKE_editmesh_deform_update_tag(em_.get(), {verts_[1]}, false);
+  BKE_id_free(nullptr, mesh_a);
+
+  /* The new mesh has a batch cache already, the stashed one is freed instead. */
+  Mesh *mesh_b = this->evaluated_mesh_create();
+  mesh_b->runtime->batch_cache = &batch_cache_b_;
+  BKE_mesh_runtime_batch_cache_restore_for_deform(mesh_b);
+  EXPECT_EQ(mesh_b->runtime->batch_cache, &batch_cache_b_);
+  EXPECT_EQ(freed_batch_caches.as_span(), Span<void *>({&batch_cache_a_}));
+  EXPECT_EQ(deform_tag_count, 0);
+  BKE_id_free(nullptr, mesh_b);
+}
+
+TEST_F(MeshBatchCacheDeformTest, ClearFreesStashedCache)
+{
+  Mesh *mesh_a = this->evaluated_mesh_create();
+  mesh_a->runtime->batch_cache = &batch_cache_a_;
+  BKE_editmesh_deform_update_tag(em_.get(), {verts_[1]}, false);
+  BKE_id_free(nullptr, mesh_a);
+  EXPECT_TRUE(freed_batch_caches.is_empty());
+
+  /* Any other change to the edit-mesh discards the stashed cache. */
+  BKE_editmesh_deform_update_clear(em_.get());
+  EXPECT_EQ(freed_batch_caches.as_span(), Span<void *>({&batch_cache_a_}));
+  EXPECT_EQ(em_->deform_update, nullptr);
+}
+
+}  // namespace blender::bke::tests
@@ -69,6 +69,7 @@
 /* end */
 
 #include "DEG_depsgraph.hh"
+#include "DEG_depsgraph_debug.hh"
 #include "DEG_depsgraph_query.hh"
 
 #include "MOD_modifiertypes.hh"
@@ -1465,6 +1466,7 @@ ScopedModifierTimer::~ScopedModifierTimer()
   const double end_time = get_current_time_in_seconds();
   const double duration = end_time - start_time_;
   md_.execution_time = duration;
+  DEG_debug_trace_add_scope(md_.name, "MODIFIER", duration);
 }
 
 }  // namespace blender::bke
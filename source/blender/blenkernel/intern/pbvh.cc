@@ -8,6 +8,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include <atomic>
 #include <climits>
 
 #include "BLI_array_utils.hh"
@@ -101,26 +102,70 @@ static int partition_prim_indices(MutableSpan<int> prim_indices,
                                   const Span<Bounds<float3>> prim_bounds,
                                   const Span<int> prim_to_face_map)
 {
-  for (int i = lo; i < hi; i++) {
-    prim_scratch[i - lo] = prim_indices[i];
-  }
-
-  int lo2 = lo, hi2 = hi - 1;
-  int i1 = lo, i2 = 0;
-
-  while (i1 < hi) {
-    const int face_i = prim_to_face_map[prim_scratch[i2]];
-    const Bounds<float3> &bounds = prim_bounds[prim_scratch[i2]];
-    const bool side = math::midpoint(bounds.min[axis], bounds.max[axis]) >= mid;
-
-    while (i1 < hi && prim_to_face_map[prim_scratch[i2]] == face_i) {
-      prim_indices[side ? hi2-- : lo2++] = prim_scratch[i2];
-      i1++;
-      i2++;
+  const IndexRange range = IndexRange::from_begin_end(lo, hi);
+  MutableSpan<int> indices = prim_indices.slice(range);
+  MutableSpan<int> scratch = prim_scratch.slice(range);
+  array_utils::copy(indices.as_span(), scratch);
+
+  /* All primitives of a face are put on the same side, which is decided by the first one. The
+   * side is computed once per face, only the first face of a chunk has to look back for the
+   * first primitive of its face. */
+  const auto foreach_prim_side = [&](const IndexRange chunk, auto &&fn) {
+    int face_first = chunk.start();
+    while (face_first > 0 &&
+           prim_to_face_map[scratch[face_first - 1]] == prim_to_face_map[scratch[chunk.start()]])
+    {
+      face_first--;
+    }
+    int face = -1;
+    bool right = false;
+    for (const int i : chunk) {
+      const int face_i = prim_to_face_map[scratch[i]];
+      if (face_i != face) {
+        face = face_i;
+        const Bounds<float3> &bounds = prim_bounds[scratch[i == chunk.start() ? face_first : i]];
+        right = math::midpoint(bounds.min[axis], bounds.max[axis]) >= mid;
+      }
+      fn(i, right);
+    }
+  };
+
+  /* Primitives on the left side keep their order, the ones on the right side are reversed. Chunks
+   * of primitives are processed in parallel, based on the number of primitives on the left side
+   * in the previous chunks. */
+  constexpr int chunk_size = 4096;
+  const int chunks_num = divide_ceil_ul(indices.size(), chunk_size);
+  const auto chunk_range = [&](const int chunk) {
+    return IndexRange(chunk * chunk_size, chunk_size).intersect(indices.index_range());
+  };
+  Array<int> left_offsets_data(chunks_num + 1);
+  threading::parallel_for(IndexRange(chunks_num), 1, [&](const IndexRange chunks) {
+    for (const int chunk : chunks) {
+      int left_num = 0;
+      foreach_prim_side(chunk_range(chunk), [&](const int /*i*/, const bool right) {
+        left_num += right ? 0 : 1;
+      });
+      left_offsets_data[chunk] = left_num;
     }
-  }
+  });
+  const OffsetIndices left_offsets = offset_indices::accumulate_counts_to_offsets(
+      left_offsets_data);
+  threading::parallel_for(IndexRange(chunks_num), 1, [&](const IndexRange chunks) {
+    for (const int chunk : chunks) {
+      int left = left_offsets[chunk].start();
+      int right = chunk_range(chunk).start() - left;
+      foreach_prim_side(chunk_range(chunk), [&](const int i, const bool is_right) {
+        if (is_right) {
+          indices[indices.size() - 1 - right++] = scratch[i];
+        }
+        else {
+          indices[left++] = scratch[i];
+        }
+      });
+    }
+  });
 
-  return lo2;
+  return lo + left_offsets.total_size();
 }
 
 /* Returns the index of the first element on the right of the partition */
@@ -157,15 +202,15 @@ static int partition_indices_material_faces(MutableSpan<int> indices,
 /* Add a vertex to the map, with a positive value for unique vertices and
  * a negative value for additional vertices */
 static int map_insert_vert(Map<int, int> &map,
-                           MutableSpan<bool> vert_bitmap,
+                           const Span<std::atomic<int>> vert_owners,
+                           const int leaf_index,
                            int *face_verts,
                            int *uniq_verts,
                            int vertex)
 {
   return map.lookup_or_add_cb(vertex, [&]() {
     int value;
-    if (!vert_bitmap[vertex]) {
-      vert_bitmap[vertex] = true;
+    if (vert_owners[vertex].load(std::memory_order_relaxed) == leaf_index) {
       value = *uniq_verts;
       (*uniq_verts)++;
     }
@@ -177,10 +222,14 @@ static int map_insert_vert(Map<int, int> &map,
   });
 }
 
-/* Find vertices used by the faces in this node and update the draw buffers */
+/**
+ * Find vertices used by the faces in this node and update the draw buffers. The leaf with the
+ * lowest index that uses a vertex owns it, see #calc_vert_owners.
+ */
 static void build_mesh_leaf_node(const Span<int> corner_verts,
                                  const Span<int3> corner_tris,
-                                 MutableSpan<bool> vert_bitmap,
+                                 const Span<std::atomic<int>> vert_owners,
+                                 const int leaf_index,
                                  Node &node)
 {
   node.unique_verts_num_ = 0;
@@ -196,8 +245,12 @@ static void build_mesh_leaf_node(const Span<int> corner_verts,
   for (const int i : prim_indices.index_range()) {
     const int3 &tri = corner_tris[prim_indices[i]];
     for (int j = 0; j < 3; j++) {
-      node.face_vert_indices_[i][j] = map_insert_vert(
-          map, vert_bitmap, &shared_verts, &node.unique_verts_num_, corner_verts[tri[j]]);
+      node.face_vert_indices_[i][j] = map_insert_vert(map,
+                                                      vert_owners,
+                                                      leaf_index,
+                                                      &shared_verts,
+                                                      &node.unique_verts_num_,
+                                                      corner_verts[tri[j]]);
     }
   }
 
@@ -228,7 +281,7 @@ static void build_mesh_leaf_node(const Span<int> corner_verts,
 
 /* Return zero if all primitives in the node can be drawn with the
  * same material (including flat/smooth shading), non-zero otherwise */
-static bool leaf_needs_material_split(Tree &pbvh,
+static bool leaf_needs_material_split(const Span<int> prim_indices,
                                       const Span<int> prim_to_face_map,
                                       const Span<int> material_indices,
                                       const Span<bool> sharp_faces,
@@ -239,9 +292,9 @@ static bool leaf_needs_material_split(Tree &pbvh,
     return false;
   }
 
-  const int first = prim_to_face_map[pbvh.prim_indices_[offset]];
+  const int first = prim_to_face_map[prim_indices[offset]];
   for (int i = offset + count - 1; i > offset; i--) {
-    int prim = pbvh.prim_indices_[i];
+    int prim = prim_indices[i];
     if (!face_materials_match(material_indices, sharp_faces, first, prim_to_face_map[prim])) {
       return true;
     }
@@ -250,108 +303,198 @@ static bool leaf_needs_material_split(Tree &pbvh,
   return false;
 }
 
-static void build_nodes_recursive_mesh(Tree &pbvh,
-                                       const Span<int> corner_verts,
-                                       const Span<int3> corner_tris,
-                                       const Span<int> tri_faces,
-                                       const Span<int> material_indices,
-                                       const Span<bool> sharp_faces,
-                                       const int leaf_limit,
-                                       MutableSpan<bool> vert_bitmap,
-                                       const int node_index,
-                                       const Bounds<float3> *cb,
-                                       const Span<Bounds<float3>> prim_bounds,
-                                       const int prim_offset,
-                                       const int prims_num,
-                                       MutableSpan<int> prim_scratch,
-                                       const int depth)
+/**
+ * A node of the tree while it is built. The subtrees are built in parallel, but the final order
+ * of the nodes depends on the order in which they are built, so it is only known once the whole
+ * tree is built.
+ */
+struct BuildNode {
+  /** Range of #Tree::prim_indices_ in the node. */
+  IndexRange prims;
+  /** Empty for leaf nodes. */
+  std::array<std::unique_ptr<BuildNode>, 2> children;
+};
+
+static std::unique_ptr<BuildNode> build_nodes_recursive(MutableSpan<int> prim_indices,
+                                                        MutableSpan<int> prim_scratch,
+                                                        const Span<int> prim_to_face_map,
+                                                        const Span<int> material_indices,
+                                                        const Span<bool> sharp_faces,
+                                                        const int leaf_limit,
+                                                        const Bounds<float3> *cb,
+                                                        const Span<Bounds<float3>> prim_bounds,
+                                                        const int prim_offset,
+                                                        const int prims_num,
+                                                        const int depth)
 {
   int end;
 
+  std::unique_ptr<BuildNode> node = std::make_unique<BuildNode>();
+  node->prims = IndexRange(prim_offset, prims_num);
+
   /* Decide whether this is a leaf or not */
   const bool below_leaf_limit = prims_num <= leaf_limit || depth >= STACK_FIXED_DEPTH - 1;
   if (below_leaf_limit) {
     if (!leaf_needs_material_split(
-            pbvh, tri_faces, material_indices, sharp_faces, prim_offset, prims_num))
+            prim_indices, prim_to_face_map, material_indices, sharp_faces, prim_offset, prims_num))
     {
-      Node &node = pbvh.nodes_[node_index];
-      node.flag_ |= PBVH_Leaf;
-      node.prim_indices_ = pbvh.prim_indices_.as_span().slice(prim_offset, prims_num);
-      build_mesh_leaf_node(corner_verts, corner_tris, vert_bitmap, node);
-
-      return;
+      return node;
     }
   }
 
-  /* Add two child nodes */
-  pbvh.nodes_[node_index].children_offset_ = pbvh.nodes_.size();
-  pbvh.nodes_.resize(pbvh.nodes_.size() + 2);
-
   Bounds<float3> cb_backing;
   if (!below_leaf_limit) {
     /* Find axis with widest range of primitive centroids */
     if (!cb) {
-      cb_backing = negative_bounds();
-      for (int i = prim_offset + prims_num - 1; i >= prim_offset; i--) {
-        const int prim = pbvh.prim_indices_[i];
-        const float3 center = math::midpoint(prim_bounds[prim].min, prim_bounds[prim].max);
-        math::min_max(center, cb_backing.min, cb_backing.max);
-      }
+      cb_backing = threading::parallel_reduce(
+          node->prims,
+          1024,
+          negative_bounds(),
+          [&](const IndexRange range, const Bounds<float3> &init) {
+            Bounds<float3> current = init;
+            for (const int i : range) {
+              const int prim = prim_indices[i];
+              const float3 center = math::midpoint(prim_bounds[prim].min, prim_bounds[prim].max);
+              math::min_max(center, current.min, current.max);
+            }
+            return current;
+          },
+          [](const Bounds<float3> &a, const Bounds<float3> &b) { return bounds::merge(a, b); });
       cb = &cb_backing;
     }
     const int axis = math::dominant_axis(cb->max - cb->min);
 
     /* Partition primitives along that axis */
-    end = partition_prim_indices(pbvh.prim_indices_,
+    end = partition_prim_indices(prim_indices,
                                  prim_scratch,
                                  prim_offset,
                                  prim_offset + prims_num,
                                  axis,
                                  math::midpoint(cb->min[axis], cb->max[axis]),
                                  prim_bounds,
-                                 tri_faces);
+                                 prim_to_face_map);
   }
   else {
     /* Partition primitives by material */
-    end = partition_indices_material_faces(pbvh.prim_indices_,
-                                           tri_faces,
+    end = partition_indices_material_faces(prim_indices,
+                                           prim_to_face_map,
                                            material_indices,
                                            sharp_faces,
                                            prim_offset,
                                            prim_offset + prims_num - 1);
   }
 
-  /* Build children */
-  build_nodes_recursive_mesh(pbvh,
-                             corner_verts,
-                             corner_tris,
-                             tri_faces,
-                             material_indices,
-                             sharp_faces,
-                             leaf_limit,
-                             vert_bitmap,
-                             pbvh.nodes_[node_index].children_offset_,
-                             nullptr,
-                             prim_bounds,
-                             prim_offset,
-                             end - prim_offset,
-                             prim_scratch,
-                             depth + 1);
-  build_nodes_recursive_mesh(pbvh,
-                             corner_verts,
-                             corner_tris,
-                             tri_faces,
-                             material_indices,
-                             sharp_faces,
-                             leaf_limit,
-                             vert_bitmap,
-                             pbvh.nodes_[node_index].children_offset_ + 1,
-                             nullptr,
-                             prim_bounds,
-                             end,
-                             prim_offset + prims_num - end,
-                             prim_scratch,
-                             depth + 1);
+  /* Build children. They only access their own range of the primitive arrays, so they can be
+   * built in parallel. */
+  threading::parallel_invoke(
+      prims_num > leaf_limit,
+      [&]() {
+        node->children[0] = build_nodes_recursive(prim_indices,
+                                                  prim_scratch,
+                                                  prim_to_face_map,
+                                                  material_indices,
+                                                  sharp_faces,
+                                                  leaf_limit,
+                                                  nullptr,
+                                                  prim_bounds,
+                                                  prim_offset,
+                                                  end - prim_offset,
+                                                  depth + 1);
+      },
+      [&]() {
+        node->children[1] = build_nodes_recursive(prim_indices,
+                                                  prim_scratch,
+                                                  prim_to_face_map,
+                                                  material_indices,
+                                                  sharp_faces,
+                                                  leaf_limit,
+                                                  nullptr,
+                                                  prim_bounds,
+                                                  end,
+                                                  prim_offset + prims_num - end,
+                                                  depth + 1);
+      });
+  return node;
+}
+
+/**
+ * Add the nodes of the built tree to the final tree, in the same order as if the tree was built on
+ * a single thread: the children of a node are added when it is visited in depth-first order.
+ */
+static void add_built_nodes(Tree &pbvh,
+                            const BuildNode &build_node,
+                            const int node_index,
+                            Vector<int> &r_leaf_nodes)
+{
+  if (!build_node.children[0]) {
+    Node &node = pbvh.nodes_[node_index];
+    node.flag_ |= PBVH_Leaf;
+    node.prim_indices_ = pbvh.prim_indices_.as_span().slice(build_node.prims);
+    r_leaf_nodes.append(node_index);
+    return;
+  }
+  const int children_offset = pbvh.nodes_.size();
+  pbvh.nodes_[node_index].children_offset_ = children_offset;
+  pbvh.nodes_.resize(pbvh.nodes_.size() + 2);
+  add_built_nodes(pbvh, *build_node.children[0], children_offset, r_leaf_nodes);
+  add_built_nodes(pbvh, *build_node.children[1], children_offset + 1, r_leaf_nodes);
+}
+
+static Vector<int> build_nodes(Tree &pbvh,
+                               const Span<int> prim_to_face_map,
+                               const Span<int> material_indices,
+                               const Span<bool> sharp_faces,
+                               const int leaf_limit,
+                               const Bounds<float3> &cb,
+                               const Span<Bounds<float3>> prim_bounds)
+{
+  Array<int> prim_scratch(pbvh.prim_indices_.size());
+  const std::unique_ptr<BuildNode> root = build_nodes_recursive(pbvh.prim_indices_,
+                                                                prim_scratch,
+                                                                prim_to_face_map,
+                                                                material_indices,
+                                                                sharp_faces,
+                                                                leaf_limit,
+                                                                &cb,
+                                                                prim_bounds,
+                                                                0,
+                                                                pbvh.prim_indices_.size(),
+                                                                0);
+  pbvh.nodes_.resize(1);
+  Vector<int> leaf_nodes;
+  add_built_nodes(pbvh, *root, 0, leaf_nodes);
+  return leaf_nodes;
+}
+
+/**
+ * Find the first leaf that uses each vertex, which is the leaf where the vertex is unique. This is
+ * the same leaf that would find the vertex first when building the leaves one after another.
+ */
+static void calc_vert_owners(const Tree &pbvh,
+                             const Span<int> corner_verts,
+                             const Span<int3> corner_tris,
+                             const Span<int> leaf_nodes,
+                             MutableSpan<std::atomic<int>> vert_owners)
+{
+  threading::parallel_for(vert_owners.index_range(), 4096, [&](const IndexRange range) {
+    for (const int vert : range) {
+      vert_owners[vert].store(INT_MAX, std::memory_order_relaxed);
+    }
+  });
+  threading::parallel_for(leaf_nodes.index_range(), 1, [&](const IndexRange range) {
+    for (const int leaf_index : range) {
+      for (const int tri : pbvh.nodes_[leaf_nodes[leaf_index]].prim_indices_) {
+        for (int j = 0; j < 3; j++) {
+          std::atomic<int> &owner = vert_owners[corner_verts[corner_tris[tri][j]]];
+          int prev_owner = owner.load(std::memory_order_relaxed);
+          while (leaf_index < prev_owner &&
+                 !owner.compare_exchange_weak(prev_owner, leaf_index, std::memory_order_relaxed))
+          {
+          }
+        }
+      }
+    }
+  });
 }
 
 void update_mesh_pointers(Tree &pbvh, Mesh *mesh)
@@ -379,8 +522,6 @@ std::unique_ptr<Tree> build_mesh(Mesh *mesh)
   update_mesh_pointers(*pbvh, mesh);
   const Span<int> tri_faces = mesh->corner_tri_faces();
 
-  Array<bool> vert_bitmap(mesh->verts_num, false);
-
   const int leaf_limit = LEAF_LIMIT;
 
   /* For each face, store the AABB and the AABB centroid */
@@ -413,22 +554,20 @@ std::unique_ptr<Tree> build_mesh(Mesh *mesh)
     pbvh->prim_indices_.reinitialize(corner_tris.size());
     array_utils::fill_index_range<int>(pbvh->prim_indices_);
 
-    pbvh->nodes_.resize(1);
-    build_nodes_recursive_mesh(*pbvh,
-                               corner_verts,
-                               corner_tris,
-                               tri_faces,
-                               material_index,
-                               sharp_face,
-                               leaf_limit,
-                               vert_bitmap,
-                               0,
-                               &cb,
-                               prim_bounds,
-                               0,
-                               corner_tris.size(),
-                               Array<int>(pbvh->prim_indices_.size()),
-                               0);
+    const Vector<int> leaf_nodes = build_nodes(
+        *pbvh, tri_faces, material_index, sharp_face, leaf_limit, cb, prim_bounds);
+
+    Array<std::atomic<int>> vert_owners(mesh->verts_num);
+    calc_vert_owners(*pbvh, corner_verts, corner_tris, leaf_nodes, vert_owners);
+    threading::parallel_for(leaf_nodes.index_range(), 1, [&](const IndexRange range) {
+      for (const int leaf_index : range) {
+        build_mesh_leaf_node(corner_verts,
+                             corner_tris,
+                             vert_owners,
+                             leaf_index,
+                             pbvh->nodes_[leaf_nodes[leaf_index]]);
+      }
+    });
 
     update_bounds(*pbvh);
     store_bounds_orig(*pbvh);
@@ -449,100 +588,6 @@ std::unique_ptr<Tree> build_mesh(Mesh *mesh)
   return pbvh;
 }
 
-static void build_nodes_recursive_grids(Tree &pbvh,
-                                        const Span<int> material_indices,
-                                        const Span<bool> sharp_faces,
-                                        const int leaf_limit,
-                                        const int node_index,
-                                        const Bounds<float3> *cb,
-                                        const Span<Bounds<float3>> prim_bounds,
-                                        const int prim_offset,
-                                        const int prims_num,
-                                        MutableSpan<int> prim_scratch,
-                                        const int depth)
-{
-  const Span<int> prim_to_face_map = pbvh.subdiv_ccg_->grid_to_face_map;
-  int end;
-
-  /* Decide whether this is a leaf or not */
-  const bool below_leaf_limit = prims_num <= leaf_limit || depth >= STACK_FIXED_DEPTH - 1;
-  if (below_leaf_limit) {
-    if (!leaf_needs_material_split(
-            pbvh, prim_to_face_map, material_indices, sharp_faces, prim_offset, prims_num))
-    {
-      Node &node = pbvh.nodes_[node_index];
-      node.flag_ |= PBVH_Leaf;
-
-      node.prim_indices_ = pbvh.prim_indices_.as_span().slice(prim_offset, prims_num);
-      BKE_pbvh_node_mark_positions_update(&node);
-      BKE_pbvh_node_mark_rebuild_draw(&node);
-      return;
-    }
-  }
-
-  /* Add two child nodes */
-  pbvh.nodes_[node_index].children_offset_ = pbvh.nodes_.size();
-  pbvh.nodes_.resize(pbvh.nodes_.size() + 2);
-
-  Bounds<float3> cb_backing;
-  if (!below_leaf_limit) {
-    /* Find axis with widest range of primitive centroids */
-    if (!cb) {
-      cb_backing = negative_bounds();
-      for (int i = prim_offset + prims_num - 1; i >= prim_offset; i--) {
-        const int prim = pbvh.prim_indices_[i];
-        const float3 center = math::midpoint(prim_bounds[prim].min, prim_bounds[prim].max);
-        math::min_max(center, cb_backing.min, cb_backing.max);
-      }
-      cb = &cb_backing;
-    }
-    const int axis = math::dominant_axis(cb->max - cb->min);
-
-    /* Partition primitives along that axis */
-    end = partition_prim_indices(pbvh.prim_indices_,
-                                 prim_scratch,
-                                 prim_offset,
-                                 prim_offset + prims_num,
-                                 axis,
-                                 math::midpoint(cb->min[axis], cb->max[axis]),
-                                 prim_bounds,
-                                 prim_to_face_map);
-  }
-  else {
-    /* Partition primitives by material */
-    end = partition_indices_material_faces(pbvh.prim_indices_,
-                                           prim_to_face_map,
-                                           material_indices,
-                                           sharp_faces,
-                                           prim_offset,
-                                           prim_offset + prims_num - 1);
-  }
-
-  /* Build children */
-  build_nodes_recursive_grids(pbvh,
-                              material_indices,
-                              sharp_faces,
-                              leaf_limit,
-                              pbvh.nodes_[node_index].children_offset_,
-                              nullptr,
-                              prim_bounds,
-                              prim_offset,
-                              end - prim_offset,
-                              prim_scratch,
-                              depth + 1);
-  build_nodes_recursive_grids(pbvh,
-                              material_indices,
-                              sharp_faces,
-                              leaf_limit,
-                              pbvh.nodes_[node_index].children_offset_ + 1,
-                              nullptr,
-                              prim_bounds,
-                              end,
-                              prim_offset + prims_num - end,
-                              prim_scratch,
-                              depth + 1);
-}
-
 std::unique_ptr<Tree> build_grids(Mesh *mesh, SubdivCCG *subdiv_ccg)
 {
   std::unique_ptr<Tree> pbvh = std::make_unique<Tree>(Type::Grids);
@@ -598,18 +643,17 @@ std::unique_ptr<Tree> build_grids(Mesh *mesh, SubdivCCG *subdiv_ccg)
     pbvh->prim_indices_.reinitialize(grids.size());
     array_utils::fill_index_range<int>(pbvh->prim_indices_);
 
-    pbvh->nodes_.resize(1);
-    build_nodes_recursive_grids(*pbvh,
-                                material_index,
-                                sharp_face,
-                                leaf_limit,
-                                0,
-                                &cb,
-                                prim_bounds,
-                                0,
-                                grids.size(),
-                                Array<int>(pbvh->prim_indices_.size()),
-                                0);
+    const Vector<int> leaf_nodes = build_nodes(*pbvh,
+                                               subdiv_ccg->grid_to_face_map,
+                                               material_index,
+                                               sharp_face,
+                                               leaf_limit,
+                                               cb,
+                                               prim_bounds);
+    for (const int i : leaf_nodes) {
+      BKE_pbvh_node_mark_positions_update(&pbvh->nodes_[i]);
+      BKE_pbvh_node_mark_rebuild_draw(&pbvh->nodes_[i]);
+    }
 
     update_bounds(*pbvh);
     store_bounds_orig(*pbvh);
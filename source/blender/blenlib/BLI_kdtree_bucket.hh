@@ -0,0 +1,113 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/** \file
+ * \ingroup bli
+ *
+ * A KD-tree for nearest neighbor search, optimized for building and querying with many points.
+ *
+ * Compared to #KDTree_3d (see `BLI_kdtree.h`):
+ * - The tree has an implicit layout. Nodes don't store child pointers, and the points are
+ *   reordered so that every node covers a contiguous range of them.
+ * - Leaves store small buckets of points. Their distances are computed together with a loop
+ *   over separate coordinate arrays, which compilers turn into SIMD instructions.
+ * - The tree is built on multiple threads. There are also batched queries that process many
+ *   query points on multiple threads.
+ *
+ * The tree is immutable once built. All queries are thread-safe.
+ */
+
+#include <array>
+
+#include "BLI_array.hh"
+#include "BLI_function_ref.hh"
+#include "BLI_math_vector_types.hh"
+#include "BLI_span.hh"
+
+namespace blender {
+
+template<int Dims> class BucketKDTree {
+ public:
+  using VecT = VecBase<float, Dims>;
+
+  /** Maximum number of points in a leaf bucket. */
+  static constexpr int max_leaf_size = 8;
+
+ private:
+  int64_t points_num_ = 0;
+  /** The tree has `2^depth` leaves and `2^depth - 1` inner nodes. */
+  int depth_ = 0;
+  /**
+   * Splitting plane of every inner node, in breadth first order: the children of node `i`
+   * are `2 * i + 1` and `2 * i + 2`.
+   */
+  Array<float> split_values_;
+  Array<uint8_t> split_axes_;
+  /**
+   * Coordinates of the points in tree order, one array per axis. The arrays are padded with
+   * #max_leaf_size elements, so that the distances of a full bucket can always be computed.
+   */
+  std::array<Array<float>, Dims> coords_;
+  /** Index of every point in tree order, in the positions passed to the constructor. */
+  Array<int> indices_;
+
+ public:
+  BucketKDTree() = default;
+  /**
+   * Build the tree on multiple threads. Query results refer to points by their index in
+   * \a positions.
+   */
+  explicit BucketKDTree(Span<VecT> positions);
+
+  int64_t size() const
+  {
+    return points_num_;
+  }
+
+  /**
+   * Find the point closest to \a co. When there are multiple points at the same distance, the
+   * one with the lowest index is used, so results don't depend on the order of points.
+   *
+   * \return The index of the nearest point or -1 if the tree is empty.
+   */
+  int find_nearest(const VecT &co, float *r_dist_sq = nullptr) const;
+
+  /**
+   * Call #find_nearest for every query point on multiple threads.
+   *
+   * \param r_dists_sq: Optional squared distances to the nearest points.
+   */
+  void find_nearest_batch(Span<VecT> queries,
+                          MutableSpan<int> r_indices,
+                          MutableSpan<float> r_dists_sq = {}) const;
+
+  /**
+   * Call \a fn for every point with a distance to \a co that is smaller or equal to \a range.
+   * Points are not visited in any particular order.
+   */
+  void range_search(const VecT &co,
+                    float range,
+                    FunctionRef<void(int index, float dist_sq)> fn) const;
+
+  /**
+   * Call #range_search for every query point on multiple threads. \a fn is called from multiple
+   * threads at the same time, but all calls for the same query point come from the same thread.
+   */
+  void range_search_batch(
+      Span<VecT> queries,
+      float range,
+      FunctionRef<void(int64_t query_index, int index, float dist_sq)> fn) const;
+
+ private:
+  IndexRange node_points(int64_t node, int depth) const;
+  void build_node(Span<VecT> positions, MutableSpan<int> order, int64_t node, int depth);
+  void leaf_dists_sq(int64_t start, const VecT &co, float r_dists_sq[max_leaf_size]) const;
+};
+
+extern template class BucketKDTree<2>;
+extern template class BucketKDTree<3>;
+
+}  // namespace blender
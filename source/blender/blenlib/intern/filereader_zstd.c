@@ -11,13 +11,32 @@
 
 #include "BLI_filereader.h"
 #include "BLI_math_base.h"
+#include "BLI_threads.h"
 
 #ifdef __BIG_ENDIAN__
 #  include "BLI_endian_switch.h"
 #endif
 
+#include "DNA_listBase.h"
+
 #include "MEM_guardedalloc.h"
 
+/* Upper limit for the number of frames that are decompressed ahead of the read position. */
+#define ZSTD_READAHEAD_MAX_FRAMES 16
+
+/* A frame that is decompressed in a separate thread, before it is actually read. */
+typedef struct ZstdReadaheadFrame {
+  /* Index of the frame, or -1 if the slot is unused. */
+  int frame;
+  /* Whether a thread was started for this frame and has not been joined yet. */
+  bool running;
+
+  char *compressed_data;
+  size_t compressed_size;
+  char *uncompressed_data;
+  size_t uncompressed_size;
+} ZstdReadaheadFrame;
+
 typedef struct {
   FileReader reader;
 
@@ -35,6 +54,16 @@ typedef struct {
     char *cached_content;
     int cached_frame;
   } seek;
+
+  /* When frames are read in order, the following ones are decompressed on other threads in
+   * advance. Frame `i` is stored in `frames[i % frames_num]`. */
+  struct {
+    ListBase threadpool;
+    ZstdReadaheadFrame *frames;
+    int frames_num;
+    /* Last frame that was loaded into the cache, to detect sequential reading. */
+    int last_frame;
+  } readahead;
 } ZstdReader;
 
 static bool zstd_read_u32(FileReader *base, uint32_t *val)
@@ -130,6 +159,7 @@ static bool zstd_read_seek_table(ZstdReader *zstd)
   }
 
   zstd->seek.cached_frame = -1;
+  zstd->readahead.last_frame = -1;
 
   return true;
 }
@@ -157,6 +187,123 @@ static int zstd_frame_from_pos(ZstdReader *zstd, size_t pos)
   return low;
 }
 
+static void *zstd_readahead_task(void *userdata)
+{
+  ZstdReadaheadFrame *slot = (ZstdReadaheadFrame *)userdata;
+
+  slot->uncompressed_data = MEM_mallocN(slot->uncompressed_size, __func__);
+  size_t res = ZSTD_decompress(slot->uncompressed_data,
+                               slot->uncompressed_size,
+                               slot->compressed_data,
+                               slot->compressed_size);
+  MEM_SAFE_FREE(slot->compressed_data);
+  if (ZSTD_isError(res) || res < slot->uncompressed_size) {
+    MEM_SAFE_FREE(slot->uncompressed_data);
+  }
+  return NULL;
+}
+
+/* Wait until the slot's frame is decompressed (if it is in progress), and free it. */
+static void zstd_readahead_slot_clear(ZstdReader *zstd, ZstdReadaheadFrame *slot)
+{
+  if (slot->running) {
+    BLI_threadpool_remove(&zstd->readahead.threadpool, slot);
+    slot->running = false;
+  }
+  MEM_SAFE_FREE(slot->compressed_data);
+  MEM_SAFE_FREE(slot->uncompressed_data);
+  slot->frame = -1;
+}
+
+/* Read the compressed data of the frame and start decompressing it on another thread. */
+static void zstd_readahead_start(ZstdReader *zstd, int frame)
+{
+  ZstdReadaheadFrame *slot = &zstd->readahead.frames[frame % zstd->readahead.frames_num];
+  if (slot->frame == frame) {
+    return;
+  }
+  zstd_readahead_slot_clear(zstd, slot);
+
+  slot->compressed_size = zstd->seek.compressed_ofs[frame + 1] - zstd->seek.compressed_ofs[frame];
+  slot->uncompressed_size = zstd->seek.uncompressed_ofs[frame + 1] -
+                            zstd->seek.uncompressed_ofs[frame];
+  slot->compressed_data = MEM_mallocN(slot->compressed_size, __func__);
+  if (zstd->base->seek(zstd->base, zstd->seek.compressed_ofs[frame], SEEK_SET) < 0 ||
+      zstd->base->read(zstd->base, slot->compressed_data, slot->compressed_size) <
+          slot->compressed_size)
+  {
+    MEM_SAFE_FREE(slot->compressed_data);
+    return;
+  }
+
+  slot->frame = frame;
+  slot->running = true;
+  BLI_threadpool_insert(&zstd->readahead.threadpool, slot);
+}
+
+/* Take the frame from the read-ahead slots if it was decompressed in advance already. */
+static char *zstd_readahead_take(ZstdReader *zstd, int frame)
+{
+  if (zstd->readahead.frames == NULL) {
+    return NULL;
+  }
+  ZstdReadaheadFrame *slot = &zstd->readahead.frames[frame % zstd->readahead.frames_num];
+  if (slot->frame != frame) {
+    return NULL;
+  }
+  /* Wait for the thread to finish and take over its result, which is NULL on failure. */
+  if (slot->running) {
+    BLI_threadpool_remove(&zstd->readahead.threadpool, slot);
+    slot->running = false;
+  }
+  char *uncompressed_data = slot->uncompressed_data;
+  slot->uncompressed_data = NULL;
+  slot->frame = -1;
+  return uncompressed_data;
+}
+
+/* When reading in order, start decompressing the next frames that are not started yet. */
+static void zstd_readahead_update(ZstdReader *zstd, int frame)
+{
+  const bool is_sequential = frame == zstd->readahead.last_frame + 1;
+  zstd->readahead.last_frame = frame;
+  if (!is_sequential || zstd->seek.frames_num < 2) {
+    return;
+  }
+
+  if (zstd->readahead.frames == NULL) {
+    /* Leave one thread for the main reading logic, but always read ahead at least one frame. */
+    const int frames_num = clamp_i(
+        BLI_system_thread_count() - 1, 1, ZSTD_READAHEAD_MAX_FRAMES);
+    zstd->readahead.frames_num = frames_num;
+    zstd->readahead.frames = MEM_calloc_arrayN(
+        frames_num, sizeof(ZstdReadaheadFrame), "zstd readahead frames");
+    for (int i = 0; i < frames_num; i++) {
+      zstd->readahead.frames[i].frame = -1;
+    }
+    BLI_threadpool_init(&zstd->readahead.threadpool, zstd_readahead_task, frames_num);
+  }
+
+  const int end_frame = min_ii(frame + 1 + zstd->readahead.frames_num, zstd->seek.frames_num);
+  for (int i = frame + 1; i < end_frame; i++) {
+    zstd_readahead_start(zstd, i);
+  }
+}
+
+static void zstd_readahead_free(ZstdReader *zstd)
+{
+  if (zstd->readahead.frames == NULL) {
+    return;
+  }
+  BLI_threadpool_end(&zstd->readahead.threadpool);
+  for (int i = 0; i < zstd->readahead.frames_num; i++) {
+    ZstdReadaheadFrame *slot = &zstd->readahead.frames[i];
+    MEM_SAFE_FREE(slot->compressed_data);
+    MEM_SAFE_FREE(slot->uncompressed_data);
+  }
+  MEM_freeN(zstd->readahead.frames);
+}
+
 /* Ensure that the currently loaded frame is the correct one. */
 static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
 {
@@ -168,6 +315,14 @@ static const char *zstd_ensure_cache(ZstdReader *zstd, int frame)
   /* Cached frame doesn't match, so discard it and cache the wanted one instead. */
   MEM_SAFE_FREE(zstd->seek.cached_content);
 
+  char *readahead_data = zstd_readahead_take(zstd, frame);
+  zstd_readahead_update(zstd, frame);
+  if (readahead_data) {
+    zstd->seek.cached_frame = frame;
+    zstd->seek.cached_content = readahead_data;
+    return readahead_data;
+  }
+
   size_t compressed_size = zstd->seek.compressed_ofs[frame + 1] - zstd->seek.compressed_ofs[frame];
   size_t uncompressed_size = zstd->seek.uncompressed_ofs[frame + 1] -
                              zstd->seek.uncompressed_ofs[frame];
@@ -283,6 +438,7 @@ static void zstd_close(FileReader *reader)
 
   ZSTD_freeDCtx(zstd->ctx);
   if (zstd->reader.seek) {
+    zstd_readahead_free(zstd);
     MEM_freeN(zstd->seek.uncompressed_ofs);
     MEM_freeN(zstd->seek.compressed_ofs);
     /* When an error has occurred this may be NULL, see: #99744. */
@@ -0,0 +1,269 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup bli
+ */
+
+#include <algorithm>
+#include <cfloat>
+
+#include "BLI_array_utils.hh"
+#include "BLI_kdtree_bucket.hh"
+#include "BLI_math_vector.hh"
+#include "BLI_task.hh"
+
+namespace blender {
+
+/** Build child nodes on separate threads when they contain more points than this. */
+static constexpr int64_t build_parallel_threshold = 4096;
+/** Enough for any tree depth with 64 bit point counts. */
+static constexpr int max_stack_size = 64;
+
+template<int Dims>
+IndexRange BucketKDTree<Dims>::node_points(const int64_t node, const int depth) const
+{
+  /* Nodes at the same depth split the points evenly, so the range can be computed from the
+   * position of the node in its level. */
+  const uint64_t level_start = (uint64_t(1) << depth) - 1;
+  const uint64_t position = uint64_t(node) - level_start;
+  const uint64_t points_num = uint64_t(points_num_);
+  const int64_t start = int64_t((position * points_num) >> depth);
+  const int64_t end = int64_t(((position + 1) * points_num) >> depth);
+  return IndexRange::from_begin_end(start, end);
+}
+
+template<int Dims>
+void BucketKDTree<Dims>::build_node(const Span<VecT> positions,
+                                    MutableSpan<int> order,
+                                    const int64_t node,
+                                    const int depth)
+{
+  if (depth == depth_) {
+    return;
+  }
+  const IndexRange points = this->node_points(node, depth);
+  const int64_t left = 2 * node + 1;
+  const int64_t right = left + 1;
+  const int64_t split = this->node_points(left, depth + 1).one_after_last();
+
+  /* Split along the axis with the largest extent. */
+  VecT min(FLT_MAX);
+  VecT max(-FLT_MAX);
+  for (const int i : order.slice(points)) {
+    min = math::min(min, positions[i]);
+    max = math::max(max, positions[i]);
+  }
+  int axis = 0;
+  const VecT extent = max - min;
+  for (int i = 1; i < Dims; i++) {
+    if (extent[i] > extent[axis]) {
+      axis = i;
+    }
+  }
+
+  std::nth_element(
+      order.begin() + points.start(),
+      order.begin() + split,
+      order.begin() + points.one_after_last(),
+      [&](const int a, const int b) { return positions[a][axis] < positions[b][axis]; });
+  split_values_[node] = positions[order[split]][axis];
+  split_axes_[node] = uint8_t(axis);
+
+  threading::parallel_invoke(
+      points.size() > build_parallel_threshold,
+      [&]() { this->build_node(positions, order, left, depth + 1); },
+      [&]() { this->build_node(positions, order, right, depth + 1); });
+}
+
+template<int Dims> BucketKDTree<Dims>::BucketKDTree(const Span<VecT> positions)
+{
+  points_num_ = positions.size();
+  while (((points_num_ - 1) >> depth_) >= max_leaf_size) {
+    depth_++;
+  }
+  const int64_t inner_nodes_num = (int64_t(1) << depth_) - 1;
+  split_values_.reinitialize(inner_nodes_num);
+  split_axes_.reinitialize(inner_nodes_num);
+
+  indices_.reinitialize(points_num_);
+  array_utils::fill_index_range<int>(indices_);
+  this->build_node(positions, indices_, 0, 0);
+
+  for (int axis = 0; axis < Dims; axis++) {
+    coords_[axis].reinitialize(points_num_ + max_leaf_size);
+    coords_[axis].as_mutable_span().take_back(max_leaf_size).fill(0.0f);
+  }
+  threading::parallel_for(indices_.index_range(), 4096, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      const VecT &co = positions[indices_[i]];
+      for (int axis = 0; axis < Dims; axis++) {
+        coords_[axis][i] = co[axis];
+      }
+    }
+  });
+}
+
+template<int Dims>
+void BucketKDTree<Dims>::leaf_dists_sq(const int64_t start,
+                                       const VecT &co,
+                                       float r_dists_sq[max_leaf_size]) const
+{
+  /* Always process a full bucket to get a fixed size loop the compiler can vectorize. */
+  for (int i = 0; i < max_leaf_size; i++) {
+    r_dists_sq[i] = 0.0f;
+  }
+  for (int axis = 0; axis < Dims; axis++) {
+    const float *coords = coords_[axis].data() + start;
+    for (int i = 0; i < max_leaf_size; i++) {
+      const float delta = coords[i] - co[axis];
+      r_dists_sq[i] += delta * delta;
+    }
+  }
+}
+
+namespace {
+struct StackItem {
+  int64_t node;
+  int depth;
+  float dist_sq;
+};
+}  // namespace
+
+template<int Dims>
+int BucketKDTree<Dims>::find_nearest(const VecT &co, float *r_dist_sq) const
+{
+  if (points_num_ == 0) {
+    return -1;
+  }
+
+  int min_index = -1;
+  float min_dist_sq = FLT_MAX;
+
+  std::array<StackItem, max_stack_size> stack;
+  int stack_size = 0;
+  stack[stack_size++] = {0, 0, 0.0f};
+
+  while (stack_size > 0) {
+    const StackItem item = stack[--stack_size];
+    /* Points at the same distance as the current nearest point may have a lower index. */
+    if (item.dist_sq > min_dist_sq) {
+      continue;
+    }
+    int64_t node = item.node;
+    int depth = item.depth;
+    /* Descend to the leaf containing the query point, remembering the other sides. */
+    while (depth < depth_) {
+      const int axis = split_axes_[node];
+      const float delta = co[axis] - split_values_[node];
+      const int64_t left = 2 * node + 1;
+      if (delta < 0.0f) {
+        stack[stack_size++] = {left + 1, depth + 1, delta * delta};
+        node = left;
+      }
+      else {
+        stack[stack_size++] = {left, depth + 1, delta * delta};
+        node = left + 1;
+      }
+      depth++;
+    }
+
+    const IndexRange points = this->node_points(node, depth);
+    float dists_sq[max_leaf_size];
+    this->leaf_dists_sq(points.start(), co, dists_sq);
+    for (const int64_t i : IndexRange(points.size())) {
+      const float dist_sq = dists_sq[i];
+      if (dist_sq > min_dist_sq) {
+        continue;
+      }
+      const int index = indices_[points[i]];
+      if (dist_sq < min_dist_sq || index < min_index) {
+        min_dist_sq = dist_sq;
+        min_index = index;
+      }
+    }
+  }
+
+  if (r_dist_sq) {
+    *r_dist_sq = min_dist_sq;
+  }
+  return min_index;
+}
+
+template<int Dims>
+void BucketKDTree<Dims>::find_nearest_batch(const Span<VecT> queries,
+                                            MutableSpan<int> r_indices,
+                                            MutableSpan<float> r_dists_sq) const
+{
+  BLI_assert(r_indices.size() == queries.size());
+  BLI_assert(r_dists_sq.is_empty() || r_dists_sq.size() == queries.size());
+  threading::parallel_for(queries.index_range(), 512, [&](const IndexRange range) {
+    for (const int64_t i : range) {
+      r_indices[i] = this->find_nearest(queries[i],
+                                        r_dists_sq.is_empty() ? nullptr : &r_dists_sq[i]);
+    }
+  });
+}
+
+template<int Dims>
+void BucketKDTree<Dims>::range_search(const VecT &co,
+                                      const float range,
+                                      const FunctionRef<void(int index, float dist_sq)> fn) const
+{
+  if (points_num_ == 0) {
+    return;
+  }
+  const float range_sq = range * range;
+
+  std::array<StackItem, max_stack_size> stack;
+  int stack_size = 0;
+  stack[stack_size++] = {0, 0, 0.0f};
+
+  while (stack_size > 0) {
+    const StackItem item = stack[--stack_size];
+    int64_t node = item.node;
+    int depth = item.depth;
+    while (depth < depth_) {
+      const int axis = split_axes_[node];
+      const float delta = co[axis] - split_values_[node];
+      const int64_t left = 2 * node + 1;
+      const int64_t near_child = delta < 0.0f ? left : left + 1;
+      const int64_t far_child = delta < 0.0f ? left + 1 : left;
+      if (delta * delta <= range_sq) {
+        stack[stack_size++] = {far_child, depth + 1, delta * delta};
+      }
+      node = near_child;
+      depth++;
+    }
+
+    const IndexRange points = this->node_points(node, depth);
+    float dists_sq[max_leaf_size];
+    this->leaf_dists_sq(points.start(), co, dists_sq);
+    for (const int64_t i : IndexRange(points.size())) {
+      if (dists_sq[i] <= range_sq) {
+        fn(indices_[points[i]], dists_sq[i]);
+      }
+    }
+  }
+}
+
+template<int Dims>
+void BucketKDTree<Dims>::range_search_batch(
+    const Span<VecT> queries,
+    const float range,
+    const FunctionRef<void(int64_t query_index, int index, float dist_sq)> fn) const
+{
+  threading::parallel_for(queries.index_range(), 256, [&](const IndexRange query_range) {
+    for (const int64_t query_i : query_range) {
+      this->range_search(queries[query_i], range, [&](const int index, const float dist_sq) {
+        fn(query_i, index, dist_sq);
+      });
+    }
+  });
+}
+
+template class BucketKDTree<2>;
+template class BucketKDTree<3>;
+
+}  // namespace blender
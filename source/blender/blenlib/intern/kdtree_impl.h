@@ -836,12 +836,14 @@ struct DeDuplicateParams {
 static void deduplicate_recursive(const struct DeDuplicateParams *p, uint i)
 {
   const KDTreeNode *node = &p->nodes[i];
-  if (p->search_co[node->d] + p->range <= node->co[node->d]) {
+  /* Nodes exactly at the range are compared like in the range searches, because they are merged
+   * when they are within the range of the search position. */
+  if (p->search_co[node->d] + p->range < node->co[node->d]) {
     if (node->left != KD_NODE_UNSET) {
       deduplicate_recursive(p, node->left);
     }
   }
-  else if (p->search_co[node->d] - p->range >= node->co[node->d]) {
+  else if (p->search_co[node->d] - p->range > node->co[node->d]) {
     if (node->right != KD_NODE_UNSET) {
       deduplicate_recursive(p, node->right);
     }
@@ -4,8 +4,14 @@
 
 #include "testing/testing.h"
 
+#include "BLI_array.hh"
 #include "BLI_kdtree.h"
+#include "BLI_kdtree_bucket.hh"
+#include "BLI_math_vector.hh"
+#include "BLI_rand.hh"
+#include "BLI_vector.hh"
 
+#include <algorithm>
 #include <cmath>
 
 /* -------------------------------------------------------------------- */
@@ -63,3 +69,126 @@ TEST(kdtree, Deduplicate)
 {
   deduplicate_test();
 }
+
+/**
+ * Pairs of points exactly the range apart along one of the axes, far away from the other pairs.
+ * The points are merged regardless of which axis the tree splits at.
+ */
+static void calc_duplicates_at_range_test(const bool use_index_order)
+{
+  const float range = 0.5f;
+  for (int pairs_num = 1; pairs_num < 40; pairs_num++) {
+    KDTree_3d *tree = BLI_kdtree_3d_new(pairs_num * 2);
+    for (int i = 0; i < pairs_num; i++) {
+      const float co[3] = {float(i % 4) * 10.0f, float(i % 3) * 10.0f, float(i / 12) * 10.0f};
+      float co_other[3] = {co[0], co[1], co[2]};
+      co_other[i % 3] += range;
+      BLI_kdtree_3d_insert(tree, i * 2, co);
+      BLI_kdtree_3d_insert(tree, i * 2 + 1, co_other);
+    }
+    BLI_kdtree_3d_balance(tree);
+    blender::Array<int> duplicates(pairs_num * 2, -1);
+    const int found = BLI_kdtree_3d_calc_duplicates_fast(
+        tree, range, use_index_order, duplicates.data());
+    BLI_kdtree_3d_free(tree);
+
+    EXPECT_EQ(found, pairs_num);
+    for (int i = 0; i < pairs_num; i++) {
+      EXPECT_TRUE(duplicates[i * 2] == i * 2 + 1 || duplicates[i * 2 + 1] == i * 2);
+    }
+  }
+}
+
+TEST(kdtree, CalcDuplicatesAtRange)
+{
+  calc_duplicates_at_range_test(false);
+}
+
+TEST(kdtree, CalcDuplicatesAtRangeIndexOrder)
+{
+  calc_duplicates_at_range_test(true);
+}
+
+/* -------------------------------------------------------------------- */
+/* Bucket KD-tree */
+
+namespace blender::tests {
+
+static Array<float3> random_positions(const int64_t size, const uint32_t seed)
+{
+  RandomNumberGenerator rng(seed);
+  Array<float3> positions(size);
+  for (float3 &position : positions) {
+    position = float3(rng.get_float(), rng.get_float(), rng.get_float());
+  }
+  return positions;
+}
+
+TEST(kdtree_bucket, Empty)
+{
+  const BucketKDTree<3> tree(Span<float3>{});
+  EXPECT_EQ(tree.find_nearest(float3(0.0f)), -1);
+  int found = 0;
+  tree.range_search(float3(0.0f), 1.0f, [&](int /*index*/, float /*dist_sq*/) { found++; });
+  EXPECT_EQ(found, 0);
+}
+
+TEST(kdtree_bucket, FindNearest)
+{
+  for (const int64_t size : {1, 7, 8, 9, 100, 1000}) {
+    const Array<float3> positions = random_positions(size, 0);
+    const Array<float3> queries = random_positions(200, 1);
+    const BucketKDTree<3> tree(positions);
+    Array<int> indices(queries.size());
+    tree.find_nearest_batch(queries, indices);
+    for (const int64_t i : queries.index_range()) {
+      int expected = 0;
+      for (const int64_t j : positions.index_range()) {
+        if (math::distance_squared(queries[i], positions[j]) <
+            math::distance_squared(queries[i], positions[expected]))
+        {
+          expected = int(j);
+        }
+      }
+      EXPECT_EQ(indices[i], expected);
+    }
+  }
+}
+
+TEST(kdtree_bucket, FindNearestDuplicates)
+{
+  Array<float3> positions(100, float3(1.0f));
+  positions[50] = float3(0.0f);
+  positions[70] = float3(0.0f);
+  const BucketKDTree<3> tree(positions);
+  float dist_sq;
+  EXPECT_EQ(tree.find_nearest(float3(0.0f), &dist_sq), 50);
+  EXPECT_EQ(dist_sq, 0.0f);
+  EXPECT_EQ(tree.find_nearest(float3(2.0f)), 0);
+}
+
+TEST(kdtree_bucket, RangeSearch)
+{
+  const Array<float3> positions = random_positions(1000, 2);
+  const Array<float3> queries = random_positions(100, 3);
+  const float range = 0.1f;
+  const BucketKDTree<3> tree(positions);
+
+  Array<Vector<int>> found(queries.size());
+  tree.range_search_batch(
+      queries, range, [&](const int64_t query_i, const int index, const float /*dist_sq*/) {
+        found[query_i].append(index);
+      });
+  for (const int64_t i : queries.index_range()) {
+    Vector<int> expected;
+    for (const int64_t j : positions.index_range()) {
+      if (math::distance_squared(queries[i], positions[j]) <= range * range) {
+        expected.append(int(j));
+      }
+    }
+    std::sort(found[i].begin(), found[i].end());
+    EXPECT_EQ(found[i].as_span(), expected.as_span());
+  }
+}
+
+}  // namespace blender::tests
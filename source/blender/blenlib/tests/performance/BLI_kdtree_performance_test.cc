@@ -0,0 +1,113 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include <atomic>
+#include <iostream>
+#include <optional>
+
+#include "BLI_array.hh"
+#include "BLI_enumerable_thread_specific.hh"
+#include "BLI_kdtree.h"
+#include "BLI_kdtree_bucket.hh"
+#include "BLI_math_vector_types.hh"
+#include "BLI_rand.hh"
+#include "BLI_task.hh"
+#include "BLI_timeit.hh"
+
+namespace blender::tests {
+
+/* Compare #KDTree_3d with #BucketKDTree, for building the tree and for queries from the points
+ * themselves, like merge by distance does. */
+
+static Array<float3> random_positions(const int64_t size)
+{
+  RandomNumberGenerator rng(0);
+  Array<float3> positions(size);
+  for (float3 &position : positions) {
+    position = float3(rng.get_float(), rng.get_float(), rng.get_float());
+  }
+  return positions;
+}
+
+static void kdtree_3d_benchmark(const Span<float3> positions, const float range)
+{
+  KDTree_3d *tree;
+  {
+    SCOPED_TIMER("KDTree_3d: build");
+    tree = BLI_kdtree_3d_new(uint(positions.size()));
+    for (const int64_t i : positions.index_range()) {
+      BLI_kdtree_3d_insert(tree, int(i), positions[i]);
+    }
+    BLI_kdtree_3d_balance(tree);
+  }
+  Array<int> nearest(positions.size());
+  {
+    SCOPED_TIMER("KDTree_3d: find nearest (multi-threaded)");
+    threading::parallel_for(positions.index_range(), 512, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        nearest[i] = BLI_kdtree_3d_find_nearest(tree, positions[i], nullptr);
+      }
+    });
+  }
+  std::atomic<int64_t> found = 0;
+  {
+    SCOPED_TIMER("KDTree_3d: range search (multi-threaded)");
+    threading::parallel_for(positions.index_range(), 256, [&](const IndexRange query_range) {
+      int64_t found_local = 0;
+      for (const int64_t i : query_range) {
+        BLI_kdtree_3d_range_search_cb_cpp(
+            tree, positions[i], range, [&](int /*index*/, const float * /*co*/, float /*dist*/) {
+              found_local++;
+              return true;
+            });
+      }
+      found += found_local;
+    });
+  }
+  std::cout << "Found: " << found << "\n";
+  BLI_kdtree_3d_free(tree);
+}
+
+static void kdtree_bucket_benchmark(const Span<float3> positions, const float range)
+{
+  std::optional<BucketKDTree<3>> tree;
+  {
+    SCOPED_TIMER("BucketKDTree: build");
+    tree.emplace(positions);
+  }
+  Array<int> nearest(positions.size());
+  {
+    SCOPED_TIMER("BucketKDTree: find nearest (batch)");
+    tree->find_nearest_batch(positions, nearest);
+  }
+  std::atomic<int64_t> found = 0;
+  {
+    SCOPED_TIMER("BucketKDTree: range search (batch)");
+    threading::EnumerableThreadSpecific<int64_t> found_local;
+    tree->range_search_batch(
+        positions, range, [&](int64_t /*query_i*/, int /*index*/, float /*dist_sq*/) {
+          found_local.local()++;
+        });
+    for (const int64_t value : found_local) {
+      found += value;
+    }
+  }
+  std::cout << "Found: " << found << "\n";
+}
+
+TEST(kdtree_performance, Compare)
+{
+  for (const int64_t size : {10'000, 1'000'000}) {
+    const Array<float3> positions = random_positions(size);
+    /* About a hundred points within the range of every point. */
+    const float range = std::cbrt(30.0f / float(size));
+    std::cout << "\n" << size << " points:\n";
+    kdtree_3d_benchmark(positions, range);
+    kdtree_bucket_benchmark(positions, range);
+  }
+}
+
+}  // namespace blender::tests
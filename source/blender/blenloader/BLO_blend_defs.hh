@@ -56,6 +56,11 @@ enum {
    * Terminate reading (no data).
    */
   BLO_CODE_ENDB = BLEND_MAKE_ID('E', 'N', 'D', 'B'),
+  /**
+   * Index of all ID blocks in the file, written after #BLO_CODE_ENDB
+   * (ignored by regular file reading, see #BlendFileIndexHeader).
+   */
+  BLO_CODE_BIDX = BLEND_MAKE_ID('B', 'I', 'D', 'X'),
 };
 
 #define BLEN_THUMB_MEMSIZE_FILE(_x, _y) (sizeof(int) * (2 + (size_t)(_x) * (size_t)(_y)))
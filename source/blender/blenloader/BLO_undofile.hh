@@ -18,6 +18,7 @@ class ImplicitSharingInfo;
 }
 struct GHash;
 struct Main;
+struct MemFileChunkStorage;
 struct Scene;
 
 struct MemFileSharedStorage {
@@ -31,10 +32,11 @@ struct MemFileSharedStorage {
 
 struct MemFileChunk {
   void *next, *prev;
+  /** Owned by #MemFile.chunk_storage, shared by all chunks with the same content. */
   const char *buf;
   /** Size in bytes. */
   size_t size;
-  /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
+  /** When true, this chunk is identical to the one at the same position in the previous step. */
   bool is_identical;
   /** When true, this chunk is also identical to the one in the next step (used by undo code to
    * detect unchanged IDs).
@@ -47,7 +49,16 @@ struct MemFileChunk {
 
 struct MemFile {
   ListBase chunks;
+  /** Size of the chunk buffers and shared data added by this step. */
   size_t size;
+  /** Size of the chunks that reuse a buffer of an other chunk with the same content. */
+  size_t size_deduplicated;
+  /**
+   * Chunk buffers by their content. This is shared with the reference #MemFile this one was
+   * written with (i.e. the steps of an undo stack), so identical data is only stored once, even
+   * when it moved to another position in the file.
+   */
+  MemFileChunkStorage *chunk_storage;
   /**
    * Some data is not serialized into a new buffer because the undo-step can take ownership of it
    * without making a copy. This is faster and requires less memory.
@@ -9,6 +9,7 @@
  * \brief external `writefile.cc` function prototypes.
  */
 
+struct BlendFileWriteBuffer;
 struct BlendThumbnail;
 struct Main;
 struct MemFile;
@@ -54,6 +55,25 @@ extern bool BLO_write_file(Main *mainvar,
                            const BlendFileWriteParams *params,
                            ReportList *reports);
 
+/**
+ * Serialize the file into memory, so that it can be written to disk with
+ * #BLO_write_file_buffer_flush later, while \a mainvar is modified or freed.
+ *
+ * \return The file data, or null on failure.
+ */
+BlendFileWriteBuffer *BLO_write_file_to_buffer(Main *mainvar,
+                                               const char *filepath,
+                                               int write_flags,
+                                               const BlendFileWriteParams *params,
+                                               ReportList *reports);
+/**
+ * Write the file data to disk (compressing it when requested), can be called from any thread.
+ *
+ * \return Success.
+ */
+bool BLO_write_file_buffer_flush(const BlendFileWriteBuffer *buffer, ReportList *reports);
+void BLO_write_file_buffer_free(BlendFileWriteBuffer *buffer);
+
 /**
  * \return Success.
  */
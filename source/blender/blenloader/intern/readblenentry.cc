@@ -66,7 +66,7 @@ BlendHandle *BLO_blendhandle_from_file(const char *filepath, BlendFileReadReport
 {
   BlendHandle *bh;
 
-  bh = (BlendHandle *)blo_filedata_from_file(filepath, reports);
+  bh = (BlendHandle *)blo_filedata_from_file(filepath, reports, true);
 
   return bh;
 }
@@ -77,7 +77,7 @@ BlendHandle *BLO_blendhandle_from_memory(const void *mem,
 {
   BlendHandle *bh;
 
-  bh = (BlendHandle *)blo_filedata_from_memory(mem, memsize, reports);
+  bh = (BlendHandle *)blo_filedata_from_memory(mem, memsize, reports, true);
 
   return bh;
 }
@@ -127,6 +127,25 @@ LinkNode *BLO_blendhandle_get_datablock_names(BlendHandle *bh,
   BHead *bhead;
   int tot = 0;
 
+  const blender::Span<BlendFileIndexEntry> index_entries = blo_bhead_index_entries(fd);
+  if (!index_entries.is_empty()) {
+    for (const int i : index_entries.index_range()) {
+      if (index_entries[i].code != ofblocktype) {
+        continue;
+      }
+      if (use_assets_only) {
+        bhead = blo_bhead_index_block(fd, i);
+        if (bhead == nullptr || blo_bhead_id_asset_data_address(fd, bhead) == nullptr) {
+          continue;
+        }
+      }
+      BLI_linklist_prepend(&names, BLI_strdup(index_entries[i].name + 2));
+      tot++;
+    }
+    *r_tot_names = tot;
+    return names;
+  }
+
   for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == ofblocktype) {
       const char *idname = blo_bhead_id_name(fd, bhead);
@@ -146,6 +165,49 @@ LinkNode *BLO_blendhandle_get_datablock_names(BlendHandle *bh,
   return names;
 }
 
+/**
+ * Create the info for the ID of \a id_bhead, reading its asset data from the following blocks.
+ * \return nullptr when the ID should be skipped.
+ */
+static BLODataBlockInfo *blo_blendhandle_datablock_info_create(FileData *fd,
+                                                               BHead *id_bhead,
+                                                               const bool use_assets_only,
+                                                               const int sdna_nr_preview_image)
+{
+  const char *name = blo_bhead_id_name(fd, id_bhead) + 2;
+  AssetMetaData *asset_meta_data = blo_bhead_id_asset_data_address(fd, id_bhead);
+
+  const bool is_asset = asset_meta_data != nullptr;
+  const bool skip_datablock = use_assets_only && !is_asset;
+  if (skip_datablock) {
+    return nullptr;
+  }
+  BLODataBlockInfo *info = static_cast<BLODataBlockInfo *>(MEM_mallocN(sizeof(*info), __func__));
+
+  /* Lastly, read asset data from the following blocks. */
+  if (asset_meta_data) {
+    blo_read_asset_data_block(fd, id_bhead, &asset_meta_data);
+  }
+
+  STRNCPY(info->name, name);
+  info->asset_data = asset_meta_data;
+  info->free_asset_data = true;
+
+  bool has_preview = false;
+  /* See if we can find a preview in the data of this ID. */
+  for (BHead *data_bhead = blo_bhead_next(fd, id_bhead); data_bhead->code == BLO_CODE_DATA;
+       data_bhead = blo_bhead_next(fd, data_bhead))
+  {
+    if (data_bhead->SDNAnr == sdna_nr_preview_image) {
+      has_preview = true;
+      break;
+    }
+  }
+  info->no_preview_found = !has_preview;
+
+  return info;
+}
+
 LinkNode *BLO_blendhandle_get_datablock_info(BlendHandle *bh,
                                              int ofblocktype,
                                              const bool use_assets_only,
@@ -158,50 +220,39 @@ LinkNode *BLO_blendhandle_get_datablock_info(BlendHandle *bh,
 
   const int sdna_nr_preview_image = DNA_struct_find_with_alias(fd->filesdna, "PreviewImage");
 
+  const blender::Span<BlendFileIndexEntry> index_entries = blo_bhead_index_entries(fd);
+  if (!index_entries.is_empty()) {
+    /* Only read the blocks of the requested ID type. */
+    for (const int i : index_entries.index_range()) {
+      if (index_entries[i].code != ofblocktype) {
+        continue;
+      }
+      bhead = blo_bhead_index_block(fd, i);
+      if (bhead == nullptr) {
+        continue;
+      }
+      if (BLODataBlockInfo *info = blo_blendhandle_datablock_info_create(
+              fd, bhead, use_assets_only, sdna_nr_preview_image))
+      {
+        BLI_linklist_prepend(&infos, info);
+        tot++;
+      }
+    }
+    *r_tot_info_items = tot;
+    return infos;
+  }
+
   for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == BLO_CODE_ENDB) {
       break;
     }
     if (bhead->code == ofblocktype) {
-      BHead *id_bhead = bhead;
-
-      const char *name = blo_bhead_id_name(fd, bhead) + 2;
-      AssetMetaData *asset_meta_data = blo_bhead_id_asset_data_address(fd, bhead);
-
-      const bool is_asset = asset_meta_data != nullptr;
-      const bool skip_datablock = use_assets_only && !is_asset;
-      if (skip_datablock) {
-        continue;
-      }
-      BLODataBlockInfo *info = static_cast<BLODataBlockInfo *>(
-          MEM_mallocN(sizeof(*info), __func__));
-
-      /* Lastly, read asset data from the following blocks. */
-      if (asset_meta_data) {
-        bhead = blo_read_asset_data_block(fd, bhead, &asset_meta_data);
-        /* blo_read_asset_data_block() reads all DATA heads and already advances bhead to the
-         * next non-DATA one. Go back, so the loop doesn't skip the non-DATA head. */
-        bhead = blo_bhead_prev(fd, bhead);
-      }
-
-      STRNCPY(info->name, name);
-      info->asset_data = asset_meta_data;
-      info->free_asset_data = true;
-
-      bool has_preview = false;
-      /* See if we can find a preview in the data of this ID. */
-      for (BHead *data_bhead = blo_bhead_next(fd, id_bhead); data_bhead->code == BLO_CODE_DATA;
-           data_bhead = blo_bhead_next(fd, data_bhead))
+      if (BLODataBlockInfo *info = blo_blendhandle_datablock_info_create(
+              fd, bhead, use_assets_only, sdna_nr_preview_image))
       {
-        if (data_bhead->SDNAnr == sdna_nr_preview_image) {
-          has_preview = true;
-          break;
-        }
+        BLI_linklist_prepend(&infos, info);
+        tot++;
       }
-      info->no_preview_found = !has_preview;
-
-      BLI_linklist_prepend(&infos, info);
-      tot++;
     }
   }
 
@@ -261,7 +312,25 @@ PreviewImage *BLO_blendhandle_get_preview_for_id(BlendHandle *bh,
   bool looking = false;
   const int sdna_preview_image = DNA_struct_find_with_alias(fd->filesdna, "PreviewImage");
 
-  for (BHead *bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
+  BHead *bhead_first = nullptr;
+  const blender::Span<BlendFileIndexEntry> index_entries = blo_bhead_index_entries(fd);
+  if (!index_entries.is_empty()) {
+    /* Start at the ID block, its data blocks are followed by an #BLO_CODE_ENDB block. */
+    for (const int i : index_entries.index_range()) {
+      if (index_entries[i].code == ofblocktype && STREQ(index_entries[i].name + 2, name)) {
+        bhead_first = blo_bhead_index_block(fd, i);
+        break;
+      }
+    }
+    if (bhead_first == nullptr) {
+      return nullptr;
+    }
+  }
+  else {
+    bhead_first = blo_bhead_first(fd);
+  }
+
+  for (BHead *bhead = bhead_first; bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == BLO_CODE_DATA) {
       if (looking && bhead->SDNAnr == sdna_preview_image) {
         PreviewImage *preview_from_file = static_cast<PreviewImage *>(
@@ -301,6 +370,21 @@ LinkNode *BLO_blendhandle_get_linkable_groups(BlendHandle *bh)
   LinkNode *names = nullptr;
   BHead *bhead;
 
+  const blender::Span<BlendFileIndexEntry> index_entries = blo_bhead_index_entries(fd);
+  if (!index_entries.is_empty()) {
+    for (const BlendFileIndexEntry &entry : index_entries) {
+      if (BKE_idtype_idcode_is_valid(entry.code) && BKE_idtype_idcode_is_linkable(entry.code)) {
+        const char *str = BKE_idtype_idcode_to_name(entry.code);
+
+        if (BLI_gset_add(gathered, (void *)str)) {
+          BLI_linklist_prepend(&names, BLI_strdup(str));
+        }
+      }
+    }
+    BLI_gset_free(gathered, nullptr);
+    return names;
+  }
+
   for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == BLO_CODE_ENDB) {
       break;
@@ -13,6 +13,7 @@
 #include <cstddef> /* for offsetof. */
 #include <cstdlib> /* for atoi. */
 #include <ctime>   /* for gmtime. */
+#include <limits>
 #include <fcntl.h> /* for open flags (O_BINARY, O_RDONLY). */
 
 #include "BLI_utildefines.h"
@@ -41,22 +42,27 @@
 #include "DNA_packedFile_types.h"
 #include "DNA_sdna_types.h"
 #include "DNA_sound_types.h"
+#include "DNA_userdef_types.h"
 #include "DNA_vfont_types.h"
 #include "DNA_volume_types.h"
 #include "DNA_workspace_types.h"
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_array.hh"
 #include "BLI_blenlib.h"
 #include "BLI_endian_defines.h"
 #include "BLI_endian_switch.h"
 #include "BLI_ghash.h"
+#include "BLI_hash_mm2a.hh"
 #include "BLI_linklist.h"
 #include "BLI_map.hh"
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
 #include "BLI_time.h"
+#include "BLI_vector.hh"
 
 #include "BLT_translation.hh"
 
@@ -197,6 +203,10 @@ struct BHeadN {
 
 #define BHEADN_FROM_BHEAD(bh) ((BHeadN *)POINTER_OFFSET(bh, -int(offsetof(BHeadN, bhead))))
 
+static BHeadN *blo_bhead_index_read_dna(FileData *fd);
+static BHeadN *blo_bhead_index_endb(FileData *fd);
+static void blo_bhead_index_free(FileData *fd);
+
 /**
  * We could change this in the future, for now it's simplest if only data is delayed
  * because ID names are used in lookup tables.
@@ -458,9 +468,11 @@ static void read_file_version(FileData *fd, Main *main)
         main->is_asset_edit_file = (fg->fileflags & G_FILE_ASSET_EDIT_FILE) != 0;
         MEM_freeN(fg);
       }
-      else if (bhead->code == BLO_CODE_ENDB) {
-        break;
-      }
+      /* There is only one global block, avoid walking over the whole file. */
+      break;
+    }
+    if (bhead->code == BLO_CODE_ENDB) {
+      break;
     }
   }
   if (main->curlib) {
@@ -491,6 +503,11 @@ static bool blo_bhead_is_id_valid_type(const BHead *bhead)
 #ifdef USE_GHASH_BHEAD
 static void read_file_bhead_idname_map_create(FileData *fd)
 {
+  if (fd->bhead_index) {
+    /* ID blocks are looked up in the index. */
+    return;
+  }
+
   BHead *bhead;
 
   /* dummy values */
@@ -608,6 +625,12 @@ void blo_readfile_invalidate(FileData *fd, Main *bmain, const char *message)
 struct BlendDataReader {
   FileData *fd;
 
+  /**
+   * Data blocks of the ID being read, when they are not stored in #FileData.datamap
+   * (see #read_libblock_deferred).
+   */
+  OldNewMap *datamap = nullptr;
+
   /**
    * The key is the old pointer to shared data that's written to a file, typically an array. The
    * corresponding value is the shared data at run-time.
@@ -688,7 +711,10 @@ static void bh8_from_bh4(BHead *bhead, BHead4 *bhead4)
   }
 }
 
-static BHeadN *get_bhead(FileData *fd)
+/**
+ * Read the block at the current position of the file.
+ */
+static BHeadN *read_bhead(FileData *fd)
 {
   BHeadN *new_bhead = nullptr;
   int64_t readsize;
@@ -822,6 +848,13 @@ static BHeadN *get_bhead(FileData *fd)
     }
   }
 
+  return new_bhead;
+}
+
+static BHeadN *get_bhead(FileData *fd)
+{
+  BHeadN *new_bhead = read_bhead(fd);
+
   /* We've read a new block. Now add it to the list
    * of blocks.
    */
@@ -870,6 +903,11 @@ BHead *blo_bhead_next(FileData *fd, BHead *thisblock)
      * We calculate the BHeadN pointer from the BHead pointer below */
     new_bhead = BHEADN_FROM_BHEAD(thisblock);
 
+    if (fd->bhead_index && new_bhead == blo_bhead_index_endb(fd)) {
+      /* Blocks read through the index end here, reading the next block of the file is wrong. */
+      return nullptr;
+    }
+
     /* get the next BHeadN. If it doesn't exist we read in the next one */
     new_bhead = new_bhead->next;
     if (new_bhead == nullptr) {
@@ -981,6 +1019,35 @@ static void decode_blender_header(FileData *fd)
   }
 }
 
+static bool read_file_dna_block(FileData *fd,
+                                const BHead *bhead,
+                                const int subversion,
+                                const char **r_error_message)
+{
+  const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
+  const bool do_alias = false; /* Postpone until after #blo_do_versions_dna runs. */
+  fd->filesdna = DNA_sdna_from_data(
+      &bhead[1], bhead->len, do_endian_swap, true, do_alias, r_error_message);
+  if (fd->filesdna) {
+    blo_do_versions_dna(fd->filesdna, fd->fileversion, subversion);
+    /* Allow aliased lookups (must be after version patching DNA). */
+    DNA_sdna_alias_data_ensure_structs_map(fd->filesdna);
+
+    fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
+    fd->reconstruct_info = DNA_reconstruct_info_create(fd->filesdna, fd->memsdna, fd->compflags);
+    /* used to retrieve ID names from (bhead+1) */
+    fd->id_name_offset = DNA_struct_member_offset_by_name_with_alias(
+        fd->filesdna, "ID", "char", "name[]");
+    BLI_assert(fd->id_name_offset != -1);
+    fd->id_asset_data_offset = DNA_struct_member_offset_by_name_with_alias(
+        fd->filesdna, "ID", "AssetMetaData", "*asset_data");
+
+    return true;
+  }
+
+  return false;
+}
+
 /**
  * \return Success if the file is read correctly, else set \a r_error_message.
  */
@@ -1004,31 +1071,21 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
       memcpy(num, fg->subvstr, 4);
       num[4] = 0;
       subversion = atoi(num);
-    }
-    else if (bhead->code == BLO_CODE_DNA1) {
-      const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
-      const bool do_alias = false; /* Postpone until after #blo_do_versions_dna runs. */
-      fd->filesdna = DNA_sdna_from_data(
-          &bhead[1], bhead->len, do_endian_swap, true, do_alias, r_error_message);
-      if (fd->filesdna) {
-        blo_do_versions_dna(fd->filesdna, fd->fileversion, subversion);
-        /* Allow aliased lookups (must be after version patching DNA). */
-        DNA_sdna_alias_data_ensure_structs_map(fd->filesdna);
-
-        fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
-        fd->reconstruct_info = DNA_reconstruct_info_create(
-            fd->filesdna, fd->memsdna, fd->compflags);
-        /* used to retrieve ID names from (bhead+1) */
-        fd->id_name_offset = DNA_struct_member_offset_by_name_with_alias(
-            fd->filesdna, "ID", "char", "name[]");
-        BLI_assert(fd->id_name_offset != -1);
-        fd->id_asset_data_offset = DNA_struct_member_offset_by_name_with_alias(
-            fd->filesdna, "ID", "AssetMetaData", "*asset_data");
 
-        return true;
+      if (fd->bhead_index) {
+        /* Read the DNA directly instead of walking over all the blocks before it. */
+        if (BHeadN *dna_bhead = blo_bhead_index_read_dna(fd)) {
+          const bool success = read_file_dna_block(
+              fd, &dna_bhead->bhead, subversion, r_error_message);
+          MEM_freeN(dna_bhead);
+          return success;
+        }
+        /* The index doesn't match the file, don't use it at all. */
+        blo_bhead_index_free(fd);
       }
-
-      return false;
+    }
+    else if (bhead->code == BLO_CODE_DNA1) {
+      return read_file_dna_block(fd, bhead, subversion, r_error_message);
     }
     else if (bhead->code == BLO_CODE_ENDB) {
       break;
@@ -1081,6 +1138,252 @@ static int *read_file_thumbnail(FileData *fd)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Block Index
+ *
+ * When the file has a block index (see #BlendFileIndexHeader), ID blocks are looked up in it and
+ * read on demand, together with their data blocks, instead of reading through the whole file.
+ * \{ */
+
+struct BHeadIndex {
+  /** Offset of the #BLO_CODE_DNA1 block. */
+  uint64_t dna_offset;
+  blender::Array<BlendFileIndexEntry> entries;
+  /** Linkable IDs by their full name (including the ID code). */
+  blender::Map<blender::StringRefNull, int> entry_by_idname;
+  blender::Map<uint64_t, int> entry_by_old;
+  /** Blocks read for each entry, null until they are needed. */
+  blender::Array<BHead *> bheads;
+  /** All blocks read through the index, they are not part of #FileData.bhead_list. */
+  blender::Vector<BHeadN *> allocated_bheads;
+  /** Terminates the list of blocks read for an entry. */
+  BHeadN endb;
+};
+
+static BHeadIndex *blo_bhead_index_read_impl(FileData *fd)
+{
+  BlendFileIndexFooter footer;
+  const off64_t footer_offset = fd->file->seek(fd->file, -off64_t(sizeof(footer)), SEEK_END);
+  if (footer_offset == -1 ||
+      fd->file->read(fd->file, &footer, sizeof(footer)) != sizeof(footer) ||
+      memcmp(footer.magic, BLEND_FILE_INDEX_MAGIC, sizeof(footer.magic)) != 0)
+  {
+    return nullptr;
+  }
+  if (footer.index_offset < SIZEOFBLENDERHEADER ||
+      footer.index_offset >= uint64_t(footer_offset) ||
+      fd->file->seek(fd->file, off64_t(footer.index_offset), SEEK_SET) == -1)
+  {
+    return nullptr;
+  }
+
+  BHead bhead;
+  BlendFileIndexHeader header;
+  if (fd->file->read(fd->file, &bhead, sizeof(bhead)) != sizeof(bhead) ||
+      bhead.code != BLO_CODE_BIDX || bhead.len < int(sizeof(header)) ||
+      /* The index block must end where the footer starts, this also avoids allocating a huge
+       * number of entries for corrupt files. */
+      footer.index_offset + sizeof(bhead) + uint64_t(bhead.len) != uint64_t(footer_offset) ||
+      fd->file->read(fd->file, &header, sizeof(header)) != sizeof(header) ||
+      (uint64_t(bhead.len) - sizeof(header)) % sizeof(BlendFileIndexEntry) != 0 ||
+      header.entries_num != (uint64_t(bhead.len) - sizeof(header)) / sizeof(BlendFileIndexEntry) ||
+      header.dna_offset < SIZEOFBLENDERHEADER || header.dna_offset >= footer.index_offset)
+  {
+    return nullptr;
+  }
+
+  BHeadIndex *index = MEM_new<BHeadIndex>(__func__);
+  index->dna_offset = header.dna_offset;
+  index->entries.reinitialize(int64_t(header.entries_num));
+  const int64_t entries_size = index->entries.as_span().size_in_bytes();
+  if (fd->file->read(fd->file, index->entries.data(), size_t(entries_size)) != entries_size ||
+      BLI_hash_mm2(reinterpret_cast<const uchar *>(index->entries.data()),
+                   size_t(entries_size),
+                   0) != header.entries_hash)
+  {
+    MEM_delete(index);
+    return nullptr;
+  }
+
+  for (const int i : index->entries.index_range()) {
+    BlendFileIndexEntry &entry = index->entries[i];
+    entry.name[sizeof(entry.name) - 1] = '\0';
+    if (entry.offset < SIZEOFBLENDERHEADER || entry.offset >= footer.index_offset ||
+        entry.library >= i || (entry.library >= 0 && index->entries[entry.library].code != ID_LI))
+    {
+      MEM_delete(index);
+      return nullptr;
+    }
+    index->entry_by_old.add(entry.old, i);
+    if (BKE_idtype_idcode_is_valid(short(entry.code)) &&
+        BKE_idtype_idcode_is_linkable(short(entry.code)))
+    {
+      index->entry_by_idname.add(entry.name, i);
+    }
+  }
+
+  index->bheads = blender::Array<BHead *>(index->entries.size(), nullptr);
+  index->endb.next = index->endb.prev = nullptr;
+#ifdef USE_BHEAD_READ_ON_DEMAND
+  index->endb.file_offset = 0;
+  index->endb.has_data = true;
+#endif
+  index->endb.is_memchunk_identical = false;
+  index->endb.bhead = {};
+  index->endb.bhead.code = BLO_CODE_ENDB;
+  return index;
+}
+
+/**
+ * Read the block index of the file if it has one that can be used.
+ */
+static void blo_bhead_index_read(FileData *fd)
+{
+  /* The index is only usable when blocks can be read directly from the file. */
+  if (fd->file->seek == nullptr ||
+      (fd->flags & (FD_FLAGS_SWITCH_ENDIAN | FD_FLAGS_POINTSIZE_DIFFERS | FD_FLAGS_IS_MEMFILE)))
+  {
+    return;
+  }
+
+  const off64_t offset_backup = fd->file->offset;
+  fd->bhead_index = blo_bhead_index_read_impl(fd);
+  if (fd->file->seek(fd->file, offset_backup, SEEK_SET) == -1) {
+    fd->is_eof = true;
+  }
+}
+
+static void blo_bhead_index_free(FileData *fd)
+{
+  if (fd->bhead_index == nullptr) {
+    return;
+  }
+  for (BHeadN *new_bhead : fd->bhead_index->allocated_bheads) {
+    MEM_freeN(new_bhead);
+  }
+  MEM_delete(fd->bhead_index);
+  fd->bhead_index = nullptr;
+}
+
+/**
+ * Read the block at \a offset and the data blocks following it, without changing the current
+ * position in the file.
+ */
+static BHead *blo_bhead_index_read_blocks(FileData *fd, const uint64_t offset, const int code)
+{
+  BHeadIndex &index = *fd->bhead_index;
+  const off64_t offset_backup = fd->file->offset;
+  const bool is_eof_backup = fd->is_eof;
+
+  BHeadN *first = nullptr;
+  BHeadN *last = nullptr;
+  if (offset <= uint64_t(std::numeric_limits<off64_t>::max()) &&
+      fd->file->seek(fd->file, off64_t(offset), SEEK_SET) != -1)
+  {
+    fd->is_eof = false;
+    while (BHeadN *new_bhead = read_bhead(fd)) {
+      const int expected_code = (first == nullptr) ? code : int(BLO_CODE_DATA);
+      if (new_bhead->bhead.code != expected_code) {
+        MEM_freeN(new_bhead);
+        break;
+      }
+      index.allocated_bheads.append(new_bhead);
+      new_bhead->prev = last;
+      if (last) {
+        last->next = new_bhead;
+      }
+      else {
+        first = new_bhead;
+      }
+      last = new_bhead;
+    }
+  }
+
+  fd->is_eof = is_eof_backup;
+  if (fd->file->seek(fd->file, offset_backup, SEEK_SET) == -1) {
+    fd->is_eof = true;
+  }
+
+  if (first == nullptr) {
+    return nullptr;
+  }
+  last->next = &index.endb;
+  return &first->bhead;
+}
+
+blender::Span<BlendFileIndexEntry> blo_bhead_index_entries(const FileData *fd)
+{
+  if (fd->bhead_index == nullptr) {
+    return {};
+  }
+  return fd->bhead_index->entries;
+}
+
+BHead *blo_bhead_index_block(FileData *fd, const int entry_index)
+{
+  BHeadIndex &index = *fd->bhead_index;
+  if (BHead *bhead = index.bheads[entry_index]) {
+    return bhead;
+  }
+
+  const BlendFileIndexEntry &entry = index.entries[entry_index];
+  BHead *bhead = blo_bhead_index_read_blocks(fd, entry.offset, entry.code);
+  if (bhead == nullptr) {
+    return nullptr;
+  }
+  if (entry.library >= 0) {
+    /* Placeholders are found by walking back to their library, see #find_previous_lib. */
+    if (BHead *bhead_lib = blo_bhead_index_block(fd, entry.library)) {
+      BHEADN_FROM_BHEAD(bhead)->prev = BHEADN_FROM_BHEAD(bhead_lib);
+    }
+  }
+  index.bheads[entry_index] = bhead;
+  return bhead;
+}
+
+static BHead *blo_bhead_index_find_idname(FileData *fd, const char *idname)
+{
+  const int *entry_index = fd->bhead_index->entry_by_idname.lookup_ptr(idname);
+  return entry_index ? blo_bhead_index_block(fd, *entry_index) : nullptr;
+}
+
+static BHead *blo_bhead_index_find_old(FileData *fd, const void *old)
+{
+  const int *entry_index = fd->bhead_index->entry_by_old.lookup_ptr(uint64_t(uintptr_t(old)));
+  return entry_index ? blo_bhead_index_block(fd, *entry_index) : nullptr;
+}
+
+static BHeadN *blo_bhead_index_endb(FileData *fd)
+{
+  return &fd->bhead_index->endb;
+}
+
+/**
+ * Read the #BLO_CODE_DNA1 block directly, without adding it to #FileData.bhead_list.
+ */
+static BHeadN *blo_bhead_index_read_dna(FileData *fd)
+{
+  const off64_t offset_backup = fd->file->offset;
+  const bool is_eof_backup = fd->is_eof;
+  BHeadN *new_bhead = nullptr;
+  if (fd->bhead_index->dna_offset <= uint64_t(std::numeric_limits<off64_t>::max()) &&
+      fd->file->seek(fd->file, off64_t(fd->bhead_index->dna_offset), SEEK_SET) != -1)
+  {
+    new_bhead = read_bhead(fd);
+    if (new_bhead && new_bhead->bhead.code != BLO_CODE_DNA1) {
+      MEM_freeN(new_bhead);
+      new_bhead = nullptr;
+    }
+  }
+  fd->is_eof = is_eof_backup;
+  if (fd->file->seek(fd->file, offset_backup, SEEK_SET) == -1) {
+    fd->is_eof = true;
+  }
+  return new_bhead;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name File Data API
  * \{ */
@@ -1152,11 +1455,21 @@ static bool is_minversion_older_than_blender(FileData *fd, ReportList *reports)
   return false;
 }
 
-static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
+/**
+ * \param use_block_index: Read the block index of the file if it has one. It only helps when a few
+ * IDs are read from the file, like when linking, reading the whole file doesn't use it.
+ */
+static FileData *blo_decode_and_check(FileData *fd,
+                                      ReportList *reports,
+                                      const bool use_block_index)
 {
   decode_blender_header(fd);
 
   if (fd->flags & FD_FLAGS_FILE_OK) {
+    if (use_block_index) {
+      blo_bhead_index_read(fd);
+    }
+
     const char *error_message = nullptr;
     if (read_file_dna(fd, &error_message) == false) {
       BKE_reportf(
@@ -1260,14 +1573,16 @@ static FileData *blo_filedata_from_file_open(const char *filepath, BlendFileRead
   return blo_filedata_from_file_descriptor(filepath, reports, file);
 }
 
-FileData *blo_filedata_from_file(const char *filepath, BlendFileReadReport *reports)
+FileData *blo_filedata_from_file(const char *filepath,
+                                 BlendFileReadReport *reports,
+                                 const bool use_block_index)
 {
   FileData *fd = blo_filedata_from_file_open(filepath, reports);
   if (fd != nullptr) {
     /* needed for library_append and read_libraries */
     STRNCPY(fd->relabase, filepath);
 
-    return blo_decode_and_check(fd, reports->reports);
+    return blo_decode_and_check(fd, reports->reports, use_block_index);
   }
   return nullptr;
 }
@@ -1290,7 +1605,10 @@ static FileData *blo_filedata_from_file_minimal(const char *filepath)
   return nullptr;
 }
 
-FileData *blo_filedata_from_memory(const void *mem, int memsize, BlendFileReadReport *reports)
+FileData *blo_filedata_from_memory(const void *mem,
+                                   int memsize,
+                                   BlendFileReadReport *reports,
+                                   const bool use_block_index)
 {
   if (!mem || memsize < SIZEOFBLENDERHEADER) {
     BKE_report(
@@ -1317,7 +1635,7 @@ FileData *blo_filedata_from_memory(const void *mem, int memsize, BlendFileReadRe
   FileData *fd = filedata_new(reports);
   fd->file = file;
 
-  return blo_decode_and_check(fd, reports->reports);
+  return blo_decode_and_check(fd, reports->reports, use_block_index);
 }
 
 FileData *blo_filedata_from_memfile(MemFile *memfile,
@@ -1334,7 +1652,7 @@ FileData *blo_filedata_from_memfile(MemFile *memfile,
   fd->undo_direction = params->undo_direction;
   fd->flags |= FD_FLAGS_IS_MEMFILE;
 
-  return blo_decode_and_check(fd, reports->reports);
+  return blo_decode_and_check(fd, reports->reports, false);
 }
 
 void blo_filedata_free(FileData *fd)
@@ -1390,6 +1708,7 @@ void blo_filedata_free(FileData *fd)
     BLI_ghash_free(fd->bhead_idname_hash, nullptr, nullptr);
   }
 #endif
+  blo_bhead_index_free(fd);
 
   MEM_freeN(fd);
 }
@@ -1450,12 +1769,6 @@ static void *newdataadr(FileData *fd, const void *adr)
   return oldnewmap_lookup_and_inc(fd->datamap, adr, true);
 }
 
-/* Only direct data-blocks. */
-static void *newdataadr_no_us(FileData *fd, const void *adr)
-{
-  return oldnewmap_lookup_and_inc(fd->datamap, adr, false);
-}
-
 void *blo_read_get_new_globaldata_address(FileData *fd, const void *adr)
 {
   return oldnewmap_lookup_and_inc(fd->globmap, adr, true);
@@ -2347,9 +2660,11 @@ static const char *idtype_alloc_name_get(short id_code)
   return id_alloc_names[INDEX_ID_NULL].c_str();
 }
 
-static bool direct_link_id(FileData *fd, Main *main, const int tag, ID *id, ID *id_old)
+static bool direct_link_id(
+    FileData *fd, Main *main, const int tag, ID *id, ID *id_old, OldNewMap *datamap)
 {
   BlendDataReader reader = {fd};
+  reader.datamap = datamap;
   /* Sharing is only allowed within individual data-blocks currently. The clearing is done
    * explicitly here, in case the `reader` is used by multiple IDs in the future. */
   reader.shared_data_by_stored_address.clear();
@@ -2394,7 +2709,10 @@ static bool direct_link_id(FileData *fd, Main *main, const int tag, ID *id, ID *
 }
 
 /* Read all data associated with a datablock into datamap. */
-static BHead *read_data_into_datamap(FileData *fd, BHead *bhead, const char *allocname)
+static BHead *read_data_into_datamap(FileData *fd,
+                                    BHead *bhead,
+                                    const char *allocname,
+                                    OldNewMap *datamap)
 {
   bhead = blo_bhead_next(fd, bhead);
 
@@ -2421,7 +2739,7 @@ static BHead *read_data_into_datamap(FileData *fd, BHead *bhead, const char *all
 
     void *data = read_struct(fd, bhead, allocname);
     if (data) {
-      const bool is_new = oldnewmap_insert(fd->datamap, bhead->old, data, 0);
+      const bool is_new = oldnewmap_insert(datamap, bhead->old, data, 0);
       if (!is_new) {
         CLOG_ERROR(&LOG,
                    "Blendfile corruption: Invalid, or multiple `bhead` with same old address "
@@ -2889,7 +3207,7 @@ static BHead *read_libblock(FileData *fd,
       }
     }
 
-    direct_link_id(fd, main, id_tag, id, id_old);
+    direct_link_id(fd, main, id_tag, id, id_old, fd->datamap);
 
     if (main->id_map != nullptr) {
       BKE_main_idmap_insert_id(main->id_map, id);
@@ -2901,8 +3219,8 @@ static BHead *read_libblock(FileData *fd,
   /* Read datablock contents.
    * Use convenient malloc name for debugging and better memory link prints. */
   const char *allocname = idtype_alloc_name_get(idcode);
-  bhead = read_data_into_datamap(fd, bhead, allocname);
-  const bool success = direct_link_id(fd, main, id_tag, id, id_old);
+  bhead = read_data_into_datamap(fd, bhead, allocname, fd->datamap);
+  const bool success = direct_link_id(fd, main, id_tag, id, id_old, fd->datamap);
   oldnewmap_clear(fd->datamap);
 
   if (!success) {
@@ -2931,6 +3249,126 @@ static BHead *read_libblock(FileData *fd,
   return bhead;
 }
 
+/**
+ * An ID read by #read_libblock_deferred, its data still has to be linked.
+ */
+struct DeferredLibBlock {
+  Main *main;
+  ID *id;
+  int id_tag;
+  /** The data blocks of the ID. */
+  OldNewMap *datamap;
+};
+
+/**
+ * Whether the data of IDs of this type can be linked on another thread than the one reading the
+ * file. This is only the case for types whose `blend_read_data` was checked to only access the
+ * data of the ID itself through the #BlendDataReader. Other types may access data shared between
+ * IDs (e.g. #FileData.globmap) or modify the main database, they are read on the main thread.
+ */
+static bool read_libblock_can_defer(const int idcode)
+{
+  switch (idcode) {
+    case ID_AC:
+    case ID_AR:
+    case ID_CA:
+    case ID_CU_LEGACY:
+    case ID_CV:
+    case ID_GR:
+    case ID_IM:
+    case ID_KE:
+    case ID_LA:
+    case ID_LP:
+    case ID_LT:
+    case ID_MA:
+    case ID_MB:
+    case ID_ME:
+    case ID_NT:
+    case ID_OB:
+    case ID_PAL:
+    case ID_PT:
+    case ID_SPK:
+    case ID_TE:
+    case ID_TXT:
+    case ID_WO:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Same as #read_libblock for local IDs when reading a file (not undo), but only reads the blocks
+ * of the ID into memory. Linking its data is done by #read_libblocks_deferred_finish, which can
+ * process many IDs in parallel.
+ */
+static BHead *read_libblock_deferred(FileData *fd,
+                                     Main *main,
+                                     BHead *bhead,
+                                     const int id_tag,
+                                     blender::Vector<DeferredLibBlock> &r_deferred)
+{
+  BLI_assert((fd->flags & FD_FLAGS_IS_MEMFILE) == 0);
+
+  if (!read_libblock_can_defer(bhead->code)) {
+    return read_libblock(fd, main, bhead, id_tag, false, nullptr);
+  }
+
+  ID *id = static_cast<ID *>(read_struct(fd, bhead, "lib block"));
+  if (id == nullptr) {
+    return blo_bhead_next(fd, bhead);
+  }
+
+  const short idcode = GS(id->name);
+  ListBase *lb = which_libbase(main, idcode);
+  if (lb == nullptr) {
+    /* Unknown ID type. */
+    CLOG_WARN(&LOG, "Unknown id code '%c%c'", (idcode & 0xff), (idcode >> 8));
+    MEM_freeN(id);
+    return blo_bhead_next(fd, bhead);
+  }
+
+  BLI_addtail(lb, id);
+  oldnewmap_lib_insert(fd, bhead->old, id, bhead->code);
+
+  DeferredLibBlock deferred;
+  deferred.main = main;
+  deferred.id = id;
+  deferred.id_tag = id_tag | LIB_TAG_NEED_LINK | LIB_TAG_NEW;
+  deferred.datamap = oldnewmap_new();
+  bhead = read_data_into_datamap(fd, bhead, idtype_alloc_name_get(idcode), deferred.datamap);
+  r_deferred.append(deferred);
+
+  return bhead;
+}
+
+/**
+ * Link the data of the IDs read by #read_libblock_deferred. Each ID only accesses its own data
+ * blocks, so this is done in parallel.
+ */
+static void read_libblocks_deferred_finish(FileData *fd,
+                                           blender::Vector<DeferredLibBlock> &deferred)
+{
+  using namespace blender;
+  threading::parallel_for(deferred.index_range(), 16, [&](const IndexRange range) {
+    for (DeferredLibBlock &block : deferred.as_mutable_span().slice(range)) {
+      const bool success = direct_link_id(
+          fd, block.main, block.id_tag, block.id, nullptr, block.datamap);
+      BLI_assert(success);
+      UNUSED_VARS_NDEBUG(success);
+      oldnewmap_clear(block.datamap);
+      oldnewmap_free(block.datamap);
+    }
+  });
+
+  for (const DeferredLibBlock &block : deferred) {
+    if (block.main->id_map != nullptr) {
+      BKE_main_idmap_insert_id(block.main->id_map, block.id);
+    }
+  }
+  deferred.clear();
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -2941,7 +3379,7 @@ BHead *blo_read_asset_data_block(FileData *fd, BHead *bhead, AssetMetaData **r_a
 {
   BLI_assert(blo_bhead_is_id_valid_type(bhead));
 
-  bhead = read_data_into_datamap(fd, bhead, "asset-data read");
+  bhead = read_data_into_datamap(fd, bhead, "asset-data read", fd->datamap);
 
   BlendDataReader reader = {fd};
   BLO_read_struct(&reader, AssetMetaData, r_asset_data);
@@ -3301,7 +3739,7 @@ static BHead *read_userdef(BlendFileData *bfd, FileData *fd, BHead *bhead)
   user->subversionfile = bfd->main->subversionfile;
 
   /* read all data into fd->datamap */
-  bhead = read_data_into_datamap(fd, bhead, "user def");
+  bhead = read_data_into_datamap(fd, bhead, "user def", fd->datamap);
 
   BlendDataReader reader_ = {fd};
   BlendDataReader *reader = &reader_;
@@ -3519,6 +3957,10 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
     read_undo_reuse_noundo_local_ids(fd);
   }
 
+  /* Link the data of IDs on multiple threads, after reading all blocks. */
+  const bool use_deferred_read = !is_undo && USER_EXPERIMENTAL_TEST(&U, use_parallel_file_read);
+  blender::Vector<DeferredLibBlock> deferred_libblocks;
+
   while (bhead) {
     switch (bhead->code) {
       case BLO_CODE_DATA:
@@ -3564,16 +4006,22 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
         if (fd->skip_flags & BLO_READ_SKIP_DATA) {
           bhead = blo_bhead_next(fd, bhead);
         }
+        else if (use_deferred_read) {
+          bhead = read_libblock_deferred(fd, bfd->main, bhead, LIB_TAG_LOCAL, deferred_libblocks);
+        }
         else {
           bhead = read_libblock(fd, bfd->main, bhead, LIB_TAG_LOCAL, false, nullptr);
         }
     }
 
     if (bfd->main->is_read_invalid) {
+      read_libblocks_deferred_finish(fd, deferred_libblocks);
       return bfd;
     }
   }
 
+  read_libblocks_deferred_finish(fd, deferred_libblocks);
+
   if (is_undo) {
     /* Move the remaining Library IDs and their linked data to the new main.
      *
@@ -3818,6 +4266,10 @@ static BHead *find_bhead(FileData *fd, void *old)
     return nullptr;
   }
 
+  if (fd->bhead_index) {
+    return blo_bhead_index_find_old(fd, old);
+  }
+
   if (fd->bheadmap == nullptr) {
     sort_bhead_old_map(fd);
   }
@@ -3843,6 +4295,13 @@ static BHead *find_bhead(FileData *fd, void *old)
 
 static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const char *name)
 {
+  if (fd->bhead_index) {
+    char idname_full[MAX_ID_NAME];
+    *((short *)idname_full) = idcode;
+    BLI_strncpy(idname_full + 2, name, sizeof(idname_full) - 2);
+    return blo_bhead_index_find_idname(fd, idname_full);
+  }
+
 #ifdef USE_GHASH_BHEAD
 
   char idname_full[MAX_ID_NAME];
@@ -3873,6 +4332,9 @@ static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const
 
 static BHead *find_bhead_from_idname(FileData *fd, const char *idname)
 {
+  if (fd->bhead_index) {
+    return blo_bhead_index_find_idname(fd, idname);
+  }
 #ifdef USE_GHASH_BHEAD
   return static_cast<BHead *>(BLI_ghash_lookup(fd->bhead_idname_hash, idname));
 #else
@@ -4744,16 +5206,21 @@ static void *blo_verify_data_address(void *new_address,
   return new_address;
 }
 
+static OldNewMap *reader_datamap(const BlendDataReader *reader)
+{
+  return reader->datamap ? reader->datamap : reader->fd->datamap;
+}
+
 void *BLO_read_get_new_data_address(BlendDataReader *reader, const void *old_address)
 {
-  return newdataadr(reader->fd, old_address);
+  return oldnewmap_lookup_and_inc(reader_datamap(reader), old_address, true);
 }
 
 void *BLO_read_get_new_data_address_no_us(BlendDataReader *reader,
                                           const void *old_address,
                                           const size_t expected_size)
 {
-  void *new_address = newdataadr_no_us(reader->fd, old_address);
+  void *new_address = oldnewmap_lookup_and_inc(reader_datamap(reader), old_address, false);
   return blo_verify_data_address(new_address, old_address, expected_size);
 }
 
@@ -4761,7 +5228,7 @@ void *BLO_read_struct_array_with_size(BlendDataReader *reader,
                                       const void *old_address,
                                       const size_t expected_size)
 {
-  void *new_address = newdataadr(reader->fd, old_address);
+  void *new_address = oldnewmap_lookup_and_inc(reader_datamap(reader), old_address, true);
   return blo_verify_data_address(new_address, old_address, expected_size);
 }
 
@@ -4936,7 +5403,7 @@ void BLO_read_pointer_array(BlendDataReader *reader, void **ptr_p)
 {
   FileData *fd = reader->fd;
 
-  void *orig_array = newdataadr(fd, *ptr_p);
+  void *orig_array = oldnewmap_lookup_and_inc(reader_datamap(reader), *ptr_p, true);
   if (orig_array == nullptr) {
     *ptr_p = nullptr;
     return;
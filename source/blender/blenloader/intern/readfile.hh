@@ -16,6 +16,9 @@
 #endif
 
 #include "BLI_filereader.h"
+#include "BLI_span.hh"
+
+#include "DNA_ID.h"
 #include "DNA_sdna_types.h"
 #include "DNA_space_types.h"
 #include "DNA_windowmanager_types.h" /* for eReportType */
@@ -26,6 +29,7 @@ struct BlendFileData;
 struct BlendFileReadParams;
 struct BlendFileReadReport;
 struct BLOCacheStorage;
+struct BHeadIndex;
 struct BHeadSort;
 struct DNA_ReconstructInfo;
 struct IDNameLib_Map;
@@ -117,6 +121,9 @@ struct FileData {
   /** See: #USE_GHASH_BHEAD. */
   GHash *bhead_idname_hash;
 
+  /** Index of ID blocks stored at the end of the file, may be null. */
+  BHeadIndex *bhead_index;
+
   ListBase *mainlist;
   /** Used for undo. */
   ListBase *old_mainlist;
@@ -140,6 +147,61 @@ struct FileData {
 
 #define SIZEOFBLENDERHEADER 12
 
+/* -------------------------------------------------------------------- */
+/** \name Block Index
+ *
+ * Files are written with an index of all ID blocks after the #BLO_CODE_ENDB block, so that
+ * older versions ignore it. It allows finding ID blocks without reading through the whole file,
+ * which is what linking from and browsing big library files needs.
+ *
+ * The index is a #BLO_CODE_BIDX block containing a #BlendFileIndexHeader followed by the
+ * entries, and the file ends with a #BlendFileIndexFooter pointing to that block. It is stored
+ * with the endianness and pointer size of the file, and is only used when these match the ones
+ * of the reader.
+ * \{ */
+
+#define BLEND_FILE_INDEX_MAGIC "BIDXFOOT"
+
+struct BlendFileIndexHeader {
+  /** Offset of the #BLO_CODE_DNA1 block. */
+  uint64_t dna_offset;
+  uint64_t entries_num;
+  /** #BLI_hash_mm2 of the entries, so that corrupt entries are not used. */
+  uint32_t entries_hash;
+  uint32_t _pad;
+};
+
+struct BlendFileIndexEntry {
+  /** Offset of the ID block in the (uncompressed) file. */
+  uint64_t offset;
+  /** #BHead.old of the ID block. */
+  uint64_t old;
+  /** #BHead.code of the ID block. */
+  int32_t code;
+  /** For #ID_LINK_PLACEHOLDER blocks, the index of the entry of their library, otherwise -1. */
+  int32_t library;
+  char name[MAX_ID_NAME];
+};
+
+struct BlendFileIndexFooter {
+  /** Offset of the #BLO_CODE_BIDX block. */
+  uint64_t index_offset;
+  char magic[8];
+};
+
+/**
+ * The entries of the file's block index, empty when the file has no (usable) index.
+ */
+blender::Span<BlendFileIndexEntry> blo_bhead_index_entries(const FileData *fd);
+/**
+ * Read the ID block of the given index entry and the data blocks following it. They can be
+ * iterated with #blo_bhead_next, the last data block is followed by a #BLO_CODE_ENDB block, which
+ * has no next block.
+ */
+BHead *blo_bhead_index_block(FileData *fd, int entry_index);
+
+/** \} */
+
 /***/
 void blo_join_main(ListBase *mainlist);
 void blo_split_main(ListBase *mainlist, Main *main);
@@ -151,8 +213,13 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath) ATTR_N
  *
  * cannot be called with relative paths anymore!
  */
-FileData *blo_filedata_from_file(const char *filepath, BlendFileReadReport *reports);
-FileData *blo_filedata_from_memory(const void *mem, int memsize, BlendFileReadReport *reports);
+FileData *blo_filedata_from_file(const char *filepath,
+                                 BlendFileReadReport *reports,
+                                 bool use_block_index = false);
+FileData *blo_filedata_from_memory(const void *mem,
+                                   int memsize,
+                                   BlendFileReadReport *reports,
+                                   bool use_block_index = false);
 FileData *blo_filedata_from_memfile(MemFile *memfile,
                                     const BlendFileReadParams *params,
                                     BlendFileReadReport *reports);
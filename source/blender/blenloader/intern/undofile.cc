@@ -20,12 +20,15 @@
 #  include <io.h>
 #endif
 
+#include <xxhash.h>
+
 #include "MEM_guardedalloc.h"
 
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
 #include "BLI_implicit_sharing.hh"
+#include "BLI_map.hh"
 
 #include "BLO_readfile.hh"
 #include "BLO_undofile.hh"
@@ -38,17 +41,109 @@
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/**
+ * Header of a chunk buffer, the content of the chunk follows it.
+ */
+struct MemFileChunkBuffer {
+  /** Next buffer with the same hash. */
+  MemFileChunkBuffer *next_same_hash;
+  uint64_t hash;
+  size_t size;
+  /** Number of chunks using this buffer. */
+  int users;
+};
+
+struct MemFileChunkStorage {
+  /** First buffer for each content hash. */
+  blender::Map<uint64_t, MemFileChunkBuffer *> buffers;
+  /** Number of #MemFile using this storage. */
+  int users = 0;
+};
+
+static MemFileChunkBuffer *memfile_chunk_buffer_from_data(const char *buf)
+{
+  return reinterpret_cast<MemFileChunkBuffer *>(const_cast<char *>(buf)) - 1;
+}
+
+static const char *memfile_chunk_buffer_data(const MemFileChunkBuffer *buffer)
+{
+  return reinterpret_cast<const char *>(buffer + 1);
+}
+
+static void memfile_chunk_buffer_add_user(const char *buf)
+{
+  memfile_chunk_buffer_from_data(buf)->users++;
+}
+
+static void memfile_chunk_buffer_remove_user(MemFileChunkStorage *storage, const char *buf)
+{
+  MemFileChunkBuffer *buffer = memfile_chunk_buffer_from_data(buf);
+  BLI_assert(buffer->users > 0);
+  if (--buffer->users > 0) {
+    return;
+  }
+
+  MemFileChunkBuffer **buffer_p = &storage->buffers.lookup(buffer->hash);
+  while (*buffer_p != buffer) {
+    buffer_p = &(*buffer_p)->next_same_hash;
+  }
+  *buffer_p = buffer->next_same_hash;
+  if (storage->buffers.lookup(buffer->hash) == nullptr) {
+    storage->buffers.remove(buffer->hash);
+  }
+  MEM_freeN(buffer);
+}
+
+/**
+ * Find a buffer with the same content in the storage, or add a copy of \a buf to it.
+ * \return The data of the buffer, with a user added for the caller.
+ */
+static const char *memfile_chunk_buffer_ensure(MemFileChunkStorage *storage,
+                                               const char *buf,
+                                               const size_t size,
+                                               bool *r_is_new)
+{
+  const uint64_t hash = XXH3_64bits(buf, size);
+  MemFileChunkBuffer *&first = storage->buffers.lookup_or_add(hash, nullptr);
+  for (MemFileChunkBuffer *buffer = first; buffer; buffer = buffer->next_same_hash) {
+    const char *data = memfile_chunk_buffer_data(buffer);
+    if (buffer->size == size && memcmp(data, buf, size) == 0) {
+      buffer->users++;
+      *r_is_new = false;
+      return data;
+    }
+  }
+
+  MemFileChunkBuffer *buffer = static_cast<MemFileChunkBuffer *>(
+      MEM_mallocN(sizeof(MemFileChunkBuffer) + size, "Chunk buffer"));
+  buffer->next_same_hash = first;
+  buffer->hash = hash;
+  buffer->size = size;
+  buffer->users = 1;
+  char *data = reinterpret_cast<char *>(buffer + 1);
+  memcpy(data, buf, size);
+  first = buffer;
+  *r_is_new = true;
+  return data;
+}
+
 void BLO_memfile_free(MemFile *memfile)
 {
   while (MemFileChunk *chunk = static_cast<MemFileChunk *>(BLI_pophead(&memfile->chunks))) {
-    if (chunk->is_identical == false) {
-      MEM_freeN((void *)chunk->buf);
-    }
+    memfile_chunk_buffer_remove_user(memfile->chunk_storage, chunk->buf);
     MEM_freeN(chunk);
   }
+  if (memfile->chunk_storage != nullptr) {
+    if (--memfile->chunk_storage->users == 0) {
+      BLI_assert(memfile->chunk_storage->buffers.is_empty());
+      MEM_delete(memfile->chunk_storage);
+    }
+    memfile->chunk_storage = nullptr;
+  }
   MEM_delete(memfile->shared_storage);
   memfile->shared_storage = nullptr;
   memfile->size = 0;
+  memfile->size_deduplicated = 0;
 }
 
 MemFileSharedStorage::~MemFileSharedStorage()
@@ -61,29 +156,25 @@ MemFileSharedStorage::~MemFileSharedStorage()
 
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
-  /* We use this mapping to store the memory buffers from second memfile chunks which are not owned
-   * by it (i.e. shared with some previous memory steps). */
+  /* Buffers are reference counted by the chunk storage, so there is no ownership to transfer.
+   * Chunks of the second memfile which were identical to chunks changed in the first memfile are
+   * not identical to the step before the first one anymore though. */
   blender::Map<const char *, MemFileChunk *> buffer_to_second_memchunk;
 
-  /* First, detect all memchunks in second memfile that are not owned by it. */
+  /* First, detect all memchunks in second memfile that are identical to the previous step. */
   LISTBASE_FOREACH (MemFileChunk *, sc, &second->chunks) {
     if (sc->is_identical) {
       buffer_to_second_memchunk.add(sc->buf, sc);
     }
   }
 
-  /* Now, check all chunks from first memfile (the one we are removing), and if a memchunk owned by
-   * it is also used by the second memfile, transfer the ownership. */
+  /* Now, check all chunks that changed in the first memfile (the one we are removing). */
   LISTBASE_FOREACH (MemFileChunk *, fc, &first->chunks) {
     if (!fc->is_identical) {
       if (MemFileChunk *sc = buffer_to_second_memchunk.lookup_default(fc->buf, nullptr)) {
         BLI_assert(sc->is_identical);
         sc->is_identical = false;
-        fc->is_identical = true;
       }
-      /* Note that if the second memfile does not use that chunk, we assume that the first one
-       * fully owns it without sharing it with any other memfile, and hence it should be freed with
-       * it. */
     }
   }
 
@@ -107,6 +198,14 @@ void BLO_memfile_write_init(MemFileWriteData *mem_data,
                                                               reference_memfile->chunks.first) :
                                                           nullptr;
 
+  /* Share the chunk storage with the previous steps. */
+  if (written_memfile->chunk_storage == nullptr) {
+    written_memfile->chunk_storage = (reference_memfile && reference_memfile->chunk_storage) ?
+                                         reference_memfile->chunk_storage :
+                                         MEM_new<MemFileChunkStorage>(__func__);
+    written_memfile->chunk_storage->users++;
+  }
+
   /* If we have a reference memfile, we generate a mapping between the session_uid's of the
    * IDs stored in that previous undo step, and its first matching memchunk. This will allow
    * us to easily find the existing undo memory storage of IDs even when some re-ordering in
@@ -153,17 +252,22 @@ void BLO_memfile_chunk_add(MemFileWriteData *mem_data, const char *buf, size_t s
         curchunk->buf = compchunk->buf;
         curchunk->is_identical = true;
         compchunk->is_identical_future = true;
+        memfile_chunk_buffer_add_user(curchunk->buf);
       }
     }
     *compchunk_step = static_cast<MemFileChunk *>(compchunk->next);
   }
 
-  /* not equal... */
+  /* not equal, look for the same content anywhere in the previous steps. */
   if (curchunk->buf == nullptr) {
-    char *buf_new = static_cast<char *>(MEM_mallocN(size, "Chunk buffer"));
-    memcpy(buf_new, buf, size);
-    curchunk->buf = buf_new;
-    memfile->size += size;
+    bool is_new;
+    curchunk->buf = memfile_chunk_buffer_ensure(memfile->chunk_storage, buf, size, &is_new);
+    if (is_new) {
+      memfile->size += size;
+    }
+    else {
+      memfile->size_deduplicated += size;
+    }
   }
 }
 
@@ -91,13 +91,17 @@
 #include "BLI_blenlib.h"
 #include "BLI_endian_defines.h"
 #include "BLI_endian_switch.h"
+#include "BLI_hash_mm2a.hh"
 #include "BLI_implicit_sharing.hh"
 #include "BLI_link_utils.h"
 #include "BLI_linklist.h"
 #include "BLI_math_base.h"
 #include "BLI_mempool.h"
+#include "BLI_array.hh"
 #include "BLI_set.hh"
+#include "BLI_task.hh"
 #include "BLI_threads.h"
+#include "BLI_vector.hh"
 
 #include "MEM_guardedalloc.h" /* MEM_freeN */
 
@@ -168,6 +172,8 @@ class WriteWrap {
 
   /** Buffer output (we only want when output isn't already buffered). */
   bool use_buf = true;
+  /** Data is kept in memory, the file is written by #BLO_write_file_buffer_flush. */
+  bool use_deferred_write = false;
 };
 
 class RawWriteWrap : public WriteWrap {
@@ -393,6 +399,47 @@ bool ZstdWriteWrap::write(const void *buf, size_t buf_len)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Deferred Writing
+ *
+ * Store the file data in memory, so it can be written to disk later on another thread.
+ * \{ */
+
+class MemWriteWrap : public WriteWrap {
+ public:
+  MemWriteWrap()
+  {
+    use_deferred_write = true;
+  }
+
+  bool open(const char * /*filepath*/) override
+  {
+    return true;
+  }
+  bool close() override
+  {
+    return true;
+  }
+  bool write(const void *buf, size_t buf_len) override
+  {
+    chunks.append(blender::Array<uchar>(
+        blender::Span<uchar>(static_cast<const uchar *>(buf), int64_t(buf_len))));
+    return true;
+  }
+
+  /** Data passed to #write, chunk sizes match the buffer size of #WriteData. */
+  blender::Vector<blender::Array<uchar>> chunks;
+};
+
+struct BlendFileWriteBuffer {
+  char filepath[FILE_MAX];
+  int write_flags;
+  bool use_save_versions;
+  MemWriteWrap data;
+};
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Write Data Type & Functions
  * \{ */
@@ -417,6 +464,17 @@ struct WriteData {
   size_t write_len;
 #endif
 
+  /** Offset in the file of the next written data (before compression). */
+  uint64_t file_offset;
+
+  /** Block index written at the end of the file, see #BlendFileIndexHeader. Not used for undo. */
+  struct {
+    blender::Vector<BlendFileIndexEntry> entries;
+    uint64_t dna_offset;
+    /** Entry of the last written library, placeholder IDs following it belong to it. */
+    int library;
+  } index;
+
   /** Whether writefile code is currently writing an ID. */
   bool is_writing_id;
 
@@ -451,6 +509,12 @@ struct WriteData {
    * Will be nullptr for UNDO.
    */
   WriteWrap *ww;
+
+  /**
+   * When set, data is appended to this buffer instead of being written to the file,
+   * see #write_ids_parallel.
+   */
+  blender::Vector<uchar> *capture_buffer;
 };
 
 struct BlendWriter {
@@ -464,6 +528,7 @@ static WriteData *writedata_new(WriteWrap *ww)
   wd->sdna = DNA_sdna_current_get();
 
   wd->ww = ww;
+  wd->index.library = -1;
 
   if ((ww == nullptr) || (ww->use_buf)) {
     if (ww == nullptr) {
@@ -480,6 +545,22 @@ static WriteData *writedata_new(WriteWrap *ww)
   return wd;
 }
 
+/**
+ * Create a #WriteData storing all written data in \a r_buffer, used to serialize IDs on
+ * separate threads. The data is not buffered further, and offsets in the block index are
+ * relative to the start of \a r_buffer.
+ */
+static WriteData *writedata_new_capture(blender::Vector<uchar> &r_buffer)
+{
+  WriteData *wd = MEM_new<WriteData>(__func__);
+
+  wd->sdna = DNA_sdna_current_get();
+  wd->index.library = -1;
+  wd->capture_buffer = &r_buffer;
+
+  return wd;
+}
+
 static void writedata_do_write(WriteData *wd, const void *mem, size_t memlen)
 {
   if ((wd == nullptr) || wd->validation_data.critical_error || (mem == nullptr) || memlen < 1) {
@@ -499,6 +580,10 @@ static void writedata_do_write(WriteData *wd, const void *mem, size_t memlen)
   if (wd->use_memfile) {
     BLO_memfile_chunk_add(&wd->mem, static_cast<const char *>(mem), memlen);
   }
+  else if (wd->capture_buffer) {
+    wd->capture_buffer->extend(
+        blender::Span<uchar>(static_cast<const uchar *>(mem), int64_t(memlen)));
+  }
   else {
     if (!wd->ww->write(mem, memlen)) {
       wd->validation_data.critical_error = true;
@@ -551,6 +636,7 @@ static void mywrite(WriteData *wd, const void *adr, size_t len)
 #ifdef USE_WRITE_DATA_LEN
   wd->write_len += len;
 #endif
+  wd->file_offset += len;
 
   if (wd->buffer.buf == nullptr) {
     writedata_do_write(wd, adr, len);
@@ -717,6 +803,27 @@ static bool write_at_address_validate(WriteData *wd, int filecode, const void *a
   return true;
 }
 
+/**
+ * Add ID blocks to the block index, before writing them.
+ */
+static void write_index_add_block(WriteData *wd, const BHead &bh, const void *data)
+{
+  /* Only ID blocks have codes with the two most-significant bytes being zero. */
+  if (wd->use_memfile || bh.code > 0xFFFF) {
+    return;
+  }
+  BlendFileIndexEntry entry = {};
+  entry.offset = wd->file_offset;
+  entry.old = uint64_t(uintptr_t(bh.old));
+  entry.code = bh.code;
+  entry.library = (bh.code == ID_LINK_PLACEHOLDER) ? wd->index.library : -1;
+  STRNCPY(entry.name, static_cast<const ID *>(data)->name);
+  if (bh.code == ID_LI) {
+    wd->index.library = int(wd->index.entries.size());
+  }
+  wd->index.entries.append(entry);
+}
+
 static void writestruct_at_address_nr(
     WriteData *wd, int filecode, const int struct_nr, int nr, const void *adr, const void *data)
 {
@@ -746,6 +853,8 @@ static void writestruct_at_address_nr(
     return;
   }
 
+  write_index_add_block(wd, bh, data);
+
   mywrite(wd, &bh, sizeof(BHead));
   mywrite(wd, data, size_t(bh.len));
 }
@@ -829,6 +938,39 @@ static void writelist_id(WriteData *wd, int filecode, const char *structname, co
 #define writestruct(wd, filecode, struct_id, nr, adr) \
   writestruct_nr(wd, filecode, SDNA_TYPE_FROM_STRUCT(struct_id), nr, adr)
 
+/**
+ * Write the block index after the end of the file, see #BlendFileIndexHeader.
+ */
+static void write_index(WriteData *wd)
+{
+  BlendFileIndexHeader header = {};
+  header.dna_offset = wd->index.dna_offset;
+  header.entries_num = uint64_t(wd->index.entries.size());
+
+  const size_t entries_size = sizeof(BlendFileIndexEntry) * wd->index.entries.size();
+  if (sizeof(header) + entries_size > INT_MAX) {
+    return;
+  }
+  header.entries_hash = BLI_hash_mm2(
+      reinterpret_cast<const uchar *>(wd->index.entries.data()), entries_size, 0);
+
+  BlendFileIndexFooter footer = {};
+  footer.index_offset = wd->file_offset;
+  memcpy(footer.magic, BLEND_FILE_INDEX_MAGIC, sizeof(footer.magic));
+
+  BHead bh = {};
+  bh.code = BLO_CODE_BIDX;
+  bh.nr = 1;
+  bh.len = int(sizeof(header) + entries_size);
+
+  mywrite(wd, &bh, sizeof(BHead));
+  mywrite(wd, &header, sizeof(header));
+  if (entries_size > 0) {
+    mywrite(wd, wd->index.entries.data(), entries_size);
+  }
+  mywrite(wd, &footer, sizeof(footer));
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -1277,6 +1419,108 @@ static int write_id_direct_linked_data_process_cb(LibraryIDLinkCallbackData *cb_
   return IDWALK_RET_NOP;
 }
 
+static void write_id(WriteData *wd,
+                     BLO_Write_IDBuffer *id_buffer,
+                     const IDTypeInfo *id_type,
+                     ID *id)
+{
+  BlendWriter writer = {wd};
+
+  mywrite_id_begin(wd, id);
+
+  id_buffer_init_from_id(id_buffer, id, wd->use_memfile);
+
+  if (id_type->blend_write != nullptr) {
+    id_type->blend_write(&writer, static_cast<ID *>(id_buffer->temp_id), id);
+  }
+
+  mywrite_id_end(wd, id);
+}
+
+/**
+ * Whether IDs of this type can be serialized on separate threads. This is only the case for types
+ * whose `blend_write` was checked to only modify the temporary copy of the ID and to only read
+ * data of other IDs, which are never written at the same time. Other types are written serially.
+ */
+static bool write_id_type_supports_parallel(const short idcode)
+{
+  switch (idcode) {
+    case ID_AC:
+    case ID_AR:
+    case ID_CA:
+    case ID_CU_LEGACY:
+    case ID_CV:
+    case ID_GR:
+    case ID_IM:
+    case ID_KE:
+    case ID_LA:
+    case ID_LP:
+    case ID_LT:
+    case ID_MA:
+    case ID_MB:
+    case ID_ME:
+    case ID_NT:
+    case ID_OB:
+    case ID_PAL:
+    case ID_PT:
+    case ID_SPK:
+    case ID_TE:
+    case ID_TXT:
+    case ID_WO:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Serialize the IDs on multiple threads into separate buffers, which are then written in order.
+ * The written data is the same as when calling #write_id for each of them.
+ */
+static void write_ids_parallel(WriteData *wd,
+                               const IDTypeInfo *id_type,
+                               const blender::Span<ID *> ids)
+{
+  using namespace blender;
+  BLI_assert(!wd->use_memfile);
+
+  Array<Vector<uchar>> buffers(ids.size());
+  Array<Vector<BlendFileIndexEntry>> index_entries(ids.size());
+  std::atomic<bool> critical_error = false;
+
+  threading::parallel_for(ids.index_range(), 1, [&](const IndexRange range) {
+    BLO_Write_IDBuffer *id_buffer = BLO_write_allocate_id_buffer();
+    id_buffer_init_for_id_type(id_buffer, id_type);
+    for (const int64_t i : range) {
+      WriteData *id_wd = writedata_new_capture(buffers[i]);
+      write_id(id_wd, id_buffer, id_type, ids[i]);
+      index_entries[i] = std::move(id_wd->index.entries);
+      if (id_wd->validation_data.critical_error) {
+        critical_error = true;
+      }
+      writedata_free(id_wd);
+    }
+    BLO_write_destroy_id_buffer(&id_buffer);
+  });
+
+  if (critical_error) {
+    wd->validation_data.critical_error = true;
+    return;
+  }
+
+  for (const int64_t i : ids.index_range()) {
+    for (BlendFileIndexEntry entry : index_entries[i]) {
+      entry.offset += wd->file_offset;
+      wd->index.entries.append(entry);
+    }
+    if (!buffers[i].is_empty()) {
+      mywrite(wd, buffers[i].data(), size_t(buffers[i].size()));
+    }
+    /* Free memory as early as possible, the buffers of big IDs can be large. */
+    buffers[i] = {};
+  }
+}
+
 /**
  * When #MemFile arguments are non-null, this is a file-safe to memory.
  *
@@ -1366,6 +1610,13 @@ static bool write_file_handle(Main *mainvar,
                                                  nullptr :
                                                  BKE_lib_override_library_operations_store_init();
 
+  /* Serialize IDs on multiple threads, they are still written to the file in the same order. */
+  const bool use_parallel = !wd->use_memfile &&
+                            USER_EXPERIMENTAL_TEST(&U, use_parallel_file_write);
+  /* Limits the memory used by serialized IDs waiting to be written. */
+  const int64_t parallel_batch_size = 128;
+  blender::Vector<ID *> parallel_ids;
+
   /* This outer loop allows to save first data-blocks from real mainvar,
    * then the temp ones from override process,
    * if needed, without duplicating whole code. */
@@ -1443,23 +1694,34 @@ static bool write_file_handle(Main *mainvar,
                                       IDWALK_READONLY | IDWALK_INCLUDE_UI);
         }
 
+        if (use_parallel && !do_override && write_id_type_supports_parallel(GS(id->name))) {
+          parallel_ids.append(id);
+          if (parallel_ids.size() == parallel_batch_size) {
+            write_ids_parallel(wd, id_type, parallel_ids);
+            parallel_ids.clear();
+          }
+          continue;
+        }
+        /* Keep the order of IDs. */
+        if (!parallel_ids.is_empty()) {
+          write_ids_parallel(wd, id_type, parallel_ids);
+          parallel_ids.clear();
+        }
+
         if (do_override) {
           BKE_lib_override_library_operations_store_start(bmain, override_storage, id);
         }
 
-        mywrite_id_begin(wd, id);
-
-        id_buffer_init_from_id(id_buffer, id, wd->use_memfile);
-
-        if (id_type->blend_write != nullptr) {
-          id_type->blend_write(&writer, static_cast<ID *>(id_buffer->temp_id), id);
-        }
+        write_id(wd, id_buffer, id_type, id);
 
         if (do_override) {
           BKE_lib_override_library_operations_store_end(override_storage, id);
         }
+      }
 
-        mywrite_id_end(wd, id);
+      if (!parallel_ids.is_empty()) {
+        write_ids_parallel(wd, id_type, parallel_ids);
+        parallel_ids.clear();
       }
 
       mywrite_flush(wd);
@@ -1487,6 +1749,7 @@ static bool write_file_handle(Main *mainvar,
    *
    * Note that we *borrow* the pointer to 'DNAstr',
    * so writing each time uses the same address and doesn't cause unnecessary undo overhead. */
+  wd->index.dna_offset = wd->file_offset;
   writedata(wd, BLO_CODE_DNA1, size_t(wd->sdna->data_len), wd->sdna->data);
 
   /* End of file. */
@@ -1494,6 +1757,10 @@ static bool write_file_handle(Main *mainvar,
   bhead.code = BLO_CODE_ENDB;
   mywrite(wd, &bhead, sizeof(BHead));
 
+  if (!wd->use_memfile) {
+    write_index(wd);
+  }
+
   blo_join_main(&mainlist);
 
   return mywrite_end(wd);
@@ -1581,6 +1848,31 @@ static void write_file_main_validate_post(Main *bmain, ReportList *reports)
   }
 }
 
+/**
+ * Replace \a filepath by the fully written \a tempname.
+ */
+static bool write_file_finalize(const char *filepath,
+                                const char *tempname,
+                                const bool use_save_versions,
+                                ReportList *reports)
+{
+  /* File save to temporary file was successful, now do reverse file history
+   * (move `.blend1` -> `.blend2`, `.blend` -> `.blend1` .. etc). */
+  if (use_save_versions) {
+    if (!do_history(filepath, reports)) {
+      BKE_report(reports, RPT_ERROR, "Version backup failed (file saved with @)");
+      return false;
+    }
+  }
+
+  if (BLI_rename_overwrite(tempname, filepath) != 0) {
+    BKE_report(reports, RPT_ERROR, "Cannot change old file (file saved with @)");
+    return false;
+  }
+
+  return true;
+}
+
 static bool BLO_write_file_impl(Main *mainvar,
                                 const char *filepath,
                                 const int write_flags,
@@ -1720,25 +2012,19 @@ static bool BLO_write_file_impl(Main *mainvar,
 
   if (err) {
     BKE_report(reports, RPT_ERROR, strerror(errno));
-    remove(tempname);
+    if (!ww.use_deferred_write) {
+      remove(tempname);
+    }
 
     return false;
   }
 
-  /* File save to temporary file was successful, now do reverse file history
-   * (move `.blend1` -> `.blend2`, `.blend` -> `.blend1` .. etc). */
-  if (use_save_versions) {
-    if (!do_history(filepath, reports)) {
-      BKE_report(reports, RPT_ERROR, "Version backup failed (file saved with @)");
+  if (!ww.use_deferred_write) {
+    if (!write_file_finalize(filepath, tempname, use_save_versions, reports)) {
       return false;
     }
   }
 
-  if (BLI_rename_overwrite(tempname, filepath) != 0) {
-    BKE_report(reports, RPT_ERROR, "Cannot change old file (file saved with @)");
-    return false;
-  }
-
   write_file_main_validate_post(mainvar, reports);
 
   return true;
@@ -1766,6 +2052,73 @@ bool BLO_write_file(Main *mainvar,
   return BLO_write_file_impl(mainvar, filepath, write_flags, params, reports, raw_wrap);
 }
 
+BlendFileWriteBuffer *BLO_write_file_to_buffer(Main *mainvar,
+                                               const char *filepath,
+                                               const int write_flags,
+                                               const BlendFileWriteParams *params,
+                                               ReportList *reports)
+{
+  BlendFileWriteBuffer *buffer = MEM_new<BlendFileWriteBuffer>(__func__);
+  STRNCPY(buffer->filepath, filepath);
+  buffer->write_flags = write_flags;
+  buffer->use_save_versions = params->use_save_versions;
+
+  if (!BLO_write_file_impl(mainvar, filepath, write_flags, params, reports, buffer->data)) {
+    MEM_delete(buffer);
+    return nullptr;
+  }
+  return buffer;
+}
+
+static bool write_file_buffer_flush_impl(const BlendFileWriteBuffer *buffer,
+                                         const char *tempname,
+                                         WriteWrap &ww)
+{
+  if (ww.open(tempname) == false) {
+    return false;
+  }
+  bool success = true;
+  for (const blender::Array<uchar> &chunk : buffer->data.chunks) {
+    if (!ww.write(chunk.data(), size_t(chunk.size()))) {
+      success = false;
+      break;
+    }
+  }
+  if (!ww.close()) {
+    success = false;
+  }
+  return success;
+}
+
+bool BLO_write_file_buffer_flush(const BlendFileWriteBuffer *buffer, ReportList *reports)
+{
+  char tempname[FILE_MAX + 1];
+  SNPRINTF(tempname, "%s@", buffer->filepath);
+
+  RawWriteWrap raw_wrap;
+  bool success;
+  if (buffer->write_flags & G_FILE_COMPRESS) {
+    ZstdWriteWrap zstd_wrap(raw_wrap);
+    success = write_file_buffer_flush_impl(buffer, tempname, zstd_wrap);
+  }
+  else {
+    success = write_file_buffer_flush_impl(buffer, tempname, raw_wrap);
+  }
+
+  if (!success) {
+    BKE_reportf(reports, RPT_ERROR, "Cannot write file %s: %s", tempname, strerror(errno));
+    remove(tempname);
+    return false;
+  }
+
+  return write_file_finalize(buffer->filepath, tempname, buffer->use_save_versions, reports);
+}
+
+void BLO_write_file_buffer_free(BlendFileWriteBuffer *buffer)
+{
+  MEM_delete(buffer);
+}
+
 bool BLO_write_file_mem(Main *mainvar, MemFile *compare, MemFile *current, int write_flags)
 {
   bool use_userdef = false;
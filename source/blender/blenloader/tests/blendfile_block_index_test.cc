@@ -0,0 +1,201 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+#include "blendfile_loading_base_test.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_fileops.h"
+#include "BLI_linklist.h"
+#include "BLI_math_vector_types.hh"
+#include "BLI_path_util.h"
+#include "BLI_vector.hh"
+
+#include "BKE_appdir.hh"
+#include "BKE_global.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_main.hh"
+#include "BKE_mesh.h"
+#include "BKE_mesh.hh"
+#include "BKE_object.hh"
+
+#include "BLO_blend_defs.hh"
+#include "BLO_readfile.hh"
+#include "BLO_writefile.hh"
+
+#include "DNA_mesh_types.h"
+#include "DNA_object_types.h"
+
+namespace blender::blenloader::tests {
+
+/**
+ * Files are written with an index of their ID blocks after the #BLO_CODE_ENDB block. Reading
+ * a file through a #BlendHandle uses it, and has to give the same results for files without an
+ * index or with an index that can't be used.
+ */
+class BlendfileBlockIndexTest : public BlendfileLoadingBaseTest {
+ protected:
+  std::string temp_dir_;
+  /** The contents of the file written by #SetUp. */
+  Vector<char> file_data_;
+  /** Size of the file up to and including the #BLO_CODE_ENDB block. */
+  int64_t file_size_without_index_ = 0;
+
+  void SetUp() override
+  {
+    BlendfileLoadingBaseTest::SetUp();
+    BKE_tempdir_init(nullptr);
+    temp_dir_ = BKE_tempdir_session();
+
+    Main *bmain = BKE_main_new();
+    Mesh *mesh = BKE_mesh_add(bmain, "Mesh");
+    Mesh *mesh_src = BKE_mesh_new_nomain(4, 0, 0, 0);
+    MutableSpan<float3> positions = mesh_src->vert_positions_for_write();
+    for (const int i : positions.index_range()) {
+      positions[i] = float3(float(i), 0.0f, 0.0f);
+    }
+    BKE_mesh_nomain_to_mesh(mesh_src, mesh, nullptr);
+    Object *object = BKE_object_add_only_object(bmain, OB_MESH, "Object");
+    object->data = mesh;
+    id_us_plus(&mesh->id);
+    BKE_object_add_only_object(bmain, OB_EMPTY, "Empty");
+
+    const std::string filepath = this->temp_path("block_index.blend");
+    BlendFileWriteParams params{};
+    params.remap_mode = BLO_WRITE_PATH_REMAP_NONE;
+    ASSERT_TRUE(BLO_write_file(bmain, filepath.c_str(), 0, &params, nullptr));
+    BKE_main_free(bmain);
+
+    size_t size = 0;
+    char *data = static_cast<char *>(BLI_file_read_binary_as_mem(filepath.c_str(), 0, &size));
+    ASSERT_NE(data, nullptr);
+    file_data_.extend(Span<char>(data, int64_t(size)));
+    MEM_freeN(data);
+
+    /* Find the end of the #BLO_CODE_ENDB block. */
+    const int64_t pointer_size = file_data_[7] == '-' ? 8 : 4;
+    const int64_t bhead_size = 16 + pointer_size;
+    int64_t offset = 12;
+    while (offset + bhead_size <= file_data_.size()) {
+      int code, len;
+      memcpy(&code, &file_data_[offset], sizeof(int));
+      memcpy(&len, &file_data_[offset + 4], sizeof(int));
+      offset += bhead_size + len;
+      if (code == BLO_CODE_ENDB) {
+        file_size_without_index_ = offset;
+        break;
+      }
+    }
+    ASSERT_GT(file_size_without_index_, 0);
+    /* The file has an index after the end block. */
+    ASSERT_GT(file_data_.size(), file_size_without_index_);
+  }
+
+  std::string temp_path(const char *filename) const
+  {
+    char path[FILE_MAX];
+    BLI_path_join(path, sizeof(path), temp_dir_.c_str(), filename);
+    return path;
+  }
+
+  std::string write_variant(const char *filename, const Span<char> data) const
+  {
+    const std::string filepath = this->temp_path(filename);
+    FILE *file = BLI_fopen(filepath.c_str(), "wb");
+    EXPECT_NE(file, nullptr);
+    if (file) {
+      EXPECT_EQ(fwrite(data.data(), 1, size_t(data.size()), file), size_t(data.size()));
+      fclose(file);
+    }
+    return filepath;
+  }
+
+  static Vector<std::string> sorted_strings(LinkNode *list)
+  {
+    Vector<std::string> result;
+    for (LinkNode *link = list; link; link = link->next) {
+      result.append(static_cast<const char *>(link->link));
+    }
+    BLI_linklist_freeN(list);
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  /** Check the IDs that can be listed and linked from the file. */
+  void expect_file_contents(const std::string &filepath)
+  {
+    BlendFileReadReport bf_reports{};
+    BlendHandle *bh = BLO_blendhandle_from_file(filepath.c_str(), &bf_reports);
+    ASSERT_NE(bh, nullptr);
+    int tot_names = 0;
+    EXPECT_EQ(sorted_strings(BLO_blendhandle_get_datablock_names(bh, ID_OB, false, &tot_names)),
+              Vector<std::string>({"Empty", "Object"}));
+    EXPECT_EQ(tot_names, 2);
+    EXPECT_EQ(sorted_strings(BLO_blendhandle_get_datablock_names(bh, ID_ME, false, &tot_names)),
+              Vector<std::string>({"Mesh"}));
+    EXPECT_EQ(sorted_strings(BLO_blendhandle_get_linkable_groups(bh)),
+              Vector<std::string>({"Mesh", "Object"}));
+    BLO_blendhandle_close(bh);
+
+    /* Linking an object also reads its mesh with all of its data blocks. */
+    TempLibraryContext *temp_lib_ctx = BLO_library_temp_load_id(
+        G.main, filepath.c_str(), ID_OB, "Object", nullptr);
+    ASSERT_NE(temp_lib_ctx->temp_id, nullptr);
+    const Object *object = reinterpret_cast<const Object *>(temp_lib_ctx->temp_id);
+    const Mesh *mesh = static_cast<const Mesh *>(object->data);
+    ASSERT_NE(mesh, nullptr);
+    EXPECT_STREQ(mesh->id.name, "MEMesh");
+    ASSERT_EQ(mesh->verts_num, 4);
+    EXPECT_EQ(mesh->vert_positions()[3], float3(3.0f, 0.0f, 0.0f));
+    BLO_library_temp_free(temp_lib_ctx);
+  }
+};
+
+TEST_F(BlendfileBlockIndexTest, WithIndex)
+{
+  this->expect_file_contents(this->write_variant("with_index.blend", file_data_));
+}
+
+TEST_F(BlendfileBlockIndexTest, WithoutIndex)
+{
+  /* Like files written by older versions. */
+  this->expect_file_contents(this->write_variant(
+      "without_index.blend", file_data_.as_span().take_front(file_size_without_index_)));
+}
+
+TEST_F(BlendfileBlockIndexTest, TruncatedIndex)
+{
+  const int64_t index_size = file_data_.size() - file_size_without_index_;
+  for (const int64_t removed_size : {int64_t(1), int64_t(16), index_size / 2, index_size - 1}) {
+    this->expect_file_contents(this->write_variant(
+        "truncated_index.blend", file_data_.as_span().drop_back(removed_size)));
+  }
+}
+
+TEST_F(BlendfileBlockIndexTest, CorruptIndex)
+{
+  const int64_t index_size = file_data_.size() - file_size_without_index_;
+  /* Change bytes in the footer, the index header, the entries and the block header. */
+  for (const int64_t offset : {file_data_.size() - 1,
+                               file_data_.size() - 12,
+                               file_size_without_index_ + index_size / 2,
+                               file_size_without_index_ + 30,
+                               file_size_without_index_ + 4})
+  {
+    Vector<char> data = file_data_;
+    data[offset] = char(~data[offset]);
+    this->expect_file_contents(this->write_variant("corrupt_index.blend", data));
+  }
+
+  /* Entries pointing past the end of the file. */
+  Vector<char> data = file_data_;
+  std::fill(data.begin() + file_size_without_index_ + 40, data.end() - 16, char(0xff));
+  this->expect_file_contents(this->write_variant("corrupt_entries.blend", data));
+}
+
+}  // namespace blender::blenloader::tests
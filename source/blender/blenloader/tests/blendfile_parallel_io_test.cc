@@ -0,0 +1,224 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+#include "blendfile_loading_base_test.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_vector.hh"
+
+#include "BKE_appdir.hh"
+#include "BKE_attribute.hh"
+#include "BKE_lib_query.hh"
+#include "BKE_main.hh"
+#include "BKE_mesh.hh"
+
+#include "BLO_blend_defs.hh"
+#include "BLO_readfile.hh"
+#include "BLO_writefile.hh"
+
+#include "DNA_mesh_types.h"
+#include "DNA_userdef_types.h"
+
+namespace blender::blenloader::tests {
+
+/**
+ * Compares files read and written with the experimental multi-threaded reading and writing to
+ * the ones read and written on a single thread.
+ */
+class BlendfileParallelIOTest : public BlendfileLoadingBaseTest {
+ protected:
+  std::string temp_dir_;
+
+  void SetUp() override
+  {
+    BlendfileLoadingBaseTest::SetUp();
+    BKE_tempdir_init(nullptr);
+    temp_dir_ = BKE_tempdir_session();
+    U.flag |= USER_DEVELOPER_UI;
+  }
+
+  void TearDown() override
+  {
+    U.flag &= ~USER_DEVELOPER_UI;
+    U.experimental.use_parallel_file_read = false;
+    U.experimental.use_parallel_file_write = false;
+    BlendfileLoadingBaseTest::TearDown();
+  }
+
+  std::string asset_path(const char *filepath) const
+  {
+    const std::string &test_assets_dir = blender::tests::flags_test_asset_dir();
+    if (test_assets_dir.empty()) {
+      return "";
+    }
+    char abspath[FILE_MAX];
+    BLI_path_join(abspath, sizeof(abspath), test_assets_dir.c_str(), filepath);
+    return abspath;
+  }
+
+  std::string temp_path(const char *filename) const
+  {
+    char path[FILE_MAX];
+    BLI_path_join(path, sizeof(path), temp_dir_.c_str(), filename);
+    return path;
+  }
+
+  static BlendFileData *read_file(const std::string &filepath, const bool use_parallel)
+  {
+    U.experimental.use_parallel_file_read = use_parallel;
+    BlendFileReadReport bf_reports = {};
+    BlendFileData *bfd = BLO_read_from_file(filepath.c_str(), BLO_READ_SKIP_NONE, &bf_reports);
+    U.experimental.use_parallel_file_read = false;
+    return bfd;
+  }
+
+  static bool write_file(Main *bmain, const std::string &filepath, const bool use_parallel)
+  {
+    U.experimental.use_parallel_file_write = use_parallel;
+    BlendFileWriteParams params{};
+    params.remap_mode = BLO_WRITE_PATH_REMAP_NONE;
+    const bool success = BLO_write_file(bmain, filepath.c_str(), 0, &params, nullptr);
+    U.experimental.use_parallel_file_write = false;
+    return success;
+  }
+};
+
+/**
+ * Describe the IDs of the main database and the data that is read for them, without any memory
+ * addresses, so that it can be compared with other main databases.
+ */
+static Vector<std::string> describe_main(Main *bmain)
+{
+  Vector<std::string> result;
+  ID *id;
+  FOREACH_MAIN_ID_BEGIN (bmain, id) {
+    result.append(id->name);
+    BKE_library_foreach_ID_link(
+        nullptr,
+        id,
+        [&](LibraryIDLinkCallbackData *cb_data) {
+          const ID *other_id = *cb_data->id_pointer;
+          result.append(std::string("  -> ") + (other_id ? other_id->name : "null"));
+          return IDWALK_RET_NOP;
+        },
+        nullptr,
+        IDWALK_READONLY);
+    if (GS(id->name) == ID_ME) {
+      const Mesh &mesh = *reinterpret_cast<const Mesh *>(id);
+      mesh.attributes().for_all(
+          [&](const bke::AttributeIDRef &attribute_id, const bke::AttributeMetaData &meta_data) {
+            const GVArraySpan data = *mesh.attributes().lookup(attribute_id);
+            result.append("  " + std::string(attribute_id.name()) + " " +
+                          std::to_string(int(meta_data.domain)) + " " +
+                          std::to_string(int(meta_data.data_type)) + " " +
+                          std::string(static_cast<const char *>(data.data()),
+                                      data.size_in_bytes()));
+            return true;
+          });
+    }
+  }
+  FOREACH_MAIN_ID_END;
+  return result;
+}
+
+/**
+ * The headers of all blocks in a written file, without the old memory addresses.
+ */
+static Vector<std::string> read_block_headers(const std::string &filepath)
+{
+  Vector<std::string> result;
+  size_t size = 0;
+  char *data = static_cast<char *>(BLI_file_read_binary_as_mem(filepath.c_str(), 0, &size));
+  if (data == nullptr || size < 12) {
+    ADD_FAILURE() << "Unable to read file '" << filepath << "'";
+    MEM_SAFE_FREE(data);
+    return result;
+  }
+  const size_t pointer_size = data[7] == '-' ? 8 : 4;
+  size_t offset = 12;
+  while (offset + 16 + pointer_size <= size) {
+    int code, len, sdna_nr, nr;
+    memcpy(&code, data + offset, sizeof(int));
+    memcpy(&len, data + offset + 4, sizeof(int));
+    memcpy(&sdna_nr, data + offset + 8 + pointer_size, sizeof(int));
+    memcpy(&nr, data + offset + 12 + pointer_size, sizeof(int));
+    result.append(std::string(reinterpret_cast<const char *>(&code), 4) + " " +
+                  std::to_string(len) + " " + std::to_string(sdna_nr) + " " + std::to_string(nr));
+    if (code == BLO_CODE_ENDB) {
+      break;
+    }
+    offset += 16 + pointer_size + size_t(len);
+  }
+  MEM_freeN(data);
+  return result;
+}
+
+TEST_F(BlendfileParallelIOTest, ParallelRead)
+{
+  const std::string filepath = this->asset_path("modifier_stack" SEP_STR "array_test.blend");
+  if (filepath.empty()) {
+    return;
+  }
+  BlendFileData *bfd_serial = read_file(filepath, false);
+  BlendFileData *bfd_parallel = read_file(filepath, true);
+  ASSERT_NE(bfd_serial, nullptr);
+  ASSERT_NE(bfd_parallel, nullptr);
+
+  EXPECT_EQ(describe_main(bfd_serial->main), describe_main(bfd_parallel->main));
+
+  /* Writing both files again gives the same blocks. */
+  const std::string path_serial = this->temp_path("parallel_read_serial.blend");
+  const std::string path_parallel = this->temp_path("parallel_read_parallel.blend");
+  EXPECT_TRUE(write_file(bfd_serial->main, path_serial, false));
+  EXPECT_TRUE(write_file(bfd_parallel->main, path_parallel, false));
+  EXPECT_EQ(read_block_headers(path_serial), read_block_headers(path_parallel));
+
+  BLO_blendfiledata_free(bfd_serial);
+  BLO_blendfiledata_free(bfd_parallel);
+}
+
+TEST_F(BlendfileParallelIOTest, ParallelWrite)
+{
+  const std::string filepath = this->asset_path("modifier_stack" SEP_STR "array_test.blend");
+  if (filepath.empty()) {
+    return;
+  }
+  BlendFileData *bfd = read_file(filepath, false);
+  ASSERT_NE(bfd, nullptr);
+
+  /* The same main database is written, so even the memory addresses in the files are the same. */
+  const std::string path_serial = this->temp_path("parallel_write_serial.blend");
+  const std::string path_parallel = this->temp_path("parallel_write_parallel.blend");
+  EXPECT_TRUE(write_file(bfd->main, path_serial, false));
+  EXPECT_TRUE(write_file(bfd->main, path_parallel, true));
+  BLO_blendfiledata_free(bfd);
+
+  size_t size_serial = 0;
+  size_t size_parallel = 0;
+  void *data_serial = BLI_file_read_binary_as_mem(path_serial.c_str(), 0, &size_serial);
+  void *data_parallel = BLI_file_read_binary_as_mem(path_parallel.c_str(), 0, &size_parallel);
+  ASSERT_NE(data_serial, nullptr);
+  ASSERT_NE(data_parallel, nullptr);
+  EXPECT_EQ(size_serial, size_parallel);
+  EXPECT_EQ(memcmp(data_serial, data_parallel, std::min(size_serial, size_parallel)), 0);
+  MEM_freeN(data_serial);
+  MEM_freeN(data_parallel);
+
+  /* Reading the files gives the same data. */
+  BlendFileData *bfd_serial = read_file(path_serial, false);
+  BlendFileData *bfd_parallel = read_file(path_parallel, false);
+  ASSERT_NE(bfd_serial, nullptr);
+  ASSERT_NE(bfd_parallel, nullptr);
+  EXPECT_EQ(describe_main(bfd_serial->main), describe_main(bfd_parallel->main));
+  BLO_blendfiledata_free(bfd_serial);
+  BLO_blendfiledata_free(bfd_parallel);
+}
+
+}  // namespace blender::blenloader::tests
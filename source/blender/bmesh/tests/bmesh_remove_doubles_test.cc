@@ -0,0 +1,30 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "BLI_utildefines.h"
+#include "bmesh.hh"
+
+TEST(bmesh_remove_doubles, VertsAtMergeDistance)
+{
+  /* Pairs of vertices exactly the merge distance apart along one of the axes, which are merged
+   * regardless of the layout of the KD-tree used to find them. */
+  const float dist = 0.5f;
+  for (int pairs_num = 1; pairs_num < 40; pairs_num++) {
+    BMeshCreateParams bmesh_create_params{};
+    bmesh_create_params.use_toolflags = true;
+    BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default, &bmesh_create_params);
+    for (int i = 0; i < pairs_num; i++) {
+      const float co[3] = {float(i % 4) * 10.0f, float(i % 3) * 10.0f, float(i / 12) * 10.0f};
+      float co_other[3] = {co[0], co[1], co[2]};
+      co_other[i % 3] += dist;
+      BM_vert_create(bm, co, nullptr, BM_CREATE_NOP);
+      BM_vert_create(bm, co_other, nullptr, BM_CREATE_NOP);
+    }
+    BMO_op_callf(bm, BMO_FLAG_DEFAULTS, "remove_doubles verts=%av dist=%f", dist);
+    EXPECT_EQ(bm->totvert, pairs_num);
+    BM_mesh_free(bm);
+  }
+}
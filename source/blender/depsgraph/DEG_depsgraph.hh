@@ -30,6 +30,9 @@
 
 #pragma once
 
+#include "BLI_function_ref.hh"
+#include "BLI_span.hh"
+
 #include "DNA_ID.h"
 
 /* Dependency Graph */
@@ -200,6 +203,30 @@ void DEG_evaluate_on_refresh(
     Depsgraph *graph,
     DepsgraphEvaluateSyncWriteback sync_writeback = DEG_EVALUATE_SYNC_WRITEBACK_NO);
 
+/**
+ * Check whether the evaluated state of the graph at a frame does not depend on the evaluation of
+ * previous frames, so that frames can be evaluated in any order and on separate graphs. This is
+ * not the case when there are simulations such as physics, particles or simulation nodes.
+ */
+bool DEG_graph_is_frame_independent(const Depsgraph *graph);
+
+/**
+ * Evaluate the given frames on multiple independent dependency graphs concurrently, for example
+ * to export animation faster. The graphs must be built for the same data, not be active and be
+ * frame independent.
+ *
+ * Frames are evaluated in batches of one frame per graph, after which \a frame_fn is called from
+ * the calling thread in the order of the frames, with the graph evaluated at that frame.
+ * Evaluation stops when it returns false.
+ *
+ * \note Frame change handlers are not run, as they can modify original data. So this must not be
+ * used when frame change handlers are registered, see #BKE_callback_is_used.
+ */
+void DEG_evaluate_frames_parallel(
+    blender::Span<Depsgraph *> graphs,
+    blender::Span<float> frames,
+    blender::FunctionRef<bool(Depsgraph *graph, float frame)> frame_fn);
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
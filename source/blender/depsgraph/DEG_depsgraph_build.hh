@@ -72,6 +72,16 @@ void DEG_graph_relations_update(Depsgraph *graph);
 /** Tag all relations in the database for update. */
 void DEG_relations_tag_update(Main *bmain);
 
+/**
+ * Tag relations from the given graph for update after only the visibility of objects and
+ * collections in the view layer changed. Such an update adds and removes nodes of the affected
+ * IDs instead of re-building the whole graph, when possible.
+ */
+void DEG_graph_tag_relations_visibility_update(Depsgraph *graph);
+
+/** Tag all relations in the database for update after a visibility change in a view layer. */
+void DEG_relations_tag_visibility_update(Main *bmain);
+
 /* Add Dependencies  ----------------------------- */
 
 /**
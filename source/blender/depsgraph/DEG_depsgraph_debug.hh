@@ -50,6 +50,27 @@ void DEG_debug_stats_gnuplot(const Depsgraph *graph,
                              const char *label,
                              const char *output_filename);
 
+/* ************************************************ */
+/* Evaluation Tracing */
+
+/**
+ * Start recording the evaluation of all dependency graphs: the start and end time and the thread
+ * of every evaluated operation. The recording is written to the given file in the Chrome trace
+ * event format when tracing ends.
+ */
+void DEG_debug_trace_begin(const char *filepath);
+
+/** Stop recording the evaluation and write the recording to the file, if tracing was started. */
+void DEG_debug_trace_end();
+
+bool DEG_debug_trace_is_enabled();
+
+/**
+ * Record a part of an operation evaluation, such as a single modifier, which ends at the time of
+ * this call. It is shown nested in the operation in the trace.
+ */
+void DEG_debug_trace_add_scope(const char *name, const char *category, double duration);
+
 /* ************************************************ */
 
 /** Compare two dependency graphs. */
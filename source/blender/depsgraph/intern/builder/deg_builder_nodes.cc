@@ -562,6 +562,27 @@ void DepsgraphNodeBuilder::end_build()
   update_invalid_cow_pointers();
 }
 
+void DepsgraphNodeBuilder::begin_build_incremental(Scene *scene, ViewLayer *view_layer)
+{
+  for (IDNode *id_node : graph_->id_nodes) {
+    built_map_.tagBuild(id_node->id_orig);
+    /* The state of the nodes from the previous build is the current one, so that only changes
+     * caused by the incremental update are detected when finalizing the build. */
+    id_node->previously_visible_components_mask = id_node->visible_components_mask;
+    id_node->previous_eval_flags = id_node->eval_flags;
+    id_node->previous_customdata_masks = id_node->customdata_masks;
+  }
+  /* NOTE: Pass view layer index of 0, same as the full view layer build. */
+  scene_ = scene;
+  view_layer_ = view_layer;
+  view_layer_index_ = 0;
+}
+
+void DepsgraphNodeBuilder::end_build_incremental()
+{
+  update_invalid_cow_pointers();
+}
+
 void DepsgraphNodeBuilder::build_id(ID *id, const bool force_be_visible)
 {
   if (id == nullptr) {
@@ -892,19 +913,36 @@ void DepsgraphNodeBuilder::build_object_flags(int base_index,
   if (base_index == -1) {
     return;
   }
+  /* TODO(sergey): Is this really best component to be used? */
+  add_operation_node(&object->id,
+                     NodeType::OBJECT_FROM_LAYER,
+                     OperationCode::OBJECT_BASE_FLAGS,
+                     object_flags_eval_function(base_index, object, linked_state));
+}
+
+void DepsgraphNodeBuilder::update_object_flags(int base_index,
+                                               Object *object,
+                                               eDepsNode_LinkedState_Type linked_state)
+{
+  OperationNode *op_node = find_operation_node(
+      &object->id, NodeType::OBJECT_FROM_LAYER, OperationCode::OBJECT_BASE_FLAGS);
+  if (op_node == nullptr) {
+    return;
+  }
+  op_node->evaluate = object_flags_eval_function(base_index, object, linked_state);
+}
+
+DepsEvalOperationCb DepsgraphNodeBuilder::object_flags_eval_function(
+    int base_index, Object *object, eDepsNode_LinkedState_Type linked_state)
+{
   Scene *scene_cow = get_cow_datablock(scene_);
   Object *object_cow = get_cow_datablock(object);
   const bool is_from_set = (linked_state == DEG_ID_LINKED_VIA_SET);
-  /* TODO(sergey): Is this really best component to be used? */
-  add_operation_node(
-      &object->id,
-      NodeType::OBJECT_FROM_LAYER,
-      OperationCode::OBJECT_BASE_FLAGS,
-      [view_layer_index = view_layer_index_, scene_cow, object_cow, base_index, is_from_set](
-          ::Depsgraph *depsgraph) {
-        BKE_object_eval_eval_base_flags(
-            depsgraph, scene_cow, view_layer_index, object_cow, base_index, is_from_set);
-      });
+  return [view_layer_index = view_layer_index_, scene_cow, object_cow, base_index, is_from_set](
+             ::Depsgraph *depsgraph) {
+    BKE_object_eval_eval_base_flags(
+        depsgraph, scene_cow, view_layer_index, object_cow, base_index, is_from_set);
+  };
 }
 
 void DepsgraphNodeBuilder::build_object_instance_collection(Object *object, bool is_object_visible)
@@ -89,6 +89,12 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
   virtual void begin_build();
   virtual void end_build();
 
+  /* Begin adding nodes to the graph without clearing it first: nodes of IDs which are already in
+   * the graph are kept as they are, and are not built again. Used by the incremental update of the
+   * graph when objects and collections of the view layer become visible. */
+  virtual void begin_build_incremental(Scene *scene, ViewLayer *view_layer);
+  virtual void end_build_incremental();
+
   /**
    * `id_cow_self` is the user of `id_pointer`,
    * see also `LibraryIDLinkCallbackData` struct definition.
@@ -186,6 +192,11 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
   virtual void build_object_flags(int base_index,
                                   Object *object,
                                   eDepsNode_LinkedState_Type linked_state);
+  /* Update base flags evaluation of an object which is already in the graph for a new index of its
+   * base in the view layer. */
+  virtual void update_object_flags(int base_index,
+                                   Object *object,
+                                   eDepsNode_LinkedState_Type linked_state);
   virtual void build_object_modifiers(Object *object);
   virtual void build_object_data(Object *object);
   virtual void build_object_data_camera(Object *object);
@@ -310,6 +321,10 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
                               bool is_reference,
                               void *user_data);
 
+  DepsEvalOperationCb object_flags_eval_function(int base_index,
+                                                 Object *object,
+                                                 eDepsNode_LinkedState_Type linked_state);
+
   void tag_previously_tagged_nodes();
   /**
    * Check for IDs that need to be flushed (copy-on-eval-updated)
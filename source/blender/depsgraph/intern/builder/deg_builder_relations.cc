@@ -517,6 +517,20 @@ Depsgraph *DepsgraphRelationBuilder::getGraph()
 
 void DepsgraphRelationBuilder::begin_build() {}
 
+void DepsgraphRelationBuilder::begin_build_incremental(Scene *scene,
+                                                       Span<IDNode *> existing_id_nodes)
+{
+  for (IDNode *id_node : existing_id_nodes) {
+    /* Collections which were only built from a layer collection are not tagged, so that their
+     * object relations are built if the collection gets instanced by a newly added object. */
+    if (id_node->id_type == ID_GR && !id_node->is_collection_fully_expanded) {
+      continue;
+    }
+    built_map_.tagBuild(id_node->id_orig);
+  }
+  scene_ = scene;
+}
+
 void DepsgraphRelationBuilder::build_id(ID *id)
 {
   if (id == nullptr) {
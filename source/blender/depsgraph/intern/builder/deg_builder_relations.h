@@ -87,6 +87,11 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
 
   void begin_build();
 
+  /* Begin adding relations of IDs which were added to the graph by an incremental update. The
+   * given ID nodes were in the graph before the update, and their relations are kept as they are.
+   */
+  void begin_build_incremental(Scene *scene, Span<IDNode *> existing_id_nodes);
+
   template<typename KeyFrom, typename KeyTo>
   Relation *add_relation(const KeyFrom &key_from,
                          const KeyTo &key_to,
@@ -133,6 +138,13 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
 
   virtual bool build_layer_collection(LayerCollection *layer_collection);
   virtual void build_view_layer_collections(ViewLayer *view_layer);
+  /* Relations of a collection which was added to the graph by an incremental update from a layer
+   * collection, and of its parent collection to it. */
+  virtual void build_view_layer_collection_incremental(LayerCollection *layer_collection,
+                                                       Collection *parent_collection);
+  /* Hierarchy relation from a collection which is built from a layer collection to an object in
+   * it which was added to the graph by an incremental update. */
+  virtual void build_layer_collection_object_hierarchy(Collection *collection, Object *object);
 
   virtual void build_view_layer(Scene *scene,
                                 ViewLayer *view_layer,
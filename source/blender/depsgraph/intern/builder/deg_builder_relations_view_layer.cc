@@ -90,6 +90,33 @@ void DepsgraphRelationBuilder::build_view_layer_collections(ViewLayer *view_laye
   }
 }
 
+void DepsgraphRelationBuilder::build_view_layer_collection_incremental(
+    LayerCollection *layer_collection, Collection *parent_collection)
+{
+  Collection *collection = layer_collection->collection;
+  build_collection(layer_collection, collection);
+
+  const ComponentKey collection_hierarchy_key{&collection->id, NodeType::HIERARCHY};
+  if (parent_collection == nullptr) {
+    const ComponentKey scene_hierarchy_key{&scene_->id, NodeType::HIERARCHY};
+    add_relation(scene_hierarchy_key, collection_hierarchy_key, "Scene -> Collection hierarchy");
+  }
+  else {
+    const ComponentKey parent_collection_hierarchy_key{&parent_collection->id,
+                                                       NodeType::HIERARCHY};
+    add_relation(
+        parent_collection_hierarchy_key, collection_hierarchy_key, "Collection hierarchy");
+  }
+}
+
+void DepsgraphRelationBuilder::build_layer_collection_object_hierarchy(Collection *collection,
+                                                                       Object *object)
+{
+  const ComponentKey collection_hierarchy_key{&collection->id, NodeType::HIERARCHY};
+  const ComponentKey object_hierarchy_key{&object->id, NodeType::HIERARCHY};
+  add_relation(collection_hierarchy_key, object_hierarchy_key, "Collection -> Object hierarchy");
+}
+
 void DepsgraphRelationBuilder::build_freestyle_lineset(FreestyleLineSet *fls)
 {
   if (fls->group != nullptr) {
@@ -0,0 +1,63 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#pragma once
+
+#include "intern/depsgraph_type.hh"
+
+struct Collection;
+struct LayerCollection;
+struct Object;
+struct Scene;
+struct ViewLayer;
+
+namespace blender::deg {
+
+/* Collection which is built from a layer collection of the view layer. */
+struct ViewLayerCollection {
+  LayerCollection *layer_collection;
+  /* Collection of the parent layer collection, nullptr for the top level layer collections. */
+  Collection *parent_collection;
+};
+
+/* Objects and collections of the view layer which the dependency graph was built from.
+ *
+ * Stored after the graph is built from a view layer, so that a change of which objects and
+ * collections of the view layer are visible can be handled by only adding and removing nodes of
+ * the affected IDs, without re-building the whole graph. */
+struct ViewLayerBuildState {
+  /* The graph was built from the view layer, and the rest of the state is valid. */
+  bool is_valid = false;
+
+  /* Scene and view layer the graph was built for. */
+  const Scene *scene = nullptr;
+  const ViewLayer *view_layer = nullptr;
+
+  /* Objects of the bases which are pulled into the graph, in the order of their base index. */
+  Vector<Object *> base_objects;
+
+  /* Collections built from the layer collections, each preceded by the collection of the parent
+   * layer collection. */
+  Vector<pair<Collection *, Collection *>> layer_collections;
+
+  /* Visibility restriction flags of collections which are built along with all of their objects,
+   * for example instanced collections. The visibility of such objects depends on the flags. */
+  Map<Collection *, int> expanded_collection_flags;
+
+  void clear()
+  {
+    is_valid = false;
+    scene = nullptr;
+    view_layer = nullptr;
+    base_objects.clear();
+    layer_collections.clear();
+    expanded_collection_flags.clear();
+  }
+};
+
+}  // namespace blender::deg
@@ -54,6 +54,8 @@ void AbstractBuilderPipeline::build_step_nodes()
   /* Generate all the nodes in the graph first */
   unique_ptr<DepsgraphNodeBuilder> node_builder = construct_node_builder();
   node_builder->begin_build();
+  /* Pipelines which support incremental updates store the new state while building nodes. */
+  deg_graph_->view_layer_build_state.clear();
   build_nodes(*node_builder);
   node_builder->end_build();
 }
@@ -92,6 +94,7 @@ void AbstractBuilderPipeline::build_step_finalize()
 #endif
   /* Relations are up to date. */
   deg_graph_->need_update_relations = false;
+  deg_graph_->need_update_relations_visibility_only = false;
 }
 
 unique_ptr<DepsgraphNodeBuilder> AbstractBuilderPipeline::construct_node_builder()
@@ -4,12 +4,270 @@
 
 #include "pipeline_view_layer.h"
 
+#include "BLI_listbase.h"
+#include "BLI_time.h"
+
+#include "BKE_global.hh"
+#include "BKE_layer.hh"
+#include "BKE_lib_query.hh"
+
+#include "DNA_collection_types.h"
+#include "DNA_layer_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_force_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
 #include "intern/builder/deg_builder_nodes.h"
 #include "intern/builder/deg_builder_relations.h"
 #include "intern/depsgraph.hh"
+#include "intern/depsgraph_relation.hh"
+#include "intern/node/deg_node_component.hh"
+#include "intern/node/deg_node_id.hh"
+#include "intern/node/deg_node_operation.hh"
 
 namespace blender::deg {
 
+namespace {
+
+/* Gather collections built from the layer collections, matching the nodes builder. Returns false
+ * when the relations builder handles them differently, which happens when a layer collection is
+ * nested in an excluded one without being excluded itself. */
+bool collect_layer_collections(ListBase *layer_collections,
+                               Collection *parent_collection,
+                               const int visibility_flag,
+                               const bool is_parent_excluded,
+                               Vector<ViewLayerCollection> &r_layer_collections)
+{
+  LISTBASE_FOREACH (LayerCollection *, lc, layer_collections) {
+    if (lc->collection->flag & visibility_flag) {
+      continue;
+    }
+    const bool is_excluded = (lc->flag & LAYER_COLLECTION_EXCLUDE) != 0;
+    if (!is_excluded) {
+      if (is_parent_excluded) {
+        return false;
+      }
+      r_layer_collections.append({lc, parent_collection});
+    }
+    if (!collect_layer_collections(&lc->layer_collections,
+                                   lc->collection,
+                                   visibility_flag,
+                                   is_excluded || is_parent_excluded,
+                                   r_layer_collections))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Objects which are gathered into scene-wide data along with the relations (physics relations,
+ * light linking), which is not updated incrementally. */
+bool object_affects_scene_relations(const Object *object)
+{
+  if (object->pd != nullptr && (object->pd->forcefield != PFIELD_NULL || object->pd->deflect)) {
+    return true;
+  }
+  if (object->rigidbody_object != nullptr || object->rigidbody_constraint != nullptr) {
+    return true;
+  }
+  if (!BLI_listbase_is_empty(&object->particlesystem)) {
+    return true;
+  }
+  LISTBASE_FOREACH (const ModifierData *, md, &object->modifiers) {
+    if (ELEM(md->type, eModifierType_Fluid, eModifierType_DynamicPaint)) {
+      return true;
+    }
+  }
+  return object->light_linking != nullptr;
+}
+
+/* IDs which are only pulled into the graph through relations of other IDs. They can be removed
+ * from the graph once no remaining ID depends on them. */
+bool is_id_type_removable(const ID_Type id_type)
+{
+  switch (id_type) {
+    case ID_OB:
+    case ID_GR:
+    case ID_ME:
+    case ID_CU_LEGACY:
+    case ID_MB:
+    case ID_LT:
+    case ID_AR:
+    case ID_CV:
+    case ID_PT:
+    case ID_VO:
+    case ID_GP:
+    case ID_GD_LEGACY:
+    case ID_LA:
+    case ID_CA:
+    case ID_LP:
+    case ID_SPK:
+    case ID_KE:
+    case ID_MA:
+    case ID_TE:
+    case ID_IM:
+    case ID_NT:
+    case ID_AC:
+    case ID_PA:
+      return true;
+    default:
+      return false;
+  }
+}
+
+IDNode *get_operation_id_node(const Node *node)
+{
+  if (node->type != NodeType::OPERATION) {
+    return nullptr;
+  }
+  return static_cast<const OperationNode *>(node)->owner->owner;
+}
+
+/* Relations from a collection built from a layer collection to the objects and nested
+ * collections in it. They only exist because the collection is in the view layer, so they do not
+ * prevent the collection from being removed. */
+bool is_layer_collection_hierarchy_relation(const Relation *rel)
+{
+  const OperationNode *op_from = static_cast<const OperationNode *>(rel->from);
+  const OperationNode *op_to = static_cast<const OperationNode *>(rel->to);
+  return op_from->owner->owner->id_type == ID_GR && op_from->owner->type == NodeType::HIERARCHY &&
+         op_to->owner->type == NodeType::HIERARCHY;
+}
+
+/* Find ID nodes to be removed along with the given root ID nodes: the roots themselves and the IDs
+ * which were only pulled into the graph because the roots depend on them. Returns false if any of
+ * the roots is still needed by an ID which stays in the graph. */
+bool find_id_nodes_to_remove(Span<IDNode *> root_id_nodes,
+                             const Set<const ID *> &kept_ids,
+                             Vector<IDNode *> &r_id_nodes)
+{
+  Vector<IDNode *> candidates(root_id_nodes);
+  Set<IDNode *> candidates_set(root_id_nodes);
+  for (int64_t i = 0; i < candidates.size(); i++) {
+    for (ComponentNode *comp_node : candidates[i]->components.values()) {
+      for (OperationNode *op_node : comp_node->operations) {
+        for (Relation *rel : op_node->inlinks) {
+          IDNode *id_node_from = get_operation_id_node(rel->from);
+          if (id_node_from == nullptr || !is_id_type_removable(id_node_from->id_type) ||
+              kept_ids.contains(id_node_from->id_orig))
+          {
+            continue;
+          }
+          if (candidates_set.add(id_node_from)) {
+            candidates.append(id_node_from);
+          }
+        }
+      }
+    }
+  }
+
+  /* Candidates which an ID outside of the candidates depends on are kept in the graph, along
+   * with all the candidates they depend on. */
+  Set<IDNode *> kept_id_nodes;
+  Vector<IDNode *> stack;
+  for (IDNode *id_node : candidates) {
+    bool is_needed = false;
+    for (ComponentNode *comp_node : id_node->components.values()) {
+      for (OperationNode *op_node : comp_node->operations) {
+        for (Relation *rel : op_node->outlinks) {
+          IDNode *id_node_to = get_operation_id_node(rel->to);
+          if (id_node_to == nullptr || candidates_set.contains(id_node_to) ||
+              is_layer_collection_hierarchy_relation(rel))
+          {
+            continue;
+          }
+          is_needed = true;
+          break;
+        }
+      }
+    }
+    if (is_needed) {
+      kept_id_nodes.add(id_node);
+      stack.append(id_node);
+    }
+  }
+  while (!stack.is_empty()) {
+    IDNode *id_node = stack.pop_last();
+    for (ComponentNode *comp_node : id_node->components.values()) {
+      for (OperationNode *op_node : comp_node->operations) {
+        for (Relation *rel : op_node->inlinks) {
+          IDNode *id_node_from = get_operation_id_node(rel->from);
+          if (id_node_from != nullptr && candidates_set.contains(id_node_from) &&
+              kept_id_nodes.add(id_node_from))
+          {
+            stack.append(id_node_from);
+          }
+        }
+      }
+    }
+  }
+
+  for (IDNode *id_node : root_id_nodes) {
+    if (kept_id_nodes.contains(id_node)) {
+      return false;
+    }
+  }
+  for (IDNode *id_node : candidates) {
+    if (kept_id_nodes.contains(id_node)) {
+      continue;
+    }
+    if (id_node->id_type == ID_OB &&
+        object_affects_scene_relations(reinterpret_cast<Object *>(id_node->id_orig)))
+    {
+      return false;
+    }
+    r_id_nodes.append(id_node);
+  }
+  return true;
+}
+
+/* Check whether IDs which stay in the graph reference any of the given added or removed IDs. The
+ * relations of such IDs may depend on whether the referenced IDs are in the graph (for example
+ * when they only use an object that is visible), but they are not rebuilt incrementally. */
+bool kept_ids_reference_any(const Scene *scene,
+                            Span<IDNode *> kept_id_nodes,
+                            const Set<const ID *> &changed_ids)
+{
+  if (changed_ids.is_empty()) {
+    return false;
+  }
+  for (IDNode *id_node : kept_id_nodes) {
+    /* The scene references all objects of the view layer through its bases and master collection,
+     * and collections built from layer collections reference their objects. Their relations to
+     * the changed objects are updated along with the view layer. */
+    if (id_node->id_orig == &scene->id ||
+        (id_node->id_type == ID_GR && !id_node->is_collection_fully_expanded))
+    {
+      continue;
+    }
+    bool found = false;
+    BKE_library_foreach_ID_link(
+        nullptr,
+        id_node->id_orig,
+        [&](LibraryIDLinkCallbackData *cb_data) {
+          const ID *id = *cb_data->id_pointer;
+          if (id == nullptr || (cb_data->cb_flag & IDWALK_CB_LOOPBACK)) {
+            return IDWALK_RET_NOP;
+          }
+          if (changed_ids.contains(id)) {
+            found = true;
+            return IDWALK_RET_STOP_ITER;
+          }
+          return IDWALK_RET_NOP;
+        },
+        nullptr,
+        IDWALK_READONLY);
+    if (found) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
 ViewLayerBuilderPipeline::ViewLayerBuilderPipeline(::Depsgraph *graph)
     : AbstractBuilderPipeline(graph)
 {
@@ -18,6 +276,12 @@ ViewLayerBuilderPipeline::ViewLayerBuilderPipeline(::Depsgraph *graph)
 void ViewLayerBuilderPipeline::build_nodes(DepsgraphNodeBuilder &node_builder)
 {
   node_builder.build_view_layer(scene_, view_layer_, DEG_ID_LINKED_DIRECTLY);
+
+  Vector<Object *> base_objects;
+  Vector<ViewLayerCollection> layer_collections;
+  if (collect_view_layer_roots(node_builder, base_objects, layer_collections)) {
+    store_build_state(base_objects, layer_collections);
+  }
 }
 
 void ViewLayerBuilderPipeline::build_relations(DepsgraphRelationBuilder &relation_builder)
@@ -25,4 +289,272 @@ void ViewLayerBuilderPipeline::build_relations(DepsgraphRelationBuilder &relatio
   relation_builder.build_view_layer(scene_, view_layer_, DEG_ID_LINKED_DIRECTLY);
 }
 
+void ViewLayerBuilderPipeline::build_incremental()
+{
+  double start_time = 0.0;
+  if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+    start_time = BLI_time_now_seconds();
+  }
+
+  if (!build_step_incremental()) {
+    build();
+    return;
+  }
+  build_step_finalize();
+
+  if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+    printf("Depsgraph updated incrementally in %f seconds.\n",
+           BLI_time_now_seconds() - start_time);
+  }
+}
+
+bool ViewLayerBuilderPipeline::build_step_incremental()
+{
+  const ViewLayerBuildState &state = deg_graph_->view_layer_build_state;
+  if (!state.is_valid || state.scene != scene_ || state.view_layer != view_layer_) {
+    return false;
+  }
+  /* Scene-wide data which depends on objects of the view layer, without being tracked by the
+   * incremental update. */
+  if (scene_->set != nullptr || scene_->rigidbody_world != nullptr ||
+      view_layer_->mat_override != nullptr ||
+      !BLI_listbase_is_empty(&view_layer_->freestyle_config.linesets) ||
+      deg_graph_->light_linking_cache.has_light_linking())
+  {
+    return false;
+  }
+  /* Visibility of objects in instanced collections changed. */
+  const int visibility_flag = (deg_graph_->mode == DAG_EVAL_VIEWPORT) ? COLLECTION_HIDE_VIEWPORT :
+                                                                        COLLECTION_HIDE_RENDER;
+  for (const auto item : state.expanded_collection_flags.items()) {
+    if ((item.key->flag & visibility_flag) != item.value) {
+      return false;
+    }
+  }
+
+  unique_ptr<DepsgraphNodeBuilder> node_builder = construct_node_builder();
+
+  Vector<Object *> base_objects;
+  Vector<ViewLayerCollection> layer_collections;
+  if (!collect_view_layer_roots(*node_builder, base_objects, layer_collections)) {
+    return false;
+  }
+
+  /* IDs which are pulled into the graph by the view layer and the scene. */
+  Set<const ID *> kept_ids;
+  for (Object *object : base_objects) {
+    kept_ids.add(&object->id);
+  }
+  for (const ViewLayerCollection &item : layer_collections) {
+    kept_ids.add(&item.layer_collection->collection->id);
+  }
+  if (scene_->camera != nullptr) {
+    kept_ids.add(&scene_->camera->id);
+  }
+  LISTBASE_FOREACH (TimeMarker *, marker, &scene_->markers) {
+    if (marker->camera != nullptr) {
+      kept_ids.add(&marker->camera->id);
+    }
+  }
+
+  /* Objects and collections which are no longer pulled into the graph by the view layer. */
+  Vector<IDNode *> removed_roots;
+  for (Object *object : state.base_objects) {
+    if (kept_ids.contains(&object->id)) {
+      continue;
+    }
+    IDNode *id_node = deg_graph_->find_id_node(&object->id);
+    if (id_node == nullptr || object_affects_scene_relations(object)) {
+      return false;
+    }
+    removed_roots.append(id_node);
+  }
+  Set<pair<Collection *, Collection *>> layer_collections_set;
+  for (const ViewLayerCollection &item : layer_collections) {
+    layer_collections_set.add({item.parent_collection, item.layer_collection->collection});
+  }
+  Set<const Collection *> old_collections;
+  for (const pair<Collection *, Collection *> &item : state.layer_collections) {
+    old_collections.add(item.second);
+    if (layer_collections_set.contains(item)) {
+      continue;
+    }
+    /* Collection is still in the view layer, but with a different parent. */
+    if (kept_ids.contains(&item.second->id)) {
+      return false;
+    }
+    IDNode *id_node = deg_graph_->find_id_node(&item.second->id);
+    /* Collections which are also instanced are built along with their objects. */
+    if (id_node == nullptr || id_node->is_collection_fully_expanded) {
+      return false;
+    }
+    if (!removed_roots.contains(id_node)) {
+      removed_roots.append(id_node);
+    }
+  }
+
+  /* Objects and collections which are newly pulled into the graph by the view layer. They are
+   * required to not be in the graph yet, as IDs pulled in by other IDs are built differently. */
+  Map<const Object *, int> old_base_indices;
+  for (const int i : state.base_objects.index_range()) {
+    old_base_indices.add(state.base_objects[i], i);
+  }
+  Vector<int> added_base_indices;
+  Vector<int> moved_base_indices;
+  for (const int i : base_objects.index_range()) {
+    Object *object = base_objects[i];
+    const int old_base_index = old_base_indices.lookup_default(object, -1);
+    if (old_base_index == -1) {
+      if (deg_graph_->find_id_node(&object->id) != nullptr ||
+          object_affects_scene_relations(object))
+      {
+        return false;
+      }
+      added_base_indices.append(i);
+    }
+    else if (old_base_index != i) {
+      moved_base_indices.append(i);
+    }
+  }
+  Vector<ViewLayerCollection> added_layer_collections;
+  Set<Collection *> kept_layer_collections;
+  const Set<pair<Collection *, Collection *>> old_layer_collections_set(state.layer_collections);
+  for (const ViewLayerCollection &item : layer_collections) {
+    Collection *collection = item.layer_collection->collection;
+    if (old_layer_collections_set.contains({item.parent_collection, collection})) {
+      kept_layer_collections.add(collection);
+      continue;
+    }
+    if (old_collections.contains(collection) ||
+        deg_graph_->find_id_node(&collection->id) != nullptr)
+    {
+      return false;
+    }
+    added_layer_collections.append(item);
+  }
+
+  Vector<IDNode *> removed_id_nodes;
+  if (!find_id_nodes_to_remove(removed_roots, kept_ids, removed_id_nodes)) {
+    return false;
+  }
+
+  /* The graph is modified from here on. */
+  deg_graph_->remove_id_nodes(removed_id_nodes);
+  const int64_t num_existing_id_nodes = deg_graph_->id_nodes.size();
+
+  node_builder->begin_build_incremental(scene_, view_layer_);
+  for (const int i : moved_base_indices) {
+    node_builder->update_object_flags(i, base_objects[i], DEG_ID_LINKED_DIRECTLY);
+  }
+  for (const int i : added_base_indices) {
+    Object *object = base_objects[i];
+    node_builder->build_object(i, object, DEG_ID_LINKED_DIRECTLY, true);
+    deg_graph_->has_animated_visibility |= node_builder->is_object_visibility_animated(object);
+  }
+  for (const ViewLayerCollection &item : added_layer_collections) {
+    node_builder->build_collection(item.layer_collection, item.layer_collection->collection);
+  }
+  node_builder->end_build_incremental();
+
+  Set<const ID *> changed_ids;
+  for (IDNode *id_node : removed_id_nodes) {
+    changed_ids.add(id_node->id_orig);
+  }
+  for (IDNode *id_node : deg_graph_->id_nodes.as_span().drop_front(num_existing_id_nodes)) {
+    changed_ids.add(id_node->id_orig);
+  }
+  const bool use_full_build = kept_ids_reference_any(
+      scene_, deg_graph_->id_nodes.as_span().take_front(num_existing_id_nodes), changed_ids);
+
+  /* Evaluated copies of the removed IDs are no longer referenced by the remaining ones, which are
+   * tagged for update by the end of the build. */
+  /* Free particle settings last, same as when clearing the whole graph. */
+  for (IDNode *id_node : removed_id_nodes) {
+    if (id_node->id_type != ID_PA) {
+      id_node->destroy();
+    }
+  }
+  for (IDNode *id_node : removed_id_nodes) {
+    delete id_node;
+  }
+  if (use_full_build) {
+    /* The full build re-uses the nodes which were already added. */
+    return false;
+  }
+
+  unique_ptr<DepsgraphRelationBuilder> relation_builder = construct_relation_builder();
+  relation_builder->begin_build_incremental(
+      scene_, deg_graph_->id_nodes.as_span().take_front(num_existing_id_nodes));
+  for (const int i : added_base_indices) {
+    relation_builder->build_object_from_view_layer_base(base_objects[i]);
+  }
+  for (const ViewLayerCollection &item : added_layer_collections) {
+    relation_builder->build_view_layer_collection_incremental(item.layer_collection,
+                                                              item.parent_collection);
+  }
+  if (!added_base_indices.is_empty()) {
+    Set<const Object *> added_objects;
+    for (const int i : added_base_indices) {
+      added_objects.add(base_objects[i]);
+    }
+    for (Collection *collection : kept_layer_collections) {
+      LISTBASE_FOREACH (CollectionObject *, cob, &collection->gobject) {
+        if (added_objects.contains(cob->ob)) {
+          relation_builder->build_layer_collection_object_hierarchy(collection, cob->ob);
+        }
+      }
+    }
+  }
+  const Span<IDNode *> added_id_nodes = deg_graph_->id_nodes.as_span().drop_front(
+      num_existing_id_nodes);
+  for (IDNode *id_node : added_id_nodes) {
+    relation_builder->build_copy_on_write_relations(id_node);
+  }
+  for (IDNode *id_node : added_id_nodes) {
+    relation_builder->build_driver_relations(id_node);
+  }
+
+  store_build_state(base_objects, layer_collections);
+  return true;
+}
+
+bool ViewLayerBuilderPipeline::collect_view_layer_roots(
+    DepsgraphBuilder &builder,
+    Vector<Object *> &r_base_objects,
+    Vector<ViewLayerCollection> &r_layer_collections)
+{
+  BKE_view_layer_synced_ensure(scene_, view_layer_);
+  LISTBASE_FOREACH (Base *, base, BKE_view_layer_object_bases_get(view_layer_)) {
+    if (builder.need_pull_base_into_graph(base)) {
+      r_base_objects.append(base->object);
+    }
+  }
+  const int visibility_flag = (deg_graph_->mode == DAG_EVAL_VIEWPORT) ? COLLECTION_HIDE_VIEWPORT :
+                                                                        COLLECTION_HIDE_RENDER;
+  return collect_layer_collections(
+      &view_layer_->layer_collections, nullptr, visibility_flag, false, r_layer_collections);
+}
+
+void ViewLayerBuilderPipeline::store_build_state(Span<Object *> base_objects,
+                                                 Span<ViewLayerCollection> layer_collections)
+{
+  ViewLayerBuildState &state = deg_graph_->view_layer_build_state;
+  state.clear();
+  state.is_valid = true;
+  state.scene = scene_;
+  state.view_layer = view_layer_;
+  state.base_objects.extend(base_objects);
+  for (const ViewLayerCollection &item : layer_collections) {
+    state.layer_collections.append({item.parent_collection, item.layer_collection->collection});
+  }
+  const int visibility_flag = (deg_graph_->mode == DAG_EVAL_VIEWPORT) ? COLLECTION_HIDE_VIEWPORT :
+                                                                        COLLECTION_HIDE_RENDER;
+  for (IDNode *id_node : deg_graph_->id_nodes) {
+    if (id_node->id_type == ID_GR && id_node->is_collection_fully_expanded) {
+      Collection *collection = reinterpret_cast<Collection *>(id_node->id_orig);
+      state.expanded_collection_flags.add(collection, collection->flag & visibility_flag);
+    }
+  }
+}
+
 }  // namespace blender::deg
@@ -10,15 +10,41 @@
 
 #include "pipeline.h"
 
+#include "deg_builder_view_layer_state.h"
+
 namespace blender::deg {
 
+class DepsgraphBuilder;
+
 class ViewLayerBuilderPipeline : public AbstractBuilderPipeline {
  public:
   ViewLayerBuilderPipeline(::Depsgraph *graph);
 
+  /* Update the graph after a change of which objects and collections of the view layer are
+   * visible. Only the nodes and relations of the IDs which are added to or removed from the graph
+   * are built or removed. Falls back to a full build when the change can not be handled
+   * incrementally. */
+  void build_incremental();
+
  protected:
   virtual void build_nodes(DepsgraphNodeBuilder &node_builder) override;
   virtual void build_relations(DepsgraphRelationBuilder &relation_builder) override;
+
+ private:
+  /* Returns false if the graph could not be updated incrementally, in which case a full build has
+   * to follow. The graph is untouched when this is detected before any nodes are changed. When
+   * it is only detected after the nodes have been updated, the nodes of removed IDs have already
+   * been removed and the nodes of added IDs have been built without their relations. */
+  bool build_step_incremental();
+
+  /* Gather objects of the bases and collections of the layer collections which are pulled into
+   * the graph. Returns false if the view layer can not be updated incrementally. */
+  bool collect_view_layer_roots(DepsgraphBuilder &builder,
+                                Vector<Object *> &r_base_objects,
+                                Vector<ViewLayerCollection> &r_layer_collections);
+
+  void store_build_state(Span<Object *> base_objects,
+                         Span<ViewLayerCollection> layer_collections);
 };
 
 }  // namespace blender::deg
@@ -0,0 +1,235 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include <set>
+#include <string>
+
+#include "testing/testing.h"
+
+#include "BKE_collection.hh"
+#include "BKE_idtype.hh"
+#include "BKE_layer.hh"
+#include "BKE_main.hh"
+#include "BKE_object.hh"
+#include "BKE_scene.hh"
+
+#include "DNA_collection_types.h"
+#include "DNA_layer_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "RNA_define.hh"
+
+#include "DEG_depsgraph.hh"
+#include "DEG_depsgraph_build.hh"
+
+#include "intern/depsgraph.hh"
+#include "intern/depsgraph_relation.hh"
+#include "intern/node/deg_node_component.hh"
+#include "intern/node/deg_node_id.hh"
+#include "intern/node/deg_node_operation.hh"
+
+namespace blender::deg::tests {
+
+class ViewLayerIncrementalBuildTest : public ::testing::Test {
+ protected:
+  Main *bmain_ = nullptr;
+  Scene *scene_ = nullptr;
+  ViewLayer *view_layer_ = nullptr;
+  ::Depsgraph *graph_ = nullptr;
+
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+    DEG_register_node_types();
+    RNA_init();
+  }
+
+  static void TearDownTestSuite()
+  {
+    RNA_exit();
+    DEG_free_node_types();
+  }
+
+  void SetUp() override
+  {
+    bmain_ = BKE_main_new();
+    scene_ = BKE_scene_add(bmain_, "Scene");
+    view_layer_ = BKE_view_layer_default_view(scene_);
+  }
+
+  void TearDown() override
+  {
+    if (graph_) {
+      DEG_graph_free(graph_);
+    }
+    BKE_main_free(bmain_);
+  }
+
+  Object *add_object(Collection *collection, const char *name)
+  {
+    Object *object = BKE_object_add_only_object(bmain_, OB_EMPTY, name);
+    BKE_collection_object_add(bmain_, collection, object);
+    return object;
+  }
+
+  void build_graph()
+  {
+    BKE_main_collection_sync(bmain_);
+    graph_ = DEG_graph_new(bmain_, scene_, view_layer_, DAG_EVAL_VIEWPORT);
+    DEG_graph_relations_update(graph_);
+  }
+
+  /** Update the graph after a visibility change, like the user interface does. */
+  void update_graph_for_visibility_change()
+  {
+    BKE_main_collection_sync(bmain_);
+    DEG_graph_tag_relations_visibility_update(graph_);
+    DEG_graph_relations_update(graph_);
+  }
+
+  void expect_graph_matches_full_build()
+  {
+    ::Depsgraph *full_graph = DEG_graph_new(bmain_, scene_, view_layer_, DAG_EVAL_VIEWPORT);
+    DEG_graph_relations_update(full_graph);
+    const Depsgraph &graph = *reinterpret_cast<Depsgraph *>(graph_);
+    const Depsgraph &expected_graph = *reinterpret_cast<Depsgraph *>(full_graph);
+    EXPECT_EQ(graph_operations(graph), graph_operations(expected_graph));
+    EXPECT_EQ(graph_relations(graph), graph_relations(expected_graph));
+    DEG_graph_free(full_graph);
+  }
+
+  IDNode *find_id_node(const ID *id) const
+  {
+    return reinterpret_cast<Depsgraph *>(graph_)->find_id_node(id);
+  }
+
+ private:
+  static std::string node_identifier(const Node *node)
+  {
+    if (node->type != NodeType::OPERATION) {
+      return node->identifier();
+    }
+    const OperationNode *op_node = static_cast<const OperationNode *>(node);
+    const ComponentNode *comp_node = op_node->owner;
+    return std::string(comp_node->owner->id_orig->name) + "/" + nodeTypeAsString(comp_node->type) +
+           "/" + comp_node->name + "/" + op_node->identifier();
+  }
+
+  static std::set<std::string> graph_operations(const Depsgraph &graph)
+  {
+    std::set<std::string> operations;
+    for (const OperationNode *op_node : graph.operations) {
+      operations.insert(node_identifier(op_node));
+    }
+    return operations;
+  }
+
+  static std::set<std::string> graph_relations(const Depsgraph &graph)
+  {
+    std::set<std::string> relations;
+    for (const OperationNode *op_node : graph.operations) {
+      for (const Relation *rel : op_node->inlinks) {
+        relations.insert(node_identifier(rel->from) + " -> " + node_identifier(rel->to) + " (" +
+                         rel->name + ")");
+      }
+    }
+    return relations;
+  }
+};
+
+TEST_F(ViewLayerIncrementalBuildTest, ToggleObjectVisibility)
+{
+  Collection *collection = BKE_collection_add(bmain_, scene_->master_collection, "Collection");
+  Object *object_a = this->add_object(collection, "ObA");
+  Object *object_b = this->add_object(collection, "ObB");
+  Object *object_c = this->add_object(scene_->master_collection, "ObC");
+  this->build_graph();
+
+  const IDNode *id_node_b = this->find_id_node(&object_b->id);
+  ASSERT_NE(id_node_b, nullptr);
+
+  object_a->visibility_flag |= OB_HIDE_VIEWPORT;
+  this->update_graph_for_visibility_change();
+  EXPECT_EQ(this->find_id_node(&object_a->id), nullptr);
+  /* Nodes of unaffected objects are kept by the incremental update. */
+  EXPECT_EQ(this->find_id_node(&object_b->id), id_node_b);
+  this->expect_graph_matches_full_build();
+
+  object_a->visibility_flag &= ~OB_HIDE_VIEWPORT;
+  object_c->visibility_flag |= OB_HIDE_VIEWPORT;
+  this->update_graph_for_visibility_change();
+  EXPECT_NE(this->find_id_node(&object_a->id), nullptr);
+  EXPECT_EQ(this->find_id_node(&object_c->id), nullptr);
+  this->expect_graph_matches_full_build();
+
+  object_c->visibility_flag &= ~OB_HIDE_VIEWPORT;
+  this->update_graph_for_visibility_change();
+  this->expect_graph_matches_full_build();
+}
+
+TEST_F(ViewLayerIncrementalBuildTest, ToggleCollectionVisibility)
+{
+  Collection *collection_a = BKE_collection_add(bmain_, scene_->master_collection, "CollA");
+  Collection *collection_b = BKE_collection_add(bmain_, collection_a, "CollB");
+  Collection *collection_c = BKE_collection_add(bmain_, scene_->master_collection, "CollC");
+  this->add_object(collection_a, "ObA");
+  this->add_object(collection_b, "ObB");
+  this->add_object(collection_c, "ObC");
+  this->build_graph();
+
+  /* Exclude a collection with a nested collection from the view layer. */
+  BKE_view_layer_synced_ensure(scene_, view_layer_);
+  LayerCollection *layer_collection_a = BKE_layer_collection_first_from_scene_collection(
+      view_layer_, collection_a);
+  ASSERT_NE(layer_collection_a, nullptr);
+  layer_collection_a->flag |= LAYER_COLLECTION_EXCLUDE;
+  this->update_graph_for_visibility_change();
+  EXPECT_EQ(this->find_id_node(&collection_a->id), nullptr);
+  this->expect_graph_matches_full_build();
+
+  layer_collection_a->flag &= ~LAYER_COLLECTION_EXCLUDE;
+  this->update_graph_for_visibility_change();
+  EXPECT_NE(this->find_id_node(&collection_a->id), nullptr);
+  this->expect_graph_matches_full_build();
+
+  /* Hide a collection in the viewport for all view layers. */
+  collection_c->flag |= COLLECTION_HIDE_VIEWPORT;
+  this->update_graph_for_visibility_change();
+  this->expect_graph_matches_full_build();
+
+  collection_c->flag &= ~COLLECTION_HIDE_VIEWPORT;
+  this->update_graph_for_visibility_change();
+  this->expect_graph_matches_full_build();
+}
+
+TEST_F(ViewLayerIncrementalBuildTest, HiddenObjectUsedByVisibleObject)
+{
+  Object *parent = this->add_object(scene_->master_collection, "Parent");
+  Object *child = this->add_object(scene_->master_collection, "Child");
+  child->parent = parent;
+  this->build_graph();
+
+  /* The parent stays in the graph because the child depends on it. */
+  parent->visibility_flag |= OB_HIDE_VIEWPORT;
+  this->update_graph_for_visibility_change();
+  EXPECT_NE(this->find_id_node(&parent->id), nullptr);
+  this->expect_graph_matches_full_build();
+
+  parent->visibility_flag &= ~OB_HIDE_VIEWPORT;
+  child->visibility_flag |= OB_HIDE_VIEWPORT;
+  this->update_graph_for_visibility_change();
+  EXPECT_EQ(this->find_id_node(&child->id), nullptr);
+  this->expect_graph_matches_full_build();
+
+  child->visibility_flag &= ~OB_HIDE_VIEWPORT;
+  this->update_graph_for_visibility_change();
+  this->expect_graph_matches_full_build();
+}
+
+}  // namespace blender::deg::tests
@@ -0,0 +1,185 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/debug/deg_debug_trace.h"
+
+#include <atomic>
+#include <utility>
+
+#include "BLI_enumerable_thread_specific.hh"
+#include "BLI_fileops.hh"
+#include "BLI_serialize.hh"
+#include "BLI_threads.h"
+#include "BLI_time.h"
+#include "BLI_vector.hh"
+
+#include "DEG_depsgraph_debug.hh"
+
+#include "intern/debug/deg_debug.h"
+
+namespace deg = blender::deg;
+
+namespace blender::deg {
+namespace {
+
+struct TraceEvent {
+  std::string name;
+  std::string category;
+  std::string id_name;
+  double start_time;
+  double end_time;
+};
+
+/* Events recorded by a single thread, so that recording does not need any synchronization. */
+struct ThreadTrace {
+  int thread_index;
+  bool is_main_thread;
+  Vector<TraceEvent> events;
+};
+
+struct TraceState {
+  std::string filepath;
+  /* Time at which the tracing began, event times are written relative to it. */
+  double start_time;
+  std::atomic<int> next_thread_index = 0;
+  threading::EnumerableThreadSpecific<ThreadTrace> threads;
+
+  TraceState()
+      : threads([this]() {
+          return ThreadTrace{next_thread_index.fetch_add(1), bool(BLI_thread_is_main()), {}};
+        })
+  {
+  }
+};
+
+TraceState *trace_state = nullptr;
+std::atomic<bool> trace_enabled = false;
+/* Events are recorded with a read lock, so that the state is not freed while worker threads are
+ * still adding events to it. */
+ThreadRWMutex trace_rwlock = BLI_RWLOCK_INITIALIZER;
+
+int64_t trace_time_to_microseconds(const TraceState &state, const double time)
+{
+  return int64_t((time - state.start_time) * 1e6);
+}
+
+void trace_write(TraceState &state)
+{
+  using namespace io::serialize;
+
+  DictionaryValue root;
+  ArrayValue &events = *root.append_array("traceEvents");
+  for (const ThreadTrace &thread : state.threads) {
+    /* Name the timeline of the thread. */
+    std::shared_ptr<DictionaryValue> thread_name = events.append_dict();
+    thread_name->append_str("name", "thread_name");
+    thread_name->append_str("ph", "M");
+    thread_name->append_int("pid", 1);
+    thread_name->append_int("tid", thread.thread_index);
+    thread_name->append_dict("args")->append_str(
+        "name",
+        thread.is_main_thread ? std::string("Main") :
+                                "Worker " + std::to_string(thread.thread_index));
+
+    for (const TraceEvent &event : thread.events) {
+      const int64_t start = trace_time_to_microseconds(state, event.start_time);
+      const int64_t end = trace_time_to_microseconds(state, event.end_time);
+      std::shared_ptr<DictionaryValue> value = events.append_dict();
+      value->append_str("name", event.name);
+      value->append_str("cat", event.category);
+      value->append_str("ph", "X");
+      value->append_int("ts", start);
+      value->append_int("dur", std::max<int64_t>(end - start, 0));
+      value->append_int("pid", 1);
+      value->append_int("tid", thread.thread_index);
+      if (!event.id_name.empty()) {
+        value->append_dict("args")->append_str("id", event.id_name);
+      }
+    }
+  }
+  root.append_str("displayTimeUnit", "ms");
+
+  blender::fstream stream(state.filepath, std::ios::out | std::ios::trunc);
+  if (!stream.is_open()) {
+    DEG_ERROR_PRINTF("Error writing depsgraph trace to '%s'\n", state.filepath.c_str());
+    return;
+  }
+  JsonFormatter formatter;
+  formatter.serialize(stream, root);
+}
+
+}  // namespace
+
+bool trace_is_enabled()
+{
+  return trace_enabled.load(std::memory_order_relaxed);
+}
+
+double trace_time_now()
+{
+  return BLI_time_now_seconds();
+}
+
+void trace_add_event(const StringRef name,
+                     const StringRef category,
+                     const StringRef id_name,
+                     const double start_time,
+                     const double end_time)
+{
+  if (!trace_is_enabled()) {
+    return;
+  }
+  BLI_rw_mutex_lock(&trace_rwlock, THREAD_LOCK_READ);
+  if (trace_state != nullptr) {
+    trace_state->threads.local().events.append({name, category, id_name, start_time, end_time});
+  }
+  BLI_rw_mutex_unlock(&trace_rwlock);
+}
+
+}  // namespace blender::deg
+
+void DEG_debug_trace_begin(const char *filepath)
+{
+  DEG_debug_trace_end();
+
+  BLI_rw_mutex_lock(&deg::trace_rwlock, THREAD_LOCK_WRITE);
+  deg::trace_state = new deg::TraceState();
+  deg::trace_state->filepath = filepath;
+  deg::trace_state->start_time = deg::trace_time_now();
+  deg::trace_enabled = true;
+  BLI_rw_mutex_unlock(&deg::trace_rwlock);
+}
+
+void DEG_debug_trace_end()
+{
+  /* Wait for threads which are still recording events before writing and freeing them. */
+  BLI_rw_mutex_lock(&deg::trace_rwlock, THREAD_LOCK_WRITE);
+  deg::TraceState *state = std::exchange(deg::trace_state, nullptr);
+  deg::trace_enabled = false;
+  BLI_rw_mutex_unlock(&deg::trace_rwlock);
+
+  if (state == nullptr) {
+    return;
+  }
+  deg::trace_write(*state);
+  delete state;
+}
+
+bool DEG_debug_trace_is_enabled()
+{
+  return deg::trace_is_enabled();
+}
+
+void DEG_debug_trace_add_scope(const char *name, const char *category, const double duration)
+{
+  if (!deg::trace_is_enabled()) {
+    return;
+  }
+  const double end_time = deg::trace_time_now();
+  deg::trace_add_event(name, category, "", end_time - duration, end_time);
+}
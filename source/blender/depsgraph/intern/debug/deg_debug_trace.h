@@ -0,0 +1,34 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+/** \file
+ * \ingroup depsgraph
+ *
+ * Recording of the dependency graph evaluation as a timeline of events, which is written in the
+ * Chrome trace event format. Such file can be opened in `chrome://tracing` or Perfetto.
+ */
+
+#pragma once
+
+#include "BLI_string_ref.hh"
+
+#include "intern/depsgraph_type.hh"
+
+namespace blender::deg {
+
+/* Tracing is enabled from #DEG_debug_trace_begin until #DEG_debug_trace_end. */
+bool trace_is_enabled();
+
+/* Current time in seconds, in the clock used for the events. */
+double trace_time_now();
+
+/* Add an event to the timeline of the calling thread. Events of the same thread which overlap in
+ * time are shown nested. The ID name is shown in the event details, it can be empty. */
+void trace_add_event(StringRef name,
+                     StringRef category,
+                     StringRef id_name,
+                     double start_time,
+                     double end_time);
+
+}  // namespace blender::deg
@@ -48,6 +48,7 @@ Depsgraph::Depsgraph(Main *bmain, Scene *scene, ViewLayer *view_layer, eEvaluati
     : time_source(nullptr),
       has_animated_visibility(false),
       need_update_relations(true),
+      need_update_relations_visibility_only(false),
       need_update_nodes_visibility(true),
       need_tag_id_on_graph_visibility_update(true),
       need_tag_id_on_graph_visibility_time_update(false),
@@ -174,6 +175,47 @@ void Depsgraph::clear_id_nodes()
   light_linking_cache.clear();
 }
 
+void Depsgraph::remove_id_nodes(Span<IDNode *> id_nodes_to_remove)
+{
+  if (id_nodes_to_remove.is_empty()) {
+    return;
+  }
+  const Set<const IDNode *> removed_id_nodes(id_nodes_to_remove);
+  auto is_removed_node = [&](const Node *node) {
+    if (node->type != NodeType::OPERATION) {
+      return false;
+    }
+    const OperationNode *op_node = static_cast<const OperationNode *>(node);
+    return removed_id_nodes.contains(op_node->owner->owner);
+  };
+
+  for (IDNode *id_node : id_nodes_to_remove) {
+    for (ComponentNode *comp_node : id_node->components.values()) {
+      for (OperationNode *op_node : comp_node->operations) {
+        /* Incoming relations are freed along with the node, only unlink them from the nodes which
+         * stay in the graph. */
+        for (Relation *rel : op_node->inlinks) {
+          if (!is_removed_node(rel->from)) {
+            rel->from->outlinks.remove_first_occurrence_and_reorder(rel);
+          }
+        }
+        /* Outgoing relations are owned by the nodes they point to. */
+        for (Relation *rel : op_node->outlinks) {
+          if (!is_removed_node(rel->to)) {
+            rel->to->inlinks.remove_first_occurrence_and_reorder(rel);
+            delete rel;
+          }
+        }
+        entry_tags.remove(op_node);
+      }
+    }
+    id_hash.remove(id_node->id_orig);
+  }
+
+  id_nodes.remove_if([&](const IDNode *id_node) { return removed_id_nodes.contains(id_node); });
+  operations.remove_if([&](const OperationNode *op_node) { return is_removed_node(op_node); });
+}
+
 Relation *Depsgraph::add_new_relation(Node *from, Node *to, const char *description, int flags)
 {
   Relation *rel = nullptr;
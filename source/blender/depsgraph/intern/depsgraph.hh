@@ -27,6 +27,7 @@
 #include "DEG_depsgraph.hh"
 #include "DEG_depsgraph_physics.hh"
 
+#include "intern/builder/deg_builder_view_layer_state.h"
 #include "intern/debug/deg_debug.h"
 #include "intern/depsgraph_light_linking.hh"
 #include "intern/depsgraph_type.hh"
@@ -58,6 +59,10 @@ struct Depsgraph {
   IDNode *find_id_node(const ID *id) const;
   IDNode *add_id_node(ID *id, ID *id_cow_hint = nullptr);
   void clear_id_nodes();
+  /* Remove ID nodes from the graph, along with their relations to the nodes which stay in the
+   * graph. The nodes are not freed, so that their evaluated copies stay valid until the remaining
+   * evaluated data-blocks no longer reference them. */
+  void remove_id_nodes(Span<IDNode *> id_nodes_to_remove);
 
   /** Add new relationship between two nodes. */
   Relation *add_new_relation(Node *from, Node *to, const char *description, int flags = 0);
@@ -97,6 +102,9 @@ struct Depsgraph {
 
   /* Indicates whether relations needs to be updated. */
   bool need_update_relations;
+  /* Relations only need to be updated because of a change of which objects and collections of the
+   * view layer are visible, which allows to update them incrementally. */
+  bool need_update_relations_visibility_only;
 
   /* Indicates whether indirect effect of nodes on a directly visible ones needs to be updated. */
   bool need_update_nodes_visibility;
@@ -175,6 +183,10 @@ struct Depsgraph {
 
   light_linking::Cache light_linking_cache;
 
+  /* Objects and collections of the view layer the graph was built from, used by the incremental
+   * relations update. */
+  ViewLayerBuildState view_layer_build_state;
+
   /* The number of times this graph has been evaluated. */
   uint64_t update_count;
 
@@ -288,6 +288,7 @@ void DEG_graph_tag_relations_update(Depsgraph *graph)
   DEG_DEBUG_PRINTF(graph, TAG, "%s: Tagging relations for update.\n", __func__);
   deg::Depsgraph *deg_graph = reinterpret_cast<deg::Depsgraph *>(graph);
   deg_graph->need_update_relations = true;
+  deg_graph->need_update_relations_visibility_only = false;
 
   /* NOTE: When relations are updated, it's quite possible that we've got new bases in the scene.
    * This means, we need to re-create flat array of bases in view layer. */
@@ -311,6 +312,11 @@ void DEG_graph_relations_update(Depsgraph *graph)
     /* Graph is up to date, nothing to do. */
     return;
   }
+  if (deg_graph->need_update_relations_visibility_only) {
+    deg::ViewLayerBuilderPipeline builder(graph);
+    builder.build_incremental();
+    return;
+  }
   DEG_graph_build_from_view_layer(graph);
 }
 
@@ -321,3 +327,21 @@ void DEG_relations_tag_update(Main *bmain)
     DEG_graph_tag_relations_update(reinterpret_cast<Depsgraph *>(depsgraph));
   }
 }
+
+void DEG_graph_tag_relations_visibility_update(Depsgraph *graph)
+{
+  deg::Depsgraph *deg_graph = reinterpret_cast<deg::Depsgraph *>(graph);
+  /* Relations might already be tagged for a full update, which has to be preserved. */
+  const bool need_full_update = deg_graph->need_update_relations &&
+                                !deg_graph->need_update_relations_visibility_only;
+  DEG_graph_tag_relations_update(graph);
+  deg_graph->need_update_relations_visibility_only = !need_full_update;
+}
+
+void DEG_relations_tag_visibility_update(Main *bmain)
+{
+  DEG_GLOBAL_DEBUG_PRINTF(TAG, "%s: Tagging relations for visibility update.\n", __func__);
+  for (deg::Depsgraph *depsgraph : deg::get_all_registered_graphs(bmain)) {
+    DEG_graph_tag_relations_visibility_update(reinterpret_cast<Depsgraph *>(depsgraph));
+  }
+}
@@ -11,10 +11,13 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_listbase.h"
+#include "BLI_task.hh"
 #include "BLI_utildefines.h"
 
+#include "BKE_callbacks.hh"
 #include "BKE_scene.hh"
 
+#include "DNA_modifier_types.h"
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 
@@ -26,6 +29,7 @@
 #include "intern/eval/deg_eval_flush.h"
 
 #include "intern/node/deg_node.hh"
+#include "intern/node/deg_node_id.hh"
 #include "intern/node/deg_node_operation.hh"
 #include "intern/node/deg_node_time.hh"
 
@@ -92,3 +96,81 @@ void DEG_evaluate_on_framechange(Depsgraph *graph,
   deg_graph->ctime = BKE_scene_frame_to_ctime(scene, frame);
   deg_flush_updates_and_refresh(deg_graph, sync_writeback);
 }
+
+static bool object_is_frame_independent(const Object *object)
+{
+  if (!BLI_listbase_is_empty(&object->particlesystem) || object->soft != nullptr ||
+      object->rigidbody_object != nullptr)
+  {
+    return false;
+  }
+  LISTBASE_FOREACH (const ModifierData *, md, &object->modifiers) {
+    /* Modifiers which store state of the previous frame or read simulation caches. */
+    if (ELEM(md->type,
+             eModifierType_Softbody,
+             eModifierType_Cloth,
+             eModifierType_Collision,
+             eModifierType_Surface,
+             eModifierType_DynamicPaint,
+             eModifierType_Fluid))
+    {
+      return false;
+    }
+    if (md->type == eModifierType_Nodes &&
+        reinterpret_cast<const NodesModifierData *>(md)->bakes_num > 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DEG_graph_is_frame_independent(const Depsgraph *graph)
+{
+  const deg::Depsgraph *deg_graph = reinterpret_cast<const deg::Depsgraph *>(graph);
+  if (deg_graph->scene->rigidbody_world != nullptr) {
+    return false;
+  }
+  for (const deg::IDNode *id_node : deg_graph->id_nodes) {
+    if (id_node->id_type == ID_OB &&
+        !object_is_frame_independent(reinterpret_cast<const Object *>(id_node->id_orig)))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void DEG_evaluate_frames_parallel(
+    const blender::Span<Depsgraph *> graphs,
+    const blender::Span<float> frames,
+    const blender::FunctionRef<bool(Depsgraph *graph, float frame)> frame_fn)
+{
+  using namespace blender;
+  BLI_assert(!graphs.is_empty());
+#ifndef NDEBUG
+  for (Depsgraph *graph : graphs) {
+    BLI_assert(!reinterpret_cast<deg::Depsgraph *>(graph)->is_active);
+    BLI_assert(DEG_graph_is_frame_independent(graph));
+  }
+  BLI_assert(!BKE_callback_is_used(BKE_CB_EVT_FRAME_CHANGE_PRE));
+  BLI_assert(!BKE_callback_is_used(BKE_CB_EVT_FRAME_CHANGE_POST));
+#endif
+
+  for (int64_t batch_start = 0; batch_start < frames.size(); batch_start += graphs.size()) {
+    const Span<float> batch_frames = frames.slice(
+        batch_start, std::min(graphs.size(), frames.size() - batch_start));
+    /* A single graph often can not keep all threads busy, so the graphs are evaluated at once
+     * while each of them still evaluates its operations on multiple threads. */
+    threading::parallel_for(batch_frames.index_range(), 1, [&](const IndexRange range) {
+      for (const int64_t i : range) {
+        DEG_evaluate_on_framechange(graphs[i], batch_frames[i]);
+      }
+    });
+    for (const int64_t i : batch_frames.index_range()) {
+      if (!frame_fn(graphs[i], batch_frames[i])) {
+        return;
+      }
+    }
+  }
+}
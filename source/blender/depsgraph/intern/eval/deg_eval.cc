@@ -10,10 +10,15 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <mutex>
+
 #include "BLI_compiler_attrs.h"
 #include "BLI_function_ref.hh"
 #include "BLI_gsqueue.h"
+#include "BLI_heap_simple.h"
+#include "BLI_stack.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_time.h"
 #include "BLI_utildefines.h"
 
@@ -32,6 +37,7 @@
 
 #include "atomic_ops.h"
 
+#include "intern/debug/deg_debug_trace.h"
 #include "intern/depsgraph.hh"
 #include "intern/depsgraph_relation.hh"
 #include "intern/depsgraph_tag.hh"
@@ -52,6 +58,7 @@ namespace {
 struct DepsgraphEvalState;
 
 void deg_task_run_func(TaskPool *pool, void *taskdata);
+void deg_task_run_priority_func(TaskPool *pool, void *taskdata);
 
 void schedule_children(DepsgraphEvalState *state,
                        OperationNode *node,
@@ -80,22 +87,58 @@ enum class EvaluationStage {
 struct DepsgraphEvalState {
   Depsgraph *graph;
   bool do_stats;
+  /* Record every evaluated operation in the evaluation trace. */
+  bool do_trace = false;
   EvaluationStage stage;
   bool need_update_pending_parents = true;
   bool need_single_thread_pass = false;
+
+  /* Evaluate operations on the critical path first during the threaded evaluation stage, instead
+   * of evaluating operations in the order they become ready. */
+  bool use_priority_scheduling = false;
+  /* Operations ready to be evaluated, ordered by their negated #OperationNode::priority. */
+  HeapSimple *ready_operations = nullptr;
+  std::mutex ready_operations_mutex;
+  /* Measure all operations to refresh their cost for the priority scheduling. Only done for a
+   * fraction of the evaluations, since the costs change slowly and timing every operation has a
+   * measurable overhead for cheap operations. */
+  bool do_priority_timing = false;
 };
 
+/* Refresh the operation costs used for priority scheduling once every this many updates. */
+static constexpr int PRIORITY_TIMING_INTERVAL = 16;
+
 void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_node)
 {
   ::Depsgraph *depsgraph = reinterpret_cast<::Depsgraph *>(state->graph);
 
   /* Sanity checks. */
   BLI_assert_msg(!operation_node->is_noop(), "NOOP nodes should not actually be scheduled");
+  /* Operations which were never timed are measured right away, so that a new graph gets usable
+   * priorities after its first evaluation. */
+  const bool do_timing = state->do_priority_timing ||
+                         (state->use_priority_scheduling &&
+                          operation_node->stats.average_time == 0.0);
   /* Perform operation. */
-  if (state->do_stats) {
+  if (state->do_stats || state->do_trace || do_timing) {
     const double start_time = BLI_time_now_seconds();
     operation_node->evaluate(depsgraph);
-    operation_node->stats.current_time += BLI_time_now_seconds() - start_time;
+    const double end_time = BLI_time_now_seconds();
+    const double time = end_time - start_time;
+    if (state->do_stats) {
+      operation_node->stats.current_time += time;
+    }
+    if (state->do_trace) {
+      const ComponentNode *comp_node = operation_node->owner;
+      trace_add_event(operation_node->full_identifier(),
+                      nodeTypeAsString(comp_node->type),
+                      comp_node->owner->name,
+                      start_time,
+                      end_time);
+    }
+    if (do_timing) {
+      deg_eval_stats_operation_timing_add(operation_node, time);
+    }
   }
   else {
     operation_node->evaluate(depsgraph);
@@ -123,6 +166,37 @@ void deg_task_run_func(TaskPool *pool, void *taskdata)
   });
 }
 
+void schedule_operation_with_priority(DepsgraphEvalState *state,
+                                      TaskPool *pool,
+                                      OperationNode *node)
+{
+  {
+    std::lock_guard<std::mutex> lock{state->ready_operations_mutex};
+    BLI_heapsimple_insert(state->ready_operations, -node->priority, node);
+  }
+  /* Every task evaluates the ready operation with the highest priority at the time it starts,
+   * which is not necessarily the operation that was just added. */
+  BLI_task_pool_push(pool, deg_task_run_priority_func, nullptr, false, nullptr);
+}
+
+void deg_task_run_priority_func(TaskPool *pool, void * /*taskdata*/)
+{
+  void *userdata_v = BLI_task_pool_user_data(pool);
+  DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
+
+  OperationNode *operation_node;
+  {
+    std::lock_guard<std::mutex> lock{state->ready_operations_mutex};
+    operation_node = static_cast<OperationNode *>(
+        BLI_heapsimple_pop_min(state->ready_operations));
+  }
+  evaluate_node(state, operation_node);
+
+  schedule_children(state, operation_node, [&](OperationNode *node) {
+    schedule_operation_with_priority(state, pool, node);
+  });
+}
+
 bool check_operation_node_visible(const DepsgraphEvalState *state, OperationNode *op_node)
 {
   const ComponentNode *comp_node = op_node->owner;
@@ -186,6 +260,60 @@ void calculate_pending_parents_if_needed(DepsgraphEvalState *state)
   state->need_update_pending_parents = false;
 }
 
+bool need_evaluate_operation(const DepsgraphEvalState *state, OperationNode *node)
+{
+  return (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) && check_operation_node_visible(state, node);
+}
+
+/* Calculate the estimated cost of the longest chain of operations starting with every operation
+ * that is to be evaluated, so that operations on the critical path of the graph can be evaluated
+ * first. Chains are traversed from their end, similar to the visibility flush. */
+void calculate_priorities(const DepsgraphEvalState *state)
+{
+  BLI_Stack *stack = BLI_stack_new(sizeof(OperationNode *), "DEG priorities stack");
+
+  for (OperationNode *op_node : state->graph->operations) {
+    op_node->priority = 0.0f;
+    /* Number of children which are to be handled before the operation itself. */
+    op_node->custom_flags = 0;
+    if (!need_evaluate_operation(state, op_node)) {
+      continue;
+    }
+    for (Relation *rel : op_node->outlinks) {
+      if ((rel->to->type == NodeType::OPERATION) && (rel->flag & RELATION_FLAG_CYCLIC) == 0 &&
+          need_evaluate_operation(state, (OperationNode *)rel->to))
+      {
+        ++op_node->custom_flags;
+      }
+    }
+    if (op_node->custom_flags == 0) {
+      BLI_stack_push(stack, &op_node);
+    }
+  }
+
+  while (!BLI_stack_is_empty(stack)) {
+    OperationNode *op_node;
+    BLI_stack_pop(stack, &op_node);
+    /* The priority contains the highest priority of the children at this point. */
+    op_node->priority += float(deg_eval_stats_operation_cost(op_node));
+    for (Relation *rel : op_node->inlinks) {
+      if ((rel->from->type != NodeType::OPERATION) || (rel->flag & RELATION_FLAG_CYCLIC) != 0) {
+        continue;
+      }
+      OperationNode *op_from = (OperationNode *)rel->from;
+      if (!need_evaluate_operation(state, op_from)) {
+        continue;
+      }
+      op_from->priority = std::max(op_from->priority, op_node->priority);
+      if (--op_from->custom_flags == 0) {
+        BLI_stack_push(stack, &op_from);
+      }
+    }
+  }
+
+  BLI_stack_free(stack);
+}
+
 void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
 {
   /* Clear tags and other things which needs to be clear. */
@@ -317,6 +445,18 @@ void evaluate_graph_threaded_stage(DepsgraphEvalState *state,
 
   calculate_pending_parents_if_needed(state);
 
+  if (state->use_priority_scheduling && stage == EvaluationStage::THREADED_EVALUATION) {
+    calculate_priorities(state);
+    state->ready_operations = BLI_heapsimple_new();
+    schedule_graph(state, [&](OperationNode *node) {
+      schedule_operation_with_priority(state, task_pool, node);
+    });
+    BLI_task_pool_work_and_wait(task_pool);
+    BLI_heapsimple_free(state->ready_operations, nullptr);
+    state->ready_operations = nullptr;
+    return;
+  }
+
   schedule_graph(state, [&](OperationNode *node) {
     BLI_task_pool_push(task_pool, deg_task_run_func, node, false, nullptr);
   });
@@ -389,6 +529,7 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   graph->update_count++;
 
   graph->debug.begin_graph_evaluation();
+  const double trace_start_time = trace_is_enabled() ? trace_time_now() : 0.0;
 
 #ifdef WITH_PYTHON
   /* Release the GIL so that Python drivers can be evaluated. See #91046. */
@@ -402,6 +543,12 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   DepsgraphEvalState state;
   state.graph = graph;
   state.do_stats = graph->debug.do_time_debug();
+  state.do_trace = trace_is_enabled();
+  /* The evaluation order doesn't matter without multiple threads. */
+  state.use_priority_scheduling = (G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS) == 0 &&
+                                  BLI_system_thread_count() > 1;
+  state.do_priority_timing = state.use_priority_scheduling &&
+                             (graph->update_count % PRIORITY_TIMING_INTERVAL) == 1;
 
   /* Prepare all nodes for evaluation. */
   initialize_execution(&state, graph);
@@ -465,6 +612,14 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   BPy_END_ALLOW_THREADS;
 #endif
 
+  if (state.do_trace) {
+    trace_add_event(graph->debug.name.empty() ? "Depsgraph" : "Depsgraph " + graph->debug.name,
+                    "DEPSGRAPH",
+                    "",
+                    trace_start_time,
+                    trace_time_now());
+  }
+
   graph->debug.end_graph_evaluation();
 }
 
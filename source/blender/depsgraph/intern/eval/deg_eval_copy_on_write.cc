@@ -725,6 +725,9 @@ void update_id_after_copy(const Depsgraph *depsgraph,
       Scene *scene_cow = (Scene *)id_cow;
       const Scene *scene_orig = (const Scene *)id_orig;
       scene_cow->toolsettings = scene_orig->toolsettings;
+      /* The graph may be evaluated at another frame than the original scene, see
+       * #DEG_evaluate_on_framechange. */
+      BKE_scene_frame_set(scene_cow, depsgraph->frame);
       scene_setup_view_layers_after_remap(depsgraph, id_node, reinterpret_cast<Scene *>(id_cow));
       break;
     }
@@ -8,6 +8,8 @@
 
 #include "intern/eval/deg_eval_stats.h"
 
+#include <algorithm>
+
 #include "BLI_utildefines.h"
 
 #include "intern/depsgraph.hh"
@@ -39,4 +41,22 @@ void deg_eval_stats_aggregate(Depsgraph *graph)
   }
 }
 
+void deg_eval_stats_operation_timing_add(OperationNode *op_node, const double time)
+{
+  Node::Stats &stats = op_node->stats;
+  /* Favor recent timings, as the cost of operations changes with the data they evaluate. */
+  stats.average_time = (stats.average_time == 0.0) ? time : (stats.average_time + time) * 0.5;
+}
+
+double deg_eval_stats_operation_cost(const OperationNode *op_node)
+{
+  if (op_node->is_noop()) {
+    return 0.0;
+  }
+  /* Operations which were not evaluated yet are assumed to be cheap, this still gives priority
+   * to longer chains of operations. */
+  const double default_cost = 1e-6;
+  return std::max(op_node->stats.average_time, default_cost);
+}
+
 }  // namespace blender::deg
@@ -11,8 +11,15 @@
 namespace blender::deg {
 
 struct Depsgraph;
+struct OperationNode;
 
 /* Aggregate operation timings to overall component and ID nodes timing. */
 void deg_eval_stats_aggregate(Depsgraph *graph);
 
+/* Accumulate the time spent on evaluating an operation into its average evaluation time. */
+void deg_eval_stats_operation_timing_add(OperationNode *op_node, double time);
+
+/* Estimated time needed to evaluate the operation, based on its previous evaluations. */
+double deg_eval_stats_operation_cost(const OperationNode *op_node);
+
 }  // namespace blender::deg
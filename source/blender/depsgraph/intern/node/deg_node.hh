@@ -168,6 +168,9 @@ struct Node {
     void reset_current();
     /* Time spent on this node during current graph evaluation. */
     double current_time;
+    /* Moving average of the time spent on this node in previous graph evaluations, used to
+     * estimate the cost of evaluating it again. Only maintained for operation nodes. */
+    double average_time;
   };
   /* Relationships between nodes
    * The reason why all depsgraph nodes are descended from this type (apart
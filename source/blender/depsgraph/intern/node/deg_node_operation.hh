@@ -280,6 +280,9 @@ struct OperationNode : public Node {
   /* How many inlinks are we still waiting on before we can be evaluated. */
   uint32_t num_links_pending;
   bool scheduled;
+  /* Estimated time to evaluate the longest chain of operations starting with this one.
+   * Operations with a higher priority are evaluated first. */
+  float priority;
 
   /* Identifier for the operation being performed. */
   OperationCode opcode;
@@ -8,8 +8,13 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <optional>
+
 #include "BLI_math_matrix_types.hh"
 #include "BLI_utildefines.h"
+#include "BLI_vector.hh"
 
 #include "GPU_shader.hh"
 
@@ -21,6 +26,10 @@ class IndexBuf;
 }  // namespace blender::gpu
 struct TaskGraph;
 
+namespace blender::bke {
+enum class MeshNormalDomain : int8_t;
+}
+
 namespace blender::draw {
 
 struct MeshRenderData;
@@ -210,6 +219,47 @@ struct SortedFaceData {
   std::optional<Array<int>> face_tri_offsets;
 };
 
+/**
+ * Triangles sorted by material for one combination of material indices, hidden faces and
+ * triangulation of the meshes sharing a #MeshTopologyCache.
+ */
+struct MeshTopologyTris {
+  /**
+   * Hash of the material indices, hidden faces and triangulation, see #mesh_topology_tris_hash.
+   * The number of triangles and materials are compared as well, so that a hash collision is less
+   * likely to reuse triangles that don't fit the mesh.
+   */
+  uint64_t hash = 0;
+  int corner_tris_num = 0;
+  int materials_num = 0;
+  SortedFaceData face_sorted;
+  /**
+   * Triangles of all faces, sorted with #face_sorted. Extracted buffer caches use sub-ranges of
+   * this buffer, and keep it alive with #MeshBufferCache::tris_src when it is removed.
+   */
+  std::shared_ptr<gpu::IndexBuf> tris;
+};
+
+/**
+ * Data derived from the topology of a #Mesh, shared between meshes with the same topology with
+ * #MeshRuntime::draw_topology_cache. Meshes that are only deformed reuse it instead of finding
+ * loose geometry, sorting and uploading their triangles again every time they are evaluated.
+ */
+struct MeshTopologyCache {
+  /** Extraction of different meshes sharing this cache can run at the same time. */
+  std::mutex mutex;
+
+  std::optional<MeshExtractLooseGeom> loose_geom;
+
+  /**
+   * Material indices, hidden faces and the triangulation are not part of the topology, so meshes
+   * sharing it can still differ in them, e.g. when the same mesh is used by objects in different
+   * modes. A few variants are kept so that these meshes don't replace each other's triangles on
+   * every redraw. The most recently used variant is first.
+   */
+  Vector<MeshTopologyTris, 0> tris;
+};
+
 /**
  * Data that are kept around between extractions to reduce rebuilding time.
  *
@@ -221,6 +271,17 @@ struct MeshBufferCache {
   MeshExtractLooseGeom loose_geom;
 
   SortedFaceData face_sorted;
+
+  /**
+   * Normal domain of the #BMesh the buffers were last extracted from. Used to update normals
+   * of deformed faces without checking the flags of all faces and edges again.
+   */
+  std::optional<bke::MeshNormalDomain> bm_normals_domain;
+
+  /** Topology data shared with other meshes, only used for the final #Mesh outside edit mode. */
+  std::shared_ptr<MeshTopologyCache> topology;
+  /** The shared index buffer that `ibo.tris` is a sub-range of. */
+  std::shared_ptr<gpu::IndexBuf> tris_src;
 };
 
 #define FOREACH_MESH_BUFFER_CACHE(batch_cache, mbc) \
@@ -252,6 +313,11 @@ struct MeshBatchCache {
   int mat_len;
   /* Instantly invalidates cache, skipping mesh check */
   bool is_dirty;
+  /**
+   * Edit-mesh vertices moved since the position and normal buffers were extracted.
+   * See #DRW_mesh_batch_cache_deform_tag.
+   */
+  Vector<int> deformed_verts;
   bool is_editmode;
   bool is_uvsyncsel;
 
@@ -296,6 +362,15 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
                                         const ToolSettings *ts,
                                         bool use_hide);
 
+/**
+ * Update the positions and normals of the given faces in buffers that were extracted from the
+ * #BMesh before it was deformed. Other buffers have to be discarded by the caller.
+ */
+void mesh_buffer_cache_update_deformed(MeshBufferCache &mbc,
+                                       BMEditMesh &em,
+                                       Span<IndexRange> pos_face_ranges,
+                                       Span<IndexRange> nor_face_ranges);
+
 void mesh_buffer_cache_create_requested_subdiv(MeshBatchCache &cache,
                                                MeshBufferCache &mbc,
                                                DRWSubdivCache &subdiv_cache,
@@ -195,6 +195,15 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
   mr->use_subsurf_fdots = mr->mesh && !mr->mesh->runtime->subsurf_face_dot_tags.is_empty();
   mr->use_final_mesh = do_final;
   mr->use_simplify_normals = (scene.r.mode & R_SIMPLIFY) && (scene.r.mode & R_SIMPLIFY_NORMALS);
+  mbc.bm_normals_domain = (mr->extract_type == MR_EXTRACT_BMESH) ?
+                              std::optional(mr->normals_domain) :
+                              std::nullopt;
+  /* Outside of edit mode, data that only depends on the topology can be shared with the meshes
+   * evaluated for other frames or objects, as long as they are only deformed. Like the loose
+   * geometry, it is kept until the buffer cache is cleared, since buffers may reference it. */
+  if (!mbc.topology && !is_editmode && do_final && mr->extract_type == MR_EXTRACT_MESH) {
+    mbc.topology = mesh_topology_cache_get(*mr->mesh);
+  }
 
 #ifdef DEBUG_TIME
   double rdata_end = BLI_time_now_seconds();
@@ -308,6 +317,11 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
         &task_graph,
         [](void *__restrict task_data) {
           const TaskData &data = *static_cast<TaskData *>(task_data);
+          if (data.mbc.topology) {
+            data.mbc.tris_src = extract_tris_shared(
+                data.mr, *data.mbc.topology, data.cache, *data.mbc.buff.ibo.tris);
+            return;
+          }
           const SortedFaceData &face_sorted = mesh_render_data_faces_sorted_ensure(data.mr,
                                                                                    data.mbc);
           extract_tris(data.mr, face_sorted, data.cache, *data.mbc.buff.ibo.tris);
@@ -751,6 +765,38 @@ void mesh_buffer_cache_create_requested(TaskGraph &task_graph,
 
 /** \} */
 
+/* ---------------------------------------------------------------------- */
+/** \name Deformed Edit-Mesh Update
+ * \{ */
+
+void mesh_buffer_cache_update_deformed(MeshBufferCache &mbc,
+                                       BMEditMesh &em,
+                                       const Span<IndexRange> pos_face_ranges,
+                                       const Span<IndexRange> nor_face_ranges)
+{
+  MeshBufferList &buffers = mbc.buff;
+  /* Buffers that are requested but not extracted yet will be created from the deformed mesh. */
+  auto is_extracted = [](gpu::VertBuf *vbo) {
+    return vbo != nullptr && (GPU_vertbuf_get_status(vbo) & GPU_VERTBUF_INIT);
+  };
+  const bool update_pos = is_extracted(buffers.vbo.pos);
+  const bool update_nor = is_extracted(buffers.vbo.nor) && mbc.bm_normals_domain.has_value() &&
+                          *mbc.bm_normals_domain != bke::MeshNormalDomain::Corner;
+  if (!update_pos && !update_nor) {
+    return;
+  }
+
+  std::unique_ptr<MeshRenderData> mr = mesh_render_data_create_for_deform(em, mbc);
+  if (update_pos) {
+    extract_positions_update(*mr, pos_face_ranges, *buffers.vbo.pos);
+  }
+  if (update_nor) {
+    extract_normals_update(*mr, nor_face_ranges, *buffers.vbo.nor);
+  }
+}
+
+/** \} */
+
 /* ---------------------------------------------------------------------- */
 /** \name Subdivision Extract Loop
  * \{ */
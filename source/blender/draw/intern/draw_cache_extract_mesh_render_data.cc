@@ -13,6 +13,7 @@
 #include "BLI_array.hh"
 #include "BLI_array_utils.hh"
 #include "BLI_enumerable_thread_specific.hh"
+#include "BLI_hash.hh"
 #include "BLI_index_mask.hh"
 #include "BLI_math_matrix.h"
 #include "BLI_task.hh"
@@ -31,6 +32,8 @@
 
 #include "mesh_extractors/extract_mesh.hh"
 
+#include <xxhash.h>
+
 /* ---------------------------------------------------------------------- */
 /** \name Update Loose Geometry
  * \{ */
@@ -141,6 +144,18 @@ static void mesh_render_data_loose_geom_ensure(const MeshRenderData &mr, MeshBuf
   if (!cache.loose_geom.verts.is_empty()) {
     return;
   }
+  if (cache.topology) {
+    MeshTopologyCache &topology = *cache.topology;
+    std::lock_guard lock(topology.mutex);
+    if (!topology.loose_geom) {
+      mesh_render_data_loose_geom_build(mr, cache);
+      topology.loose_geom = cache.loose_geom;
+    }
+    else {
+      cache.loose_geom = *topology.loose_geom;
+    }
+    return;
+  }
   mesh_render_data_loose_geom_build(mr, cache);
 }
 
@@ -357,6 +372,63 @@ const SortedFaceData &mesh_render_data_faces_sorted_ensure(const MeshRenderData
   return cache.face_sorted;
 }
 
+template<typename T> static uint64_t hash_span(const Span<T> data)
+{
+  return XXH3_64bits(data.data(), size_t(data.size_in_bytes()));
+}
+
+uint64_t mesh_topology_tris_hash(const MeshRenderData &mr)
+{
+  BLI_assert(mr.extract_type == MR_EXTRACT_MESH);
+  return get_default_hash(mr.materials_num,
+                          hash_span<int>(mr.material_indices),
+                          hash_span<bool>(mr.hide_poly),
+                          hash_span(mr.mesh->corner_tris()));
+}
+
+MeshTopologyTris &mesh_topology_tris_ensure(const MeshRenderData &mr,
+                                            MeshTopologyCache &topology,
+                                            const uint64_t hash)
+{
+  /* Enough for a mesh used in a few different modes or with a few different triangulations. */
+  constexpr int64_t max_variants = 4;
+
+  const int corner_tris_num = mr.mesh->corner_tris().size();
+  Vector<MeshTopologyTris, 0> &variants = topology.tris;
+  const int64_t index = std::find_if(variants.begin(),
+                                     variants.end(),
+                                     [&](const MeshTopologyTris &variant) {
+                                       return variant.hash == hash &&
+                                              variant.corner_tris_num == corner_tris_num &&
+                                              variant.materials_num == mr.materials_num;
+                                     }) -
+                        variants.begin();
+  if (index < variants.size()) {
+    std::rotate(variants.begin(), variants.begin() + index, variants.begin() + index + 1);
+    return variants.first();
+  }
+
+  if (variants.size() == max_variants) {
+    variants.remove_last();
+  }
+  MeshTopologyTris variant;
+  variant.hash = hash;
+  variant.corner_tris_num = corner_tris_num;
+  variant.materials_num = mr.materials_num;
+  variant.face_sorted = mesh_render_data_faces_sorted_build(mr);
+  variants.insert(0, std::move(variant));
+  return variants.first();
+}
+
+std::shared_ptr<MeshTopologyCache> mesh_topology_cache_get(const Mesh &mesh)
+{
+  /* The cache isn't freed when it is tagged dirty and not shared, so replace it entirely. */
+  mesh.runtime->draw_topology_cache.ensure([&](std::shared_ptr<MeshTopologyCache> &r_data) {
+    r_data = std::make_shared<MeshTopologyCache>();
+  });
+  return mesh.runtime->draw_topology_cache.data();
+}
+
 /** \} */
 
 /* ---------------------------------------------------------------------- */
@@ -697,6 +769,38 @@ std::unique_ptr<MeshRenderData> mesh_render_data_create(Object &object,
   return mr;
 }
 
+std::unique_ptr<MeshRenderData> mesh_render_data_create_for_deform(BMEditMesh &em,
+                                                                   const MeshBufferCache &mbc)
+{
+  BLI_assert(mbc.bm_normals_domain.has_value());
+  std::unique_ptr<MeshRenderData> mr = std::make_unique<MeshRenderData>();
+  mr->extract_type = MR_EXTRACT_BMESH;
+  mr->edit_bmesh = &em;
+  mr->bm = em.bm;
+
+  BM_mesh_elem_index_ensure(mr->bm, BM_VERT | BM_EDGE | BM_LOOP | BM_FACE);
+  BM_mesh_elem_table_ensure(mr->bm, BM_VERT | BM_EDGE | BM_FACE);
+
+  mr->verts_num = mr->bm->totvert;
+  mr->edges_num = mr->bm->totedge;
+  mr->faces_num = mr->bm->totface;
+  mr->corners_num = mr->bm->totloop;
+  mr->corner_tris_num = poly_to_tri_count(mr->faces_num, mr->corners_num);
+
+  /* The topology didn't change, so the normals domain can only change because of edits that
+   * already cause a full update. */
+  mr->normals_domain = *mbc.bm_normals_domain;
+
+  /* The loose geometry was cached when the buffers were created. */
+  mr->loose_edges = mbc.loose_geom.edges;
+  mr->loose_verts = mbc.loose_geom.verts;
+  mr->loose_edges_num = mbc.loose_geom.edges.size();
+  mr->loose_verts_num = mbc.loose_geom.verts.size();
+  mr->loose_indices_num = mr->loose_verts_num + (mr->loose_edges_num * 2);
+
+  return mr;
+}
+
 /** \} */
 
 }  // namespace blender::draw
@@ -41,6 +41,11 @@ void DRW_curve_batch_cache_validate(Curve *cu);
 void DRW_curve_batch_cache_free(Curve *cu);
 
 void DRW_mesh_batch_cache_dirty_tag(Mesh *mesh, eMeshBatchDirtyMode mode);
+/**
+ * Tag edit-mesh vertices that were moved without changing the topology, so that only the parts of
+ * the position and normal buffers that contain them are updated.
+ */
+void DRW_mesh_batch_cache_deform_tag(Mesh *mesh, Span<int> verts, bool looptris_changed);
 void DRW_mesh_batch_cache_validate(Object &object, Mesh &mesh);
 void DRW_mesh_batch_cache_free(void *batch_cache);
 
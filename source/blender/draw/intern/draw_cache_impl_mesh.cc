@@ -12,6 +12,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_bit_span_ops.hh"
+#include "BLI_bit_vector.hh"
 #include "BLI_bitmap.h"
 #include "BLI_buffer.h"
 #include "BLI_index_range.hh"
@@ -50,6 +52,7 @@
 #include "bmesh.hh"
 
 #include "GPU_batch.hh"
+#include "GPU_context.hh"
 #include "GPU_material.hh"
 
 #include "DRW_render.hh"
@@ -774,6 +777,148 @@ void DRW_mesh_batch_cache_dirty_tag(Mesh *mesh, eMeshBatchDirtyMode mode)
   }
 }
 
+void DRW_mesh_batch_cache_deform_tag(Mesh *mesh,
+                                     const Span<int> verts,
+                                     const bool looptris_changed)
+{
+  if (!mesh->runtime->batch_cache) {
+    return;
+  }
+  MeshBatchCache &cache = *static_cast<MeshBatchCache *>(mesh->runtime->batch_cache);
+  if (cache.subdiv_cache) {
+    /* The subdivided buffers can't be updated partially. */
+    cache.is_dirty = true;
+    return;
+  }
+  if (GPU_backend_get_type() == GPU_BACKEND_VULKAN) {
+    /* Sub-updates of vertex buffers are not implemented in the Vulkan backend yet. */
+    cache.is_dirty = true;
+    return;
+  }
+
+  /* Positions and normals are updated for the moved vertices before the next extraction, other
+   * buffers that depend on the positions are rebuilt entirely. */
+  DRWBatchFlag batch_map = BATCH_MAP(vbo.edge_fac,
+                                     vbo.tan,
+                                     vbo.orco,
+                                     vbo.edituv_stretch_area,
+                                     vbo.edituv_stretch_angle,
+                                     vbo.mesh_analysis,
+                                     vbo.fdots_pos,
+                                     vbo.fdots_nor,
+                                     vbo.skin_roots,
+                                     vbo.vnor);
+  FOREACH_MESH_BUFFER_CACHE (cache, mbc) {
+    GPU_VERTBUF_DISCARD_SAFE(mbc->buff.vbo.edge_fac);
+    GPU_VERTBUF_DISCARD_SAFE(mbc->buff.vbo.tan);
+    GPU_VERTBUF_DISCARD_SAFE(mbc->buff.vbo.orco);
+    GPU_VERTBUF_DISCARD_SAFE(mbc->buff.vbo.edituv_stretch_area);
+    GPU_VERTBUF_DISCARD_SAFE(mbc->buff.vbo.edituv_stretch_angle);
+    GPU_VERTBUF_DISCARD_SAFE(mbc->buff.vbo.mesh_analysis);
+    GPU_VERTBUF_DISCARD_SAFE(mbc->buff.vbo.fdots_pos);
+    GPU_VERTBUF_DISCARD_SAFE(mbc->buff.vbo.fdots_nor);
+    GPU_VERTBUF_DISCARD_SAFE(mbc->buff.vbo.skin_roots);
+    GPU_VERTBUF_DISCARD_SAFE(mbc->buff.vbo.vnor);
+    GPU_VERTBUF_DISCARD_SAFE(mbc->buff.vbo.attr_viewer);
+    for (int i = 0; i < GPU_MAX_ATTR; i++) {
+      if (STREQ(cache.attr_used.requests[i].attribute_name, "position")) {
+        GPU_VERTBUF_DISCARD_SAFE(mbc->buff.vbo.attr[i]);
+        batch_map |= BATCH_MAP(vbo.attr[0]);
+      }
+    }
+    /* Corner normals depend on the positions of neighboring faces, so they can't be updated
+     * partially. */
+    if (!mbc->bm_normals_domain || *mbc->bm_normals_domain == bke::MeshNormalDomain::Corner) {
+      GPU_VERTBUF_DISCARD_SAFE(mbc->buff.vbo.nor);
+      batch_map |= BATCH_MAP(vbo.nor);
+    }
+    if (looptris_changed) {
+      GPU_INDEXBUF_DISCARD_SAFE(mbc->buff.ibo.tris);
+      GPU_INDEXBUF_DISCARD_SAFE(mbc->buff.ibo.lines_adjacency);
+      GPU_INDEXBUF_DISCARD_SAFE(mbc->buff.ibo.edituv_tris);
+    }
+  }
+  batch_map |= BATCH_MAP(vbo.attr_viewer);
+  if (looptris_changed) {
+    for (int i = 0; i < cache.mat_len; i++) {
+      GPU_INDEXBUF_DISCARD_SAFE(cache.tris_per_mat[i]);
+    }
+    batch_map |= BATCH_MAP(ibo.tris, ibo.lines_adjacency, ibo.edituv_tris) |
+                 batches_that_use_buffer(TRIS_PER_MAT_INDEX);
+  }
+  mesh_batch_cache_discard_batch(cache, batch_map);
+
+  cache.tot_area = 0.0f;
+  cache.tot_uv_area = 0.0f;
+
+  cache.deformed_verts.extend(verts);
+}
+
+/**
+ * Update the parts of the position and normal buffers that contain the vertices moved since the
+ * last extraction, see #DRW_mesh_batch_cache_deform_tag.
+ */
+static void mesh_batch_cache_update_deformed(MeshBatchCache &cache, Mesh &mesh)
+{
+  BMEditMesh &em = *mesh.runtime->edit_mesh;
+  BMesh &bm = *em.bm;
+  BM_mesh_elem_index_ensure(&bm, BM_VERT | BM_LOOP | BM_FACE);
+  BM_mesh_elem_table_ensure(&bm, BM_VERT | BM_FACE);
+
+  /* Faces using the moved vertices have new positions. The normals of the vertices of those
+   * faces changed as well, which affects the next ring of faces. */
+  BitVector<> pos_faces(bm.totface, false);
+  BitVector<> nor_faces(bm.totface, false);
+  BitVector<> nor_verts(bm.totvert, false);
+  for (const int vert_index : cache.deformed_verts) {
+    BMVert *vert = BM_vert_at_index(&bm, vert_index);
+    BMIter iter;
+    BMFace *face;
+    BM_ITER_ELEM (face, &iter, vert, BM_FACES_OF_VERT) {
+      const int face_index = BM_elem_index_get(face);
+      if (pos_faces[face_index]) {
+        continue;
+      }
+      pos_faces[face_index].set();
+      const BMLoop *loop = BM_FACE_FIRST_LOOP(face);
+      for ([[maybe_unused]] const int i : IndexRange(face->len)) {
+        nor_verts[BM_elem_index_get(loop->v)].set();
+        loop = loop->next;
+      }
+    }
+  }
+  bits::foreach_1_index(nor_verts, [&](const int vert_index) {
+    BMVert *vert = BM_vert_at_index(&bm, vert_index);
+    BMIter iter;
+    BMFace *face;
+    BM_ITER_ELEM (face, &iter, vert, BM_FACES_OF_VERT) {
+      nor_faces[BM_elem_index_get(face)].set();
+    }
+  });
+
+  /* Join ranges that are close to each other to reduce the number of uploads. */
+  auto bits_to_ranges = [](const BitSpan bits) {
+    constexpr int max_gap = 64;
+    Vector<IndexRange> ranges;
+    bits::foreach_1_index(bits, [&](const int index) {
+      if (!ranges.is_empty() && index - ranges.last().one_after_last() < max_gap) {
+        ranges.last() = IndexRange::from_begin_end(ranges.last().start(), index + 1);
+      }
+      else {
+        ranges.append(IndexRange(index, 1));
+      }
+    });
+    return ranges;
+  };
+  const Vector<IndexRange> pos_face_ranges = bits_to_ranges(pos_faces);
+  const Vector<IndexRange> nor_face_ranges = bits_to_ranges(nor_faces);
+
+  FOREACH_MESH_BUFFER_CACHE (cache, mbc) {
+    mesh_buffer_cache_update_deformed(*mbc, em, pos_face_ranges, nor_face_ranges);
+  }
+  cache.deformed_verts.clear();
+}
+
 static void mesh_buffer_list_clear(MeshBufferList *mbuflist)
 {
   gpu::VertBuf **vbos = (gpu::VertBuf **)&mbuflist->vbo;
@@ -792,6 +937,9 @@ static void mesh_buffer_cache_clear(MeshBufferCache *mbc)
 
   mbc->loose_geom = {};
   mbc->face_sorted = {};
+  mbc->bm_normals_domain.reset();
+  mbc->topology.reset();
+  mbc->tris_src.reset();
 }
 
 static void mesh_batch_cache_free_subdiv_cache(MeshBatchCache &cache)
@@ -826,6 +974,7 @@ static void mesh_batch_cache_clear(MeshBatchCache &cache)
 
   cache.batch_ready = (DRWBatchFlag)0;
   drw_mesh_weight_state_clear(&cache.weight_state);
+  cache.deformed_verts.clear_and_shrink();
 
   mesh_batch_cache_free_subdiv_cache(cache);
 }
@@ -1347,6 +1496,10 @@ void DRW_mesh_batch_cache_create_requested(TaskGraph &task_graph,
     return;
   }
 
+  if (!cache.deformed_verts.is_empty() && mesh.runtime->edit_mesh) {
+    mesh_batch_cache_update_deformed(cache, mesh);
+  }
+
 #ifndef NDEBUG
   /* Map the index of a buffer to a flag containing all batches that use it. */
   Map<int, DRWBatchFlag> batches_that_use_buffer_local;
@@ -3098,6 +3098,7 @@ void DRW_engines_register()
     BKE_curve_batch_cache_free_cb = DRW_curve_batch_cache_free;
 
     BKE_mesh_batch_cache_dirty_tag_cb = DRW_mesh_batch_cache_dirty_tag;
+    BKE_mesh_batch_cache_deform_tag_cb = DRW_mesh_batch_cache_deform_tag;
     BKE_mesh_batch_cache_free_cb = DRW_mesh_batch_cache_free;
 
     BKE_lattice_batch_cache_dirty_tag_cb = DRW_lattice_batch_cache_dirty_tag;
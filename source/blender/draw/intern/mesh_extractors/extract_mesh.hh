@@ -178,6 +178,18 @@ BLI_INLINE const float *bm_face_no_get(const MeshRenderData &mr, const BMFace *e
   return efa->no;
 }
 
+/**
+ * Corners of a range of faces. The corners of consecutive faces are consecutive as well, because
+ * loop indices are assigned in the same order as face indices.
+ */
+BLI_INLINE IndexRange bm_faces_corners_range(BMesh &bm, const IndexRange faces)
+{
+  const BMFace *first = BM_face_at_index(&bm, faces.first());
+  const BMFace *last = BM_face_at_index(&bm, faces.last());
+  return IndexRange::from_begin_end(BM_elem_index_get(BM_FACE_FIRST_LOOP(first)),
+                                    BM_elem_index_get(BM_FACE_FIRST_LOOP(last)) + last->len);
+}
+
 /** \} */
 
 /* `draw_cache_extract_mesh_render_data.cc` */
@@ -198,9 +210,29 @@ std::unique_ptr<MeshRenderData> mesh_render_data_create(Object &object,
                                                         const ToolSettings *ts);
 void mesh_render_data_update_corner_normals(MeshRenderData &mr);
 void mesh_render_data_update_face_normals(MeshRenderData &mr);
+/**
+ * Render data for updating the buffers of a #BMesh that was only deformed since they were
+ * extracted, see #mesh_buffer_cache_update_deformed.
+ */
+std::unique_ptr<MeshRenderData> mesh_render_data_create_for_deform(BMEditMesh &em,
+                                                                   const MeshBufferCache &mbc);
 void mesh_render_data_update_loose_geom(MeshRenderData &mr, MeshBufferCache &cache);
 const SortedFaceData &mesh_render_data_faces_sorted_ensure(const MeshRenderData &mr,
                                                            MeshBufferCache &cache);
+/**
+ * Hash of the material indices, hidden faces and triangulation of the mesh, which are not part of
+ * the topology, but are needed to sort its triangles.
+ */
+uint64_t mesh_topology_tris_hash(const MeshRenderData &mr);
+/**
+ * Find the triangles of the shared topology cache with the given hash, or add them with sorted
+ * faces. The #MeshTopologyCache::mutex must be locked.
+ */
+MeshTopologyTris &mesh_topology_tris_ensure(const MeshRenderData &mr,
+                                            MeshTopologyCache &topology,
+                                            uint64_t hash);
+/** Get the topology data shared between all meshes with the same topology as this one. */
+std::shared_ptr<MeshTopologyCache> mesh_topology_cache_get(const Mesh &mesh);
 
 /* draw_cache_extract_mesh_extractors.c */
 
@@ -258,6 +290,13 @@ void extract_mesh_loose_edge_data(const Span<T> vert_data,
 }
 
 void extract_positions(const MeshRenderData &mr, gpu::VertBuf &vbo);
+/**
+ * Update the positions of the given ranges of faces and of the loose geometry in an already
+ * extracted buffer, without extracting everything again.
+ */
+void extract_positions_update(const MeshRenderData &mr,
+                              Span<IndexRange> face_ranges,
+                              gpu::VertBuf &vbo);
 void extract_positions_subdiv(const DRWSubdivCache &subdiv_cache,
                               const MeshRenderData &mr,
                               gpu::VertBuf &vbo,
@@ -270,6 +309,10 @@ void extract_face_dots_subdiv(const DRWSubdivCache &subdiv_cache,
                               gpu::IndexBuf &fdots);
 
 void extract_normals(const MeshRenderData &mr, bool use_hq, gpu::VertBuf &vbo);
+/** Update the normals of the given ranges of faces in an already extracted buffer. */
+void extract_normals_update(const MeshRenderData &mr,
+                            Span<IndexRange> face_ranges,
+                            gpu::VertBuf &vbo);
 void extract_normals_subdiv(const DRWSubdivCache &subdiv_cache,
                             gpu::VertBuf &pos_nor,
                             gpu::VertBuf &lnor);
@@ -285,6 +328,14 @@ void extract_tris(const MeshRenderData &mr,
                   const SortedFaceData &face_sorted,
                   MeshBatchCache &cache,
                   gpu::IndexBuf &ibo);
+/**
+ * Reuse the triangles of a mesh with the same topology if the triangulation didn't change.
+ * \a ibo becomes a sub-range of the returned buffer, which must be kept alive as long as it.
+ */
+std::shared_ptr<gpu::IndexBuf> extract_tris_shared(const MeshRenderData &mr,
+                                                   MeshTopologyCache &topology,
+                                                   MeshBatchCache &cache,
+                                                   gpu::IndexBuf &ibo);
 void extract_tris_subdiv(const DRWSubdivCache &subdiv_cache,
                          MeshBatchCache &cache,
                          gpu::IndexBuf &ibo);
@@ -130,6 +130,32 @@ void extract_tris(const MeshRenderData &mr,
   }
 }
 
+std::shared_ptr<gpu::IndexBuf> extract_tris_shared(const MeshRenderData &mr,
+                                                   MeshTopologyCache &topology,
+                                                   MeshBatchCache &cache,
+                                                   gpu::IndexBuf &ibo)
+{
+  BLI_assert(mr.extract_type == MR_EXTRACT_MESH);
+  /* Deforming the mesh usually doesn't change the triangulation. Hashing it is much cheaper than
+   * building and uploading the index buffer again, and can be done before locking. */
+  const uint64_t hash = mesh_topology_tris_hash(mr);
+
+  std::lock_guard lock(topology.mutex);
+  MeshTopologyTris &variant = mesh_topology_tris_ensure(mr, topology, hash);
+  if (!variant.tris) {
+    variant.tris = std::shared_ptr<gpu::IndexBuf>(GPU_indexbuf_calloc(), GPU_indexbuf_discard);
+    extract_tris_mesh(mr, variant.face_sorted, *variant.tris);
+  }
+
+  GPU_indexbuf_create_subrange_in_place(
+      &ibo, variant.tris.get(), 0, variant.face_sorted.visible_tris_num * 3);
+
+  if (mr.use_final_mesh && !cache.tris_per_mat.is_empty()) {
+    create_material_subranges(mr, variant.face_sorted, cache, *variant.tris);
+  }
+  return variant.tris;
+}
+
 void extract_tris_subdiv(const DRWSubdivCache &subdiv_cache,
                          MeshBatchCache &cache,
                          gpu::IndexBuf &ibo)
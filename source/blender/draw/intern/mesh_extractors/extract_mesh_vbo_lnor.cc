@@ -152,6 +152,39 @@ static void extract_paint_overlay_flags(const MeshRenderData &mr, MutableSpan<GP
   });
 }
 
+/**
+ * Fill the normals of the corners of a face when there are no custom normals.
+ * \param corner_offset: The index of the first corner in \a normals.
+ */
+template<typename GPUType>
+static void extract_face_normals_bm(const MeshRenderData &mr,
+                                    const BMFace &face,
+                                    const int corner_offset,
+                                    MutableSpan<GPUType> normals)
+{
+  const BMLoop *loop = BM_FACE_FIRST_LOOP(&face);
+  const IndexRange face_range(BM_elem_index_get(loop) - corner_offset, face.len);
+
+  if (mr.normals_domain == bke::MeshNormalDomain::Face ||
+      !BM_elem_flag_test(&face, BM_ELEM_SMOOTH))
+  {
+    normals.slice(face_range).fill(convert_normal<GPUType>(bm_face_no_get(mr, &face)));
+  }
+  else {
+    for ([[maybe_unused]] const int i : IndexRange(face.len)) {
+      const int index = BM_elem_index_get(loop);
+      normals[index - corner_offset] = convert_normal<GPUType>(bm_vert_no_get(mr, loop->v));
+      loop = loop->next;
+    }
+  }
+
+  if (BM_elem_flag_test(&face, BM_ELEM_HIDDEN)) {
+    for (GPUType &value : normals.slice(face_range)) {
+      value.w = -1;
+    }
+  }
+}
+
 template<typename GPUType>
 static void extract_normals_bm(const MeshRenderData &mr, MutableSpan<GPUType> normals)
 {
@@ -171,29 +204,10 @@ static void extract_normals_bm(const MeshRenderData &mr, MutableSpan<GPUType> no
     });
   }
   else {
-    const bke::MeshNormalDomain domain = mr.normals_domain;
     threading::parallel_for(IndexRange(bm.totface), 2048, [&](const IndexRange range) {
       for (const int face_index : range) {
         const BMFace &face = *BM_face_at_index(&const_cast<BMesh &>(bm), face_index);
-        const BMLoop *loop = BM_FACE_FIRST_LOOP(&face);
-        const IndexRange face_range(BM_elem_index_get(loop), face.len);
-
-        if (domain == bke::MeshNormalDomain::Face || !BM_elem_flag_test(&face, BM_ELEM_SMOOTH)) {
-          normals.slice(face_range).fill(convert_normal<GPUType>(bm_face_no_get(mr, &face)));
-        }
-        else {
-          for ([[maybe_unused]] const int i : IndexRange(face.len)) {
-            const int index = BM_elem_index_get(loop);
-            normals[index] = convert_normal<GPUType>(bm_vert_no_get(mr, loop->v));
-            loop = loop->next;
-          }
-        }
-
-        if (BM_elem_flag_test(&face, BM_ELEM_HIDDEN)) {
-          for (GPUType &value : normals.slice(face_range)) {
-            value.w = -1;
-          }
-        }
+        extract_face_normals_bm(mr, face, 0, normals);
       }
     });
   }
@@ -248,6 +262,49 @@ void extract_normals(const MeshRenderData &mr, const bool use_hq, gpu::VertBuf &
   }
 }
 
+template<typename GPUType>
+static void extract_normals_update_bm(const MeshRenderData &mr,
+                                      const Span<IndexRange> face_ranges,
+                                      gpu::VertBuf &vbo)
+{
+  BMesh &bm = *mr.bm;
+  Array<GPUType> data;
+  for (const IndexRange faces : face_ranges) {
+    const IndexRange corners = bm_faces_corners_range(bm, faces);
+    data.reinitialize(corners.size());
+    threading::parallel_for(faces, 2048, [&](const IndexRange range) {
+      for (const int face_index : range) {
+        extract_face_normals_bm(
+            mr, *BM_face_at_index(&bm, face_index), corners.start(), data.as_mutable_span());
+      }
+    });
+    GPU_vertbuf_update_sub(&vbo,
+                           corners.start() * sizeof(GPUType),
+                           data.as_span().size_in_bytes(),
+                           data.data());
+  }
+}
+
+void extract_normals_update(const MeshRenderData &mr,
+                            const Span<IndexRange> face_ranges,
+                            gpu::VertBuf &vbo)
+{
+  BLI_assert(mr.extract_type == MR_EXTRACT_BMESH);
+  BLI_assert(mr.normals_domain != bke::MeshNormalDomain::Corner);
+  BLI_assert(GPU_vertbuf_get_vertex_len(&vbo) == mr.corners_num + mr.loose_indices_num);
+
+  /* Make sure the buffer exists on the GPU before updating parts of it. */
+  GPU_vertbuf_use(&vbo);
+
+  /* Loose geometry has no normals, so only the face corners need to be updated. */
+  if (GPU_vertbuf_get_format(&vbo)->attrs[0].comp_type == GPU_COMP_I16) {
+    extract_normals_update_bm<short4>(mr, face_ranges, vbo);
+  }
+  else {
+    extract_normals_update_bm<GPUPackedNormal>(mr, face_ranges, vbo);
+  }
+}
+
 static const GPUVertFormat &get_subdiv_lnor_format()
 {
   static GPUVertFormat format = {0};
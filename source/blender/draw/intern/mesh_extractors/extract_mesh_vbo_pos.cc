@@ -30,24 +30,24 @@ static void extract_positions_mesh(const MeshRenderData &mr, MutableSpan<float3>
       });
 }
 
-static void extract_positions_bm(const MeshRenderData &mr, MutableSpan<float3> vbo_data)
+static void extract_face_positions_bm(const MeshRenderData &mr,
+                                      const BMFace &face,
+                                      const int corner_offset,
+                                      MutableSpan<float3> corners_data)
 {
-  const BMesh &bm = *mr.bm;
-  MutableSpan corners_data = vbo_data.take_front(mr.corners_num);
-  MutableSpan loose_edge_data = vbo_data.slice(mr.corners_num, mr.loose_edges.size() * 2);
-  MutableSpan loose_vert_data = vbo_data.take_back(mr.loose_verts.size());
+  const BMLoop *loop = BM_FACE_FIRST_LOOP(&face);
+  for ([[maybe_unused]] const int i : IndexRange(face.len)) {
+    const int index = BM_elem_index_get(loop);
+    corners_data[index - corner_offset] = bm_vert_co_get(mr, loop->v);
+    loop = loop->next;
+  }
+}
 
-  threading::parallel_for(IndexRange(bm.totface), 2048, [&](const IndexRange range) {
-    for (const int face_index : range) {
-      const BMFace &face = *BM_face_at_index(&const_cast<BMesh &>(bm), face_index);
-      const BMLoop *loop = BM_FACE_FIRST_LOOP(&face);
-      for ([[maybe_unused]] const int i : IndexRange(face.len)) {
-        const int index = BM_elem_index_get(loop);
-        corners_data[index] = bm_vert_co_get(mr, loop->v);
-        loop = loop->next;
-      }
-    }
-  });
+static void extract_loose_positions_bm(const MeshRenderData &mr, MutableSpan<float3> loose_data)
+{
+  const BMesh &bm = *mr.bm;
+  MutableSpan loose_edge_data = loose_data.take_front(mr.loose_edges.size() * 2);
+  MutableSpan loose_vert_data = loose_data.take_back(mr.loose_verts.size());
 
   const Span<int> loose_edges = mr.loose_edges;
   threading::parallel_for(loose_edges.index_range(), 4096, [&](const IndexRange range) {
@@ -67,6 +67,21 @@ static void extract_positions_bm(const MeshRenderData &mr, MutableSpan<float3> v
   });
 }
 
+static void extract_positions_bm(const MeshRenderData &mr, MutableSpan<float3> vbo_data)
+{
+  const BMesh &bm = *mr.bm;
+  MutableSpan corners_data = vbo_data.take_front(mr.corners_num);
+
+  threading::parallel_for(IndexRange(bm.totface), 2048, [&](const IndexRange range) {
+    for (const int face_index : range) {
+      const BMFace &face = *BM_face_at_index(&const_cast<BMesh &>(bm), face_index);
+      extract_face_positions_bm(mr, face, 0, corners_data);
+    }
+  });
+
+  extract_loose_positions_bm(mr, vbo_data.drop_front(mr.corners_num));
+}
+
 void extract_positions(const MeshRenderData &mr, gpu::VertBuf &vbo)
 {
   static GPUVertFormat format = {0};
@@ -85,6 +100,41 @@ void extract_positions(const MeshRenderData &mr, gpu::VertBuf &vbo)
   }
 }
 
+void extract_positions_update(const MeshRenderData &mr,
+                              const Span<IndexRange> face_ranges,
+                              gpu::VertBuf &vbo)
+{
+  BLI_assert(mr.extract_type == MR_EXTRACT_BMESH);
+  BLI_assert(GPU_vertbuf_get_vertex_len(&vbo) == mr.corners_num + mr.loose_indices_num);
+  BMesh &bm = *mr.bm;
+
+  /* Make sure the buffer exists on the GPU before updating parts of it. */
+  GPU_vertbuf_use(&vbo);
+
+  Array<float3> data;
+  for (const IndexRange faces : face_ranges) {
+    const IndexRange corners = bm_faces_corners_range(bm, faces);
+    data.reinitialize(corners.size());
+    threading::parallel_for(faces, 2048, [&](const IndexRange range) {
+      for (const int face_index : range) {
+        extract_face_positions_bm(mr, *BM_face_at_index(&bm, face_index), corners.start(), data);
+      }
+    });
+    GPU_vertbuf_update_sub(&vbo,
+                           corners.start() * sizeof(float3),
+                           data.as_span().size_in_bytes(),
+                           data.data());
+  }
+
+  /* Loose geometry isn't sorted by vertex, so always update all of it. */
+  if (mr.loose_indices_num > 0) {
+    data.reinitialize(mr.loose_indices_num);
+    extract_loose_positions_bm(mr, data);
+    GPU_vertbuf_update_sub(
+        &vbo, mr.corners_num * sizeof(float3), data.as_span().size_in_bytes(), data.data());
+  }
+}
+
 static const GPUVertFormat &get_normals_format()
 {
   static GPUVertFormat format = {0};
@@ -0,0 +1,149 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "testing/testing.h"
+
+#include "BLI_math_matrix.hh"
+#include "BLI_vector.hh"
+
+#include "BKE_attribute.hh"
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_mesh.h"
+#include "BKE_mesh.hh"
+
+#include "DNA_mesh_types.h"
+#include "DNA_object_types.h"
+
+#include "GPU_index_buffer.hh"
+
+#include "draw_testing.hh"
+#include "mesh_extractors/extract_mesh.hh"
+
+namespace blender::draw {
+
+/** Two quads next to each other. */
+static Mesh *create_quads_mesh()
+{
+  Mesh *mesh = BKE_mesh_new_nomain(6, 0, 2, 8);
+  mesh->vert_positions_for_write().copy_from({float3(0.0f, 0.0f, 0.0f),
+                                              float3(1.0f, 0.0f, 0.0f),
+                                              float3(2.0f, 0.0f, 0.0f),
+                                              float3(0.0f, 1.0f, 0.0f),
+                                              float3(1.0f, 1.0f, 0.0f),
+                                              float3(2.0f, 1.0f, 0.0f)});
+  mesh->face_offsets_for_write().copy_from({0, 4, 8});
+  mesh->corner_verts_for_write().copy_from({0, 1, 4, 3, 1, 2, 5, 4});
+  bke::mesh_calc_edges(*mesh, false, false);
+  return mesh;
+}
+
+/** Extracts the triangles of meshes with a shared topology cache like the batch cache does. */
+class TrisExtractor {
+ public:
+  Object *object;
+  Vector<gpu::IndexBuf *> ibos;
+
+  TrisExtractor()
+  {
+    object = static_cast<Object *>(BKE_id_new_nomain(ID_OB, nullptr));
+    object->type = OB_MESH;
+  }
+
+  ~TrisExtractor()
+  {
+    /* The sub-ranges have to be freed before the buffers they are a part of. */
+    for (gpu::IndexBuf *ibo : ibos) {
+      GPU_indexbuf_discard(ibo);
+    }
+    BKE_id_free(nullptr, object);
+  }
+
+  std::shared_ptr<gpu::IndexBuf> extract(Mesh &mesh)
+  {
+    /* Use paint mode, so that hidden faces are taken into account. */
+    std::unique_ptr<MeshRenderData> mr = mesh_render_data_create(
+        *object, mesh, false, true, false, float4x4::identity(), true, false, true, nullptr);
+    MeshBatchCache cache{};
+    gpu::IndexBuf *ibo = GPU_indexbuf_calloc();
+    ibos.append(ibo);
+    return extract_tris_shared(*mr, *mesh_topology_cache_get(mesh), cache, *ibo);
+  }
+};
+
+static void test_mesh_topology_cache_tris()
+{
+  BKE_idtype_init();
+  std::shared_ptr<gpu::IndexBuf> tris_a;
+  std::shared_ptr<gpu::IndexBuf> tris_hidden;
+  std::shared_ptr<gpu::IndexBuf> tris_flipped;
+  {
+    TrisExtractor extractor;
+    Mesh *mesh = create_quads_mesh();
+    std::shared_ptr<MeshTopologyCache> topology = mesh_topology_cache_get(*mesh);
+
+    /* Copies of the mesh share the topology cache. */
+    Mesh *mesh_deformed = BKE_mesh_copy_for_eval(*mesh);
+    Mesh *mesh_hidden = BKE_mesh_copy_for_eval(*mesh);
+    Mesh *mesh_flipped = BKE_mesh_copy_for_eval(*mesh);
+    EXPECT_EQ(mesh_topology_cache_get(*mesh_deformed), topology);
+
+    tris_a = extractor.extract(*mesh);
+    ASSERT_NE(tris_a, nullptr);
+    EXPECT_EQ(topology->tris.size(), 1);
+
+    /* Deforming the mesh without changing its triangulation reuses the triangles. */
+    for (float3 &position : mesh_deformed->vert_positions_for_write()) {
+      position.z += 1.0f;
+    }
+    mesh_deformed->tag_positions_changed();
+    EXPECT_EQ(extractor.extract(*mesh_deformed), tris_a);
+    EXPECT_EQ(topology->tris.size(), 1);
+
+    /* Hiding a face requires different triangles, which don't replace the original ones. */
+    bke::SpanAttributeWriter<bool> hide_poly =
+        mesh_hidden->attributes_for_write().lookup_or_add_for_write_span<bool>(
+            ".hide_poly", bke::AttrDomain::Face);
+    hide_poly.span[0] = true;
+    hide_poly.finish();
+    tris_hidden = extractor.extract(*mesh_hidden);
+    EXPECT_NE(tris_hidden, tris_a);
+    EXPECT_EQ(extractor.extract(*mesh), tris_a);
+    EXPECT_EQ(extractor.extract(*mesh_hidden), tris_hidden);
+    EXPECT_EQ(topology->tris.size(), 2);
+
+    /* Moving a vertex so that the first quad is concave changes its triangulation. */
+    mesh_flipped->vert_positions_for_write()[4] = float3(2.0f, -0.5f, 0.0f);
+    mesh_flipped->tag_positions_changed();
+    ASSERT_NE(mesh_flipped->corner_tris(), mesh->corner_tris());
+    tris_flipped = extractor.extract(*mesh_flipped);
+    EXPECT_NE(tris_flipped, tris_a);
+    EXPECT_NE(tris_flipped, tris_hidden);
+    EXPECT_EQ(topology->tris.size(), 3);
+
+    /* Changing the topology gives the mesh a new cache. */
+    mesh_deformed->tag_topology_changed();
+    EXPECT_NE(mesh_topology_cache_get(*mesh_deformed), topology);
+
+    BKE_id_free(nullptr, mesh);
+    BKE_id_free(nullptr, mesh_deformed);
+    BKE_id_free(nullptr, mesh_hidden);
+    BKE_id_free(nullptr, mesh_flipped);
+
+    /* The buffers stay alive when the cache is freed, since extracted buffers use them. */
+    const std::weak_ptr<MeshTopologyCache> topology_weak = topology;
+    topology.reset();
+    EXPECT_TRUE(topology_weak.expired());
+    EXPECT_EQ(tris_a.use_count(), 1);
+    EXPECT_TRUE(GPU_indexbuf_is_init(tris_a.get()));
+    EXPECT_TRUE(GPU_indexbuf_is_init(tris_hidden.get()));
+    EXPECT_TRUE(GPU_indexbuf_is_init(tris_flipped.get()));
+  }
+  tris_a.reset();
+  tris_hidden.reset();
+  tris_flipped.reset();
+}
+DRAW_TEST(mesh_topology_cache_tris)
+
+}  // namespace blender::draw
@@ -1659,6 +1659,9 @@ void EDBM_update(Mesh *mesh, const EDBMUpdate_Params *params)
   DEG_id_tag_update(&mesh->id, ID_RECALC_GEOMETRY);
   WM_main_add_notifier(NC_GEOM | ND_DATA, &mesh->id);
 
+  /* Any change besides moving vertices requires the draw cache to be created again. */
+  BKE_editmesh_deform_update_clear(em);
+
   if (params->calc_normals && params->calc_looptris) {
     /* Calculating both has some performance gains. */
     BKE_editmesh_looptris_and_normals_calc(em);
@@ -7094,9 +7094,7 @@ void filter_distances_with_radius(const float radius,
                                   const MutableSpan<float> factors)
 {
   for (const int i : distances.index_range()) {
-    if (distances[i] > radius) {
-      factors[i] = 0.0f;
-    }
+    factors[i] = distances[i] > radius ? 0.0f : factors[i];
   }
 }
 
@@ -7173,13 +7171,8 @@ void apply_hardness_to_distances(const float radius,
   const float radius_inv = math::rcp(radius);
   const float hardness_inv_rcp = math::rcp(1.0f - hardness);
   for (const int i : distances.index_range()) {
-    if (distances[i] < threshold) {
-      distances[i] = 0.0f;
-    }
-    else {
-      const float radius_factor = (distances[i] * radius_inv - hardness) * hardness_inv_rcp;
-      distances[i] = radius_factor * radius;
-    }
+    const float radius_factor = (distances[i] * radius_inv - hardness) * hardness_inv_rcp;
+    distances[i] = distances[i] < threshold ? 0.0f : radius_factor * radius;
   }
 }
 
@@ -30,13 +30,17 @@
  * Operators must have the OPTYPE_UNDO flag set for this to work properly.
  */
 
+#include <atomic>
 #include <cstddef>
 
+#include <zstd.h>
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_array_utils.hh"
 #include "BLI_listbase.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "DNA_key_types.h"
@@ -207,6 +211,18 @@ struct StepData {
   /** Storage of per-node undo data after creation of the undo step is finished. */
   Vector<std::unique_ptr<Node>> nodes;
 
+  /**
+   * Compressed arrays of each node in #nodes while the step is not being restored, see
+   * #compress_nodes_in_background. Empty when the arrays are stored in the nodes directly.
+   */
+  Array<Array<std::byte>> compressed_nodes;
+  /** Pool of the task compressing the nodes, null when no compression is running. */
+  TaskPool *compress_task_pool = nullptr;
+  /** Size of the step with compressed nodes, written by the compression task. */
+  size_t compressed_size = 0;
+  /** Set by the compression task when it is done, so that finishing it doesn't have to block. */
+  std::atomic<bool> compression_finished = false;
+
   size_t undo_size;
 };
 
@@ -1154,8 +1170,253 @@ static void restore_list(bContext *C, Depsgraph *depsgraph, StepData &step_data)
   }
 }
 
+static size_t node_size_in_bytes(const Node &node)
+{
+  size_t size = sizeof(Node);
+  size += node.position.as_span().size_in_bytes();
+  size += node.orig_position.as_span().size_in_bytes();
+  size += node.normal.as_span().size_in_bytes();
+  size += node.col.as_span().size_in_bytes();
+  size += node.mask.as_span().size_in_bytes();
+  size += node.loop_col.as_span().size_in_bytes();
+  size += node.orig_loop_col.as_span().size_in_bytes();
+  size += node.vert_indices.as_span().size_in_bytes();
+  size += node.corner_indices.as_span().size_in_bytes();
+  size += node.vert_hidden.size() / 8;
+  size += node.face_hidden.size() / 8;
+  size += node.grids.as_span().size_in_bytes();
+  size += node.grid_hidden.all_bits().size() / 8;
+  size += node.face_sets.as_span().size_in_bytes();
+  size += node.face_indices.as_span().size_in_bytes();
+  return size;
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Node Compression
+ *
+ * Sculpt undo steps store full copies of the changed values of every affected node, which adds
+ * up quickly when sculpting on dense meshes. After a step is finished, its arrays are compressed
+ * in the background and only decompressed again while the step is restored.
+ *
+ * All stored arrays consist of 4 byte values. Before compressing, integer arrays are delta
+ * encoded and the bytes of all values are grouped by their significance, which makes similar
+ * bytes like the exponents of nearby positions end up next to each other.
+ * \{ */
+
+/** Fast zstd level, the arrays are compressed while the user continues sculpting. */
+static constexpr int compression_level = 1;
+static constexpr int compression_value_size = 4;
+
+static bool use_compression(const StepData &step_data)
+{
+  return ELEM(step_data.type, Type::Position, Type::Mask, Type::Color, Type::FaceSet) &&
+         !step_data.nodes.is_empty();
+}
+
+template<typename T> static void write_array(Vector<std::byte> &buffer, const Span<T> values)
+{
+  static_assert(sizeof(T) % compression_value_size == 0);
+  const int64_t size = values.size();
+  buffer.extend(Span(reinterpret_cast<const std::byte *>(&size), sizeof(size)));
+
+  const int64_t values_num = values.size_in_bytes() / compression_value_size;
+  Span<std::byte> src = values.template cast<std::byte>();
+  Array<int> deltas;
+  if constexpr (std::is_same_v<T, int>) {
+    deltas.reinitialize(values.size());
+    for (const int i : values.index_range()) {
+      deltas[i] = i == 0 ? values[i] : int(uint32_t(values[i]) - uint32_t(values[i - 1]));
+    }
+    src = deltas.as_span().cast<std::byte>();
+  }
+
+  const int64_t start = buffer.size();
+  buffer.resize(start + src.size());
+  MutableSpan<std::byte> dst = buffer.as_mutable_span().drop_front(start);
+  for (const int64_t i : IndexRange(values_num)) {
+    for (const int byte : IndexRange(compression_value_size)) {
+      dst[byte * values_num + i] = src[i * compression_value_size + byte];
+    }
+  }
+}
+
+static int64_t read_size(Span<std::byte> &buffer)
+{
+  int64_t size;
+  memcpy(&size, buffer.data(), sizeof(size));
+  buffer = buffer.drop_front(sizeof(size));
+  return size;
+}
+
+template<typename T> static void read_values(Span<std::byte> &buffer, MutableSpan<T> values)
+{
+  const int64_t values_num = values.size_in_bytes() / compression_value_size;
+  const Span<std::byte> src = buffer.take_front(values.size_in_bytes());
+  MutableSpan<std::byte> dst = values.template cast<std::byte>();
+  for (const int64_t i : IndexRange(values_num)) {
+    for (const int byte : IndexRange(compression_value_size)) {
+      dst[i * compression_value_size + byte] = src[byte * values_num + i];
+    }
+  }
+  if constexpr (std::is_same_v<T, int>) {
+    for (const int i : values.index_range().drop_front(1)) {
+      values[i] = int(uint32_t(values[i]) + uint32_t(values[i - 1]));
+    }
+  }
+  buffer = buffer.drop_front(values.size_in_bytes());
+}
+
+template<typename T> static void read_array(Span<std::byte> &buffer, Array<T> &r_values)
+{
+  r_values.reinitialize(read_size(buffer));
+  read_values(buffer, r_values.as_mutable_span());
+}
+
+/** Move the arrays of the node into a compressed buffer. */
+static Array<std::byte> compress_node(Node &node)
+{
+  Vector<std::byte> buffer;
+  write_array(buffer, node.position.as_span());
+  write_array(buffer, node.orig_position.as_span());
+  write_array(buffer, node.col.as_span());
+  write_array(buffer, node.mask.as_span());
+  write_array(buffer, node.loop_col.as_span());
+  write_array(buffer, node.orig_loop_col.as_span());
+  write_array(buffer, node.vert_indices.as_span());
+  write_array(buffer, node.corner_indices.as_span());
+  write_array(buffer, node.grids.as_span());
+  write_array(buffer, node.face_sets.as_span());
+  write_array(buffer, node.face_indices.as_span());
+
+  Array<std::byte> compressed(ZSTD_compressBound(buffer.size()));
+  const size_t compressed_size = ZSTD_compress(
+      compressed.data(), compressed.size(), buffer.data(), buffer.size(), compression_level);
+  if (ZSTD_isError(compressed_size)) {
+    /* Keep the uncompressed arrays in the node. */
+    return {};
+  }
+
+  node.position = {};
+  node.orig_position = {};
+  node.col = {};
+  node.mask = {};
+  node.loop_col = {};
+  node.orig_loop_col = {};
+  node.vert_indices = {};
+  node.corner_indices = {};
+  node.grids = {};
+  node.face_sets = {};
+  node.face_indices.clear_and_shrink();
+  return compressed.as_span().take_front(compressed_size);
+}
+
+static void decompress_node(const Span<std::byte> compressed, Node &node)
+{
+  if (compressed.is_empty()) {
+    return;
+  }
+  Array<std::byte> data(ZSTD_getFrameContentSize(compressed.data(), compressed.size()));
+  const size_t size = ZSTD_decompress(
+      data.data(), data.size(), compressed.data(), compressed.size());
+  BLI_assert(!ZSTD_isError(size) && size == data.size());
+  UNUSED_VARS_NDEBUG(size);
+
+  Span<std::byte> buffer = data;
+  read_array(buffer, node.position);
+  read_array(buffer, node.orig_position);
+  read_array(buffer, node.col);
+  read_array(buffer, node.mask);
+  read_array(buffer, node.loop_col);
+  read_array(buffer, node.orig_loop_col);
+  read_array(buffer, node.vert_indices);
+  read_array(buffer, node.corner_indices);
+  read_array(buffer, node.grids);
+  read_array(buffer, node.face_sets);
+  node.face_indices.resize(read_size(buffer));
+  read_values(buffer, node.face_indices.as_mutable_span());
+  BLI_assert(buffer.is_empty());
+}
+
+static void compress_nodes_task(TaskPool *__restrict pool, void * /*taskdata*/)
+{
+  StepData &step_data = *static_cast<StepData *>(BLI_task_pool_user_data(pool));
+  /* Compress on this thread only, the worker threads are likely busy with the next stroke. */
+  size_t size = 0;
+  for (const int i : step_data.nodes.index_range()) {
+    Node &node = *step_data.nodes[i];
+    step_data.compressed_nodes[i] = compress_node(node);
+    size += node_size_in_bytes(node) + step_data.compressed_nodes[i].as_span().size_in_bytes();
+  }
+  step_data.compressed_size = size;
+  step_data.compression_finished.store(true, std::memory_order_release);
+}
+
+/** Wait for the compression of the step to finish and update its size. */
+static void compression_wait(StepData &step_data)
+{
+  if (!step_data.compress_task_pool) {
+    return;
+  }
+  BLI_task_pool_work_and_wait(step_data.compress_task_pool);
+  BLI_task_pool_free(step_data.compress_task_pool);
+  step_data.compress_task_pool = nullptr;
+  step_data.undo_size = step_data.compressed_size;
+}
+
+static void compress_nodes_in_background(StepData &step_data)
+{
+  BLI_assert(step_data.compress_task_pool == nullptr);
+  BLI_assert(step_data.compressed_nodes.is_empty());
+  if (!use_compression(step_data)) {
+    return;
+  }
+  /* Allocate the storage here, the task must not change the layout of the step data. */
+  step_data.compressed_nodes.reinitialize(step_data.nodes.size());
+  step_data.compression_finished.store(false, std::memory_order_relaxed);
+  step_data.compress_task_pool = BLI_task_pool_create_background(&step_data, TASK_PRIORITY_LOW);
+  BLI_task_pool_push(step_data.compress_task_pool, compress_nodes_task, nullptr, false, nullptr);
+}
+
+/** Make the node arrays available again for restoring the step. */
+static void decompress_nodes(StepData &step_data)
+{
+  compression_wait(step_data);
+  if (step_data.compressed_nodes.is_empty()) {
+    return;
+  }
+  threading::parallel_for(step_data.nodes.index_range(), 1, [&](const IndexRange range) {
+    for (const int i : range) {
+      decompress_node(step_data.compressed_nodes[i], *step_data.nodes[i]);
+    }
+  });
+  step_data.compressed_nodes = {};
+}
+
+/**
+ * Update the memory usage of sculpt steps whose compression finished in the meantime. Steps that
+ * are still being compressed keep their uncompressed size, this doesn't wait for them.
+ */
+static void update_compressed_step_sizes(UndoStack &ustack)
+{
+  LISTBASE_FOREACH (UndoStep *, us, &ustack.steps) {
+    if (us->type != BKE_UNDOSYS_TYPE_SCULPT) {
+      continue;
+    }
+    StepData &step_data = reinterpret_cast<SculptUndoStep *>(us)->data;
+    if (step_data.compress_task_pool &&
+        step_data.compression_finished.load(std::memory_order_acquire))
+    {
+      compression_wait(step_data);
+      us->data_size = step_data.undo_size;
+    }
+  }
+}
+
+/** \} */
+
 static void free_step_data(StepData &step_data)
 {
+  compression_wait(step_data);
   geometry_free_data(&step_data.geometry_original);
   geometry_free_data(&step_data.geometry_modified);
   geometry_free_data(&step_data.geometry_bmesh_enter);
@@ -1720,31 +1981,13 @@ void push_end(Object &ob)
   push_end_ex(ob, false);
 }
 
-static size_t node_size_in_bytes(const Node &node)
-{
-  size_t size = sizeof(Node);
-  size += node.position.as_span().size_in_bytes();
-  size += node.orig_position.as_span().size_in_bytes();
-  size += node.normal.as_span().size_in_bytes();
-  size += node.col.as_span().size_in_bytes();
-  size += node.mask.as_span().size_in_bytes();
-  size += node.loop_col.as_span().size_in_bytes();
-  size += node.orig_loop_col.as_span().size_in_bytes();
-  size += node.vert_indices.as_span().size_in_bytes();
-  size += node.corner_indices.as_span().size_in_bytes();
-  size += node.vert_hidden.size() / 8;
-  size += node.face_hidden.size() / 8;
-  size += node.grids.as_span().size_in_bytes();
-  size += node.grid_hidden.all_bits().size() / 8;
-  size += node.face_sets.as_span().size_in_bytes();
-  size += node.face_indices.as_span().size_in_bytes();
-  return size;
-}
-
 void push_end_ex(Object &ob, const bool use_nested_undo)
 {
   StepData *step_data = get_step_data();
 
+  /* In case the step was finished before already, its existing nodes may be compressed. */
+  decompress_nodes(*step_data);
+
   /* Move undo node storage from map to vector. */
   step_data->nodes.reserve(step_data->undo_nodes_by_pbvh_node.size());
   for (std::unique_ptr<Node> &node : step_data->undo_nodes_by_pbvh_node.values()) {
@@ -1775,11 +2018,15 @@ void push_end_ex(Object &ob, const bool use_nested_undo)
     UndoStack *ustack = ED_undo_stack_get();
     BKE_undosys_step_push(ustack, nullptr, nullptr);
     if (wm->op_undo_depth == 0) {
+      /* Account for the compression of the previous steps before freeing steps. */
+      update_compressed_step_sizes(*ustack);
       BKE_undosys_stack_limit_steps_and_memory_defaults(ustack);
     }
     WM_file_tag_modified();
   }
 
+  compress_nodes_in_background(*step_data);
+
   UndoStack *ustack = ED_undo_stack_get();
   SculptUndoStep *us = (SculptUndoStep *)BKE_undosys_stack_init_or_active_with_type(
       ustack, BKE_UNDOSYS_TYPE_SCULPT);
@@ -1870,7 +2117,9 @@ static void step_decode_undo_impl(bContext *C, Depsgraph *depsgraph, SculptUndoS
 {
   BLI_assert(us->step.is_applied == true);
 
+  decompress_nodes(us->data);
   restore_list(C, depsgraph, us->data);
+  compress_nodes_in_background(us->data);
   us->step.is_applied = false;
 
   print_nodes(*CTX_data_active_object(C), nullptr);
@@ -1880,7 +2129,9 @@ static void step_decode_redo_impl(bContext *C, Depsgraph *depsgraph, SculptUndoS
 {
   BLI_assert(us->step.is_applied == false);
 
+  decompress_nodes(us->data);
   restore_list(C, depsgraph, us->data);
+  compress_nodes_in_background(us->data);
   us->step.is_applied = true;
 
   print_nodes(*CTX_data_active_object(C), nullptr);
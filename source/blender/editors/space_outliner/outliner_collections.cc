@@ -990,7 +990,7 @@ static int collection_view_layer_exec(bContext *C, wmOperator *op)
   BLI_gset_free(data.collections_to_edit, nullptr);
 
   BKE_view_layer_need_resync_tag(view_layer);
-  DEG_relations_tag_update(bmain);
+  DEG_relations_tag_visibility_update(bmain);
 
   WM_main_add_notifier(NC_SCENE | ND_LAYER, nullptr);
 
@@ -1415,7 +1415,7 @@ static int collection_flag_exec(bContext *C, wmOperator *op)
   DEG_id_tag_update(&scene->id, ID_RECALC_BASE_FLAGS);
 
   if (!is_render) {
-    DEG_relations_tag_update(CTX_data_main(C));
+    DEG_relations_tag_visibility_update(CTX_data_main(C));
   }
 
   WM_main_add_notifier(NC_SCENE | ND_LAYER_CONTENT, nullptr);
@@ -302,7 +302,7 @@ static void outliner_object_set_flag_recursive_fn(bContext *C,
   /* We don't call RNA_property_update() due to performance, so we batch update them. */
   if (ob) {
     BKE_main_collection_sync_remap(bmain);
-    DEG_relations_tag_update(bmain);
+    DEG_relations_tag_visibility_update(bmain);
   }
   else {
     BKE_view_layer_need_resync_tag(view_layer);
@@ -632,7 +632,7 @@ static void outliner_collection_set_flag_recursive_fn(bContext *C,
 
   /* We don't call RNA_property_update() due to performance, so we batch update them. */
   BKE_main_collection_sync_remap(bmain);
-  DEG_relations_tag_update(bmain);
+  DEG_relations_tag_visibility_update(bmain);
 }
 
 /**
@@ -19,6 +19,7 @@
 #include "BLI_math_vector.h"
 #include "BLI_memarena.h"
 #include "BLI_utildefines_stack.h"
+#include "BLI_vector_set.hh"
 
 #include "BKE_context.hh"
 #include "BKE_crazyspace.hh"
@@ -2070,6 +2071,91 @@ static void mesh_transdata_mirror_apply(TransDataContainer *tc)
   }
 }
 
+/**
+ * Vertices moved by the transform, so that drawing only updates the data that depends on them.
+ * Returns false when the draw cache should be created again instead.
+ */
+static bool mesh_deform_update_verts_get(const TransInfo *t,
+                                         const TransDataContainer *tc,
+                                         Vector<BMVert *> &r_verts)
+{
+  const TransCustomDataMesh *tcmd = static_cast<const TransCustomDataMesh *>(
+      tc->custom.type.data);
+  if (tcmd && tcmd->cd_layer_correct) {
+    /* Face attributes are modified as well. */
+    return false;
+  }
+  if (t->flag & T_PROP_EDIT) {
+    /* Reducing the proportional size restores vertices which are not part of the update. */
+    return false;
+  }
+  const BMEditMesh *em = BKE_editmesh_from_object(tc->obedit);
+  if ((tc->data_len + tc->data_mirror_len) * 2 > em->bm->totvert) {
+    /* Updating most of the mesh isn't worth the cost of finding the affected data. */
+    return false;
+  }
+
+  r_verts.reserve(tc->data_len + tc->data_mirror_len);
+  for (const TransData &td : Span(tc->data, tc->data_len)) {
+    r_verts.append(static_cast<BMVert *>(td.extra));
+  }
+  for (const TransDataMirror &td_mirror : Span(tc->data_mirror, tc->data_mirror_len)) {
+    r_verts.append(static_cast<BMVert *>(td_mirror.extra));
+  }
+  return true;
+}
+
+/**
+ * Faces using the given vertices whose triangulation can change (faces with more than three
+ * corners), each face is only added once.
+ */
+static VectorSet<BMFace *> mesh_ngons_of_verts_get(const Span<BMVert *> verts)
+{
+  VectorSet<BMFace *> faces;
+  for (BMVert *v : verts) {
+    BMIter iter;
+    BMFace *f;
+    BM_ITER_ELEM (f, &iter, v, BM_FACES_OF_VERT) {
+      if (f->len > 3) {
+        faces.add(f);
+      }
+    }
+  }
+  return faces;
+}
+
+static IndexRange mesh_looptris_of_face(const BMFace *f)
+{
+  const int loop_index = BM_elem_index_get(BM_FACE_FIRST_LOOP(f));
+  return IndexRange(poly_to_tri_count(BM_elem_index_get(f), loop_index), f->len - 2);
+}
+
+static Vector<std::array<BMLoop *, 3>> mesh_looptris_of_faces_get(const BMEditMesh *em,
+                                                                   const Span<BMFace *> faces)
+{
+  Vector<std::array<BMLoop *, 3>> looptris;
+  for (const BMFace *f : faces) {
+    looptris.extend(em->looptris.as_span().slice(mesh_looptris_of_face(f)));
+  }
+  return looptris;
+}
+
+/** Check whether the triangulation of the faces changed since the looptris were retrieved. */
+static bool mesh_looptris_of_faces_changed(const BMEditMesh *em,
+                                           const Span<BMFace *> faces,
+                                           const Span<std::array<BMLoop *, 3>> looptris_prev)
+{
+  int offset = 0;
+  for (const BMFace *f : faces) {
+    const IndexRange tris = mesh_looptris_of_face(f);
+    if (em->looptris.as_span().slice(tris) != looptris_prev.slice(offset, tris.size())) {
+      return true;
+    }
+    offset += tris.size();
+  }
+  return false;
+}
+
 static void recalcData_mesh(TransInfo *t)
 {
   bool is_canceling = t->state == TRANS_CANCEL;
@@ -2099,7 +2185,27 @@ static void recalcData_mesh(TransInfo *t)
   FOREACH_TRANS_DATA_CONTAINER (t, tc) {
     DEG_id_tag_update(static_cast<ID *>(tc->obedit->data), ID_RECALC_GEOMETRY);
 
+    BMEditMesh *em = BKE_editmesh_from_object(tc->obedit);
+    Vector<BMVert *> deform_verts;
+    const bool use_deform_update = mesh_deform_update_verts_get(t, tc, deform_verts);
+    VectorSet<BMFace *> deform_ngons;
+    Vector<std::array<BMLoop *, 3>> looptris_prev;
+    if (use_deform_update) {
+      BM_mesh_elem_index_ensure(em->bm, BM_LOOP | BM_FACE);
+      deform_ngons = mesh_ngons_of_verts_get(deform_verts);
+      looptris_prev = mesh_looptris_of_faces_get(em, deform_ngons);
+    }
+
     mesh_partial_update(t, tc, &partial_state);
+
+    if (use_deform_update) {
+      const bool looptris_changed = mesh_looptris_of_faces_changed(
+          em, deform_ngons, looptris_prev);
+      BKE_editmesh_deform_update_tag(em, deform_verts, looptris_changed);
+    }
+    else {
+      BKE_editmesh_deform_update_clear(em);
+    }
   }
 }
 
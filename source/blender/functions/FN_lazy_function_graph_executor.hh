@@ -11,6 +11,10 @@
  * another #Graph again).
  */
 
+#include <atomic>
+#include <chrono>
+
+#include "BLI_array.hh"
 #include "BLI_vector.hh"
 #include "BLI_vector_set.hh"
 
@@ -37,6 +41,20 @@ class GraphExecutorLogger {
                                       const Params &params,
                                       const Context &context) const;
 
+  /**
+   * Whether #log_node_overhead should be called in this context. Measuring the overhead requires
+   * reading the clock multiple times for every node, so it is disabled by default.
+   */
+  virtual bool is_node_overhead_logged(const Context &context) const;
+
+  /**
+   * Called after a node has been run with the time the executor spent on it besides executing
+   * the node function, e.g. for locking, scheduling and forwarding values.
+   */
+  virtual void log_node_overhead(const FunctionNode &node,
+                                 std::chrono::nanoseconds overhead,
+                                 const Context &context) const;
+
   virtual void dump_when_outputs_are_missing(const FunctionNode &node,
                                              Span<const OutputSocket *> missing_sockets,
                                              const Context &context) const;
@@ -105,6 +123,12 @@ class GraphExecutor : public LazyFunction {
    * Optional wrapper for node execution functions.
    */
   const NodeExecuteWrapper *node_execute_wrapper_;
+  /**
+   * Estimated execution time of every node in nanoseconds, indexed by #Node::index_in_graph.
+   * It is measured every time the graph is executed and used to decide whether it is worth to
+   * let other threads work on scheduled nodes. Zero if the node has not been executed yet.
+   */
+  mutable Array<std::atomic<int32_t>> node_cost_estimates_;
 
   /**
    * When a graph is executed, various things have to be allocated (e.g. the state of all nodes).
@@ -359,4 +359,14 @@ class Params {
   }
 };
 
+/**
+ * Add the parameters in #full_params to #r_sliced_params, but only the part in the given range.
+ * The indices in the mask of #r_sliced_params are expected to be shifted accordingly. Vector
+ * parameters are not supported.
+ */
+void add_sliced_parameters(const Signature &signature,
+                           Params &full_params,
+                           IndexRange slice_range,
+                           ParamsBuilder &r_sliced_params);
+
 }  // namespace blender::fn::multi_function
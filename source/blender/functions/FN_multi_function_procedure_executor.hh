@@ -12,11 +12,18 @@
 
 namespace blender::fn::multi_function {
 
+class ValueAllocator;
+
 /** A multi-function that executes a procedure internally. */
 class ProcedureExecutor : public MultiFunction {
  private:
   Signature signature_;
   const Procedure &procedure_;
+  /**
+   * True when large masks can be evaluated in smaller blocks, which is possible when the
+   * procedure has no vector parameters.
+   */
+  bool supports_blocks_;
 
  public:
   ProcedureExecutor(const Procedure &procedure);
@@ -24,6 +31,11 @@ class ProcedureExecutor : public MultiFunction {
   void call(const IndexMask &mask, Params params, Context context) const override;
 
  private:
+  void call_block(const IndexMask &mask,
+                  Params params,
+                  const Context &context,
+                  ValueAllocator &value_allocator) const;
+
   ExecutionHints get_execution_hints() const override;
 };
 
@@ -214,36 +214,57 @@ struct LockedNode {
 class Executor;
 class GraphExecutorLFParams;
 
+/**
+ * Cost of nodes whose execution time has not been measured yet, in nanoseconds.
+ */
+static constexpr int32_t default_node_cost_ns = 1000;
+/**
+ * Scheduled nodes are only split up between multiple threads when their estimated total cost is
+ * larger than this, in nanoseconds. For cheaper nodes, the overhead of creating a task and moving
+ * the data between threads is likely larger than the gain. The value corresponds to splitting up
+ * 128 nodes whose cost is not known yet.
+ */
+static constexpr int64_t min_cost_to_split_scheduled_nodes_ns = 128 * default_node_cost_ns;
+
 /**
  * Keeps track of nodes that are currently scheduled on a thread. A node can only be scheduled by
  * one thread at the same time.
  */
 struct ScheduledNodes {
  private:
+  struct ScheduledNode {
+    const FunctionNode *node;
+    /** Estimated cost at the time the node has been scheduled. */
+    int32_t cost;
+  };
+
   /** Use two stacks of scheduled nodes for different priorities. */
-  Vector<const FunctionNode *> priority_;
-  Vector<const FunctionNode *> normal_;
+  Vector<ScheduledNode> priority_;
+  Vector<ScheduledNode> normal_;
+  /** Sum of the estimated costs of all scheduled nodes, in nanoseconds. */
+  int64_t cost_ = 0;
 
  public:
-  void schedule(const FunctionNode &node, const bool is_priority)
+  void schedule(const FunctionNode &node, const bool is_priority, const int32_t cost)
   {
     if (is_priority) {
-      this->priority_.append(&node);
+      this->priority_.append({&node, cost});
     }
     else {
-      this->normal_.append(&node);
+      this->normal_.append({&node, cost});
     }
+    cost_ += cost;
   }
 
   const FunctionNode *pop_next_node()
   {
-    if (!this->priority_.is_empty()) {
-      return this->priority_.pop_last();
-    }
-    if (!this->normal_.is_empty()) {
-      return this->normal_.pop_last();
+    Vector<ScheduledNode> &nodes = this->priority_.is_empty() ? this->normal_ : this->priority_;
+    if (nodes.is_empty()) {
+      return nullptr;
     }
-    return nullptr;
+    const ScheduledNode scheduled_node = nodes.pop_last();
+    cost_ -= scheduled_node.cost;
+    return scheduled_node.node;
   }
 
   bool is_empty() const
@@ -256,18 +277,32 @@ struct ScheduledNodes {
     return priority_.size() + normal_.size();
   }
 
+  int64_t estimated_cost() const
+  {
+    return cost_;
+  }
+
   /**
-   * Split up the scheduled nodes into two groups that can be worked on in parallel.
+   * Split up the scheduled nodes into two groups that can be worked on in parallel. The nodes that
+   * have been scheduled last stay in this group, because they likely use data that has just been
+   * computed by the current thread.
    */
   void split_into(ScheduledNodes &other)
   {
     BLI_assert(this != &other);
     const int64_t priority_split = priority_.size() / 2;
     const int64_t normal_split = normal_.size() / 2;
-    other.priority_.extend(priority_.as_span().drop_front(priority_split));
-    other.normal_.extend(normal_.as_span().drop_front(normal_split));
-    priority_.resize(priority_split);
-    normal_.resize(normal_split);
+    for (const ScheduledNode &scheduled_node : priority_.as_span().take_front(priority_split)) {
+      other.priority_.append(scheduled_node);
+      other.cost_ += scheduled_node.cost;
+    }
+    for (const ScheduledNode &scheduled_node : normal_.as_span().take_front(normal_split)) {
+      other.normal_.append(scheduled_node);
+      other.cost_ += scheduled_node.cost;
+    }
+    priority_.remove(0, priority_split);
+    normal_.remove(0, normal_split);
+    cost_ -= other.cost_;
   }
 };
 
@@ -327,6 +362,11 @@ class Executor {
    * Set to false when the first execution ends.
    */
   bool is_first_execution_ = true;
+  /**
+   * The node costs are only used to decide when to split up the scheduled nodes between threads,
+   * so they are not measured when that is not possible anyway.
+   */
+  bool measure_node_costs_ = false;
 
   friend GraphExecutorLFParams;
 
@@ -346,6 +386,9 @@ class Executor {
   {
     /* The indices are necessary, because they are used as keys in #node_states_. */
     BLI_assert(self_.graph_.node_indices_are_valid());
+#ifdef WITH_TBB
+    measure_node_costs_ = BLI_system_thread_count() > 1;
+#endif
   }
 
   ~Executor()
@@ -742,12 +785,13 @@ class Executor {
       case NodeScheduleState::NotScheduled: {
         locked_node.node_state.schedule_state = NodeScheduleState::Scheduled;
         const FunctionNode &node = static_cast<const FunctionNode &>(locked_node.node);
+        const int32_t cost = this->get_node_cost_estimate(node);
         if (this->use_multi_threading()) {
           std::lock_guard lock{current_task.mutex};
-          current_task.scheduled_nodes.schedule(node, is_priority);
+          current_task.scheduled_nodes.schedule(node, is_priority, cost);
         }
         else {
-          current_task.scheduled_nodes.schedule(node, is_priority);
+          current_task.scheduled_nodes.schedule(node, is_priority, cost);
         }
         current_task.has_scheduled_nodes.store(true, std::memory_order_relaxed);
         break;
@@ -814,9 +858,12 @@ class Executor {
       }
       this->run_node_task(*node, current_task, local_data);
 
-      /* If there are many nodes scheduled at the same time, it's beneficial to let multiple
-       * threads work on those. */
-      if (current_task.scheduled_nodes.nodes_num() > 128) {
+      /* If the scheduled nodes are expected to take a while, it's beneficial to let multiple
+       * threads work on those. Many cheap nodes are better run on the same thread, because moving
+       * them to another thread costs more than it gains. */
+      if (current_task.scheduled_nodes.nodes_num() > 1 &&
+          current_task.scheduled_nodes.estimated_cost() > min_cost_to_split_scheduled_nodes_ns)
+      {
         if (this->try_enable_multi_threading()) {
           std::unique_ptr<ScheduledNodes> split_nodes = std::make_unique<ScheduledNodes>();
           current_task.scheduled_nodes.split_into(*split_nodes);
@@ -826,6 +873,25 @@ class Executor {
     }
   }
 
+  int32_t get_node_cost_estimate(const FunctionNode &node) const
+  {
+    const int32_t cost = self_.node_cost_estimates_[node.index_in_graph()].load(
+        std::memory_order_relaxed);
+    return cost == 0 ? default_node_cost_ns : cost;
+  }
+
+  void update_node_cost_estimate(const FunctionNode &node, const std::chrono::nanoseconds duration)
+  {
+    std::atomic<int32_t> &estimate = self_.node_cost_estimates_[node.index_in_graph()];
+    /* Clamp to at least one nanosecond, because zero means that the node was not measured yet. */
+    const int64_t new_cost = std::clamp<int64_t>(duration.count(), 1, INT32_MAX);
+    const int32_t old_cost = estimate.load(std::memory_order_relaxed);
+    /* Smooth out the estimate over multiple evaluations. Concurrent updates from different
+     * threads may overwrite each other, which is fine because the value is only a heuristic. */
+    const int64_t cost = old_cost == 0 ? new_cost : (int64_t(old_cost) + new_cost) / 2;
+    estimate.store(int32_t(cost), std::memory_order_relaxed);
+  }
+
   void run_node_task(const FunctionNode &node,
                      CurrentTask &current_task,
                      const LocalData &local_data)
@@ -835,6 +901,14 @@ class Executor {
     Context local_context{context_->storage, context_->user_data, local_data.local_user_data};
     const LazyFunction &fn = node.function();
 
+    /* Reading the clock for every node is not free, so only do it when the times are used. */
+    const bool log_overhead = self_.logger_ != nullptr &&
+                              self_.logger_->is_node_overhead_logged(local_context);
+    const bool measure_execution = measure_node_costs_ || log_overhead;
+    const timeit::TimePoint start_time = log_overhead ? timeit::Clock::now() :
+                                                        timeit::TimePoint();
+    timeit::Nanoseconds execute_duration{0};
+
     bool node_needs_execution = false;
     this->with_locked_node(
         node, node_state, current_task, local_data, [&](LockedNode &locked_node) {
@@ -922,7 +996,15 @@ class Executor {
       /* Importantly, the node must not be locked when it is executed. That would result in locks
        * being hold very long in some cases and results in multiple locks being hold by the same
        * thread in the same graph which can lead to deadlocks. */
+      const timeit::TimePoint execute_start_time = measure_execution ? timeit::Clock::now() :
+                                                                       timeit::TimePoint();
       this->execute_node(node, node_state, current_task, local_data);
+      if (measure_execution) {
+        execute_duration = timeit::Clock::now() - execute_start_time;
+      }
+      if (measure_node_costs_) {
+        this->update_node_cost_estimate(node, execute_duration);
+      }
     }
 
     this->with_locked_node(
@@ -940,6 +1022,11 @@ class Executor {
             this->schedule_node(locked_node, current_task, false);
           }
         });
+
+    if (log_overhead) {
+      const timeit::Nanoseconds overhead = timeit::Clock::now() - start_time - execute_duration;
+      self_.logger_->log_node_overhead(node, overhead, local_context);
+    }
   }
 
   void assert_expected_outputs_have_been_computed(LockedNode &locked_node,
@@ -1473,11 +1560,16 @@ GraphExecutor::GraphExecutor(const Graph &graph,
       graph_output_index_by_socket_index_(graph.graph_outputs().size(), -1),
       logger_(logger),
       side_effect_provider_(side_effect_provider),
-      node_execute_wrapper_(node_execute_wrapper)
+      node_execute_wrapper_(node_execute_wrapper),
+      node_cost_estimates_(graph.nodes().size())
 {
   /* The graph executor can handle partial execution when there are still missing inputs. */
   allow_missing_requested_inputs_ = true;
 
+  for (std::atomic<int32_t> &estimate : node_cost_estimates_) {
+    estimate.store(0, std::memory_order_relaxed);
+  }
+
   for (const int i : graph_inputs_.index_range()) {
     const OutputSocket &socket = *graph_inputs_[i];
     BLI_assert(socket.node().is_interface());
@@ -1567,6 +1659,19 @@ void GraphExecutorLogger::log_after_node_execute(const FunctionNode &node,
   UNUSED_VARS(node, params, context);
 }
 
+bool GraphExecutorLogger::is_node_overhead_logged(const Context &context) const
+{
+  UNUSED_VARS(context);
+  return false;
+}
+
+void GraphExecutorLogger::log_node_overhead(const FunctionNode &node,
+                                            const std::chrono::nanoseconds overhead,
+                                            const Context &context) const
+{
+  UNUSED_VARS(node, overhead, context);
+}
+
 Vector<const FunctionNode *> GraphExecutorSideEffectProvider::get_nodes_with_side_effects(
     const Context &context) const
 {
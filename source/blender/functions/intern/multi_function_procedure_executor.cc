@@ -8,12 +8,28 @@
 
 namespace blender::fn::multi_function {
 
+/**
+ * Large masks are processed in blocks of at most this many indices. Then all instructions are
+ * executed on one block before moving on to the next, so that intermediate values stay in the CPU
+ * cache instead of being written to and read back from main memory for every instruction.
+ */
+static constexpr int64_t max_block_size = 1024;
+/**
+ * The indices in a block span at most this many elements, because buffers for intermediate values
+ * are allocated for the whole span. Masks that are sparser on average are not split into blocks.
+ */
+static constexpr int64_t max_block_span = 4 * max_block_size;
+
 ProcedureExecutor::ProcedureExecutor(const Procedure &procedure) : procedure_(procedure)
 {
   SignatureBuilder builder("Procedure Executor", signature_);
 
+  supports_blocks_ = true;
   for (const ConstParameter &param : procedure.params()) {
     builder.add("Parameter", ParamType(param.type, param.variable->data_type()));
+    if (param.variable->data_type().is_vector()) {
+      supports_blocks_ = false;
+    }
   }
 
   this->set_signature(&signature_);
@@ -148,8 +164,17 @@ class ValueAllocator : NonCopyable, NonMovable {
   Stack<void *> small_single_value_free_list_;
   Map<const CPPType *, Stack<void *>> single_value_free_lists_;
 
+  /**
+   * Span buffers are allocated with at least this size, so that they can be reused when
+   * evaluating multiple blocks with different array sizes.
+   */
+  int64_t min_span_size_;
+
  public:
-  ValueAllocator(LinearAllocator<> &linear_allocator) : linear_allocator_(linear_allocator) {}
+  ValueAllocator(LinearAllocator<> &linear_allocator, const int64_t min_span_size = 0)
+      : linear_allocator_(linear_allocator), min_span_size_(min_span_size)
+  {
+  }
 
   VariableValue_GVArray *obtain_GVArray(const GVArray &varray)
   {
@@ -166,9 +191,11 @@ class ValueAllocator : NonCopyable, NonMovable {
     return this->obtain<VariableValue_Span>(buffer, false);
   }
 
-  VariableValue_Span *obtain_Span(const CPPType &type, int size)
+  VariableValue_Span *obtain_Span(const CPPType &type, int64_t size)
   {
     void *buffer = nullptr;
+    BLI_assert(min_span_size_ == 0 || size <= min_span_size_);
+    size = std::max(size, min_span_size_);
 
     const int64_t element_size = type.size();
     const int64_t alignment = type.alignment();
@@ -813,17 +840,17 @@ class VariableState : NonCopyable, NonMovable {
 /** Keeps track of the states of all variables during evaluation. */
 class VariableStates {
  private:
-  ValueAllocator value_allocator_;
+  ValueAllocator &value_allocator_;
   const Procedure &procedure_;
   /** The state of every variable, indexed by #Variable::index_in_procedure(). */
   Array<VariableState> variable_states_;
   const IndexMask &full_mask_;
 
  public:
-  VariableStates(LinearAllocator<> &linear_allocator,
+  VariableStates(ValueAllocator &value_allocator,
                  const Procedure &procedure,
                  const IndexMask &full_mask)
-      : value_allocator_(linear_allocator),
+      : value_allocator_(value_allocator),
         procedure_(procedure),
         variable_states_(procedure.variables().size()),
         full_mask_(full_mask)
@@ -1165,7 +1192,45 @@ void ProcedureExecutor::call(const IndexMask &full_mask, Params params, Context
   LinearAllocator<> linear_allocator;
   linear_allocator.provide_buffer(local_buffer);
 
-  VariableStates variable_states{linear_allocator, procedure_, full_mask};
+  const bool use_blocks = supports_blocks_ && full_mask.size() > max_block_size &&
+                          full_mask.bounds().size() <=
+                              full_mask.size() * (max_block_span / max_block_size);
+  if (!use_blocks) {
+    ValueAllocator value_allocator{linear_allocator};
+    this->call_block(full_mask, params, context, value_allocator);
+    return;
+  }
+
+  /* All blocks share the same allocator, so that the buffers for intermediate values are reused
+   * and likely still in the cache. */
+  ValueAllocator value_allocator{linear_allocator, max_block_span};
+  int64_t mask_pos = 0;
+  while (mask_pos < full_mask.size()) {
+    const int64_t block_start = full_mask[mask_pos];
+    /* Blocks contain a fixed number of indices, unless they would span too many elements in sparse
+     * parts of the mask. */
+    const int64_t block_mask_size = std::min(
+        max_block_size, full_mask.slice_content(IndexRange(block_start, max_block_span)).size());
+    const IndexRange block_mask_range{mask_pos, block_mask_size};
+
+    IndexMaskMemory memory;
+    const IndexMask block_mask = full_mask.slice_and_shift(block_mask_range, -block_start, memory);
+    const IndexRange input_slice_range{block_start, block_mask.min_array_size()};
+
+    ParamsBuilder block_params{*this, &block_mask};
+    add_sliced_parameters(signature_, params, input_slice_range, block_params);
+    this->call_block(block_mask, block_params, context, value_allocator);
+
+    mask_pos += block_mask_size;
+  }
+}
+
+void ProcedureExecutor::call_block(const IndexMask &full_mask,
+                                   Params params,
+                                   const Context &context,
+                                   ValueAllocator &value_allocator) const
+{
+  VariableStates variable_states{value_allocator, procedure_, full_mask};
   variable_states.add_initial_variable_states(*this, procedure_, params);
 
   InstructionScheduler scheduler;
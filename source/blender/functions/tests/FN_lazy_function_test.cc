@@ -9,6 +9,7 @@
 #include "FN_lazy_function_graph_executor.hh"
 
 #include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_timeit.hh"
 
 namespace blender::fn::lazy_function::tests {
@@ -179,4 +180,131 @@ TEST(lazy_function, GraphWithCycle)
   EXPECT_EQ(result, 10 * 2 * 5);
 }
 
+#ifdef WITH_TBB
+
+/** Busy waits for the given time, so that the node has a known minimum cost. */
+class WaitFunction : public LazyFunction {
+ private:
+  timeit::Nanoseconds duration_;
+
+ public:
+  WaitFunction(const timeit::Nanoseconds duration) : duration_(duration)
+  {
+    debug_name_ = "Wait";
+  }
+
+  void execute_impl(Params & /*params*/, const Context & /*context*/) const override
+  {
+    const timeit::TimePoint end_time = timeit::Clock::now() + duration_;
+    while (timeit::Clock::now() < end_time) {
+    }
+  }
+};
+
+/**
+ * Counts how often the executor tries to split up the scheduled nodes between threads. The request
+ * is always declined, so that all nodes are still run on the calling thread in a fixed order.
+ */
+class CountMultiThreadingRequestsParams : public BasicParams {
+ public:
+  int requests_num = 0;
+
+  using BasicParams::BasicParams;
+
+  bool try_enable_multi_threading_impl() override
+  {
+    requests_num++;
+    return false;
+  }
+};
+
+/**
+ * Executes a graph that only contains nodes with side effects, and returns how often the executor
+ * tried to use multiple threads.
+ */
+static int execute_and_count_multi_threading_requests(const GraphExecutor &executor_fn)
+{
+  LinearAllocator<> allocator;
+  Context context(executor_fn.init_storage(allocator), nullptr, nullptr);
+  CountMultiThreadingRequestsParams params{executor_fn, {}, {}, {}, {}, {}};
+  executor_fn.execute(params, context);
+  executor_fn.destruct_storage(context.storage);
+  return params.requests_num;
+}
+
+class LazyFunctionSplitTest : public ::testing::Test {
+ protected:
+  void SetUp() override
+  {
+    BLI_task_scheduler_init();
+    /* Make the result independent of the number of threads of the machine. */
+    BLI_system_num_threads_override_set(4);
+  }
+
+  void TearDown() override
+  {
+    BLI_system_num_threads_override_set(0);
+  }
+};
+
+TEST_F(LazyFunctionSplitTest, ManyCheapNodes)
+{
+  const WaitFunction fn{timeit::Nanoseconds(0)};
+  Graph graph;
+  Vector<const FunctionNode *> nodes;
+  for ([[maybe_unused]] const int i : IndexRange(200)) {
+    nodes.append(&graph.add_function(fn));
+  }
+  graph.update_node_indices();
+  SimpleSideEffectProvider side_effect_provider{nodes};
+  GraphExecutor executor_fn{graph, {}, {}, nullptr, &side_effect_provider, nullptr};
+
+  /* The cost of the nodes is not known yet, so they are assumed to be worth splitting up. */
+  EXPECT_GT(execute_and_count_multi_threading_requests(executor_fn), 0);
+  /* Once the nodes have been measured, they are run on the same thread. */
+  for ([[maybe_unused]] const int i : IndexRange(3)) {
+    execute_and_count_multi_threading_requests(executor_fn);
+  }
+  EXPECT_EQ(execute_and_count_multi_threading_requests(executor_fn), 0);
+}
+
+TEST_F(LazyFunctionSplitTest, FewExpensiveNodes)
+{
+  const WaitFunction fn{std::chrono::microseconds(200)};
+  Graph graph;
+  Vector<const FunctionNode *> nodes;
+  for ([[maybe_unused]] const int i : IndexRange(4)) {
+    nodes.append(&graph.add_function(fn));
+  }
+  graph.update_node_indices();
+  SimpleSideEffectProvider side_effect_provider{nodes};
+  GraphExecutor executor_fn{graph, {}, {}, nullptr, &side_effect_provider, nullptr};
+
+  /* The cost of the few nodes is unknown at first, so they are not worth splitting up. */
+  EXPECT_EQ(execute_and_count_multi_threading_requests(executor_fn), 0);
+  /* With the measured cost, other threads are asked to help. */
+  EXPECT_GT(execute_and_count_multi_threading_requests(executor_fn), 0);
+}
+
+TEST_F(LazyFunctionSplitTest, SingleThread)
+{
+  BLI_system_num_threads_override_set(1);
+  const WaitFunction fn{std::chrono::microseconds(200)};
+  Graph graph;
+  Vector<const FunctionNode *> nodes;
+  for ([[maybe_unused]] const int i : IndexRange(4)) {
+    nodes.append(&graph.add_function(fn));
+  }
+  graph.update_node_indices();
+  SimpleSideEffectProvider side_effect_provider{nodes};
+  GraphExecutor executor_fn{graph, {}, {}, nullptr, &side_effect_provider, nullptr};
+
+  /* The node costs are not measured when there is only one thread, so the nodes are never
+   * considered to be expensive. */
+  EXPECT_EQ(execute_and_count_multi_threading_requests(executor_fn), 0);
+  EXPECT_EQ(execute_and_count_multi_threading_requests(executor_fn), 0);
+}
+
+#endif
+
 }  // namespace blender::fn::lazy_function::tests
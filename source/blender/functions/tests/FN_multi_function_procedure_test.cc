@@ -96,6 +96,119 @@ TEST(multi_function_procedure, SimpleTest)
   EXPECT_EQ(output_array[2], 19);
 }
 
+TEST(multi_function_procedure, LargeMask)
+{
+  /**
+   * procedure(int var1, int var2, int *var4) {
+   *   int var3 = var1 + var2;
+   *   var4 = var2 + var3;
+   * }
+   */
+
+  auto add_fn = mf::build::SI2_SO<int, int, int>("add", [](int a, int b) { return a + b; });
+
+  Procedure procedure;
+  ProcedureBuilder builder{procedure};
+
+  Variable *var1 = &builder.add_single_input_parameter<int>();
+  Variable *var2 = &builder.add_single_input_parameter<int>();
+  auto [var3] = builder.add_call<1>(add_fn, {var1, var2});
+  auto [var4] = builder.add_call<1>(add_fn, {var2, var3});
+  builder.add_destruct({var1, var2, var3});
+  builder.add_return();
+  builder.add_output_parameter(*var4);
+
+  EXPECT_TRUE(procedure.validate());
+
+  ProcedureExecutor executor{procedure};
+
+  /* Use a mask that is large enough to be evaluated in multiple blocks and has gaps. */
+  const int64_t size = 10000;
+  IndexMaskMemory memory;
+  const IndexMask mask = IndexMask::from_predicate(
+      IndexRange(size), GrainSize(1024), memory, [](const int64_t i) {
+        return i % 3 != 0 || (i > 2000 && i < 6000);
+      });
+  ParamsBuilder params{executor, &mask};
+  ContextBuilder context;
+
+  Array<int> input_array(size);
+  for (const int64_t i : input_array.index_range()) {
+    input_array[i] = int(i);
+  }
+  params.add_readonly_single_input(input_array.as_span());
+  params.add_readonly_single_input_value(5);
+
+  Array<int> output_array(size, -1);
+  params.add_uninitialized_single_output(output_array.as_mutable_span());
+
+  executor.call(mask, params, context);
+
+  for (const int64_t i : output_array.index_range()) {
+    const bool in_mask = mask.contains(i);
+    EXPECT_EQ(output_array[i], in_mask ? int(i) + 10 : -1);
+  }
+}
+
+TEST(multi_function_procedure, SparseMask)
+{
+  /**
+   * procedure(int var1, int var2, int *var4) {
+   *   int var3 = var1 + var2;
+   *   var4 = var2 + var3;
+   * }
+   */
+
+  auto add_fn = mf::build::SI2_SO<int, int, int>("add", [](int a, int b) { return a + b; });
+
+  Procedure procedure;
+  ProcedureBuilder builder{procedure};
+
+  Variable *var1 = &builder.add_single_input_parameter<int>();
+  Variable *var2 = &builder.add_single_input_parameter<int>();
+  auto [var3] = builder.add_call<1>(add_fn, {var1, var2});
+  auto [var4] = builder.add_call<1>(add_fn, {var2, var3});
+  builder.add_destruct({var1, var2, var3});
+  builder.add_return();
+  builder.add_output_parameter(*var4);
+
+  EXPECT_TRUE(procedure.validate());
+
+  ProcedureExecutor executor{procedure};
+
+  const int64_t size = 100000;
+  Array<int> input_array(size);
+  for (const int64_t i : input_array.index_range()) {
+    input_array[i] = int(i);
+  }
+
+  IndexMaskMemory memory;
+  /* A mask that is sparse everywhere and one that is dense at the start and sparse at the end. */
+  const IndexMask sparse_mask = IndexMask::from_predicate(
+      IndexRange(size), GrainSize(1024), memory, [](const int64_t i) { return i % 50 == 7; });
+  const IndexMask mixed_mask = IndexMask::from_predicate(
+      IndexRange(size), GrainSize(1024), memory, [](const int64_t i) {
+        return i < 40000 || i % 1000 == 0;
+      });
+
+  for (const IndexMask &mask : {sparse_mask, mixed_mask}) {
+    ParamsBuilder params{executor, &mask};
+    ContextBuilder context;
+    params.add_readonly_single_input(input_array.as_span());
+    params.add_readonly_single_input_value(5);
+
+    Array<int> output_array(size, -1);
+    params.add_uninitialized_single_output(output_array.as_mutable_span());
+
+    executor.call(mask, params, context);
+
+    for (const int64_t i : output_array.index_range()) {
+      const bool in_mask = mask.contains(i);
+      EXPECT_EQ(output_array[i], in_mask ? int(i) + 10 : -1);
+    }
+  }
+}
+
 TEST(multi_function_procedure, BranchTest)
 {
   /**
@@ -6,11 +6,16 @@
 // #define USE_WELD_DEBUG_TIME
 
 #include "BLI_array.hh"
+#include "BLI_array_utils.hh"
 #include "BLI_bit_vector.hh"
+#include "BLI_bounds.hh"
 #include "BLI_index_mask.hh"
 #include "BLI_kdtree.h"
 #include "BLI_math_vector.h"
+#include "BLI_math_vector.hh"
 #include "BLI_offset_indices.hh"
+#include "BLI_sort.hh"
+#include "BLI_task.hh"
 #include "BLI_vector.hh"
 
 #include "BKE_customdata.hh"
@@ -333,33 +338,50 @@ static Vector<WeldEdge> weld_edge_ctx_alloc_and_find_collapsed(Span<int2> edges,
                                                                int *r_edge_collapsed_len)
 {
   /* Edge Context. */
-  int edge_collapsed_len = 0;
-
-  Vector<WeldEdge> wedge;
-  wedge.reserve(edges.size());
-
-  for (const int i : edges.index_range()) {
-    int v1 = edges[i][0];
-    int v2 = edges[i][1];
-    int v_dest_1 = vert_dest_map[v1];
-    int v_dest_2 = vert_dest_map[v2];
-    if (v_dest_1 == OUT_OF_CONTEXT && v_dest_2 == OUT_OF_CONTEXT) {
-      r_edge_dest_map[i] = OUT_OF_CONTEXT;
-      continue;
-    }
-
+  const int edge_collapsed_len = threading::parallel_reduce(
+      edges.index_range(),
+      4096,
+      0,
+      [&](const IndexRange range, int collapsed_len) {
+        for (const int i : range) {
+          const int v1 = edges[i][0];
+          const int v2 = edges[i][1];
+          const int v_dest_1 = vert_dest_map[v1];
+          const int v_dest_2 = vert_dest_map[v2];
+          if (v_dest_1 == OUT_OF_CONTEXT && v_dest_2 == OUT_OF_CONTEXT) {
+            r_edge_dest_map[i] = OUT_OF_CONTEXT;
+            continue;
+          }
+          const int vert_a = (v_dest_1 == OUT_OF_CONTEXT) ? v1 : v_dest_1;
+          const int vert_b = (v_dest_2 == OUT_OF_CONTEXT) ? v2 : v_dest_2;
+          if (vert_a == vert_b) {
+            r_edge_dest_map[i] = ELEM_COLLAPSED;
+            collapsed_len++;
+          }
+          else {
+            r_edge_dest_map[i] = i;
+          }
+        }
+        return collapsed_len;
+      },
+      std::plus<>());
+
+  IndexMaskMemory memory;
+  const IndexMask wedge_mask = IndexMask::from_predicate(
+      edges.index_range(), GrainSize(4096), memory, [&](const int i) {
+        return r_edge_dest_map[i] == i;
+      });
+
+  Vector<WeldEdge> wedge(wedge_mask.size());
+  wedge_mask.foreach_index(GrainSize(4096), [&](const int i, const int pos) {
+    const int v1 = edges[i][0];
+    const int v2 = edges[i][1];
+    const int v_dest_1 = vert_dest_map[v1];
+    const int v_dest_2 = vert_dest_map[v2];
     const int vert_a = (v_dest_1 == OUT_OF_CONTEXT) ? v1 : v_dest_1;
     const int vert_b = (v_dest_2 == OUT_OF_CONTEXT) ? v2 : v_dest_2;
-
-    if (vert_a == vert_b) {
-      r_edge_dest_map[i] = ELEM_COLLAPSED;
-      edge_collapsed_len++;
-    }
-    else {
-      wedge.append({i, vert_a, vert_b});
-      r_edge_dest_map[i] = i;
-    }
-  }
+    wedge[pos] = {i, vert_a, vert_b};
+  });
 
   *r_edge_collapsed_len = edge_collapsed_len;
   return wedge;
@@ -581,21 +603,33 @@ static void weld_poly_loop_ctx_alloc(const OffsetIndices<int> faces,
   Span<int> edge_dest_map = r_weld_mesh->edge_dest_map;
 
   /* Loop/Poly Context. */
-  Array<int> loop_map(corner_verts.size());
-  Array<int> face_map(faces.size());
+  Array<int> loop_map(corner_verts.size(), OUT_OF_CONTEXT);
+  Array<int> face_map(faces.size(), OUT_OF_CONTEXT);
   int wloop_len = 0;
   int wpoly_len = 0;
   int max_ctx_poly_len = 4;
 
+  /* Usually only few faces have weld vertices, find them in parallel to skip the others. */
+  IndexMaskMemory memory;
+  const IndexMask ctx_faces = IndexMask::from_predicate(
+      faces.index_range(), GrainSize(1024), memory, [&](const int i) {
+        const Span<int> face_verts = corner_verts.slice(faces[i]);
+        return std::any_of(face_verts.begin(), face_verts.end(), [&](const int vert) {
+          return vert_dest_map[vert] != OUT_OF_CONTEXT;
+        });
+      });
+
   Vector<WeldLoop> wloop;
-  wloop.reserve(corner_verts.size());
+  int ctx_loops_num = 0;
+  ctx_faces.foreach_index([&](const int i) { ctx_loops_num += faces[i].size(); });
+  wloop.reserve(ctx_loops_num);
 
   Vector<WeldPoly> wpoly;
-  wpoly.reserve(faces.size());
+  wpoly.reserve(ctx_faces.size());
 
   int maybe_new_poly = 0;
 
-  for (const int i : faces.index_range()) {
+  ctx_faces.foreach_index([&](const int i) {
     const int loopstart = faces[i].start();
     const int totloop = faces[i].size();
     const int loop_end = loopstart + totloop - 1;
@@ -673,10 +707,7 @@ static void weld_poly_loop_ctx_alloc(const OffsetIndices<int> faces,
         CLAMP_MIN(max_ctx_poly_len, totloop);
       }
     }
-    else {
-      face_map[i] = OUT_OF_CONTEXT;
-    }
-  }
+  });
 
   wpoly.reserve(wpoly.size() + maybe_new_poly);
 
@@ -1690,6 +1721,302 @@ static Mesh *create_merged_mesh(const Mesh &mesh,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Vertex Grid
+ *
+ * Finds the vertices to merge in parallel, giving the same result as
+ * #BLI_kdtree_3d_calc_duplicates_fast with index order: vertices are visited in order of their
+ * index, and every vertex that was not merged yet is kept and becomes the target of all other
+ * vertices within the merge distance that were not merged yet.
+ *
+ * Equivalently, a vertex is merged into the kept vertex with the lowest index within the merge
+ * distance, and it is kept if there is no such vertex. This only depends on the state of the
+ * vertices with a lower index within the merge distance, so all vertices whose lower-index
+ * neighbors are decided can be decided at the same time. The vertices are sorted into a grid with
+ * the merge distance as cell size to find their neighbors, and are decided in a few rounds until
+ * every vertex is decided.
+ * \{ */
+
+enum class WeldVertState : int8_t {
+  Undecided,
+  /** The vertex is kept, other vertices may be merged into it. */
+  Kept,
+  /** The vertex is merged into the vertex in the destination map. */
+  Merged,
+};
+
+struct WeldVertGrid {
+  /**
+   * The cells are computed in double precision. With float, the rounding error of the offset
+   * from the origin alone can be larger than the cell margin when there are many cells.
+   */
+  double3 origin;
+  double cell_size_inv;
+  int3 resolution;
+  /** Sorted keys of the cells that contain selected vertices. */
+  Array<uint64_t> cell_keys;
+  /** Range of #verts for each cell in #cell_keys. */
+  Array<int> cell_offsets;
+  /** Selected vertices, sorted by cell and by index within each cell. */
+  Array<int> verts;
+
+  int3 cell_of_position(const float3 &position) const
+  {
+    const int3 cell(math::floor((double3(position) - origin) * cell_size_inv));
+    return math::clamp(cell, int3(0), resolution - 1);
+  }
+
+  uint64_t cell_key(const int3 &cell) const
+  {
+    return (uint64_t(cell.z) * uint64_t(resolution.y) + uint64_t(cell.y)) *
+               uint64_t(resolution.x) +
+           uint64_t(cell.x);
+  }
+
+  int3 cell_of_key(const uint64_t key) const
+  {
+    const uint64_t row = key / uint64_t(resolution.x);
+    return int3(int(key % uint64_t(resolution.x)),
+                int(row % uint64_t(resolution.y)),
+                int(row / uint64_t(resolution.y)));
+  }
+
+  Span<int> cell_verts(const int cell) const
+  {
+    return verts.as_span().slice(cell_offsets[cell], cell_offsets[cell + 1] - cell_offsets[cell]);
+  }
+
+  /**
+   * Call the function for the non-empty cells in the 3x3x3 block around the cell, which contain
+   * all vertices within the merge distance of the vertices in the cell. Cells in the same row are
+   * consecutive, so they are passed together as a range.
+   */
+  template<typename Fn> void foreach_neighbor_cells(const int cell, const Fn &fn) const
+  {
+    const int3 center = this->cell_of_key(cell_keys[cell]);
+    const int3 min = math::max(center - 1, int3(0));
+    const int3 max = math::min(center + 1, resolution - 1);
+    const uint64_t *keys_begin = cell_keys.begin();
+    for (int z = min.z; z <= max.z; z++) {
+      for (int y = min.y; y <= max.y; y++) {
+        /* Rows are visited in order of their keys, so the search can start at the last row. */
+        const uint64_t *first = std::lower_bound(
+            keys_begin, cell_keys.end(), this->cell_key({min.x, y, z}));
+        const uint64_t *last = std::upper_bound(
+            first, cell_keys.end(), this->cell_key({max.x, y, z}));
+        keys_begin = last;
+        if (first != last) {
+          fn(IndexRange::from_begin_end(first - cell_keys.begin(), last - cell_keys.begin()));
+        }
+      }
+    }
+  }
+};
+
+/**
+ * Sort the selected vertices into a grid. Returns none if the grid would have too many cells,
+ * which happens with a merge distance that is tiny compared to the size of the mesh.
+ */
+static std::optional<WeldVertGrid> weld_vert_grid_create(const Span<float3> positions,
+                                                         const IndexMask &selection,
+                                                         const float merge_distance)
+{
+  if (!(merge_distance > 0.0f)) {
+    return std::nullopt;
+  }
+  const std::optional<Bounds<float3>> bounds = bounds::min_max(selection, positions);
+  if (!bounds) {
+    return std::nullopt;
+  }
+
+  /* Enlarge the cells a bit, so that vertices within the merge distance are never more than one
+   * cell apart because of rounding of the distances, which are computed in float. */
+  const double cell_size = double(merge_distance) * 1.001;
+  const double3 size = (double3(bounds->max) - double3(bounds->min)) / cell_size + 1.0;
+  if (!(math::reduce_max(size) < double(1 << 30)) ||
+      !(size.x * size.y * size.z < double(uint64_t(1) << 62)))
+  {
+    return std::nullopt;
+  }
+
+  WeldVertGrid grid;
+  grid.origin = double3(bounds->min);
+  grid.cell_size_inv = 1.0 / cell_size;
+  grid.resolution = int3(size);
+
+  Array<std::pair<uint64_t, int>> items(selection.size());
+  selection.foreach_index(GrainSize(4096), [&](const int vert, const int pos) {
+    items[pos] = {grid.cell_key(grid.cell_of_position(positions[vert])), vert};
+  });
+  parallel_sort(items.begin(), items.end());
+
+  IndexMaskMemory memory;
+  const IndexMask cell_starts = IndexMask::from_predicate(
+      items.index_range(), GrainSize(4096), memory, [&](const int64_t i) {
+        return i == 0 || items[i].first != items[i - 1].first;
+      });
+  grid.cell_keys.reinitialize(cell_starts.size());
+  grid.cell_offsets.reinitialize(cell_starts.size() + 1);
+  cell_starts.foreach_index(GrainSize(4096), [&](const int i, const int cell) {
+    grid.cell_keys[cell] = items[i].first;
+    grid.cell_offsets[cell] = i;
+  });
+  grid.cell_offsets.last() = items.size();
+
+  grid.verts.reinitialize(items.size());
+  threading::parallel_for(items.index_range(), 4096, [&](const IndexRange range) {
+    for (const int i : range) {
+      grid.verts[i] = items[i].second;
+    }
+  });
+  return grid;
+}
+
+/**
+ * Decide the vertices of the cell whose lower-index neighbors are decided already. The states of
+ * vertices in other cells are read from \a states, because they may be decided by other threads
+ * at the same time. Vertices in the same cell are processed in order of their index, so their
+ * decisions from this round in \a r_states can be used directly.
+ *
+ * \return The number of vertices in the cell that remain undecided.
+ */
+static int weld_vert_grid_decide_cell(const WeldVertGrid &grid,
+                                      const Span<float3> positions,
+                                      const float merge_distance_sq,
+                                      const int cell,
+                                      const Span<WeldVertState> states,
+                                      MutableSpan<WeldVertState> r_states,
+                                      MutableSpan<int> r_vert_dest_map)
+{
+  int undecided_num = 0;
+  for (const int vert : grid.cell_verts(cell)) {
+    if (r_states[vert] != WeldVertState::Undecided) {
+      continue;
+    }
+    const float3 &position = positions[vert];
+    int min_kept = INT_MAX;
+    int min_undecided = INT_MAX;
+    grid.foreach_neighbor_cells(cell, [&](const IndexRange neighbor_cells) {
+      for (const int neighbor_cell : neighbor_cells) {
+        const Span<WeldVertState> neighbor_states = neighbor_cell == cell ? r_states.as_span() :
+                                                                            states;
+        for (const int other : grid.cell_verts(neighbor_cell)) {
+          if (other >= vert) {
+            /* Vertices are sorted by index within each cell. */
+            break;
+          }
+          if (math::distance_squared(position, positions[other]) > merge_distance_sq) {
+            continue;
+          }
+          switch (neighbor_states[other]) {
+            case WeldVertState::Undecided:
+              min_undecided = std::min(min_undecided, other);
+              break;
+            case WeldVertState::Kept:
+              min_kept = std::min(min_kept, other);
+              break;
+            case WeldVertState::Merged:
+              break;
+          }
+        }
+      }
+    });
+    if (min_undecided < min_kept) {
+      /* The undecided vertex may be kept, in which case this vertex is merged into it. */
+      undecided_num++;
+    }
+    else if (min_kept != INT_MAX) {
+      r_states[vert] = WeldVertState::Merged;
+      r_vert_dest_map[vert] = min_kept;
+    }
+    else {
+      r_states[vert] = WeldVertState::Kept;
+    }
+  }
+  return undecided_num;
+}
+
+/**
+ * Fill the destination map for all selected vertices within the merge distance of each other.
+ *
+ * \return The number of merged vertices, or none if the grid can't be used, in which case the
+ * destination map is not changed.
+ */
+static std::optional<int> weld_vert_grid_calc_duplicates(const Span<float3> positions,
+                                                         const IndexMask &selection,
+                                                         const float merge_distance,
+                                                         MutableSpan<int> r_vert_dest_map)
+{
+  const std::optional<WeldVertGrid> grid = weld_vert_grid_create(
+      positions, selection, merge_distance);
+  if (!grid) {
+    return std::nullopt;
+  }
+  const float merge_distance_sq = merge_distance * merge_distance;
+
+  Array<WeldVertState> states(positions.size(), WeldVertState::Undecided);
+  Array<WeldVertState> new_states(positions.size());
+
+  IndexMaskMemory memory;
+  IndexMask cells_todo(grid->cell_keys.size());
+  int64_t undecided_num = selection.size();
+  while (!cells_todo.is_empty()) {
+    array_utils::copy(states.as_span(), new_states.as_mutable_span());
+    const int64_t new_undecided_num = threading::parallel_reduce(
+        cells_todo.index_range(),
+        64,
+        int64_t(0),
+        [&](const IndexRange range, int64_t num) {
+          cells_todo.slice(range).foreach_index([&](const int cell) {
+            num += weld_vert_grid_decide_cell(
+                *grid, positions, merge_distance_sq, cell, states, new_states, r_vert_dest_map);
+          });
+          return num;
+        },
+        std::plus<>());
+    std::swap(states, new_states);
+    cells_todo = IndexMask::from_predicate(
+        cells_todo, GrainSize(1024), memory, [&](const int cell) {
+          const Span<int> verts = grid->cell_verts(cell);
+          return std::any_of(verts.begin(), verts.end(), [&](const int vert) {
+            return states[vert] == WeldVertState::Undecided;
+          });
+        });
+    if (new_undecided_num > undecided_num / 2) {
+      /* Long chains of vertices within the merge distance of each other only allow deciding a few
+       * vertices per round. Decide the remaining vertices in order of their index, then all
+       * lower-index neighbors are always decided already. */
+      IndexMaskMemory remaining_memory;
+      const IndexMask remaining = IndexMask::from_predicate(
+          selection, GrainSize(4096), remaining_memory, [&](const int vert) {
+            return states[vert] == WeldVertState::Undecided;
+          });
+      remaining.foreach_index([&](const int vert) {
+        const uint64_t key = grid->cell_key(grid->cell_of_position(positions[vert]));
+        const int cell = std::lower_bound(grid->cell_keys.begin(), grid->cell_keys.end(), key) -
+                         grid->cell_keys.begin();
+        weld_vert_grid_decide_cell(
+            *grid, positions, merge_distance_sq, cell, states, states, r_vert_dest_map);
+      });
+      break;
+    }
+    undecided_num = new_undecided_num;
+  }
+
+  int vert_kill_len = 0;
+  selection.foreach_index([&](const int vert) {
+    BLI_assert(states[vert] != WeldVertState::Undecided);
+    if (states[vert] == WeldVertState::Merged) {
+      const int vert_dest = r_vert_dest_map[vert];
+      r_vert_dest_map[vert_dest] = vert_dest;
+      vert_kill_len++;
+    }
+  });
+  return vert_kill_len;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Merge Map Creation
  * \{ */
@@ -1700,15 +2027,23 @@ std::optional<Mesh *> mesh_merge_by_distance_all(const Mesh &mesh,
 {
   Array<int> vert_dest_map(mesh.verts_num, OUT_OF_CONTEXT);
 
-  KDTree_3d *tree = BLI_kdtree_3d_new(selection.size());
-
   const Span<float3> positions = mesh.vert_positions();
-  selection.foreach_index([&](const int64_t i) { BLI_kdtree_3d_insert(tree, i, positions[i]); });
-
-  BLI_kdtree_3d_balance(tree);
-  const int vert_kill_len = BLI_kdtree_3d_calc_duplicates_fast(
-      tree, merge_distance, true, vert_dest_map.data());
-  BLI_kdtree_3d_free(tree);
+  int vert_kill_len;
+  if (const std::optional<int> grid_kill_len = weld_vert_grid_calc_duplicates(
+          positions, selection, merge_distance, vert_dest_map))
+  {
+    vert_kill_len = *grid_kill_len;
+  }
+  else {
+    KDTree_3d *tree = BLI_kdtree_3d_new(selection.size());
+    selection.foreach_index(
+        [&](const int64_t i) { BLI_kdtree_3d_insert(tree, i, positions[i]); });
+
+    BLI_kdtree_3d_balance(tree);
+    vert_kill_len = BLI_kdtree_3d_calc_duplicates_fast(
+        tree, merge_distance, true, vert_dest_map.data());
+    BLI_kdtree_3d_free(tree);
+  }
 
   if (vert_kill_len == 0) {
     return std::nullopt;
@@ -8,6 +8,7 @@
 #include "DNA_collection_types.h"
 
 #include "BLI_array_utils.hh"
+#include "BLI_bounds.hh"
 #include "BLI_noise.hh"
 
 #include "BKE_curves.hh"
@@ -416,6 +417,10 @@ static void copy_generic_attributes_to_result(
   threading::parallel_for(
       dst_attribute_writers.index_range(), 10, [&](const IndexRange attribute_range) {
         for (const int attribute_index : attribute_range) {
+          if (!dst_attribute_writers[attribute_index]) {
+            /* The attribute is shared with the source geometry. */
+            continue;
+          }
           const bke::AttrDomain domain = ordered_attributes.kinds[attribute_index].domain;
           const IndexRange element_slice = range_fn(domain);
 
@@ -1370,6 +1375,47 @@ static AllMeshesInfo preprocess_meshes(const bke::GeometrySet &geometry_set,
   return info;
 }
 
+/**
+ * Whether all material indices reference one of the material slots. Other indices are set to zero
+ * when the indices are copied, so the array can only be shared when there are none.
+ */
+static bool material_indices_in_range(const VArray<int> &material_indices, const int materials_num)
+{
+  const IndexRange range(materials_num);
+  if (material_indices.is_single()) {
+    return range.contains(material_indices.get_internal_single());
+  }
+  const VArraySpan<int> indices(material_indices);
+  const std::optional<Bounds<int>> bounds = bounds::min_max(Span<int>(indices));
+  return !bounds || (range.contains(bounds->min) && range.contains(bounds->max));
+}
+
+/**
+ * Share the attribute of the source mesh with the result instead of copying it, which is possible
+ * when it is stored with the same domain and type.
+ *
+ * \return False if the attribute has to be copied.
+ */
+static bool try_share_mesh_attribute(const Mesh &src_mesh,
+                                     const AttributeIDRef &attribute_id,
+                                     const bke::AttrDomain domain,
+                                     const eCustomDataType data_type,
+                                     bke::MutableAttributeAccessor dst_attributes)
+{
+  const bke::GAttributeReader src = src_mesh.attributes().lookup(attribute_id);
+  if (!src || src.domain != domain || !src.sharing_info || !src.varray.is_span()) {
+    return false;
+  }
+  if (bke::cpp_type_to_custom_data_type(src.varray.type()) != data_type) {
+    return false;
+  }
+  return dst_attributes.add(
+      attribute_id,
+      domain,
+      data_type,
+      bke::AttributeInitShared(src.varray.get_internal_span().data(), *src.sharing_info));
+}
+
 static void execute_realize_mesh_task(const RealizeInstancesOptions &options,
                                       const RealizeMeshTask &task,
                                       const OrderedAttributes &ordered_attributes,
@@ -1396,37 +1442,49 @@ static void execute_realize_mesh_task(const RealizeInstancesOptions &options,
   const IndexRange dst_face_range(task.start_indices.face, src_faces.size());
   const IndexRange dst_loop_range(task.start_indices.loop, src_corner_verts.size());
 
-  MutableSpan<float3> dst_positions = all_dst_positions.slice(dst_vert_range);
-  MutableSpan<int2> dst_edges = all_dst_edges.slice(dst_edge_range);
-  MutableSpan<int> dst_face_offsets = all_dst_face_offsets.slice(dst_face_range);
-  MutableSpan<int> dst_corner_verts = all_dst_corner_verts.slice(dst_loop_range);
-  MutableSpan<int> dst_corner_edges = all_dst_corner_edges.slice(dst_loop_range);
-
-  threading::parallel_for(src_positions.index_range(), 1024, [&](const IndexRange vert_range) {
-    for (const int i : vert_range) {
-      dst_positions[i] = math::transform_point(task.transform, src_positions[i]);
-    }
-  });
-  threading::parallel_for(src_edges.index_range(), 1024, [&](const IndexRange edge_range) {
-    for (const int i : edge_range) {
-      dst_edges[i] = src_edges[i] + task.start_indices.vertex;
-    }
-  });
-  threading::parallel_for(src_corner_verts.index_range(), 1024, [&](const IndexRange loop_range) {
-    for (const int i : loop_range) {
-      dst_corner_verts[i] = src_corner_verts[i] + task.start_indices.vertex;
-    }
-  });
-  threading::parallel_for(src_corner_edges.index_range(), 1024, [&](const IndexRange loop_range) {
-    for (const int i : loop_range) {
-      dst_corner_edges[i] = src_corner_edges[i] + task.start_indices.edge;
-    }
-  });
-  threading::parallel_for(src_faces.index_range(), 1024, [&](const IndexRange face_range) {
-    for (const int i : face_range) {
-      dst_face_offsets[i] = src_faces[i].start() + task.start_indices.loop;
-    }
-  });
+  /* Empty destination spans indicate that the array is shared with the source mesh. */
+  if (!all_dst_positions.is_empty()) {
+    MutableSpan<float3> dst_positions = all_dst_positions.slice(dst_vert_range);
+    threading::parallel_for(src_positions.index_range(), 1024, [&](const IndexRange vert_range) {
+      for (const int i : vert_range) {
+        dst_positions[i] = math::transform_point(task.transform, src_positions[i]);
+      }
+    });
+  }
+  if (!all_dst_edges.is_empty()) {
+    MutableSpan<int2> dst_edges = all_dst_edges.slice(dst_edge_range);
+    threading::parallel_for(src_edges.index_range(), 1024, [&](const IndexRange edge_range) {
+      for (const int i : edge_range) {
+        dst_edges[i] = src_edges[i] + task.start_indices.vertex;
+      }
+    });
+  }
+  if (!all_dst_corner_verts.is_empty()) {
+    MutableSpan<int> dst_corner_verts = all_dst_corner_verts.slice(dst_loop_range);
+    threading::parallel_for(
+        src_corner_verts.index_range(), 1024, [&](const IndexRange loop_range) {
+          for (const int i : loop_range) {
+            dst_corner_verts[i] = src_corner_verts[i] + task.start_indices.vertex;
+          }
+        });
+  }
+  if (!all_dst_corner_edges.is_empty()) {
+    MutableSpan<int> dst_corner_edges = all_dst_corner_edges.slice(dst_loop_range);
+    threading::parallel_for(
+        src_corner_edges.index_range(), 1024, [&](const IndexRange loop_range) {
+          for (const int i : loop_range) {
+            dst_corner_edges[i] = src_corner_edges[i] + task.start_indices.edge;
+          }
+        });
+  }
+  if (!all_dst_face_offsets.is_empty()) {
+    MutableSpan<int> dst_face_offsets = all_dst_face_offsets.slice(dst_face_range);
+    threading::parallel_for(src_faces.index_range(), 1024, [&](const IndexRange face_range) {
+      for (const int i : face_range) {
+        dst_face_offsets[i] = src_faces[i].start() + task.start_indices.loop;
+      }
+    });
+  }
   if (!all_dst_material_indices.is_empty()) {
     const Span<int> material_index_map = mesh_info.material_index_map;
     MutableSpan<int> dst_material_indices = all_dst_material_indices.slice(dst_face_range);
@@ -1500,14 +1558,9 @@ static void execute_realize_mesh_tasks(const RealizeInstancesOptions &options,
   const int tot_loops = last_task.start_indices.loop + last_mesh.corners_num;
   const int tot_faces = last_task.start_indices.face + last_mesh.faces_num;
 
-  Mesh *dst_mesh = BKE_mesh_new_nomain(tot_vertices, tot_edges, tot_faces, tot_loops);
+  Mesh *dst_mesh = bke::mesh_new_no_attributes(tot_vertices, tot_edges, tot_faces, tot_loops);
   r_realized_geometry.replace_mesh(dst_mesh);
   bke::MutableAttributeAccessor dst_attributes = dst_mesh->attributes_for_write();
-  MutableSpan<float3> dst_positions = dst_mesh->vert_positions_for_write();
-  MutableSpan<int2> dst_edges = dst_mesh->edges_for_write();
-  MutableSpan<int> dst_face_offsets = dst_mesh->face_offsets_for_write();
-  MutableSpan<int> dst_corner_verts = dst_mesh->corner_verts_for_write();
-  MutableSpan<int> dst_corner_edges = dst_mesh->corner_edges_for_write();
 
   /* Copy settings from the first input geometry set with a mesh. */
   const RealizeMeshTask &first_task = tasks.first();
@@ -1517,6 +1570,59 @@ static void execute_realize_mesh_tasks(const RealizeInstancesOptions &options,
    * attributes are added explicitly below. */
   BLI_freelistN(&dst_mesh->vertex_group_names);
 
+  /* When the result only contains a single mesh, arrays that are not changed by realizing it are
+   * shared with that mesh instead of being copied. Arrays of the result can't reference ranges of
+   * other arrays, so with more than one mesh everything is still copied, even when all instances
+   * reference the same mesh. */
+  const bool share_unchanged_arrays = tasks.size() == 1;
+  const bool positions_unchanged = first_task.transform == float4x4::identity();
+  /* Returns false if the array is shared with the first mesh and must not be written. */
+  const auto add_array = [&](const AttributeIDRef &attribute_id,
+                             const bke::AttrDomain domain,
+                             const eCustomDataType data_type,
+                             const bool is_unchanged) {
+    if (share_unchanged_arrays && is_unchanged &&
+        try_share_mesh_attribute(first_mesh, attribute_id, domain, data_type, dst_attributes))
+    {
+      return false;
+    }
+    dst_attributes.add(attribute_id, domain, data_type, bke::AttributeInitConstruct());
+    return true;
+  };
+
+  MutableSpan<float3> dst_positions;
+  if (add_array("position", bke::AttrDomain::Point, CD_PROP_FLOAT3, positions_unchanged)) {
+    dst_positions = dst_mesh->vert_positions_for_write();
+  }
+  else {
+    dst_mesh->runtime->bounds_cache = first_mesh.runtime->bounds_cache;
+  }
+  MutableSpan<int2> dst_edges;
+  if (add_array(".edge_verts", bke::AttrDomain::Edge, CD_PROP_INT32_2D, true)) {
+    dst_edges = dst_mesh->edges_for_write();
+  }
+  MutableSpan<int> dst_corner_verts;
+  if (add_array(".corner_vert", bke::AttrDomain::Corner, CD_PROP_INT32, true)) {
+    dst_corner_verts = dst_mesh->corner_verts_for_write();
+  }
+  MutableSpan<int> dst_corner_edges;
+  if (add_array(".corner_edge", bke::AttrDomain::Corner, CD_PROP_INT32, true)) {
+    dst_corner_edges = dst_mesh->corner_edges_for_write();
+  }
+  MutableSpan<int> dst_face_offsets;
+  if (share_unchanged_arrays) {
+    implicit_sharing::free_shared_data(&dst_mesh->face_offset_indices,
+                                       &dst_mesh->runtime->face_offsets_sharing_info);
+    implicit_sharing::copy_shared_pointer(first_mesh.face_offset_indices,
+                                          first_mesh.runtime->face_offsets_sharing_info,
+                                          &dst_mesh->face_offset_indices,
+                                          &dst_mesh->runtime->face_offsets_sharing_info);
+  }
+  else if (tot_faces > 0) {
+    dst_face_offsets = dst_mesh->face_offsets_for_write();
+    dst_face_offsets.last() = tot_loops;
+  }
+
   /* Add materials. */
   for (const int i : IndexRange(ordered_materials.size())) {
     Material *material = ordered_materials[i];
@@ -1532,8 +1638,18 @@ static void execute_realize_mesh_tasks(const RealizeInstancesOptions &options,
   /* Prepare material indices. */
   SpanAttributeWriter<int> material_indices;
   if (all_meshes_info.create_material_index_attribute) {
-    material_indices = dst_attributes.lookup_or_add_for_write_only_span<int>(
-        "material_index", bke::AttrDomain::Face);
+    const Span<int> material_index_map = first_task.mesh_info->material_index_map;
+    const bool material_indices_unchanged =
+        share_unchanged_arrays && first_mesh.totcol > 0 &&
+        array_utils::indices_are_range(material_index_map, material_index_map.index_range()) &&
+        material_indices_in_range(first_task.mesh_info->material_indices, first_mesh.totcol);
+    if (!(material_indices_unchanged &&
+          try_share_mesh_attribute(
+              first_mesh, "material_index", bke::AttrDomain::Face, CD_PROP_INT32, dst_attributes)))
+    {
+      material_indices = dst_attributes.lookup_or_add_for_write_only_span<int>(
+          "material_index", bke::AttrDomain::Face);
+    }
   }
 
   /* Prepare generic output attributes. */
@@ -1542,6 +1658,12 @@ static void execute_realize_mesh_tasks(const RealizeInstancesOptions &options,
     const AttributeIDRef &attribute_id = ordered_attributes.ids[attribute_index];
     const bke::AttrDomain domain = ordered_attributes.kinds[attribute_index].domain;
     const eCustomDataType data_type = ordered_attributes.kinds[attribute_index].data_type;
+    if (share_unchanged_arrays &&
+        try_share_mesh_attribute(first_mesh, attribute_id, domain, data_type, dst_attributes))
+    {
+      dst_attribute_writers.append({});
+      continue;
+    }
     dst_attribute_writers.append(
         dst_attributes.lookup_or_add_for_write_only_span(attribute_id, domain, data_type));
   }
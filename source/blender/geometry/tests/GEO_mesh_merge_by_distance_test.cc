@@ -0,0 +1,236 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include <algorithm>
+#include <cmath>
+
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_mesh.hh"
+
+#include "BLI_array.hh"
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.hh"
+#include "BLI_rand.hh"
+#include "BLI_vector.hh"
+
+#include "DNA_mesh_types.h"
+
+#include "GEO_mesh_merge_by_distance.hh"
+
+#include "testing/testing.h"
+
+namespace blender::geometry::tests {
+
+class MeshMergeByDistanceTest : public ::testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+};
+
+static Mesh *create_points_mesh(const Span<float3> positions)
+{
+  Mesh *mesh = BKE_mesh_new_nomain(positions.size(), 0, 0, 0);
+  mesh->vert_positions_for_write().copy_from(positions);
+  return mesh;
+}
+
+/** The result of #mesh_merge_by_distance_all when the vertices are found with a KD-tree. */
+static std::optional<Mesh *> merge_by_distance_kdtree(const Mesh &mesh,
+                                                      const IndexMask &selection,
+                                                      const float merge_distance)
+{
+  const Span<float3> positions = mesh.vert_positions();
+  Array<int> vert_dest_map(mesh.verts_num, -1);
+  KDTree_3d *tree = BLI_kdtree_3d_new(selection.size());
+  selection.foreach_index([&](const int i) { BLI_kdtree_3d_insert(tree, i, positions[i]); });
+  BLI_kdtree_3d_balance(tree);
+  const int vert_kill_len = BLI_kdtree_3d_calc_duplicates_fast(
+      tree, merge_distance, true, vert_dest_map.data());
+  BLI_kdtree_3d_free(tree);
+  if (vert_kill_len == 0) {
+    return std::nullopt;
+  }
+  return mesh_merge_verts(mesh, vert_dest_map, vert_kill_len, true);
+}
+
+/**
+ * Merged vertices get the average position of their group, so the positions only match when
+ * the same vertices are merged into the same targets.
+ */
+static void expect_same_as_kdtree(const Span<float3> positions,
+                                  const IndexMask &selection,
+                                  const float merge_distance)
+{
+  Mesh *mesh = create_points_mesh(positions);
+  const std::optional<Mesh *> result = mesh_merge_by_distance_all(
+      *mesh, selection, merge_distance);
+  const std::optional<Mesh *> expected = merge_by_distance_kdtree(
+      *mesh, selection, merge_distance);
+  BKE_id_free(nullptr, mesh);
+
+  ASSERT_EQ(result.has_value(), expected.has_value());
+  if (!result) {
+    return;
+  }
+  const Span<float3> result_positions = (*result)->vert_positions();
+  const Span<float3> expected_positions = (*expected)->vert_positions();
+  EXPECT_EQ(result_positions.size(), expected_positions.size());
+  for (const int i : result_positions.index_range().take_front(expected_positions.size())) {
+    EXPECT_EQ(result_positions[i], expected_positions[i]) << "Vertex " << i;
+  }
+  BKE_id_free(nullptr, *result);
+  BKE_id_free(nullptr, *expected);
+}
+
+static void expect_same_as_kdtree(const Span<float3> positions, const float merge_distance)
+{
+  expect_same_as_kdtree(positions, IndexMask(positions.size()), merge_distance);
+}
+
+static Vector<float3> random_positions(const int num, const float size, const uint32_t seed)
+{
+  RandomNumberGenerator rng(seed);
+  Vector<float3> positions;
+  for ([[maybe_unused]] const int i : IndexRange(num)) {
+    positions.append(float3(rng.get_float(), rng.get_float(), rng.get_float()) * size);
+  }
+  return positions;
+}
+
+TEST_F(MeshMergeByDistanceTest, RandomPoints)
+{
+  expect_same_as_kdtree(random_positions(3000, 10.0f, 0), 0.3f);
+  expect_same_as_kdtree(random_positions(3000, 10.0f, 1), 1.0f);
+  expect_same_as_kdtree(random_positions(100, 1.0f, 2), 10.0f);
+}
+
+TEST_F(MeshMergeByDistanceTest, DuplicatePoints)
+{
+  /* Many vertices at the same positions, in random order. */
+  Vector<float3> positions = random_positions(2000, 100.0f, 3);
+  for (float3 &position : positions) {
+    position = math::floor(position / 10.0f) * 10.0f;
+  }
+  expect_same_as_kdtree(positions, 0.001f);
+}
+
+TEST_F(MeshMergeByDistanceTest, Chains)
+{
+  /* Every vertex is within the merge distance of the next one, so only a few vertices can be
+   * decided at once. */
+  Vector<float3> positions;
+  for (const int i : IndexRange(5000)) {
+    positions.append(float3(float(i) * 0.09f, std::sin(float(i)) * 0.01f, 0.0f));
+  }
+  expect_same_as_kdtree(positions, 0.1f);
+
+  /* The same vertices in reverse index order. */
+  std::reverse(positions.begin(), positions.end());
+  expect_same_as_kdtree(positions, 0.1f);
+}
+
+TEST_F(MeshMergeByDistanceTest, CellBorders)
+{
+  /* The grid starts at the minimum of the positions, with cells slightly larger than the merge
+   * distance. Place vertices on and next to the cell borders. */
+  const float merge_distance = 0.25f;
+  const float cell_size = merge_distance * 1.001f;
+  Vector<float3> positions = {float3(0.0f)};
+  for (const int i : IndexRange(1, 4)) {
+    const float border = float(i) * cell_size;
+    for (const float x : {border,
+                          std::nextafter(border, 0.0f),
+                          std::nextafter(border, 2.0f),
+                          border - merge_distance * 0.5f,
+                          border + merge_distance * 0.5f})
+    {
+      positions.append(float3(x, 0.0f, 0.0f));
+      positions.append(float3(x, border, 0.0f));
+      positions.append(float3(border, x, border));
+    }
+  }
+  expect_same_as_kdtree(positions, merge_distance);
+}
+
+TEST_F(MeshMergeByDistanceTest, ExactMergeDistance)
+{
+  /* A lattice of vertices exactly at the merge distance of their neighbors. All the distances
+   * are exact in floating point, vertices at the merge distance are merged. */
+  Vector<float3> positions;
+  for (const int z : IndexRange(6)) {
+    for (const int y : IndexRange(6)) {
+      for (const int x : IndexRange(6)) {
+        positions.append(float3(float(x), float(y), float(z)) * 0.5f);
+      }
+    }
+  }
+  expect_same_as_kdtree(positions, 0.5f);
+
+  Mesh *mesh = create_points_mesh({float3(0.0f), float3(0.5f, 0.0f, 0.0f)});
+  const std::optional<Mesh *> result = mesh_merge_by_distance_all(
+      *mesh, IndexMask(mesh->verts_num), 0.5f);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ((*result)->verts_num, 1);
+  BKE_id_free(nullptr, *result);
+  BKE_id_free(nullptr, mesh);
+}
+
+TEST_F(MeshMergeByDistanceTest, LargeCoordinates)
+{
+  /* Pairs of vertices just within the merge distance, far away from the origin and with many
+   * cells along the X axis, where the rounding of the cell computation matters. */
+  const float merge_distance = 1e-4f;
+  RandomNumberGenerator rng(6);
+  Vector<float3> positions;
+  for (const int i : IndexRange(20000)) {
+    const float3 position(100.0f + float(i) * 0.005f, rng.get_float(), rng.get_float());
+    const float3 offset = rng.get_unit_float3() * merge_distance * 0.999f;
+    if (math::distance(position, position + offset) <= merge_distance) {
+      positions.append(position);
+      positions.append(position + offset);
+    }
+  }
+  expect_same_as_kdtree(positions, merge_distance);
+
+  Mesh *mesh = create_points_mesh(positions);
+  const std::optional<Mesh *> result = mesh_merge_by_distance_all(
+      *mesh, IndexMask(mesh->verts_num), merge_distance);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_EQ((*result)->verts_num, positions.size() / 2);
+  BKE_id_free(nullptr, *result);
+  BKE_id_free(nullptr, mesh);
+
+  /* The same with negative coordinates. */
+  for (float3 &position : positions) {
+    position = -position;
+  }
+  expect_same_as_kdtree(positions, merge_distance);
+}
+
+TEST_F(MeshMergeByDistanceTest, Selection)
+{
+  const Vector<float3> positions = random_positions(3000, 10.0f, 4);
+  IndexMaskMemory memory;
+  const IndexMask every_third = IndexMask::from_predicate(
+      positions.index_range(), GrainSize(1024), memory, [&](const int i) { return i % 3 == 0; });
+  expect_same_as_kdtree(positions, every_third, 0.5f);
+
+  /* The bounds of the grid only contain the selected vertices. */
+  const IndexMask first_half = IndexMask(positions.size() / 2);
+  expect_same_as_kdtree(positions, first_half, 0.5f);
+
+  RandomNumberGenerator rng(5);
+  Array<bool> selection(positions.size());
+  for (bool &selected : selection) {
+    selected = rng.get_float() < 0.5f;
+  }
+  expect_same_as_kdtree(positions, IndexMask::from_bools(selection, memory), 0.5f);
+
+  expect_same_as_kdtree(positions, IndexMask(), 0.5f);
+}
+
+}  // namespace blender::geometry::tests
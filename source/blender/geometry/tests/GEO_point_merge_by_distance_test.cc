@@ -0,0 +1,47 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "BKE_anonymous_attribute_id.hh"
+#include "BKE_idtype.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_pointcloud.hh"
+
+#include "DNA_pointcloud_types.h"
+
+#include "GEO_point_merge_by_distance.hh"
+
+#include "testing/testing.h"
+
+namespace blender::geometry::tests {
+
+class PointMergeByDistanceTest : public ::testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+};
+
+TEST_F(PointMergeByDistanceTest, PairsAtMergeDistance)
+{
+  /* Pairs of points exactly the merge distance apart along one of the axes, which are merged
+   * regardless of the layout of the KD-tree used to find them. */
+  const float merge_distance = 0.5f;
+  for (const int pairs_num : IndexRange(1, 40)) {
+    PointCloud *points = BKE_pointcloud_new_nomain(pairs_num * 2);
+    MutableSpan<float3> positions = points->positions_for_write();
+    for (const int i : IndexRange(pairs_num)) {
+      positions[i * 2] = float3(float(i % 4), float(i % 3), float(i / 12)) * 10.0f;
+      positions[i * 2 + 1] = positions[i * 2];
+      positions[i * 2 + 1][i % 3] += merge_distance;
+    }
+    PointCloud *result = point_merge_by_distance(
+        *points, merge_distance, IndexMask(points->totpoint), {});
+    EXPECT_EQ(result->totpoint, pairs_num);
+    BKE_id_free(nullptr, result);
+    BKE_id_free(nullptr, points);
+  }
+}
+
+}  // namespace blender::geometry::tests
@@ -0,0 +1,199 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: Apache-2.0 */
+
+#include "BKE_attribute.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_idtype.hh"
+#include "BKE_instances.hh"
+#include "BKE_lib_id.hh"
+#include "BKE_mesh.hh"
+
+#include "BLI_math_matrix.hh"
+
+#include "DNA_material_types.h"
+#include "DNA_mesh_types.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "GEO_mesh_primitive_cuboid.hh"
+#include "GEO_realize_instances.hh"
+
+#include "testing/testing.h"
+
+using namespace blender::bke;
+
+namespace blender::geometry::tests {
+
+class RealizeInstancesTest : public ::testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+};
+
+/** A cube with a point attribute storing the original point indices. */
+static GeometrySet create_test_mesh()
+{
+  Mesh *mesh = create_cuboid_mesh(float3(1.0f), 2, 2, 2, "uv_map");
+  SpanAttributeWriter<float> weights =
+      mesh->attributes_for_write().lookup_or_add_for_write_only_span<float>("weight",
+                                                                           AttrDomain::Point);
+  for (const int i : weights.span.index_range()) {
+    weights.span[i] = float(i);
+  }
+  weights.finish();
+  return GeometrySet::from_mesh(mesh);
+}
+
+static GeometrySet create_test_instances(const GeometrySet &geometry,
+                                         const Span<float4x4> transforms)
+{
+  Instances *instances = new Instances();
+  const int handle = instances->add_reference(InstanceReference{geometry});
+  for (const float4x4 &transform : transforms) {
+    instances->add_instance(handle, transform);
+  }
+  return GeometrySet::from_instances(instances);
+}
+
+static const void *attribute_data(const Mesh &mesh, const StringRef name)
+{
+  const GAttributeReader attribute = mesh.attributes().lookup(name);
+  BLI_assert(attribute && attribute.varray.is_span());
+  return attribute.varray.get_internal_span().data();
+}
+
+TEST_F(RealizeInstancesTest, SingleInstanceSharesArrays)
+{
+  const GeometrySet geometry = create_test_mesh();
+  const Mesh &src_mesh = *geometry.get_mesh();
+  const GeometrySet result = realize_instances(
+      create_test_instances(geometry, {float4x4::identity()}), {});
+  const Mesh &dst_mesh = *result.get_mesh();
+  EXPECT_EQ(result.get_instances(), nullptr);
+
+  EXPECT_EQ(dst_mesh.vert_positions().data(), src_mesh.vert_positions().data());
+  EXPECT_EQ(dst_mesh.edges().data(), src_mesh.edges().data());
+  EXPECT_EQ(dst_mesh.face_offsets().data(), src_mesh.face_offsets().data());
+  EXPECT_EQ(dst_mesh.corner_verts().data(), src_mesh.corner_verts().data());
+  EXPECT_EQ(dst_mesh.corner_edges().data(), src_mesh.corner_edges().data());
+  EXPECT_EQ(attribute_data(dst_mesh, "weight"), attribute_data(src_mesh, "weight"));
+  EXPECT_EQ(attribute_data(dst_mesh, "uv_map"), attribute_data(src_mesh, "uv_map"));
+}
+
+TEST_F(RealizeInstancesTest, SingleTransformedInstance)
+{
+  const GeometrySet geometry = create_test_mesh();
+  const Mesh &src_mesh = *geometry.get_mesh();
+  const float3 offset(1.0f, 2.0f, 3.0f);
+  GeometrySet result = realize_instances(
+      create_test_instances(geometry, {math::from_location<float4x4>(offset)}), {});
+  const Mesh &dst_mesh = *result.get_mesh();
+
+  /* The positions are transformed, everything else is still shared. */
+  const Span<float3> src_positions = src_mesh.vert_positions();
+  const Span<float3> dst_positions = dst_mesh.vert_positions();
+  EXPECT_NE(dst_positions.data(), src_positions.data());
+  ASSERT_EQ(dst_positions.size(), src_positions.size());
+  for (const int i : src_positions.index_range()) {
+    EXPECT_EQ(dst_positions[i], src_positions[i] + offset);
+  }
+  EXPECT_EQ(dst_mesh.edges().data(), src_mesh.edges().data());
+  EXPECT_EQ(dst_mesh.corner_verts().data(), src_mesh.corner_verts().data());
+  EXPECT_EQ(attribute_data(dst_mesh, "weight"), attribute_data(src_mesh, "weight"));
+
+  /* Writing to the result copies the shared array, the source mesh is unchanged. */
+  SpanAttributeWriter<float> weights =
+      result.get_mesh_for_write()->attributes_for_write().lookup_for_write_span<float>("weight");
+  weights.span.fill(-1.0f);
+  weights.finish();
+  const VArraySpan<float> src_weights = *src_mesh.attributes().lookup<float>("weight");
+  for (const int i : src_weights.index_range()) {
+    EXPECT_EQ(src_weights[i], float(i));
+  }
+}
+
+TEST_F(RealizeInstancesTest, MultipleInstancesAreCopied)
+{
+  const GeometrySet geometry = create_test_mesh();
+  const Mesh &src_mesh = *geometry.get_mesh();
+  const float3 offset(5.0f, 0.0f, 0.0f);
+  const GeometrySet result = realize_instances(
+      create_test_instances(geometry,
+                            {float4x4::identity(), math::from_location<float4x4>(offset)}),
+      {});
+  const Mesh &dst_mesh = *result.get_mesh();
+
+  const int verts_num = src_mesh.verts_num;
+  const int corners_num = src_mesh.corners_num;
+  ASSERT_EQ(dst_mesh.verts_num, verts_num * 2);
+  ASSERT_EQ(dst_mesh.faces_num, src_mesh.faces_num * 2);
+  EXPECT_NE(dst_mesh.vert_positions().data(), src_mesh.vert_positions().data());
+  EXPECT_NE(dst_mesh.corner_verts().data(), src_mesh.corner_verts().data());
+  EXPECT_NE(attribute_data(dst_mesh, "weight"), attribute_data(src_mesh, "weight"));
+
+  const Span<float3> src_positions = src_mesh.vert_positions();
+  const Span<float3> dst_positions = dst_mesh.vert_positions();
+  const VArraySpan<float> dst_weights = *dst_mesh.attributes().lookup<float>("weight");
+  for (const int i : IndexRange(verts_num)) {
+    EXPECT_EQ(dst_positions[i], src_positions[i]);
+    EXPECT_EQ(dst_positions[verts_num + i], src_positions[i] + offset);
+    EXPECT_EQ(dst_weights[i], float(i));
+    EXPECT_EQ(dst_weights[verts_num + i], float(i));
+  }
+  const Span<int> src_corner_verts = src_mesh.corner_verts();
+  const Span<int> dst_corner_verts = dst_mesh.corner_verts();
+  for (const int i : IndexRange(corners_num)) {
+    EXPECT_EQ(dst_corner_verts[i], src_corner_verts[i]);
+    EXPECT_EQ(dst_corner_verts[corners_num + i], src_corner_verts[i] + verts_num);
+  }
+  EXPECT_EQ(dst_mesh.face_offsets().last(), corners_num * 2);
+}
+
+/** Realize a single instance of a mesh with two materials and the given material indices. */
+static Vector<int> realize_material_indices(const Span<int> src_indices, bool &r_shared)
+{
+  Material *material_a = static_cast<Material *>(BKE_id_new_nomain(ID_MA, "A"));
+  Material *material_b = static_cast<Material *>(BKE_id_new_nomain(ID_MA, "B"));
+  Vector<int> result;
+  {
+    GeometrySet geometry = create_test_mesh();
+    Mesh &src_mesh = *geometry.get_mesh_for_write();
+    src_mesh.mat = MEM_cnew_array<Material *>(2, __func__);
+    src_mesh.mat[0] = material_a;
+    src_mesh.mat[1] = material_b;
+    src_mesh.totcol = 2;
+    SpanAttributeWriter<int> material_indices =
+        src_mesh.attributes_for_write().lookup_or_add_for_write_only_span<int>("material_index",
+                                                                               AttrDomain::Face);
+    material_indices.span.copy_from(src_indices);
+    material_indices.finish();
+
+    const GeometrySet realized = realize_instances(
+        create_test_instances(geometry, {float4x4::identity()}), {});
+    const Mesh &dst_mesh = *realized.get_mesh();
+    r_shared = attribute_data(dst_mesh, "material_index") ==
+               attribute_data(src_mesh, "material_index");
+    result.extend(VArraySpan<int>(*dst_mesh.attributes().lookup<int>("material_index")));
+  }
+  BKE_id_free(nullptr, material_a);
+  BKE_id_free(nullptr, material_b);
+  return result;
+}
+
+TEST_F(RealizeInstancesTest, SingleInstanceMaterialIndices)
+{
+  bool shared = false;
+  const Vector<int> valid_indices = {0, 1, 1, 0, 1, 0};
+  EXPECT_EQ(realize_material_indices(valid_indices, shared), valid_indices);
+  EXPECT_TRUE(shared);
+
+  /* Indices without a material slot are set to zero, like when the indices are copied. */
+  const Vector<int> invalid_indices = {0, 1, 5, -1, 1, 0};
+  EXPECT_EQ(realize_material_indices(invalid_indices, shared), Vector<int>({0, 1, 0, 0, 1, 0}));
+  EXPECT_FALSE(shared);
+}
+
+}  // namespace blender::geometry::tests
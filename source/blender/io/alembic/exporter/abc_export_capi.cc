@@ -15,6 +15,7 @@
 
 #include "DNA_scene_types.h"
 
+#include "BKE_callbacks.hh"
 #include "BKE_context.hh"
 #include "BKE_global.hh"
 #include "BKE_lib_id.hh"
@@ -24,7 +25,9 @@
 #include "BLI_fileops.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_threads.h"
 #include "BLI_timeit.hh"
+#include "BLI_vector.hh"
 
 #include "WM_api.hh"
 #include "WM_types.hh"
@@ -32,11 +35,16 @@
 #include "CLG_log.h"
 static CLG_LogRef LOG = {"io.alembic"};
 
+#include <algorithm>
 #include <memory>
 
 struct ExportJobData {
   Main *bmain;
   Depsgraph *depsgraph;
+  /* Additional depsgraphs built for the same data as `depsgraph`, used to evaluate animation
+   * frames in parallel when the scene is frame independent. */
+  Depsgraph **frame_depsgraphs;
+  int frame_depsgraphs_num;
   wmWindowManager *wm;
 
   char filepath[FILE_MAX];
@@ -49,8 +57,12 @@ struct ExportJobData {
 
 namespace blender::io::alembic {
 
+/* Maximum number of depsgraphs evaluating animation frames in parallel. Each of them holds its own
+ * evaluated copy of the exported data, so this is limited to keep memory usage reasonable. */
+static constexpr int MAX_FRAME_DEPSGRAPHS = 4;
+
 /* Construct the depsgraph for exporting. */
-static bool build_depsgraph(ExportJobData *job)
+static bool build_depsgraph(ExportJobData *job, Depsgraph *depsgraph)
 {
   if (job->params.collection[0]) {
     Collection *collection = reinterpret_cast<Collection *>(
@@ -61,18 +73,53 @@ static bool build_depsgraph(ExportJobData *job)
       return false;
     }
 
-    DEG_graph_build_from_collection(job->depsgraph, collection);
+    DEG_graph_build_from_collection(depsgraph, collection);
   }
   else if (job->params.visible_objects_only) {
-    DEG_graph_build_from_view_layer(job->depsgraph);
+    DEG_graph_build_from_view_layer(depsgraph);
   }
   else {
-    DEG_graph_build_for_all_objects(job->depsgraph);
+    DEG_graph_build_for_all_objects(depsgraph);
   }
 
   return true;
 }
 
+/* Construct additional depsgraphs to evaluate animation frames on in parallel, when the exported
+ * data does not depend on the evaluation of previous frames. */
+static void build_frame_depsgraphs(ExportJobData *job, Scene *scene, ViewLayer *view_layer)
+{
+  job->frame_depsgraphs = nullptr;
+  job->frame_depsgraphs_num = 0;
+
+  const AlembicExportParams &params = job->params;
+  if (params.frame_start == params.frame_end || !DEG_graph_is_frame_independent(job->depsgraph)) {
+    return;
+  }
+  if (BKE_callback_is_used(BKE_CB_EVT_FRAME_CHANGE_PRE) ||
+      BKE_callback_is_used(BKE_CB_EVT_FRAME_CHANGE_POST))
+  {
+    /* Handlers run for every frame when frames are evaluated one after another, they may change
+     * the exported data. */
+    return;
+  }
+  const int frames_num = int(params.frame_end - params.frame_start) + 1;
+  const int depsgraphs_num = std::min(
+      {BLI_system_thread_count(), MAX_FRAME_DEPSGRAPHS, frames_num});
+  if (depsgraphs_num < 2) {
+    return;
+  }
+
+  job->frame_depsgraphs_num = depsgraphs_num - 1;
+  job->frame_depsgraphs = static_cast<Depsgraph **>(
+      MEM_calloc_arrayN(job->frame_depsgraphs_num, sizeof(Depsgraph *), __func__));
+  for (int i = 0; i < job->frame_depsgraphs_num; i++) {
+    job->frame_depsgraphs[i] = DEG_graph_new(
+        job->bmain, scene, view_layer, params.evaluation_mode);
+    build_depsgraph(job, job->frame_depsgraphs[i]);
+  }
+}
+
 static void report_job_duration(const ExportJobData *data)
 {
   blender::timeit::Nanoseconds duration = blender::timeit::Clock::now() - data->start_time;
@@ -144,6 +191,31 @@ static void export_startjob(void *customdata, wmJobWorkerStatus *worker_status)
     ABCArchive::Frames::const_iterator frame_it = abc_archive->frames_begin();
     const ABCArchive::Frames::const_iterator frames_end = abc_archive->frames_end();
 
+    if (data->frame_depsgraphs_num > 0) {
+      /* Evaluate frames on multiple depsgraphs in parallel, writing them in order. */
+      Vector<Depsgraph *> depsgraphs = {data->depsgraph};
+      depsgraphs.extend(Span<Depsgraph *>(data->frame_depsgraphs, data->frame_depsgraphs_num));
+      Vector<float> frames;
+      for (; frame_it != frames_end; frame_it++) {
+        frames.append(float(*frame_it));
+      }
+
+      DEG_evaluate_frames_parallel(depsgraphs, frames, [&](Depsgraph *depsgraph, float frame) {
+        if (G.is_break || worker_status->stop) {
+          return false;
+        }
+        CLOG_INFO(&LOG, 2, "Exporting frame %.2f", frame);
+        iter.set_depsgraph(depsgraph);
+        iter.set_export_subset(abc_archive->export_subset_for_frame(frame));
+        iter.iterate_and_write();
+
+        worker_status->progress += progress_per_frame;
+        worker_status->do_update = true;
+        return true;
+      });
+      iter.set_depsgraph(data->depsgraph);
+    }
+
     for (; frame_it != frames_end; frame_it++) {
       double frame = *frame_it;
 
@@ -189,6 +261,10 @@ static void export_endjob(void *customdata)
   ExportJobData *data = static_cast<ExportJobData *>(customdata);
 
   DEG_graph_free(data->depsgraph);
+  for (int i = 0; i < data->frame_depsgraphs_num; i++) {
+    DEG_graph_free(data->frame_depsgraphs[i]);
+  }
+  MEM_SAFE_FREE(data->frame_depsgraphs);
 
   if (data->was_canceled && BLI_exists(data->filepath)) {
     BLI_delete(data->filepath, false, false);
@@ -224,9 +300,10 @@ bool ABC_export(Scene *scene,
    *
    * Has to be done from main thread currently, as it may affect Main original data (e.g. when
    * doing deferred update of the view-layers, see #112534 for details). */
-  if (!blender::io::alembic::build_depsgraph(job)) {
+  if (!blender::io::alembic::build_depsgraph(job, job->depsgraph)) {
     return false;
   }
+  blender::io::alembic::build_frame_depsgraphs(job, scene, view_layer);
 
   bool export_ok = false;
   if (as_background_job) {
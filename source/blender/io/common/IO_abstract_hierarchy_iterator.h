@@ -231,6 +231,12 @@ class AbstractHierarchyIterator {
    * previous iteration. */
   void set_export_subset(ExportSubset export_subset);
 
+  /* Set the depsgraph to iterate over, which must be built for the same data as the depsgraph the
+   * iterator was created with. This allows evaluating frames on separate depsgraphs, so writers
+   * should get the depsgraph from the iterator instead of storing it. */
+  void set_depsgraph(Depsgraph *depsgraph);
+  Depsgraph *get_depsgraph() const;
+
   /* Convert the given name to something that is valid for the exported file format.
    * This base implementation is a no-op; override in a concrete subclass. */
   virtual std::string make_valid_name(const std::string &name) const;
@@ -5,7 +5,9 @@
 #include "ply_import_buffer.hh"
 
 #include "BLI_fileops.h"
+#include "BLI_mmap.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <stdexcept>
@@ -17,14 +19,21 @@ static inline bool is_newline(char ch)
 
 namespace blender::io::ply {
 
-PlyReadBuffer::PlyReadBuffer(const char *file_path, size_t read_buffer_size)
-    : buffer_(read_buffer_size), read_buffer_size_(read_buffer_size)
+PlyReadBuffer::PlyReadBuffer(const char *file_path,
+                             size_t read_buffer_size,
+                             bool use_memory_map)
+    : buffer_(read_buffer_size),
+      read_buffer_size_(read_buffer_size),
+      use_memory_map_(use_memory_map)
 {
   file_ = BLI_fopen(file_path, "rb");
 }
 
 PlyReadBuffer::~PlyReadBuffer()
 {
+  if (mmap_file_ != nullptr) {
+    BLI_mmap_free(mmap_file_);
+  }
   if (file_ != nullptr) {
     fclose(file_);
   }
@@ -33,6 +42,40 @@ PlyReadBuffer::~PlyReadBuffer()
 void PlyReadBuffer::after_header(bool is_binary)
 {
   is_binary_ = is_binary;
+  if (!is_binary || !use_memory_map_ || file_ == nullptr) {
+    return;
+  }
+  /* The binary data starts at the first byte in the buffer that was not consumed yet. */
+  const long file_pos = ftell(file_);
+  if (file_pos < 0) {
+    return;
+  }
+  const size_t data_start = size_t(file_pos) - size_t(buf_used_ - pos_);
+  mmap_file_ = BLI_mmap_open(fileno(file_));
+  if (mmap_file_ == nullptr) {
+    /* Opening the memory map seeks to the end, restore the position for buffered reading. */
+    fseek(file_, file_pos, SEEK_SET);
+    return;
+  }
+  const size_t length = BLI_mmap_get_length(mmap_file_);
+  mapped_data_ = Span(static_cast<const uint8_t *>(BLI_mmap_get_pointer(mmap_file_)),
+                      int64_t(length));
+  mapped_pos_ = std::min(data_start, length);
+}
+
+const uint8_t *PlyReadBuffer::read_mapped_bytes(size_t size)
+{
+  if (mmap_file_ == nullptr || mapped_pos_ + size > size_t(mapped_data_.size())) {
+    return nullptr;
+  }
+  const uint8_t *data = mapped_data_.data() + mapped_pos_;
+  mapped_pos_ += size;
+  return data;
+}
+
+Span<uint8_t> PlyReadBuffer::mapped_bytes_remaining() const
+{
+  return mapped_data_.drop_front(int64_t(mapped_pos_));
 }
 
 Span<char> PlyReadBuffer::read_line()
@@ -62,6 +105,14 @@ Span<char> PlyReadBuffer::read_line()
 
 bool PlyReadBuffer::read_bytes(void *dst, size_t size)
 {
+  if (mmap_file_ != nullptr) {
+    const uint8_t *data = this->read_mapped_bytes(size);
+    if (data == nullptr) {
+      return false;
+    }
+    memcpy(dst, data, size);
+    return true;
+  }
   while (size > 0) {
     if (pos_ + size > buf_used_) {
       if (!refill_buffer()) {
@@ -13,20 +13,45 @@
 #include "BLI_array.hh"
 #include "BLI_span.hh"
 
+struct BLI_mmap_file;
+
 namespace blender::io::ply {
 
 /**
  * Reads underlying PLY file in large chunks, and provides interface for ascii/header
  * parsing to read individual lines, and for binary parsing to read chunks of bytes.
+ *
+ * Binary data can optionally be read from a memory mapped file instead, which allows
+ * element rows to be accessed directly (and in parallel) without copying them first.
  */
 class PlyReadBuffer {
  public:
-  PlyReadBuffer(const char *file_path, size_t read_buffer_size = 64 * 1024);
+  PlyReadBuffer(const char *file_path,
+                size_t read_buffer_size = 64 * 1024,
+                bool use_memory_map = true);
   ~PlyReadBuffer();
 
-  /** After header is parsed, indicate whether the rest of reading will be ascii or binary. */
+  /**
+   * After header is parsed, indicate whether the rest of reading will be ascii or binary.
+   * Binary data is memory mapped from here on, if possible and enabled.
+   */
   void after_header(bool is_binary);
 
+  /** Whether the binary data after the header is read from a memory mapped file. */
+  bool is_memory_mapped() const
+  {
+    return mmap_file_ != nullptr;
+  }
+
+  /**
+   * Returns a pointer to the next `size` bytes of a memory mapped file and moves past them.
+   * Returns null if the file is not memory mapped or if there are not enough bytes left.
+   */
+  const uint8_t *read_mapped_bytes(size_t size);
+
+  /** The remaining bytes of a memory mapped file, without moving past them. */
+  Span<uint8_t> mapped_bytes_remaining() const;
+
   /**
    * Gets the next line from the file as a Span. The line does not include any newline characters.
    */
@@ -50,6 +75,11 @@ class PlyReadBuffer {
   size_t read_buffer_size_ = 0;
   bool at_eof_ = false;
   bool is_binary_ = false;
+
+  bool use_memory_map_ = false;
+  BLI_mmap_file *mmap_file_ = nullptr;
+  Span<uint8_t> mapped_data_;
+  size_t mapped_pos_ = 0;
 };
 
 }  // namespace blender::io::ply
@@ -10,8 +10,11 @@
 #include "ply_data.hh"
 #include "ply_import_buffer.hh"
 
+#include "BLI_array.hh"
 #include "BLI_endian_switch.h"
+#include "BLI_offset_indices.hh"
 #include "BLI_string_ref.hh"
+#include "BLI_task.hh"
 
 #include "fast_float.h"
 
@@ -190,22 +193,17 @@ template<typename T> static T get_binary_value(PlyDataTypes type, const uint8_t
   return val;
 }
 
-static const char *parse_row_binary(PlyReadBuffer &file,
-                                    const PlyHeader &header,
-                                    const PlyElement &element,
-                                    Vector<uint8_t> &r_scratch,
-                                    Vector<float> &r_values)
+/**
+ * Convert one row of binary element data to floats. The row data is modified in place when the
+ * endianness has to be switched.
+ */
+static const char *decode_row_binary(const PlyHeader &header,
+                                     const PlyElement &element,
+                                     uint8_t *row_data,
+                                     MutableSpan<float> r_values)
 {
-  if (element.stride == 0) {
-    return "Vertex/Edge element contains list properties, this is not supported";
-  }
-  BLI_assert(r_scratch.size() == element.stride);
   BLI_assert(r_values.size() == element.properties.size());
-  if (!file.read_bytes(r_scratch.data(), r_scratch.size())) {
-    return "Could not read row of binary property";
-  }
-
-  const uint8_t *ptr = r_scratch.data();
+  const uint8_t *ptr = row_data;
   if (header.type == PlyFormatType::BINARY_LE) {
     /* Little endian: just read/convert the values. */
     for (int i = 0, n = int(element.properties.size()); i != n; i++) {
@@ -229,6 +227,51 @@ static const char *parse_row_binary(PlyReadBuffer &file,
   return nullptr;
 }
 
+static const char *parse_row_binary(PlyReadBuffer &file,
+                                    const PlyHeader &header,
+                                    const PlyElement &element,
+                                    Vector<uint8_t> &r_scratch,
+                                    Vector<float> &r_values)
+{
+  if (element.stride == 0) {
+    return "Vertex/Edge element contains list properties, this is not supported";
+  }
+  BLI_assert(r_scratch.size() == element.stride);
+  if (!file.read_bytes(r_scratch.data(), r_scratch.size())) {
+    return "Could not read row of binary property";
+  }
+  return decode_row_binary(header, element, r_scratch.data(), r_values);
+}
+
+/**
+ * Convert all rows of a binary element with a fixed row size from the memory mapped file, in
+ * parallel. Returns false if the element can't be read this way.
+ */
+template<typename Fn>
+static bool parse_rows_mapped(PlyReadBuffer &file,
+                              const PlyHeader &header,
+                              const PlyElement &element,
+                              const Fn &store_row)
+{
+  if (!file.is_memory_mapped() || header.type == PlyFormatType::ASCII || element.stride == 0) {
+    return false;
+  }
+  const uint8_t *rows = file.read_mapped_bytes(size_t(element.count) * element.stride);
+  if (rows == nullptr) {
+    return false;
+  }
+  threading::parallel_for(IndexRange(element.count), 4096, [&](const IndexRange range) {
+    Array<uint8_t, 64> row(element.stride);
+    Array<float, 16> values(element.properties.size());
+    for (const int i : range) {
+      memcpy(row.data(), rows + size_t(i) * element.stride, element.stride);
+      decode_row_binary(header, element, row.data(), values);
+      store_row(i, values.as_span());
+    }
+  });
+  return true;
+}
+
 static const char *load_vertex_element(PlyReadBuffer &file,
                                        const PlyHeader &header,
                                        const PlyElement &element,
@@ -266,15 +309,15 @@ static const char *load_vertex_element(PlyReadBuffer &file,
     data->vertex_custom_attr.append(attr);
   }
 
-  data->vertices.reserve(element.count);
+  data->vertices.resize(element.count);
   if (has_color) {
-    data->vertex_colors.reserve(element.count);
+    data->vertex_colors.resize(element.count);
   }
   if (has_normal) {
-    data->vertex_normals.reserve(element.count);
+    data->vertex_normals.resize(element.count);
   }
   if (has_uv) {
-    data->uv_coordinates.reserve(element.count);
+    data->uv_coordinates.resize(element.count);
   }
 
   float4 color_norm = {1, 1, 1, 1};
@@ -287,31 +330,13 @@ static const char *load_vertex_element(PlyReadBuffer &file,
     color_norm.w = data_type_normalizer[element.properties[alpha_index].type];
   }
 
-  Vector<float> value_vec(element.properties.size());
-  Vector<uint8_t> scratch;
-  if (header.type != PlyFormatType::ASCII) {
-    scratch.resize(element.stride);
-  }
-
-  for (int i = 0; i < element.count; i++) {
-
-    const char *error = nullptr;
-    if (header.type == PlyFormatType::ASCII) {
-      error = parse_row_ascii(file, value_vec);
-    }
-    else {
-      error = parse_row_binary(file, header, element, scratch, value_vec);
-    }
-    if (error != nullptr) {
-      return error;
-    }
-
+  const auto store_row = [&](const int i, const Span<float> value_vec) {
     /* Vertex coord */
     float3 vertex3;
     vertex3.x = value_vec[vertex_index.x];
     vertex3.y = value_vec[vertex_index.y];
     vertex3.z = value_vec[vertex_index.z];
-    data->vertices.append(vertex3);
+    data->vertices[i] = vertex3;
 
     /* Vertex color */
     if (has_color) {
@@ -325,7 +350,7 @@ static const char *load_vertex_element(PlyReadBuffer &file,
       else {
         colors4.w = 1.0f;
       }
-      data->vertex_colors.append(colors4);
+      data->vertex_colors[i] = colors4;
     }
 
     /* If normals */
@@ -334,7 +359,7 @@ static const char *load_vertex_element(PlyReadBuffer &file,
       normals3.x = value_vec[normal_index.x];
       normals3.y = value_vec[normal_index.y];
       normals3.z = value_vec[normal_index.z];
-      data->vertex_normals.append(normals3);
+      data->vertex_normals[i] = normals3;
     }
 
     /* If uv */
@@ -342,7 +367,7 @@ static const char *load_vertex_element(PlyReadBuffer &file,
       float2 uvmap;
       uvmap.x = value_vec[uv_index.x];
       uvmap.y = value_vec[uv_index.y];
-      data->uv_coordinates.append(uvmap);
+      data->uv_coordinates[i] = uvmap;
     }
 
     /* Custom attributes */
@@ -350,6 +375,31 @@ static const char *load_vertex_element(PlyReadBuffer &file,
       float value = value_vec[custom_attr_indices[ci]];
       data->vertex_custom_attr[ci].data[i] = value;
     }
+  };
+
+  if (parse_rows_mapped(file, header, element, store_row)) {
+    return nullptr;
+  }
+
+  Vector<float> value_vec(element.properties.size());
+  Vector<uint8_t> scratch;
+  if (header.type != PlyFormatType::ASCII) {
+    scratch.resize(element.stride);
+  }
+
+  for (int i = 0; i < element.count; i++) {
+
+    const char *error = nullptr;
+    if (header.type == PlyFormatType::ASCII) {
+      error = parse_row_ascii(file, value_vec);
+    }
+    else {
+      error = parse_row_binary(file, header, element, scratch, value_vec);
+    }
+    if (error != nullptr) {
+      return error;
+    }
+    store_row(i, value_vec);
   }
   return nullptr;
 }
@@ -385,6 +435,127 @@ static void skip_property(PlyReadBuffer &file,
   }
 }
 
+/**
+ * Read a single binary value (or list size) from memory mapped data and move past it.
+ * Returns false if there is not enough data left.
+ */
+static bool read_mapped_value(const Span<uint8_t> bytes,
+                              size_t &pos,
+                              const PlyDataTypes type,
+                              const bool big_endian,
+                              uint32_t &r_value)
+{
+  const int type_size = data_type_size[type];
+  if (pos + type_size > bytes.size()) {
+    return false;
+  }
+  uint8_t value[8];
+  memcpy(value, bytes.data() + pos, type_size);
+  if (big_endian) {
+    endian_switch(value, type_size);
+  }
+  const uint8_t *ptr = value;
+  r_value = get_binary_value<uint32_t>(type, ptr);
+  pos += type_size;
+  return true;
+}
+
+static bool skip_mapped_property(const Span<uint8_t> bytes,
+                                 size_t &pos,
+                                 const PlyProperty &prop,
+                                 const bool big_endian)
+{
+  uint32_t count = 1;
+  if (prop.count_type != PlyDataTypes::NONE) {
+    if (!read_mapped_value(bytes, pos, prop.count_type, big_endian, count)) {
+      return false;
+    }
+  }
+  pos += size_t(count) * data_type_size[prop.type];
+  return pos <= bytes.size();
+}
+
+/**
+ * Load binary faces from a memory mapped file. Only the list sizes are read serially, to find
+ * where the vertex indices of every face start; the indices are then converted in parallel.
+ */
+static const char *load_face_element_mapped(PlyReadBuffer &file,
+                                            const PlyHeader &header,
+                                            const PlyElement &element,
+                                            const int prop_index,
+                                            PlyData *data)
+{
+  const bool big_endian = header.type == PlyFormatType::BINARY_BE;
+  const PlyProperty &prop = element.properties[prop_index];
+  const int index_size = data_type_size[prop.type];
+  const Span<uint8_t> bytes = file.mapped_bytes_remaining();
+
+  Vector<size_t> index_starts;
+  Vector<int> face_offsets;
+  index_starts.reserve(element.count);
+  face_offsets.reserve(element.count + 1);
+  int corners_num = 0;
+  size_t pos = 0;
+  for (int i = 0; i < element.count; i++) {
+    /* Skip any properties before vertex indices. */
+    for (int j = 0; j < prop_index; j++) {
+      if (!skip_mapped_property(bytes, pos, element.properties[j], big_endian)) {
+        return "Could not read face element";
+      }
+    }
+
+    uint32_t count = 0;
+    if (!read_mapped_value(bytes, pos, prop.count_type, big_endian, count)) {
+      return "Could not read face element";
+    }
+    if (count < 1 || count > 255) {
+      return "Invalid face size, must be between 1 and 255";
+    }
+    if (pos + size_t(count) * index_size > bytes.size()) {
+      return "Could not read face element";
+    }
+    /* Previous python based importer was accepting faces with fewer
+     * than 3 vertices, and silently dropping them. */
+    if (count < 3) {
+      fprintf(stderr, "PLY Importer: ignoring face %i (%i vertices)\n", i, int(count));
+    }
+    else {
+      index_starts.append(pos);
+      face_offsets.append(corners_num);
+      data->face_sizes.append(count);
+      corners_num += int(count);
+    }
+    pos += size_t(count) * index_size;
+
+    /* Skip any properties after vertex indices. */
+    for (int j = prop_index + 1; j < element.properties.size(); j++) {
+      if (!skip_mapped_property(bytes, pos, element.properties[j], big_endian)) {
+        return "Could not read face element";
+      }
+    }
+  }
+  file.read_mapped_bytes(pos);
+  face_offsets.append(corners_num);
+
+  data->face_vertices.resize(corners_num);
+  const OffsetIndices<int> faces = face_offsets.as_span();
+  threading::parallel_for(faces.index_range(), 4096, [&](const IndexRange range) {
+    uint8_t indices[255 * 8];
+    for (const int face : range) {
+      const IndexRange face_range = faces[face];
+      memcpy(indices, bytes.data() + index_starts[face], face_range.size() * index_size);
+      if (big_endian) {
+        endian_switch_array(indices, index_size, face_range.size());
+      }
+      const uint8_t *ptr = indices;
+      for (const int corner : face_range) {
+        data->face_vertices[corner] = get_binary_value<uint32_t>(prop.type, ptr);
+      }
+    }
+  });
+  return nullptr;
+}
+
 static const char *load_face_element(PlyReadBuffer &file,
                                      const PlyHeader &header,
                                      const PlyElement &element,
@@ -405,6 +576,10 @@ static const char *load_face_element(PlyReadBuffer &file,
     return "Face element vertex indices property must be a list";
   }
 
+  if (file.is_memory_mapped() && header.type != PlyFormatType::ASCII) {
+    return load_face_element_mapped(file, header, element, prop_index, data);
+  }
+
   data->face_vertices.reserve(element.count * 3);
   data->face_sizes.reserve(element.count);
 
@@ -590,7 +765,17 @@ static const char *load_edge_element(PlyReadBuffer &file,
     return "Edge element does not contain vertex1 and vertex2 properties";
   }
 
-  data->edges.reserve(element.count);
+  data->edges.resize(element.count);
+
+  const auto store_row = [&](const int i, const Span<float> value_vec) {
+    int index1 = value_vec[prop_vertex1];
+    int index2 = value_vec[prop_vertex2];
+    data->edges[i] = std::make_pair(index1, index2);
+  };
+
+  if (parse_rows_mapped(file, header, element, store_row)) {
+    return nullptr;
+  }
 
   Vector<float> value_vec(element.properties.size());
   Vector<uint8_t> scratch;
@@ -609,9 +794,7 @@ static const char *load_edge_element(PlyReadBuffer &file,
     if (error != nullptr) {
       return error;
     }
-    int index1 = value_vec[prop_vertex1];
-    int index2 = value_vec[prop_vertex2];
-    data->edges.append(std::make_pair(index1, index2));
+    store_row(i, value_vec);
   }
   return nullptr;
 }
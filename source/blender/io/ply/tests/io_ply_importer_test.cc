@@ -25,12 +25,19 @@ struct Expectation {
 class PLYImportTest : public testing::Test {
  public:
   void import_and_check(const char *path, const Expectation &exp)
+  {
+    /* Binary data is read from a memory mapped file when possible, check both code paths. */
+    import_and_check(path, exp, false);
+    import_and_check(path, exp, true);
+  }
+
+  void import_and_check(const char *path, const Expectation &exp, const bool use_memory_map)
   {
     std::string ply_path = blender::tests::flags_test_asset_dir() +
                            SEP_STR "io_tests" SEP_STR "ply" SEP_STR + path;
 
     /* Use a small read buffer size for better coverage of buffer refilling behavior. */
-    PlyReadBuffer infile(ply_path.c_str(), 128);
+    PlyReadBuffer infile(ply_path.c_str(), 128, use_memory_map);
     PlyHeader header;
     const char *header_err = read_header(infile, header);
     if (header_err != nullptr) {
@@ -10,8 +10,13 @@
 
 #include "BKE_mesh.hh"
 
+#include "BLI_array.hh"
 #include "BLI_array_utils.hh"
+#include "BLI_index_mask.hh"
+#include "BLI_map.hh"
+#include "BLI_math_bits.h"
 #include "BLI_span.hh"
+#include "BLI_task.hh"
 
 #include "DNA_mesh_types.h"
 
@@ -20,6 +25,19 @@
 
 namespace blender::io::stl {
 
+static void report_removed_triangles(const int64_t degenerate_tris_num,
+                                     const int64_t duplicate_tris_num)
+{
+  if (degenerate_tris_num > 0) {
+    std::cout << "STL Importer: " << degenerate_tris_num << " degenerate triangles were removed"
+              << std::endl;
+  }
+  if (duplicate_tris_num > 0) {
+    std::cout << "STL Importer: " << duplicate_tris_num << " duplicate triangles were removed"
+              << std::endl;
+  }
+}
+
 STLMeshHelper::STLMeshHelper(int tris_num, bool use_custom_normals)
     : use_custom_normals_(use_custom_normals)
 {
@@ -55,14 +73,7 @@ bool STLMeshHelper::add_triangle(const PackedTriangle &data)
 
 Mesh *STLMeshHelper::to_mesh()
 {
-  if (degenerate_tris_num_ > 0) {
-    std::cout << "STL Importer: " << degenerate_tris_num_ << " degenerate triangles were removed"
-              << std::endl;
-  }
-  if (duplicate_tris_num_ > 0) {
-    std::cout << "STL Importer: " << duplicate_tris_num_ << " duplicate triangles were removed"
-              << std::endl;
-  }
+  report_removed_triangles(degenerate_tris_num_, duplicate_tris_num_);
 
   Mesh *mesh = BKE_mesh_new_nomain(verts_.size(), 0, tris_.size(), tris_.size() * 3);
   mesh->vert_positions_for_write().copy_from(verts_);
@@ -79,4 +90,139 @@ Mesh *STLMeshHelper::to_mesh()
   return mesh;
 }
 
+/**
+ * For every element in the mask, find the first element in the mask with an equal key. Elements
+ * are partitioned into buckets by the hash of their key first, so that every bucket can be
+ * processed on a separate thread while still visiting its elements in their original order.
+ * Elements that are not in the mask get -1.
+ */
+template<typename Key, typename GetKeyFn>
+static Array<int> find_first_occurrences(const IndexMask &mask,
+                                         const int size,
+                                         const GetKeyFn &get_key)
+{
+  Array<int> first_occurrences(size, -1);
+  if (mask.is_empty()) {
+    return first_occurrences;
+  }
+
+  const int buckets_num = std::clamp<int>(power_of_2_max_i(mask.size() / 16384), 1, 1024);
+  const int chunks_num = std::clamp<int>(mask.size() / 16384, 1, 256);
+  const auto chunk_mask = [&](const int chunk) {
+    const int64_t start = mask.size() * chunk / chunks_num;
+    const int64_t end = mask.size() * (chunk + 1) / chunks_num;
+    return mask.slice(IndexRange::from_begin_end(start, end));
+  };
+
+  /* Count the elements of every bucket per chunk, to know where each chunk writes its elements
+   * in the bucket. */
+  Array<uint16_t> buckets(size);
+  Array<int> offsets(buckets_num * chunks_num + 1, 0);
+  threading::parallel_for(IndexRange(chunks_num), 1, [&](const IndexRange range) {
+    for (const int chunk : range) {
+      chunk_mask(chunk).foreach_index([&](const int i) {
+        const uint64_t hash = get_default_hash(get_key(i));
+        const int bucket = int((hash ^ (hash >> 32)) & uint64_t(buckets_num - 1));
+        buckets[i] = uint16_t(bucket);
+        offsets[bucket * chunks_num + chunk]++;
+      });
+    }
+  });
+  const OffsetIndices<int> bucket_chunk_offsets = offset_indices::accumulate_counts_to_offsets(
+      offsets);
+
+  Array<int> sorted_indices(mask.size());
+  threading::parallel_for(IndexRange(chunks_num), 1, [&](const IndexRange range) {
+    for (const int chunk : range) {
+      Array<int> chunk_offsets(buckets_num);
+      for (const int bucket : IndexRange(buckets_num)) {
+        chunk_offsets[bucket] = bucket_chunk_offsets[bucket * chunks_num + chunk].start();
+      }
+      chunk_mask(chunk).foreach_index(
+          [&](const int i) { sorted_indices[chunk_offsets[buckets[i]]++] = i; });
+    }
+  });
+
+  threading::parallel_for(IndexRange(buckets_num), 1, [&](const IndexRange range) {
+    for (const int bucket : range) {
+      const IndexRange bucket_range = IndexRange::from_begin_end(
+          bucket_chunk_offsets[bucket * chunks_num].start(),
+          bucket_chunk_offsets[bucket * chunks_num + chunks_num - 1].one_after_last());
+      Map<Key, int> first_by_key;
+      first_by_key.reserve(bucket_range.size());
+      for (const int i : sorted_indices.as_span().slice(bucket_range)) {
+        first_occurrences[i] = first_by_key.lookup_or_add(get_key(i), i);
+      }
+    }
+  });
+  return first_occurrences;
+}
+
+Mesh *stl_triangles_to_mesh(const Span<PackedTriangle> tris, const bool use_custom_normals)
+{
+  const int tris_num = int(tris.size());
+  const int corners_num = tris_num * 3;
+  const auto corner_position = [&](const int corner) -> float3 {
+    return tris[corner / 3].vertices[corner % 3];
+  };
+
+  /* Merge vertices, numbering them in the order of their first use. */
+  const Array<int> first_corners = find_first_occurrences<float3>(
+      IndexRange(corners_num), corners_num, corner_position);
+  IndexMaskMemory memory;
+  const IndexMask vert_corners = IndexMask::from_predicate(
+      IndexRange(corners_num), GrainSize(4096), memory, [&](const int corner) {
+        return first_corners[corner] == corner;
+      });
+  Array<int> corner_to_vert(corners_num);
+  vert_corners.foreach_index(GrainSize(4096), [&](const int corner, const int vert) {
+    corner_to_vert[corner] = vert;
+  });
+  threading::parallel_for(IndexRange(corners_num), 4096, [&](const IndexRange range) {
+    for (const int corner : range) {
+      corner_to_vert[corner] = corner_to_vert[first_corners[corner]];
+    }
+  });
+
+  /* Remove degenerate and duplicate triangles, keeping the first occurrence. */
+  const auto tri_verts = [&](const int tri) -> Triangle {
+    return {corner_to_vert[tri * 3], corner_to_vert[tri * 3 + 1], corner_to_vert[tri * 3 + 2]};
+  };
+  const IndexMask valid_tris = IndexMask::from_predicate(
+      IndexRange(tris_num), GrainSize(4096), memory, [&](const int tri) {
+        const Triangle t = tri_verts(tri);
+        return t.v1 != t.v2 && t.v1 != t.v3 && t.v2 != t.v3;
+      });
+  const Array<int> first_tris = find_first_occurrences<Triangle>(valid_tris, tris_num, tri_verts);
+  const IndexMask unique_tris = IndexMask::from_predicate(
+      valid_tris, GrainSize(4096), memory, [&](const int tri) { return first_tris[tri] == tri; });
+
+  report_removed_triangles(tris_num - valid_tris.size(), valid_tris.size() - unique_tris.size());
+
+  Mesh *mesh = BKE_mesh_new_nomain(
+      vert_corners.size(), 0, unique_tris.size(), unique_tris.size() * 3);
+  MutableSpan<float3> positions = mesh->vert_positions_for_write();
+  vert_corners.foreach_index(GrainSize(4096), [&](const int corner, const int vert) {
+    positions[vert] = corner_position(corner);
+  });
+  offset_indices::fill_constant_group_size(3, 0, mesh->face_offsets_for_write());
+  MutableSpan<int> corner_verts = mesh->corner_verts_for_write();
+  unique_tris.foreach_index(GrainSize(4096), [&](const int tri, const int face) {
+    corner_verts.slice(face * 3, 3).copy_from(corner_to_vert.as_span().slice(tri * 3, 3));
+  });
+
+  /* NOTE: edges must be calculated first before setting custom normals. */
+  bke::mesh_calc_edges(*mesh, false, false);
+
+  if (use_custom_normals) {
+    Array<float3> corner_normals(mesh->corners_num);
+    unique_tris.foreach_index(GrainSize(4096), [&](const int tri, const int face) {
+      corner_normals.as_mutable_span().slice(face * 3, 3).fill(tris[tri].normal);
+    });
+    BKE_mesh_set_custom_normals(mesh, reinterpret_cast<float(*)[3]>(corner_normals.data()));
+  }
+
+  return mesh;
+}
+
 }  // namespace blender::io::stl
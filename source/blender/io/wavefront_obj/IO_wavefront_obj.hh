@@ -64,6 +64,13 @@ struct OBJExportParams {
   /* Create bitflags instead of the default "0"/"1" group IDs. */
   bool smooth_groups_bitflags;
 
+  /**
+   * Upper limit for the size of formatted text that is kept in memory while waiting for earlier
+   * objects to be written to the file. Objects are still written in order when it is exceeded,
+   * with fewer of them formatted in parallel.
+   */
+  size_t max_pending_write_size = 256 * 1024 * 1024;
+
   ReportList *reports = nullptr;
 };
 
@@ -82,6 +89,8 @@ struct OBJImportParams {
   bool validate_meshes = true;
   bool relative_paths = true;
   bool clear_selection = true;
+  /** Pre-parse parts of the file on multiple threads. Does not change the result. */
+  bool use_threaded_parsing = true;
 
   ReportList *reports = nullptr;
 };
@@ -207,6 +207,8 @@ void OBJWriter::write_object_name(FormatHandler &fh, const OBJMesh &obj_mesh_dat
 /* Split up large meshes into multi-threaded jobs; each job processes
  * this amount of items. */
 static const int chunk_size = 32768;
+/* Maximum number of chunks that are formatted at the same time. */
+static const int max_batch_chunk_count = 64;
 static int calc_chunk_count(int count)
 {
   return (count + chunk_size - 1) / chunk_size;
@@ -234,21 +236,27 @@ void obj_parallel_chunked_output(FormatHandler &fh, int tot_count, const Functio
     }
     return;
   }
-  /* Give each chunk its own temporary output buffer, and process them in parallel. */
-  Array<FormatHandler> buffers(chunk_count);
-  threading::parallel_for(IndexRange(chunk_count), 1, [&](IndexRange range) {
-    for (const int r : range) {
-      int i_start = r * chunk_size;
-      int i_end = std::min(i_start + chunk_size, tot_count);
-      auto &buf = buffers[r];
-      for (int i = i_start; i < i_end; i++) {
-        function(buf, i);
+  /* Give each chunk its own temporary output buffer, and process them in parallel.
+   * Very large meshes are processed in batches of chunks, so that a streaming destination
+   * buffer does not need the text of the whole mesh in memory at once. */
+  const int batch_chunk_count = std::min(chunk_count, max_batch_chunk_count);
+  Array<FormatHandler> buffers(batch_chunk_count);
+  for (int batch_start = 0; batch_start < chunk_count; batch_start += batch_chunk_count) {
+    const IndexRange batch(batch_start, std::min(batch_chunk_count, chunk_count - batch_start));
+    threading::parallel_for(batch.index_range(), 1, [&](IndexRange range) {
+      for (const int r : range) {
+        int i_start = (batch_start + r) * chunk_size;
+        int i_end = std::min(i_start + chunk_size, tot_count);
+        auto &buf = buffers[r];
+        for (int i = i_start; i < i_end; i++) {
+          function(buf, i);
+        }
       }
+    });
+    /* Emit all temporary output buffers into the destination buffer. */
+    for (const int r : batch.index_range()) {
+      fh.append_from(buffers[r]);
     }
-  });
-  /* Emit all temporary output buffers into the destination buffer. */
-  for (auto &buf : buffers) {
-    fh.append_from(buf);
   }
 }
 
@@ -8,9 +8,14 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <cstdio>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <type_traits>
 
+#include "BLI_array.hh"
 #include "BLI_compiler_attrs.h"
 #include "BLI_fileops.h"
 #include "BLI_string_ref.hh"
@@ -31,14 +36,36 @@ namespace blender::io::obj {
  * into the given file.
  */
 class FormatHandler : NonCopyable, NonMovable {
- private:
+ public:
   using VectorChar = Vector<char>;
+  using BlockFn = std::function<void(VectorChar &&block)>;
+
+ private:
   Vector<VectorChar> blocks_;
   size_t buffer_chunk_size_;
+  BlockFn full_block_fn_;
 
  public:
   FormatHandler(size_t buffer_chunk_size = 64 * 1024) : buffer_chunk_size_(buffer_chunk_size) {}
 
+  /**
+   * Hand every block to the given function as soon as it is full, instead of keeping it in the
+   * buffer. Call #flush_blocks at the end to pass on the last, partially filled block too.
+   */
+  void set_full_block_fn(BlockFn fn)
+  {
+    full_block_fn_ = std::move(fn);
+  }
+
+  /* Pass all blocks to the full block function, and clear the buffers. */
+  void flush_blocks()
+  {
+    for (VectorChar &b : blocks_) {
+      full_block_fn_(std::move(b));
+    }
+    blocks_.clear();
+  }
+
   /* Write contents to the buffer(s) into a file, and clear the buffers. */
   void write_to_file(FILE *f)
   {
@@ -63,6 +90,14 @@ class FormatHandler : NonCopyable, NonMovable {
 
   void append_from(FormatHandler &v)
   {
+    if (full_block_fn_) {
+      this->flush_blocks();
+      for (VectorChar &b : v.blocks_) {
+        full_block_fn_(std::move(b));
+      }
+      v.blocks_.clear();
+      return;
+    }
     blocks_.insert(blocks_.end(),
                    std::make_move_iterator(v.blocks_.begin()),
                    std::make_move_iterator(v.blocks_.end()));
@@ -203,6 +238,9 @@ class FormatHandler : NonCopyable, NonMovable {
   void ensure_space(size_t at_least)
   {
     if (blocks_.is_empty() || (blocks_.last().capacity() - blocks_.last().size() < at_least)) {
+      if (full_block_fn_) {
+        flush_blocks();
+      }
       blocks_.append(VectorChar());
       blocks_.last().reserve(std::max(at_least, buffer_chunk_size_));
     }
@@ -220,4 +258,118 @@ class FormatHandler : NonCopyable, NonMovable {
   }
 };
 
+/**
+ * Writes blocks of text produced on several threads into a file, in a fixed order.
+ * Every producer (e.g. one per exported object) adds blocks to its own slot, and the blocks of a
+ * slot are written after all blocks of the previous slots. Writing happens on a separate thread
+ * as soon as blocks can be written, so formatting and file IO overlap.
+ *
+ * The size of blocks that are waiting to be written is limited: a producer that would go over
+ * the limit waits until its slot is the one being written. To guarantee progress, producers have
+ * to start working on slots in order, so that the slot being written always has an active
+ * producer (or is finished already).
+ */
+class OrderedBlockWriter : NonCopyable, NonMovable {
+  using VectorChar = FormatHandler::VectorChar;
+
+  struct Slot {
+    Vector<VectorChar> blocks;
+    bool finished = false;
+  };
+
+  FILE *file_;
+  size_t max_pending_size_;
+  Array<Slot> slots_;
+  /** Slot that is currently being written, all slots before it are finished and written. */
+  int write_slot_ = 0;
+  /** Size of the blocks that have been added but not written yet. */
+  size_t pending_size_ = 0;
+  size_t max_reached_pending_size_ = 0;
+  std::mutex mutex_;
+  std::condition_variable blocks_added_;
+  std::condition_variable blocks_written_;
+  std::thread thread_;
+
+ public:
+  OrderedBlockWriter(FILE *file, const int slots_num, const size_t max_pending_size)
+      : file_(file), max_pending_size_(max_pending_size), slots_(slots_num)
+  {
+    thread_ = std::thread([this]() { this->write_loop(); });
+  }
+
+  ~OrderedBlockWriter()
+  {
+    this->finish();
+  }
+
+  void add_block(const int slot, VectorChar &&block)
+  {
+    std::unique_lock lock(mutex_);
+    /* The slot being written can always add a block once its previous ones were taken by the
+     * writer thread, so the limit can only be exceeded by the size of one block. */
+    blocks_written_.wait(lock, [&]() {
+      if (pending_size_ + block.size() <= max_pending_size_) {
+        return true;
+      }
+      return slot == write_slot_ && slots_[slot].blocks.is_empty();
+    });
+    pending_size_ += block.size();
+    max_reached_pending_size_ = std::max(max_reached_pending_size_, pending_size_);
+    slots_[slot].blocks.append(std::move(block));
+    blocks_added_.notify_one();
+  }
+
+  /** Mark that no more blocks will be added to the slot. */
+  void finish_slot(const int slot)
+  {
+    std::lock_guard lock(mutex_);
+    slots_[slot].finished = true;
+    blocks_added_.notify_one();
+  }
+
+  /** Wait until all slots are finished and written. */
+  void finish()
+  {
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  /** Largest size of blocks that were waiting to be written at the same time. */
+  size_t max_reached_pending_size() const
+  {
+    return max_reached_pending_size_;
+  }
+
+ private:
+  void write_loop()
+  {
+    std::unique_lock lock(mutex_);
+    while (write_slot_ < slots_.size()) {
+      Slot &slot = slots_[write_slot_];
+      if (!slot.blocks.is_empty()) {
+        Vector<VectorChar> blocks = std::move(slot.blocks);
+        slot.blocks.clear();
+        lock.unlock();
+        size_t written_size = 0;
+        for (const VectorChar &b : blocks) {
+          fwrite(b.data(), 1, b.size(), file_);
+          written_size += b.size();
+        }
+        blocks.clear_and_shrink();
+        lock.lock();
+        pending_size_ -= written_size;
+        blocks_written_.notify_all();
+      }
+      else if (slot.finished) {
+        write_slot_++;
+        blocks_written_.notify_all();
+      }
+      else {
+        blocks_added_.wait(lock);
+      }
+    }
+  }
+};
+
 }  // namespace blender::io::obj
@@ -6,6 +6,7 @@
  * \ingroup obj
  */
 
+#include <atomic>
 #include <cstdio>
 #include <memory>
 #include <system_error>
@@ -158,10 +159,10 @@ static void write_mesh_objects(const Span<std::unique_ptr<OBJMesh>> exportable_a
                                const OBJExportParams &export_params)
 {
   /* Parallelization is over meshes/objects, which means
-   * we have to have the output text buffer for each object,
-   * and write them all into the file at the end. */
+   * we have to have the output text buffer for each object.
+   * Buffers are streamed to the file in object order while other
+   * objects are still being formatted, see #OrderedBlockWriter. */
   size_t count = exportable_as_mesh.size();
-  Array<FormatHandler> buffers(count);
 
   /* Serial: gather material indices, ensure normals & edges. */
   Vector<Vector<int>> mtlindices;
@@ -202,52 +203,67 @@ static void write_mesh_objects(const Span<std::unique_ptr<OBJMesh>> exportable_a
     offsets.normal_offset += obj.get_normal_coords().size();
   }
 
-  /* Parallel over meshes: main result writing. */
-  threading::parallel_for(IndexRange(count), 1, [&](IndexRange range) {
-    for (const int i : range) {
-      OBJMesh &obj = *exportable_as_mesh[i];
-      auto &fh = buffers[i];
+  /* Format the whole result of one object into the buffer. */
+  auto write_mesh_object = [&](FormatHandler &fh, const int i) {
+    OBJMesh &obj = *exportable_as_mesh[i];
 
-      obj_writer.write_object_name(fh, obj);
-      obj_writer.write_vertex_coords(fh, obj, export_params.export_colors);
+    obj_writer.write_object_name(fh, obj);
+    obj_writer.write_vertex_coords(fh, obj, export_params.export_colors);
 
-      if (obj.tot_faces() > 0) {
-        if (export_params.export_smooth_groups) {
-          obj.calc_smooth_groups(export_params.smooth_groups_bitflags);
-        }
-        if (export_params.export_materials) {
-          obj.calc_face_order();
-        }
-        if (export_params.export_normals) {
-          obj_writer.write_normals(fh, obj);
-        }
-        if (export_params.export_uv) {
-          obj_writer.write_uv_coords(fh, obj);
-        }
-        /* This function takes a 0-indexed slot index for the obj_mesh object and
-         * returns the material name that we are using in the `.obj` file for it. */
-        const auto *obj_mtlindices = mtlindices.is_empty() ? nullptr : &mtlindices[i];
-        auto matname_fn = [&](int s) -> const char * {
-          if (!obj_mtlindices || s < 0 || s >= obj_mtlindices->size()) {
-            return nullptr;
-          }
-          return mtl_writer->mtlmaterial_name((*obj_mtlindices)[s]);
-        };
-        obj_writer.write_face_elements(fh, index_offsets[i], obj, matname_fn);
+    if (obj.tot_faces() > 0) {
+      if (export_params.export_smooth_groups) {
+        obj.calc_smooth_groups(export_params.smooth_groups_bitflags);
       }
-      obj_writer.write_edges_indices(fh, index_offsets[i], obj);
+      if (export_params.export_materials) {
+        obj.calc_face_order();
+      }
+      if (export_params.export_normals) {
+        obj_writer.write_normals(fh, obj);
+      }
+      if (export_params.export_uv) {
+        obj_writer.write_uv_coords(fh, obj);
+      }
+      /* This function takes a 0-indexed slot index for the obj_mesh object and
+       * returns the material name that we are using in the `.obj` file for it. */
+      const auto *obj_mtlindices = mtlindices.is_empty() ? nullptr : &mtlindices[i];
+      auto matname_fn = [&](int s) -> const char * {
+        if (!obj_mtlindices || s < 0 || s >= obj_mtlindices->size()) {
+          return nullptr;
+        }
+        return mtl_writer->mtlmaterial_name((*obj_mtlindices)[s]);
+      };
+      obj_writer.write_face_elements(fh, index_offsets[i], obj, matname_fn);
+    }
+    obj_writer.write_edges_indices(fh, index_offsets[i], obj);
 
-      /* Nothing will need this object's data after this point, release
-       * various arrays here. */
-      obj.clear();
+    /* Nothing will need this object's data after this point, release
+     * various arrays here. */
+    obj.clear();
+  };
+
+  /* Parallel over meshes: main result writing. */
+  OrderedBlockWriter block_writer(
+      obj_writer.get_outfile(), count, export_params.max_pending_write_size);
+  /* The block writer requires objects to be started in order, so rather than using the index
+   * passed in by #parallel_for, every iteration takes the next object that is not started yet. */
+  std::atomic<int> next_object = 0;
+  threading::parallel_for(IndexRange(count), 1, [&](IndexRange range) {
+    for ([[maybe_unused]] const int iter : range) {
+      const int i = next_object.fetch_add(1);
+      /* Waiting for nested tasks must not start formatting another object on this thread,
+       * which might then wait for this object to be written. */
+      threading::isolate_task([&]() {
+        FormatHandler fh;
+        fh.set_full_block_fn([&](FormatHandler::VectorChar &&block) {
+          block_writer.add_block(i, std::move(block));
+        });
+        write_mesh_object(fh, i);
+        fh.flush_blocks();
+        block_writer.finish_slot(i);
+      });
     }
   });
-
-  /* Write all the object text buffers into the output file. */
-  FILE *f = obj_writer.get_outfile();
-  for (auto &b : buffers) {
-    b.write_to_file(f);
-  }
+  block_writer.finish();
 }
 
 /**
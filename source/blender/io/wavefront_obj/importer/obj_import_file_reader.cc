@@ -8,12 +8,14 @@
 
 #include "BKE_report.hh"
 
+#include "BLI_array.hh"
 #include "BLI_fileops.hh"
 #include "BLI_map.hh"
 #include "BLI_math_vector.h"
 #include "BLI_math_vector_types.hh"
 #include "BLI_string.h"
 #include "BLI_string_ref.hh"
+#include "BLI_task.hh"
 #include "BLI_vector.hh"
 
 #include "obj_export_mtl.hh"
@@ -28,6 +30,9 @@ namespace blender::io::obj {
 
 using std::string;
 
+/** Number of read buffer sized parts that are read at once when parsing on multiple threads. */
+static constexpr size_t threaded_read_chunks_num = 64;
+
 /**
  * Based on the properties of the given Geometry instance, create a new Geometry instance
  * or return the previous one.
@@ -71,35 +76,49 @@ static Geometry *create_geometry(Geometry *const prev_geometry,
   return new_geometry();
 }
 
+/**
+ * Parse the optional `xyzrgb` vertex color that follows a vertex position (OBJ extension, see
+ * http://paulbourke.net/dataformats/obj/colour.html). Returns false if there is no valid color.
+ */
+static bool parse_vertex_color(const char *p, const char *end, float3 &r_linear)
+{
+  if (p >= end) {
+    return false;
+  }
+  float3 srgb;
+  parse_floats(p, end, -1.0f, srgb, 3);
+  if (srgb.x >= 0 && srgb.y >= 0 && srgb.z >= 0) {
+    srgb_to_linearrgb_v3_v3(r_linear, srgb);
+    return true;
+  }
+  return false;
+}
+
+/** Add the color of the most recently added vertex. */
+static void geom_add_vertex_color(const float3 &linear, GlobalVertices &r_global_vertices)
+{
+  auto &blocks = r_global_vertices.vertex_colors;
+  /* If we don't have vertex colors yet, or the previous vertex
+   * was without color, we need to start a new vertex colors block. */
+  if (blocks.is_empty() || (blocks.last().start_vertex_index + blocks.last().colors.size() !=
+                            r_global_vertices.vertices.size() - 1))
+  {
+    GlobalVertices::VertexColorsBlock block;
+    block.start_vertex_index = r_global_vertices.vertices.size() - 1;
+    blocks.append(block);
+  }
+  blocks.last().colors.append(linear);
+}
+
 static void geom_add_vertex(const char *p, const char *end, GlobalVertices &r_global_vertices)
 {
   float3 vert;
   p = parse_floats(p, end, 0.0f, vert, 3);
   r_global_vertices.vertices.append(vert);
-  /* OBJ extension: `xyzrgb` vertex colors, when the vertex position
-   * is followed by 3 more RGB color components. See
-   * http://paulbourke.net/dataformats/obj/colour.html */
-  if (p < end) {
-    float3 srgb;
-    p = parse_floats(p, end, -1.0f, srgb, 3);
-    if (srgb.x >= 0 && srgb.y >= 0 && srgb.z >= 0) {
-      float3 linear;
-      srgb_to_linearrgb_v3_v3(linear, srgb);
-
-      auto &blocks = r_global_vertices.vertex_colors;
-      /* If we don't have vertex colors yet, or the previous vertex
-       * was without color, we need to start a new vertex colors block. */
-      if (blocks.is_empty() || (blocks.last().start_vertex_index + blocks.last().colors.size() !=
-                                r_global_vertices.vertices.size() - 1))
-      {
-        GlobalVertices::VertexColorsBlock block;
-        block.start_vertex_index = r_global_vertices.vertices.size() - 1;
-        blocks.append(block);
-      }
-      blocks.last().colors.append(linear);
-    }
+  float3 linear;
+  if (parse_vertex_color(p, end, linear)) {
+    geom_add_vertex_color(linear, r_global_vertices);
   }
-  UNUSED_VARS(p);
 }
 
 static void geom_add_mrgb_colors(const char *p, const char *end, GlobalVertices &r_global_vertices)
@@ -142,9 +161,7 @@ static void geom_add_mrgb_colors(const char *p, const char *end, GlobalVertices
   }
 }
 
-static void geom_add_vertex_normal(const char *p,
-                                   const char *end,
-                                   GlobalVertices &r_global_vertices)
+static float3 parse_vertex_normal(const char *p, const char *end)
 {
   float3 normal;
   parse_floats(p, end, 0.0f, normal, 3);
@@ -152,14 +169,14 @@ static void geom_add_vertex_normal(const char *p,
    * making them ever-so-slightly non unit length. Make sure they are
    * normalized. */
   normalize_v3(normal);
-  r_global_vertices.vert_normals.append(normal);
+  return normal;
 }
 
-static void geom_add_uv_vertex(const char *p, const char *end, GlobalVertices &r_global_vertices)
+static float2 parse_uv_vertex(const char *p, const char *end)
 {
   float2 uv;
   parse_floats(p, end, 0.0f, uv, 2);
-  r_global_vertices.uv_vertices.append(uv);
+  return uv;
 }
 
 /**
@@ -225,30 +242,28 @@ static void geom_add_polyline(Geometry *geom,
   }
 }
 
-static void geom_add_polygon(Geometry *geom,
-                             const char *p,
-                             const char *end,
-                             const GlobalVertices &global_vertices,
-                             const int material_index,
-                             const int group_index,
-                             const bool shaded_smooth)
-{
-  FaceElem curr_face;
-  curr_face.shaded_smooth = shaded_smooth;
-  curr_face.material_index = material_index;
-  if (group_index >= 0) {
-    curr_face.vertex_group_index = group_index;
-    geom->has_vertex_groups_ = true;
-  }
-
-  const int orig_corners_size = geom->face_corners_.size();
-  curr_face.start_index_ = orig_corners_size;
+/**
+ * A face corner as written in the file: indices are not resolved or validated yet, since that
+ * depends on how many vertices, UVs and normals precede the face in the file.
+ */
+struct ParsedFaceCorner {
+  FaceCorner corner;
+  bool got_uv = false;
+  bool got_normal = false;
+};
 
-  bool face_valid = true;
+/**
+ * Parse the corners of a face line. Parsing stops after the first corner with an invalid vertex
+ * index, since the whole face is discarded in that case.
+ */
+static void parse_face_corners(const char *p,
+                               const char *end,
+                               Vector<ParsedFaceCorner> &r_corners)
+{
   p = drop_whitespace(p, end);
-  while (p < end && face_valid) {
-    FaceCorner corner;
-    bool got_uv = false, got_normal = false;
+  while (p < end) {
+    ParsedFaceCorner parsed;
+    FaceCorner &corner = parsed.corner;
     /* Parse vertex index. */
     p = parse_int(p, end, INT32_MAX, corner.vert_index, false);
 
@@ -257,21 +272,57 @@ static void geom_add_polygon(Geometry *geom,
       break;
     }
 
-    face_valid &= corner.vert_index != INT32_MAX;
     if (p < end && *p == '/') {
       /* Parse UV index. */
       ++p;
       if (p < end && *p != '/') {
         p = parse_int(p, end, INT32_MAX, corner.uv_vert_index, false);
-        got_uv = corner.uv_vert_index != INT32_MAX;
+        parsed.got_uv = corner.uv_vert_index != INT32_MAX;
       }
       /* Parse normal index. */
       if (p < end && *p == '/') {
         ++p;
         p = parse_int(p, end, INT32_MAX, corner.vertex_normal_index, false);
-        got_normal = corner.vertex_normal_index != INT32_MAX;
+        parsed.got_normal = corner.vertex_normal_index != INT32_MAX;
       }
     }
+    r_corners.append(parsed);
+    if (corner.vert_index == INT32_MAX) {
+      break;
+    }
+
+    /* Some files contain extra stuff per face (e.g. 4 indices); skip any remainder (#103441). */
+    p = drop_non_whitespace(p, end);
+    /* Skip whitespace to get to the next face corner. */
+    p = drop_whitespace(p, end);
+  }
+}
+
+static void geom_add_polygon(Geometry *geom,
+                             const Span<ParsedFaceCorner> parsed_corners,
+                             const GlobalVertices &global_vertices,
+                             const int material_index,
+                             const int group_index,
+                             const bool shaded_smooth)
+{
+  FaceElem curr_face;
+  curr_face.shaded_smooth = shaded_smooth;
+  curr_face.material_index = material_index;
+  if (group_index >= 0) {
+    curr_face.vertex_group_index = group_index;
+    geom->has_vertex_groups_ = true;
+  }
+
+  const int orig_corners_size = geom->face_corners_.size();
+  curr_face.start_index_ = orig_corners_size;
+
+  bool face_valid = true;
+  for (const ParsedFaceCorner &parsed : parsed_corners) {
+    if (!face_valid) {
+      break;
+    }
+    FaceCorner corner = parsed.corner;
+    face_valid &= corner.vert_index != INT32_MAX;
     /* Always keep stored indices non-negative and zero-based. */
     corner.vert_index += corner.vert_index < 0 ? global_vertices.vertices.size() : -1;
     if (corner.vert_index < 0 || corner.vert_index >= global_vertices.vertices.size()) {
@@ -285,7 +336,7 @@ static void geom_add_polygon(Geometry *geom,
       geom->track_vertex_index(corner.vert_index);
     }
     /* Ignore UV index, if the geometry does not have any UVs (#103212). */
-    if (got_uv && !global_vertices.uv_vertices.is_empty()) {
+    if (parsed.got_uv && !global_vertices.uv_vertices.is_empty()) {
       corner.uv_vert_index += corner.uv_vert_index < 0 ? global_vertices.uv_vertices.size() : -1;
       if (corner.uv_vert_index < 0 || corner.uv_vert_index >= global_vertices.uv_vertices.size()) {
         fprintf(stderr,
@@ -298,7 +349,7 @@ static void geom_add_polygon(Geometry *geom,
     /* Ignore corner normal index, if the geometry does not have any normals.
      * Some obj files out there do have face definitions that refer to normal indices,
      * without any normals being present (#98782). */
-    if (got_normal && !global_vertices.vert_normals.is_empty()) {
+    if (parsed.got_normal && !global_vertices.vert_normals.is_empty()) {
       corner.vertex_normal_index += corner.vertex_normal_index < 0 ?
                                         global_vertices.vert_normals.size() :
                                         -1;
@@ -314,11 +365,6 @@ static void geom_add_polygon(Geometry *geom,
     }
     geom->face_corners_.append(corner);
     curr_face.corner_count_++;
-
-    /* Some files contain extra stuff per face (e.g. 4 indices); skip any remainder (#103441). */
-    p = drop_non_whitespace(p, end);
-    /* Skip whitespace to get to the next face corner. */
-    p = drop_whitespace(p, end);
   }
 
   if (face_valid) {
@@ -484,6 +530,140 @@ static bool parse_keyword(const char *&p, const char *end, StringRef keyword)
   return true;
 }
 
+/**
+ * Add a face to the current geometry, using the material and group state of the parser.
+ */
+static void geom_add_face(Geometry *geom,
+                          const Span<ParsedFaceCorner> parsed_corners,
+                          const GlobalVertices &global_vertices,
+                          const StringRef state_material_name,
+                          int &r_state_material_index,
+                          const int state_group_index,
+                          const bool state_shaded_smooth)
+{
+  /* If we don't have a material index assigned yet, get one.
+   * It means "usemtl" state came from the previous object. */
+  if (r_state_material_index == -1 && !state_material_name.is_empty() &&
+      geom->material_indices_.is_empty())
+  {
+    geom->material_indices_.add_new(state_material_name, 0);
+    geom->material_order_.append(state_material_name);
+    r_state_material_index = 0;
+  }
+
+  geom_add_polygon(geom,
+                   parsed_corners,
+                   global_vertices,
+                   r_state_material_index,
+                   state_group_index,
+                   state_shaded_smooth);
+}
+
+/**
+ * Part of the file that is pre-parsed on a worker thread. Vertex data and face corners do not
+ * depend on the parser state, so they are parsed here. All other lines are only classified and
+ * are handled later, in file order, together with the resolving of the face corner indices.
+ */
+struct ParsedChunk {
+  enum class LineType : int8_t {
+    Vertex,
+    UV,
+    Normal,
+    Face,
+    Other,
+  };
+  /** Consecutive lines of the same type, or a single line that is parsed later. */
+  struct LineRun {
+    LineType type;
+    int count;
+    /** Line contents, only set for #LineType::Other. */
+    StringRef line;
+  };
+
+  Vector<LineRun> runs;
+  size_t line_count = 0;
+
+  Vector<float3> vertices;
+  /**
+   * Linear vertex colors, with negative components for vertices without a color. Only as large
+   * as needed to contain the last vertex with a color.
+   */
+  Vector<float3> vertex_colors;
+  Vector<float2> uv_vertices;
+  Vector<float3> vert_normals;
+
+  Vector<ParsedFaceCorner> face_corners;
+  /** Start of each face in #face_corners. */
+  Vector<int> face_starts;
+
+  void add_line(const LineType type)
+  {
+    if (!runs.is_empty() && runs.last().type == type) {
+      runs.last().count++;
+      return;
+    }
+    runs.append({type, 1, {}});
+  }
+
+  void add_other_line(const StringRef line)
+  {
+    runs.append({LineType::Other, 1, line});
+  }
+
+  Span<ParsedFaceCorner> face(const int face_index) const
+  {
+    const int start = face_starts[face_index];
+    const int end = face_index + 1 < face_starts.size() ? face_starts[face_index + 1] :
+                                                          face_corners.size();
+    return face_corners.as_span().slice(start, end - start);
+  }
+
+  void parse(StringRef buffer)
+  {
+    while (!buffer.is_empty()) {
+      const StringRef line = read_next_line(buffer);
+      const char *p = line.begin(), *end = line.end();
+      p = drop_whitespace(p, end);
+      ++line_count;
+      if (p == end) {
+        continue;
+      }
+      if (*p == 'v') {
+        if (parse_keyword(p, end, "v")) {
+          float3 vert;
+          p = parse_floats(p, end, 0.0f, vert, 3);
+          vertices.append(vert);
+          float3 linear;
+          if (parse_vertex_color(p, end, linear)) {
+            vertex_colors.resize(vertices.size() - 1, float3(-1.0f));
+            vertex_colors.append(linear);
+          }
+          add_line(LineType::Vertex);
+        }
+        else if (parse_keyword(p, end, "vn")) {
+          vert_normals.append(parse_vertex_normal(p, end));
+          add_line(LineType::Normal);
+        }
+        else if (parse_keyword(p, end, "vt")) {
+          uv_vertices.append(parse_uv_vertex(p, end));
+          add_line(LineType::UV);
+        }
+        else {
+          add_other_line(StringRef(p, end));
+        }
+      }
+      else if (parse_keyword(p, end, "f")) {
+        face_starts.append(face_corners.size());
+        parse_face_corners(p, end, face_corners);
+        add_line(LineType::Face);
+      }
+      else {
+        add_other_line(StringRef(p, end));
+      }
+    }
+  }
+};
+
 /* Special case: if there were no faces/edges in any geometries,
  * treat all the vertices as a point cloud. */
 static void use_all_vertices_if_no_faces(Geometry *geom,
@@ -500,6 +680,246 @@ static void use_all_vertices_if_no_faces(Geometry *geom,
   }
 }
 
+/**
+ * State variables: once set, they remain the same for the remaining
+ * elements in the object.
+ */
+struct OBJParser::ParseState {
+  Vector<std::unique_ptr<Geometry>> &all_geometries;
+  GlobalVertices &global_vertices;
+  Geometry *curr_geom = nullptr;
+
+  bool shaded_smooth = false;
+  string group_name;
+  int group_index = -1;
+  string material_name;
+  int material_index = -1;
+
+  size_t line_number = 0;
+  /** Face corners of the current face, reused for all faces when parsing serially. */
+  Vector<ParsedFaceCorner> face_corners;
+};
+
+void OBJParser::parse_line(const StringRef line, ParseState &state)
+{
+  GlobalVertices &r_global_vertices = state.global_vertices;
+  Vector<std::unique_ptr<Geometry>> &r_all_geometries = state.all_geometries;
+
+  const char *p = line.begin(), *end = line.end();
+  p = drop_whitespace(p, end);
+  if (p == end) {
+    return;
+  }
+  /* Most common things that start with 'v': vertices, normals, UVs. */
+  if (*p == 'v') {
+    if (parse_keyword(p, end, "v")) {
+      geom_add_vertex(p, end, r_global_vertices);
+    }
+    else if (parse_keyword(p, end, "vn")) {
+      r_global_vertices.vert_normals.append(parse_vertex_normal(p, end));
+    }
+    else if (parse_keyword(p, end, "vt")) {
+      r_global_vertices.uv_vertices.append(parse_uv_vertex(p, end));
+    }
+  }
+  /* Faces. */
+  else if (parse_keyword(p, end, "f")) {
+    state.face_corners.clear();
+    parse_face_corners(p, end, state.face_corners);
+    geom_add_face(state.curr_geom,
+                  state.face_corners,
+                  r_global_vertices,
+                  state.material_name,
+                  state.material_index,
+                  state.group_index,
+                  state.shaded_smooth);
+  }
+  /* Faces. */
+  else if (parse_keyword(p, end, "l")) {
+    geom_add_polyline(state.curr_geom, p, end, r_global_vertices);
+  }
+  /* Objects. */
+  else if (parse_keyword(p, end, "o")) {
+    if (import_params_.use_split_objects) {
+      geom_new_object(p,
+                      end,
+                      state.shaded_smooth,
+                      state.group_name,
+                      state.material_index,
+                      state.curr_geom,
+                      r_all_geometries);
+    }
+  }
+  /* Groups. */
+  else if (parse_keyword(p, end, "g")) {
+    if (import_params_.use_split_groups) {
+      geom_new_object(p,
+                      end,
+                      state.shaded_smooth,
+                      state.group_name,
+                      state.material_index,
+                      state.curr_geom,
+                      r_all_geometries);
+    }
+    else {
+      geom_update_group(StringRef(p, end).trim(), state.group_name);
+      int new_index = state.curr_geom->group_indices_.size();
+      state.group_index = state.curr_geom->group_indices_.lookup_or_add(state.group_name,
+                                                                        new_index);
+      if (new_index == state.group_index) {
+        state.curr_geom->group_order_.append(state.group_name);
+      }
+    }
+  }
+  /* Smoothing groups. */
+  else if (parse_keyword(p, end, "s")) {
+    geom_update_smooth_group(p, end, state.shaded_smooth);
+  }
+  /* Materials and their libraries. */
+  else if (parse_keyword(p, end, "usemtl")) {
+    state.material_name = StringRef(p, end).trim();
+    int new_mat_index = state.curr_geom->material_indices_.size();
+    state.material_index = state.curr_geom->material_indices_.lookup_or_add(state.material_name,
+                                                                            new_mat_index);
+    if (new_mat_index == state.material_index) {
+      state.curr_geom->material_order_.append(state.material_name);
+    }
+  }
+  else if (parse_keyword(p, end, "mtllib")) {
+    add_mtl_library(StringRef(p, end).trim());
+  }
+  else if (parse_keyword(p, end, "#MRGB")) {
+    geom_add_mrgb_colors(p, end, r_global_vertices);
+  }
+  /* Comments. */
+  else if (*p == '#') {
+    /* Nothing to do. */
+  }
+  /* Curve related things. */
+  else if (parse_keyword(p, end, "cstype")) {
+    state.curr_geom = geom_set_curve_type(
+        state.curr_geom, p, end, state.group_name, r_all_geometries);
+  }
+  else if (parse_keyword(p, end, "deg")) {
+    geom_set_curve_degree(state.curr_geom, p, end);
+  }
+  else if (parse_keyword(p, end, "curv")) {
+    geom_add_curve_vertex_indices(state.curr_geom, p, end, r_global_vertices);
+  }
+  else if (parse_keyword(p, end, "parm")) {
+    geom_add_curve_parameters(state.curr_geom, p, end);
+  }
+  else if (StringRef(p, end).startswith("end")) {
+    /* End of curve definition, nothing else to do. */
+  }
+  else {
+    std::cout << "OBJ element not recognized: '" << std::string(p, end) << "'" << std::endl;
+  }
+}
+
+/**
+ * Find the first line in the buffer that is longer than the given length, including its newline.
+ * Returns the offset of the start of that line, or -1 if all lines are short enough.
+ */
+static int64_t find_too_long_line(const StringRef buffer, const int64_t max_length)
+{
+  int64_t line_start = 0;
+  while (line_start < buffer.size()) {
+    const int64_t newline = buffer.find('\n', line_start);
+    const int64_t line_end = newline == StringRef::not_found ? buffer.size() : newline + 1;
+    if (line_end - line_start > max_length) {
+      return line_start;
+    }
+    line_start = line_end;
+  }
+  return -1;
+}
+
+void OBJParser::parse_buffer(StringRef buffer, ParseState &state)
+{
+  while (!buffer.is_empty()) {
+    const StringRef line = read_next_line(buffer);
+    ++state.line_number;
+    this->parse_line(line, state);
+  }
+}
+
+void OBJParser::parse_buffer_threaded(StringRef buffer, ParseState &state)
+{
+  /* Split the buffer at line boundaries into parts of roughly the serial read size. */
+  Vector<StringRef> parts;
+  while (!buffer.is_empty()) {
+    int64_t part_size = std::min<int64_t>(read_buffer_size_, buffer.size());
+    while (part_size < buffer.size() && buffer[part_size - 1] != '\n') {
+      part_size++;
+    }
+    parts.append(buffer.substr(0, part_size));
+    buffer = buffer.drop_prefix(part_size);
+  }
+
+  Array<ParsedChunk> chunks(parts.size());
+  threading::parallel_for(chunks.index_range(), 1, [&](const IndexRange range) {
+    for (const int i : range) {
+      chunks[i].parse(parts[i]);
+    }
+  });
+
+  /* Add the parsed data in file order, so that relative indices and parser state
+   * are handled exactly as when parsing serially. */
+  GlobalVertices &r_global_vertices = state.global_vertices;
+  for (const ParsedChunk &chunk : chunks) {
+    int vertex_i = 0;
+    int uv_i = 0;
+    int normal_i = 0;
+    int face_i = 0;
+    for (const ParsedChunk::LineRun &run : chunk.runs) {
+      switch (run.type) {
+        case ParsedChunk::LineType::Vertex: {
+          const IndexRange range(vertex_i, run.count);
+          if (chunk.vertex_colors.size() <= range.start()) {
+            r_global_vertices.vertices.extend(chunk.vertices.as_span().slice(range));
+          }
+          else {
+            for (const int i : range) {
+              r_global_vertices.vertices.append(chunk.vertices[i]);
+              if (i < chunk.vertex_colors.size() && chunk.vertex_colors[i].x >= 0.0f) {
+                geom_add_vertex_color(chunk.vertex_colors[i], r_global_vertices);
+              }
+            }
+          }
+          vertex_i += run.count;
+          break;
+        }
+        case ParsedChunk::LineType::UV:
+          r_global_vertices.uv_vertices.extend(chunk.uv_vertices.as_span().slice(uv_i, run.count));
+          uv_i += run.count;
+          break;
+        case ParsedChunk::LineType::Normal:
+          r_global_vertices.vert_normals.extend(
+              chunk.vert_normals.as_span().slice(normal_i, run.count));
+          normal_i += run.count;
+          break;
+        case ParsedChunk::LineType::Face:
+          for (const int i : IndexRange(face_i, run.count)) {
+            geom_add_face(state.curr_geom,
+                          chunk.face(i),
+                          r_global_vertices,
+                          state.material_name,
+                          state.material_index,
+                          state.group_index,
+                          state.shaded_smooth);
+          }
+          face_i += run.count;
+          break;
+        case ParsedChunk::LineType::Other:
+          this->parse_line(run.line, state);
+          break;
+      }
+    }
+    state.line_number += chunk.line_count;
+  }
+}
+
 void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
                       GlobalVertices &r_global_vertices)
 {
@@ -512,25 +932,30 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
   STRNCPY(ob_name, BLI_path_basename(import_params_.filepath));
   BLI_path_extension_strip(ob_name);
 
-  Geometry *curr_geom = create_geometry(nullptr, GEOM_MESH, ob_name, r_all_geometries);
+  ParseState state{r_all_geometries, r_global_vertices};
+  state.curr_geom = create_geometry(nullptr, GEOM_MESH, ob_name, r_all_geometries);
 
-  /* State variables: once set, they remain the same for the remaining
-   * elements in the object. */
-  bool state_shaded_smooth = false;
-  string state_group_name;
-  int state_group_index = -1;
-  string state_material_name;
-  int state_material_index = -1;
+  /* When parsing on multiple threads, read many chunks at once, so that there is enough work
+   * to distribute. Each thread still parses parts of roughly #read_buffer_size_. */
+  const size_t read_size = import_params_.use_threaded_parsing ?
+                               read_buffer_size_ * threaded_read_chunks_num :
+                               read_buffer_size_;
 
   /* Read the input file in chunks. We need up to twice the possible chunk size,
    * to possibly store remainder of the previous input line that got broken mid-chunk. */
-  Array<char> buffer(read_buffer_size_ * 2);
+  Array<char> buffer(read_size * 2);
+
+  auto report_too_long_line = [&]() {
+    fprintf(stderr,
+            "OBJ file contains a line #%zu that is too long (max. length %zu)\n",
+            state.line_number + 1,
+            read_buffer_size_);
+  };
 
   size_t buffer_offset = 0;
-  size_t line_number = 0;
   while (true) {
     /* Read a chunk of input from the file. */
-    size_t bytes_read = fread(buffer.data() + buffer_offset, 1, read_buffer_size_, obj_file_);
+    size_t bytes_read = fread(buffer.data() + buffer_offset, 1, read_size, obj_file_);
     if (bytes_read == 0 && buffer_offset == 0) {
       break; /* No more data to read. */
     }
@@ -541,7 +966,7 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
                              buffer.data() + buffer_offset + bytes_read);
 
     /* Ensure buffer ends in a newline. */
-    if (bytes_read < read_buffer_size_) {
+    if (bytes_read < read_size) {
       if (bytes_read == 0 || buffer[buffer_offset + bytes_read - 1] != '\n') {
         buffer[buffer_offset + bytes_read] = '\n';
         bytes_read++;
@@ -563,136 +988,32 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
     }
     if (buffer[last_nl] != '\n') {
       /* Whole line did not fit into our read buffer. Warn and exit. */
-      fprintf(stderr,
-              "OBJ file contains a line #%zu that is too long (max. length %zu)\n",
-              line_number,
-              read_buffer_size_);
+      report_too_long_line();
       break;
     }
     ++last_nl;
 
+    /* Lines have to fit into the read buffer of the serial parser. Whether a longer line fits
+     * into the buffer depends on where it starts in it, and the threaded parser reads much more
+     * at once, so check the limit explicitly to get the same result in both cases. */
+    StringRef buffer_str{buffer.data(), int64_t(last_nl)};
+    const int64_t too_long_line_start = find_too_long_line(buffer_str, read_buffer_size_);
+    if (too_long_line_start != -1) {
+      buffer_str = buffer_str.substr(0, too_long_line_start);
+    }
+
     /* Parse the buffer (until last newline) that we have so far,
      * line by line. */
-    StringRef buffer_str{buffer.data(), int64_t(last_nl)};
-    while (!buffer_str.is_empty()) {
-      StringRef line = read_next_line(buffer_str);
-      const char *p = line.begin(), *end = line.end();
-      p = drop_whitespace(p, end);
-      ++line_number;
-      if (p == end) {
-        continue;
-      }
-      /* Most common things that start with 'v': vertices, normals, UVs. */
-      if (*p == 'v') {
-        if (parse_keyword(p, end, "v")) {
-          geom_add_vertex(p, end, r_global_vertices);
-        }
-        else if (parse_keyword(p, end, "vn")) {
-          geom_add_vertex_normal(p, end, r_global_vertices);
-        }
-        else if (parse_keyword(p, end, "vt")) {
-          geom_add_uv_vertex(p, end, r_global_vertices);
-        }
-      }
-      /* Faces. */
-      else if (parse_keyword(p, end, "f")) {
-        /* If we don't have a material index assigned yet, get one.
-         * It means "usemtl" state came from the previous object. */
-        if (state_material_index == -1 && !state_material_name.empty() &&
-            curr_geom->material_indices_.is_empty())
-        {
-          curr_geom->material_indices_.add_new(state_material_name, 0);
-          curr_geom->material_order_.append(state_material_name);
-          state_material_index = 0;
-        }
+    if (import_params_.use_threaded_parsing) {
+      this->parse_buffer_threaded(buffer_str, state);
+    }
+    else {
+      this->parse_buffer(buffer_str, state);
+    }
 
-        geom_add_polygon(curr_geom,
-                         p,
-                         end,
-                         r_global_vertices,
-                         state_material_index,
-                         state_group_index,
-                         state_shaded_smooth);
-      }
-      /* Faces. */
-      else if (parse_keyword(p, end, "l")) {
-        geom_add_polyline(curr_geom, p, end, r_global_vertices);
-      }
-      /* Objects. */
-      else if (parse_keyword(p, end, "o")) {
-        if (import_params_.use_split_objects) {
-          geom_new_object(p,
-                          end,
-                          state_shaded_smooth,
-                          state_group_name,
-                          state_material_index,
-                          curr_geom,
-                          r_all_geometries);
-        }
-      }
-      /* Groups. */
-      else if (parse_keyword(p, end, "g")) {
-        if (import_params_.use_split_groups) {
-          geom_new_object(p,
-                          end,
-                          state_shaded_smooth,
-                          state_group_name,
-                          state_material_index,
-                          curr_geom,
-                          r_all_geometries);
-        }
-        else {
-          geom_update_group(StringRef(p, end).trim(), state_group_name);
-          int new_index = curr_geom->group_indices_.size();
-          state_group_index = curr_geom->group_indices_.lookup_or_add(state_group_name, new_index);
-          if (new_index == state_group_index) {
-            curr_geom->group_order_.append(state_group_name);
-          }
-        }
-      }
-      /* Smoothing groups. */
-      else if (parse_keyword(p, end, "s")) {
-        geom_update_smooth_group(p, end, state_shaded_smooth);
-      }
-      /* Materials and their libraries. */
-      else if (parse_keyword(p, end, "usemtl")) {
-        state_material_name = StringRef(p, end).trim();
-        int new_mat_index = curr_geom->material_indices_.size();
-        state_material_index = curr_geom->material_indices_.lookup_or_add(state_material_name,
-                                                                          new_mat_index);
-        if (new_mat_index == state_material_index) {
-          curr_geom->material_order_.append(state_material_name);
-        }
-      }
-      else if (parse_keyword(p, end, "mtllib")) {
-        add_mtl_library(StringRef(p, end).trim());
-      }
-      else if (parse_keyword(p, end, "#MRGB")) {
-        geom_add_mrgb_colors(p, end, r_global_vertices);
-      }
-      /* Comments. */
-      else if (*p == '#') {
-        /* Nothing to do. */
-      }
-      /* Curve related things. */
-      else if (parse_keyword(p, end, "cstype")) {
-        curr_geom = geom_set_curve_type(curr_geom, p, end, state_group_name, r_all_geometries);
-      }
-      else if (parse_keyword(p, end, "deg")) {
-        geom_set_curve_degree(curr_geom, p, end);
-      }
-      else if (parse_keyword(p, end, "curv")) {
-        geom_add_curve_vertex_indices(curr_geom, p, end, r_global_vertices);
-      }
-      else if (parse_keyword(p, end, "parm")) {
-        geom_add_curve_parameters(curr_geom, p, end);
-      }
-      else if (StringRef(p, end).startswith("end")) {
-        /* End of curve definition, nothing else to do. */
-      }
-      else {
-        std::cout << "OBJ element not recognized: '" << std::string(p, end) << "'" << std::endl;
-      }
+    if (too_long_line_start != -1) {
+      report_too_long_line();
+      break;
     }
 
     /* We might have a line that was cut in the middle by the previous buffer;
@@ -702,7 +1023,7 @@ void OBJParser::parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
     buffer_offset = left_size;
   }
 
-  use_all_vertices_if_no_faces(curr_geom, r_all_geometries, r_global_vertices);
+  use_all_vertices_if_no_faces(state.curr_geom, r_all_geometries, r_global_vertices);
   add_default_mtl_library();
 }
 
@@ -28,6 +28,8 @@ class OBJParser {
   Vector<std::string> mtl_libraries_;
   size_t read_buffer_size_;
 
+  struct ParseState;
+
  public:
   /**
    * Open OBJ file at the path given in import parameters.
@@ -38,6 +40,13 @@ class OBJParser {
   /**
    * Read the OBJ file line by line and create OBJ Geometry instances. Also store all the vertex
    * and UV vertex coordinates in a struct accessible by all objects.
+   *
+   * When #OBJImportParams::use_threaded_parsing is set, larger parts of the file are read at
+   * once, split at line boundaries and pre-parsed on multiple threads; the result is identical
+   * to parsing the file serially.
+   *
+   * Lines longer than the read buffer size are not supported. Parsing stops at the first such
+   * line in both modes.
    */
   void parse(Vector<std::unique_ptr<Geometry>> &r_all_geometries,
              GlobalVertices &r_global_vertices);
@@ -47,6 +56,9 @@ class OBJParser {
   Span<std::string> mtl_libraries() const;
 
  private:
+  void parse_line(StringRef line, ParseState &state);
+  void parse_buffer(StringRef buffer, ParseState &state);
+  void parse_buffer_threaded(StringRef buffer, ParseState &state);
   void add_mtl_library(StringRef path);
   void add_default_mtl_library();
 };
@@ -2,6 +2,7 @@
  *
  * SPDX-License-Identifier: Apache-2.0 */
 
+#include <atomic>
 #include <gtest/gtest.h>
 #include <ios>
 #include <memory>
@@ -19,6 +20,7 @@
 #include "BLI_index_range.hh"
 #include "BLI_string.h"
 #include "BLI_string_utf8.h"
+#include "BLI_task.hh"
 #include "BLI_vector.hh"
 
 #include "BLO_readfile.hh"
@@ -211,6 +213,51 @@ TEST_F(ObjExporterWriterTest, mtllib)
   ASSERT_EQ(result, "mtllib blah.mtl\nmtllib blah.mtl\n");
 }
 
+TEST_F(ObjExporterWriterTest, ordered_block_writer)
+{
+  const int slots_num = 40;
+  const size_t max_pending_size = 64;
+  std::string out_file_path = get_temp_obj_filename();
+  std::string expected;
+  for (const int i : IndexRange(slots_num)) {
+    for (const int j : IndexRange(i % 7 * 5)) {
+      expected += "o object" + std::to_string(i) + "_" + std::to_string(j) + "\n";
+    }
+  }
+  size_t max_reached_pending_size = 0;
+  {
+    OBJExportParamsDefault _export;
+    std::unique_ptr<OBJWriter> writer = init_writer(_export.params, out_file_path);
+    if (!writer) {
+      ADD_FAILURE();
+      return;
+    }
+    OrderedBlockWriter block_writer(writer->get_outfile(), slots_num, max_pending_size);
+    std::atomic<int> next_slot = 0;
+    threading::parallel_for(IndexRange(slots_num), 1, [&](IndexRange range) {
+      for ([[maybe_unused]] const int iter : range) {
+        const int i = next_slot.fetch_add(1);
+        /* Use a tiny buffer chunk size, so that every slot adds several blocks. */
+        FormatHandler fh(16);
+        fh.set_full_block_fn([&](FormatHandler::VectorChar &&block) {
+          block_writer.add_block(i, std::move(block));
+        });
+        for (const int j : IndexRange(i % 7 * 5)) {
+          fh.write_obj_object("object" + std::to_string(i) + "_" + std::to_string(j));
+        }
+        fh.flush_blocks();
+        block_writer.finish_slot(i);
+      }
+    });
+    block_writer.finish();
+    max_reached_pending_size = block_writer.max_reached_pending_size();
+  }
+  const std::string result = read_temp_file_in_string(out_file_path);
+  ASSERT_EQ(result, expected);
+  /* The limit can be exceeded by one block, which holds a single line here. */
+  EXPECT_LE(max_reached_pending_size, max_pending_size + 16);
+}
+
 TEST(obj_exporter_writer, format_handler_buffer_chunking)
 {
   /* Use a tiny buffer chunk size, so that the test below ends up creating several blocks. */
@@ -7,6 +7,7 @@
 #include "testing/testing.h"
 #include "tests/blendfile_loading_base_test.h"
 
+#include "BKE_appdir.hh"
 #include "BKE_curve.hh"
 #include "BKE_customdata.hh"
 #include "BKE_main.hh"
@@ -15,10 +16,12 @@
 #include "BKE_object.hh"
 #include "BKE_scene.hh"
 
+#include "BLI_fileops.h"
 #include "BLI_listbase.h"
 #include "BLI_math_base.hh"
 #include "BLI_math_vector_types.hh"
 #include "BLI_string.h"
+#include "BLI_timeit.hh"
 
 #include "BLO_readfile.hh"
 
@@ -33,6 +36,7 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "obj_import_file_reader.hh"
 #include "obj_importer.hh"
 
 namespace blender::io::obj {
@@ -926,4 +930,209 @@ TEST_F(OBJImportTest, import_polylines)
   import_and_check("polylines.obj", expect, std::size(expect), 0);
 }
 
+/**
+ * Write an OBJ file with many objects, so that the parser state (objects, groups, materials,
+ * relative indices, vertex colors) has to carry over between the parts that are parsed on
+ * different threads.
+ */
+static std::string write_synthetic_obj(const char *filename, const int objects_num, const int size)
+{
+  BKE_tempdir_init(nullptr);
+  const std::string filepath = std::string(BKE_tempdir_base()) + filename;
+  FILE *file = BLI_fopen(filepath.c_str(), "wb");
+  if (file == nullptr) {
+    return "";
+  }
+  fprintf(file, "# Synthetic OBJ file\nmtllib synthetic.mtl\n");
+  int verts_num = 0;
+  for (int ob = 0; ob < objects_num; ob++) {
+    fprintf(file, "o Object%d\n", ob);
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        if (ob % 3 == 1) {
+          fprintf(file, "v %d %d %g %g 0.5 1\n", x, y, ob * 0.5f, x / float(size));
+        }
+        else {
+          fprintf(file, "v %d %d %g\n", x, y, ob * 0.5f);
+        }
+        fprintf(file, "vt %g %g\nvn 0 0 %d\n", x / float(size), y / float(size), ob % 2 ? 1 : -1);
+      }
+    }
+    fprintf(file, "usemtl Material%d\ns %d\ng Group%d\n", ob % 3, ob % 2, ob % 4);
+    for (int y = 0; y < size - 1; y++) {
+      for (int x = 0; x < size - 1; x++) {
+        int i1 = y * size + x, i2 = i1 + 1, i3 = i2 + size, i4 = i1 + size;
+        if (ob % 2 == 0) {
+          /* Absolute (one-based) indices. */
+          i1 += verts_num + 1;
+          i2 += verts_num + 1;
+          i3 += verts_num + 1;
+          i4 += verts_num + 1;
+        }
+        else {
+          /* Relative indices. */
+          i1 -= size * size;
+          i2 -= size * size;
+          i3 -= size * size;
+          i4 -= size * size;
+        }
+        fprintf(file, "f %d/%d/%d %d/%d %d//%d %d\n", i1, i1, i1, i2, i2, i3, i3, i4);
+      }
+    }
+    fprintf(file, "l %d %d %d\n", verts_num + 1, verts_num + 2, verts_num + 3);
+    fprintf(file, "f 1 2 999999999\n");
+    verts_num += size * size;
+  }
+  fclose(file);
+  return filepath;
+}
+
+static void parse_obj(const std::string &filepath,
+                      const bool use_threaded_parsing,
+                      const size_t read_buffer_size,
+                      Vector<std::unique_ptr<Geometry>> &r_all_geometries,
+                      GlobalVertices &r_global_vertices)
+{
+  OBJImportParams params;
+  STRNCPY(params.filepath, filepath.c_str());
+  params.use_threaded_parsing = use_threaded_parsing;
+  OBJParser parser{params, read_buffer_size};
+  parser.parse(r_all_geometries, r_global_vertices);
+}
+
+static void expect_parse_results_equal(const Span<std::unique_ptr<Geometry>> geometries_a,
+                                       const GlobalVertices &vertices_a,
+                                       const Span<std::unique_ptr<Geometry>> geometries_b,
+                                       const GlobalVertices &vertices_b)
+{
+  EXPECT_EQ(vertices_a.vertices, vertices_b.vertices);
+  EXPECT_EQ(vertices_a.uv_vertices, vertices_b.uv_vertices);
+  EXPECT_EQ(vertices_a.vert_normals, vertices_b.vert_normals);
+  ASSERT_EQ(vertices_a.vertex_colors.size(), vertices_b.vertex_colors.size());
+  for (const int i : vertices_a.vertex_colors.index_range()) {
+    EXPECT_EQ(vertices_a.vertex_colors[i].start_vertex_index,
+              vertices_b.vertex_colors[i].start_vertex_index);
+    EXPECT_EQ(vertices_a.vertex_colors[i].colors, vertices_b.vertex_colors[i].colors);
+  }
+
+  ASSERT_EQ(geometries_a.size(), geometries_b.size());
+  for (const int i : geometries_a.index_range()) {
+    const Geometry &a = *geometries_a[i];
+    const Geometry &b = *geometries_b[i];
+    EXPECT_EQ(a.geom_type_, b.geom_type_);
+    EXPECT_EQ(a.geometry_name_, b.geometry_name_);
+    EXPECT_EQ(a.group_order_, b.group_order_);
+    EXPECT_EQ(a.material_order_, b.material_order_);
+    EXPECT_EQ(a.vertex_index_min_, b.vertex_index_min_);
+    EXPECT_EQ(a.vertex_index_max_, b.vertex_index_max_);
+    EXPECT_EQ(a.get_vertex_count(), b.get_vertex_count());
+    EXPECT_EQ(a.edges_, b.edges_);
+    EXPECT_EQ(a.has_invalid_faces_, b.has_invalid_faces_);
+    EXPECT_EQ(a.has_vertex_groups_, b.has_vertex_groups_);
+    EXPECT_EQ(a.total_corner_, b.total_corner_);
+    ASSERT_EQ(a.face_corners_.size(), b.face_corners_.size());
+    for (const int corner : a.face_corners_.index_range()) {
+      EXPECT_EQ(a.face_corners_[corner].vert_index, b.face_corners_[corner].vert_index);
+      EXPECT_EQ(a.face_corners_[corner].uv_vert_index, b.face_corners_[corner].uv_vert_index);
+      EXPECT_EQ(a.face_corners_[corner].vertex_normal_index,
+                b.face_corners_[corner].vertex_normal_index);
+    }
+    ASSERT_EQ(a.face_elements_.size(), b.face_elements_.size());
+    for (const int face : a.face_elements_.index_range()) {
+      EXPECT_EQ(a.face_elements_[face].vertex_group_index,
+                b.face_elements_[face].vertex_group_index);
+      EXPECT_EQ(a.face_elements_[face].material_index, b.face_elements_[face].material_index);
+      EXPECT_EQ(a.face_elements_[face].shaded_smooth, b.face_elements_[face].shaded_smooth);
+      EXPECT_EQ(a.face_elements_[face].start_index_, b.face_elements_[face].start_index_);
+      EXPECT_EQ(a.face_elements_[face].corner_count_, b.face_elements_[face].corner_count_);
+    }
+  }
+}
+
+TEST(obj_import_parser, threaded_parsing_matches_serial)
+{
+  const std::string filepath = write_synthetic_obj("obj_parse_threaded.obj", 40, 12);
+  ASSERT_FALSE(filepath.empty());
+
+  Vector<std::unique_ptr<Geometry>> serial_geometries;
+  GlobalVertices serial_vertices;
+  parse_obj(filepath, false, 650, serial_geometries, serial_vertices);
+
+  /* Small read buffers result in many parts per read, and in lines broken between reads. */
+  for (const size_t read_buffer_size : {650, 4096}) {
+    Vector<std::unique_ptr<Geometry>> threaded_geometries;
+    GlobalVertices threaded_vertices;
+    parse_obj(filepath, true, read_buffer_size, threaded_geometries, threaded_vertices);
+    expect_parse_results_equal(
+        serial_geometries, serial_vertices, threaded_geometries, threaded_vertices);
+  }
+
+  BLI_delete(filepath.c_str(), false, false);
+}
+
+TEST(obj_import_parser, too_long_line)
+{
+  BKE_tempdir_init(nullptr);
+  const std::string filepath = std::string(BKE_tempdir_base()) + "obj_parse_long_line.obj";
+  const size_t read_buffer_size = 650;
+
+  /* Move the long line through different positions in the read buffer. Whether a line longer
+   * than the buffer happens to fit depends on that position, but it is never parsed. */
+  for (const int verts_before : {0, 1, 30, 45, 100}) {
+    for (const int line_length : {649, 650, 651, 900, 1400}) {
+      FILE *file = BLI_fopen(filepath.c_str(), "wb");
+      ASSERT_NE(file, nullptr);
+      for (int i = 0; i < verts_before; i++) {
+        fprintf(file, "v %d 0 0\n", i);
+      }
+      /* The line length includes the newline. */
+      fprintf(file, "#%s\n", std::string(line_length - 2, 'x').c_str());
+      for (int i = 0; i < 10; i++) {
+        fprintf(file, "v 0 %d 0\n", i);
+      }
+      fclose(file);
+
+      Vector<std::unique_ptr<Geometry>> serial_geometries;
+      GlobalVertices serial_vertices;
+      parse_obj(filepath, false, read_buffer_size, serial_geometries, serial_vertices);
+      const int expected_verts_num = size_t(line_length) <= read_buffer_size ? verts_before + 10 :
+                                                                       verts_before;
+      EXPECT_EQ(serial_vertices.vertices.size(), expected_verts_num);
+
+      Vector<std::unique_ptr<Geometry>> threaded_geometries;
+      GlobalVertices threaded_vertices;
+      parse_obj(filepath, true, read_buffer_size, threaded_geometries, threaded_vertices);
+      expect_parse_results_equal(
+          serial_geometries, serial_vertices, threaded_geometries, threaded_vertices);
+    }
+  }
+
+  BLI_delete(filepath.c_str(), false, false);
+}
+
+/**
+ * Set this to 1 to activate the benchmark. It is disabled by default, because it writes a large
+ * file to the temporary directory.
+ */
+#if 0
+TEST(obj_import_parser, parse_throughput_benchmark)
+{
+  const std::string filepath = write_synthetic_obj("obj_parse_benchmark.obj", 16, 700);
+  ASSERT_FALSE(filepath.empty());
+  std::cout << "File size: " << BLI_file_size(filepath.c_str()) / (1024 * 1024) << " MB\n";
+
+  for (const bool use_threaded_parsing : {false, true}) {
+    Vector<std::unique_ptr<Geometry>> geometries;
+    GlobalVertices vertices;
+    {
+      SCOPED_TIMER(use_threaded_parsing ? "Threaded parse" : "Serial parse");
+      parse_obj(filepath, use_threaded_parsing, 256 * 1024, geometries, vertices);
+    }
+    std::cout << "Vertices: " << vertices.vertices.size() << "\n";
+  }
+
+  BLI_delete(filepath.c_str(), false, false);
+}
+#endif
+
 }  // namespace blender::io::obj
@@ -2466,7 +2466,11 @@ typedef struct NodesModifierData {
   int bakes_num;
   NodesModifierBake *bakes;
 
-  char _pad2[4];
+  /**
+   * Memory in megabytes that may be used to keep outputs of expensive nodes between evaluations.
+   * Zero disables the cache.
+   */
+  int node_cache_limit;
   int panels_num;
   NodesModifierPanel *panels;
 
@@ -378,7 +378,7 @@ static void rna_Collection_flag_update(Main *bmain, Scene *scene, PointerRNA *pt
   BKE_main_collection_sync(bmain);
 
   DEG_id_tag_update(&collection->id, ID_RECALC_SYNC_TO_EVAL);
-  DEG_relations_tag_update(bmain);
+  DEG_relations_tag_visibility_update(bmain);
   WM_main_add_notifier(NC_SCENE | ND_OB_SELECT, scene);
 }
 
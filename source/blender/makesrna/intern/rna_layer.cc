@@ -336,7 +336,7 @@ static void rna_LayerCollection_exclude_update(Main *bmain, Scene * /*scene*/, P
     FOREACH_OBJECT_END;
   }
 
-  DEG_relations_tag_update(bmain);
+  DEG_relations_tag_visibility_update(bmain);
   WM_main_add_notifier(NC_SCENE | ND_LAYER_CONTENT, nullptr);
   if (exclude) {
     blender::ed::object::base_active_refresh(bmain, scene, view_layer);
@@ -7888,6 +7888,16 @@ static void rna_def_modifier_nodes(BlenderRNA *brna)
       prop, "Simulation Bake Directory", "Location on disk where the bake data is stored");
   RNA_def_property_update(prop, 0, nullptr);
 
+  prop = RNA_def_property(srna, "node_cache_limit", PROP_INT, PROP_NONE);
+  RNA_def_property_range(prop, 0, INT_MAX);
+  RNA_def_property_ui_range(prop, 0, 16384, 64, -1);
+  RNA_def_property_ui_text(prop,
+                           "Node Cache Limit",
+                           "Memory in megabytes used to keep the outputs of expensive nodes "
+                           "between evaluations, so that they are not recomputed when their "
+                           "inputs did not change (zero to disable)");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
   prop = RNA_def_property(srna, "bakes", PROP_COLLECTION, PROP_NONE);
   RNA_def_property_struct_type(prop, "NodesModifierBake");
   RNA_def_property_collection_sdna(prop, nullptr, "bakes", "bakes_num");
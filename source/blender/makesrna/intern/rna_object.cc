@@ -372,7 +372,7 @@ static void rna_Object_hide_update(Main *bmain, Scene * /*scene*/, PointerRNA *p
   Object *ob = reinterpret_cast<Object *>(ptr->owner_id);
   BKE_main_collection_sync_remap(bmain);
   DEG_id_tag_update(&ob->id, ID_RECALC_SYNC_TO_EVAL);
-  DEG_relations_tag_update(bmain);
+  DEG_relations_tag_visibility_update(bmain);
   WM_main_add_notifier(NC_OBJECT | ND_DRAW, &ob->id);
 }
 
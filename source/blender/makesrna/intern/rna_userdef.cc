@@ -7475,6 +7475,16 @@ static void rna_def_userdef_experimental(BlenderRNA *brna)
                            "Interactive Editor Docking",
                            "Move editor areas to new locations, including between windows");
   RNA_def_property_update(prop, 0, "rna_userdef_update");
+
+  prop = RNA_def_property(srna, "use_parallel_file_read", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_ui_text(prop,
+                           "Multi-Threaded File Reading",
+                           "Read the data of data-blocks on multiple threads when opening files");
+
+  prop = RNA_def_property(srna, "use_parallel_file_write", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_ui_text(prop,
+                           "Multi-Threaded File Writing",
+                           "Write the data of data-blocks on multiple threads when saving files");
 }
 
 static void rna_def_userdef_addon_collection(BlenderRNA *brna, PropertyRNA *cprop)
@@ -13,6 +13,9 @@ struct ModifierCache;
 namespace blender::nodes::geo_eval_log {
 class GeoModifierLog;
 }
+namespace blender::nodes {
+class NodeOutputCache;
+}
 
 /**
  * Rebuild the list of properties based on the sockets exposed as the modifier's node group
@@ -37,6 +40,12 @@ struct NodesModifierRuntime {
    * used by the evaluated modifier.
    */
   std::shared_ptr<bke::bake::ModifierCache> cache;
+  /**
+   * Outputs of expensive nodes from previous evaluations. This is shared between the original and
+   * evaluated modifiers like the simulation cache, so that it survives copying the evaluated
+   * modifier when a parameter changes.
+   */
+  std::shared_ptr<nodes::NodeOutputCache> node_output_cache;
 };
 
 void nodes_modifier_data_block_destruct(NodesModifierDataBlock *data_block, bool do_id_user);
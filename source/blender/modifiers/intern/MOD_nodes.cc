@@ -93,6 +93,7 @@
 #include "NOD_geometry_nodes_execute.hh"
 #include "NOD_geometry_nodes_gizmos.hh"
 #include "NOD_geometry_nodes_lazy_function.hh"
+#include "NOD_geometry_nodes_output_cache.hh"
 #include "NOD_node_declaration.hh"
 
 #include "FN_field.hh"
@@ -115,6 +116,7 @@ static void init_data(ModifierData *md)
   MEMCPY_STRUCT_AFTER(nmd, DNA_struct_default_get(NodesModifierData), modifier);
   nmd->runtime = MEM_new<NodesModifierRuntime>(__func__);
   nmd->runtime->cache = std::make_shared<bake::ModifierCache>();
+  nmd->runtime->node_output_cache = std::make_shared<nodes::NodeOutputCache>();
 }
 
 static void find_used_ids_from_settings(const NodesModifierSettings &settings, Set<ID *> &ids)
@@ -1731,6 +1733,13 @@ static void modifyGeometry(ModifierData *md,
   nodes::GeoNodesModifierData modifier_eval_data{};
   modifier_eval_data.depsgraph = ctx->depsgraph;
   modifier_eval_data.self_object = ctx->object;
+  if (nodes::NodeOutputCache *node_output_cache = nmd->runtime->node_output_cache.get()) {
+    const int64_t limit = int64_t(nmd->node_cache_limit) * 1024 * 1024;
+    node_output_cache->set_memory_limit(limit);
+    if (limit > 0) {
+      modifier_eval_data.node_output_cache = node_output_cache;
+    }
+  }
   auto eval_log = std::make_unique<geo_log::GeoModifierLog>();
   call_data.modifier_data = &modifier_eval_data;
 
@@ -2228,6 +2237,7 @@ static void draw_bake_panel(uiLayout *layout, PointerRNA *modifier_ptr)
   uiLayoutSetPropSep(col, true);
   uiLayoutSetPropDecorate(col, false);
   uiItemR(col, modifier_ptr, "bake_directory", UI_ITEM_NONE, IFACE_("Bake Path"), ICON_NONE);
+  uiItemR(col, modifier_ptr, "node_cache_limit", UI_ITEM_NONE, IFACE_("Node Cache"), ICON_NONE);
 }
 
 static void draw_named_attributes_panel(uiLayout *layout, NodesModifierData &nmd)
@@ -2462,6 +2472,7 @@ static void blend_read(BlendDataReader *reader, ModifierData *md)
 
   nmd->runtime = MEM_new<NodesModifierRuntime>(__func__);
   nmd->runtime->cache = std::make_shared<bake::ModifierCache>();
+  nmd->runtime->node_output_cache = std::make_shared<nodes::NodeOutputCache>();
 }
 
 static void copy_data(const ModifierData *md, ModifierData *target, const int flag)
@@ -2502,11 +2513,13 @@ static void copy_data(const ModifierData *md, ModifierData *target, const int fl
   if (flag & LIB_ID_COPY_SET_COPIED_ON_WRITE) {
     /* Share the simulation cache between the original and evaluated modifier. */
     tnmd->runtime->cache = nmd->runtime->cache;
+    tnmd->runtime->node_output_cache = nmd->runtime->node_output_cache;
     /* Keep bake path in the evaluated modifier. */
     tnmd->bake_directory = nmd->bake_directory ? BLI_strdup(nmd->bake_directory) : nullptr;
   }
   else {
     tnmd->runtime->cache = std::make_shared<bake::ModifierCache>();
+    tnmd->runtime->node_output_cache = std::make_shared<nodes::NodeOutputCache>();
     /* Clear the bake path when duplicating. */
     tnmd->bake_directory = nullptr;
   }
@@ -43,6 +43,8 @@ namespace blender::nodes {
 using lf::LazyFunction;
 using mf::MultiFunction;
 
+class NodeOutputCache;
+
 /** The structs in here describe the different possible behaviors of a simulation input node. */
 namespace sim_input {
 
@@ -164,6 +166,8 @@ struct GeoNodesModifierData {
   const Object *self_object = nullptr;
   /** Depsgraph that is evaluating the modifier. */
   Depsgraph *depsgraph = nullptr;
+  /** Optional cache for outputs of expensive nodes that is kept between evaluations. */
+  NodeOutputCache *node_output_cache = nullptr;
 };
 
 struct GeoNodesOperatorDepsgraphs {
@@ -207,6 +207,11 @@ class GeoTreeLogger {
     TimePoint start;
     TimePoint end;
   };
+  struct NodeOverhead {
+    int32_t node_id;
+    /** Time spent by the evaluator on the node besides executing it. */
+    std::chrono::nanoseconds duration;
+  };
   struct ViewerNodeLogWithNode {
     int32_t node_id;
     destruct_ptr<ViewerNodeLog> viewer_log;
@@ -228,6 +233,7 @@ class GeoTreeLogger {
   linear_allocator::ChunkedList<SocketValueLog, 16> input_socket_values;
   linear_allocator::ChunkedList<SocketValueLog, 16> output_socket_values;
   linear_allocator::ChunkedList<NodeExecutionTime, 16> node_execution_times;
+  linear_allocator::ChunkedList<NodeOverhead, 16> node_overheads;
   linear_allocator::ChunkedList<ViewerNodeLogWithNode> viewer_node_logs;
   linear_allocator::ChunkedList<AttributeUsageWithNode> used_named_attributes;
   linear_allocator::ChunkedList<DebugMessage> debug_messages;
@@ -258,6 +264,11 @@ class GeoNodeLog {
    * inside.
    */
   std::chrono::nanoseconds run_time{0};
+  /**
+   * Time the evaluator spent on scheduling this node and passing values to and from it. This is
+   * not included in #run_time.
+   */
+  std::chrono::nanoseconds overhead{0};
   /** Maps from socket indices to their values. */
   Map<int, ValueLog *> input_values_;
   Map<int, ValueLog *> output_values_;
@@ -298,6 +309,7 @@ class GeoTreeLog {
   Map<int32_t, ViewerNodeLog *, 0> viewer_node_logs;
   Vector<NodeWarning> all_warnings;
   std::chrono::nanoseconds run_time_sum{0};
+  std::chrono::nanoseconds overhead_sum{0};
   Vector<const GeometryAttributeInfo *> existing_attributes;
   Map<StringRefNull, NamedAttributeUsage> used_named_attributes;
   Set<int> evaluated_gizmo_nodes;
@@ -0,0 +1,114 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#pragma once
+
+/**
+ * The output cache keeps the outputs of expensive geometry nodes around between evaluations of
+ * the same modifier. When a node is evaluated again with the same inputs, e.g. when scattering
+ * points on a terrain that did not change, the outputs are copied from the cache instead of
+ * executing the node again. This mainly helps when changing the frame or when tweaking parameters
+ * that only affect other parts of the node tree.
+ *
+ * Inputs are compared without looking at the actual data. Geometries are considered equal when
+ * they share the same attribute arrays, which is the case when they were passed through without
+ * modification or when they come from an evaluated object that did not change. Values are only
+ * compared when they are single values, inputs that are fields that depend on the context disable
+ * the cache for the node.
+ */
+
+#include <memory>
+#include <mutex>
+#include <optional>
+
+#include "BLI_compute_context.hh"
+#include "BLI_cpp_type.hh"
+#include "BLI_generic_pointer.hh"
+#include "BLI_map.hh"
+
+namespace blender::nodes {
+
+class NodeOutputCache : NonCopyable, NonMovable {
+ public:
+  struct Key {
+    /** Context the node is evaluated in, e.g. the node group it is in. */
+    ComputeContextHash context_hash;
+    /** #bNode::identifier. */
+    int32_t node_id;
+
+    uint64_t hash() const
+    {
+      return get_default_hash(context_hash, node_id);
+    }
+
+    BLI_STRUCT_EQUALITY_OPERATORS_2(Key, context_hash, node_id)
+  };
+
+  struct Entry;
+
+ private:
+  std::mutex mutex_;
+  Map<Key, std::unique_ptr<Entry>> entries_;
+  /** Approximate number of bytes used by the cached outputs. */
+  int64_t memory_ = 0;
+  int64_t memory_limit_ = 0;
+  /** Incremented on every cache access, used to find the least recently used entries. */
+  uint64_t clock_ = 0;
+
+ public:
+  NodeOutputCache();
+  ~NodeOutputCache();
+
+  /** Free cached outputs until the given number of bytes is not exceeded anymore. */
+  void set_memory_limit(int64_t limit);
+  void clear();
+
+  /** True if values of this type can be inputs or outputs of cached nodes. */
+  static bool is_supported_type(const CPPType &type);
+
+  /**
+   * Copy the cached outputs into the given uninitialized buffers if the node has been evaluated
+   * with the same inputs before. Outputs that are not needed are null.
+   *
+   * \param version: Identifies the lazy-function the node was executed with. This changes when
+   * the node tree changes, so that changed node properties invalidate the cache.
+   * \return False if there are no cached outputs for the inputs, in which case the output buffers
+   * are not initialized.
+   */
+  bool try_load(const Key &key,
+                uint64_t version,
+                Span<GPointer> inputs,
+                Span<void *> r_outputs);
+
+  /**
+   * Copies of the inputs a node is executed with. They have to be taken before the node is
+   * executed, because nodes generally move their inputs out of the parameters.
+   */
+  class InputValues : NonCopyable {
+    friend NodeOutputCache;
+    std::unique_ptr<Entry> entry_;
+
+   public:
+    InputValues(std::unique_ptr<Entry> entry);
+    InputValues(InputValues &&other);
+    ~InputValues();
+  };
+
+  /**
+   * Copy the inputs so that they can be stored together with the outputs later on.
+   * \return None if the inputs can't be cached or the cache is disabled.
+   */
+  std::optional<InputValues> snapshot_inputs(uint64_t version, Span<GPointer> inputs);
+
+  /**
+   * Remember the outputs computed by the node for the inputs taken with #snapshot_inputs before.
+   * Outputs that have not been computed have a null data pointer.
+   */
+  void store(const Key &key, InputValues inputs, Span<GPointer> outputs);
+
+ private:
+  void free_until_below_limit(int64_t limit);
+};
+
+}  // namespace blender::nodes
@@ -22,6 +22,7 @@
 
 #include "NOD_geometry_exec.hh"
 #include "NOD_geometry_nodes_lazy_function.hh"
+#include "NOD_geometry_nodes_output_cache.hh"
 #include "NOD_multi_function.hh"
 #include "NOD_node_declaration.hh"
 
@@ -163,6 +164,10 @@ class LazyFunctionForGeometryNode : public LazyFunction {
    * does not have to execute.
    */
   Vector<bool> is_attribute_output_bsocket_;
+  /** True if the outputs of the node may be kept in a #NodeOutputCache. */
+  bool use_output_cache_ = false;
+  /** Identifies this function in the #NodeOutputCache, changes when the node tree changes. */
+  uint64_t output_cache_version_ = 0;
 
   struct OutputAttributeID {
     int bsocket_index;
@@ -185,6 +190,22 @@ class LazyFunctionForGeometryNode : public LazyFunction {
     lazy_function_interface_from_node(
         node, inputs_, outputs_, own_lf_graph_info.mapping.lf_index_by_bsocket);
 
+    if (node_supports_output_cache(node)) {
+      static std::atomic<uint64_t> output_cache_version_counter = 0;
+      output_cache_version_ = output_cache_version_counter.fetch_add(1) + 1;
+      use_output_cache_ = std::all_of(
+                              inputs_.begin(),
+                              inputs_.end(),
+                              [](const lf::Input &input) {
+                                return NodeOutputCache::is_supported_type(*input.type);
+                              }) &&
+                          std::all_of(outputs_.begin(),
+                                      outputs_.end(),
+                                      [](const lf::Output &output) {
+                                        return NodeOutputCache::is_supported_type(*output.type);
+                                      });
+    }
+
     const NodeDeclaration &node_decl = *node.declaration();
     const aal::RelationsInNode *relations = node_decl.anonymous_attribute_relations();
     if (relations == nullptr) {
@@ -236,6 +257,23 @@ class LazyFunctionForGeometryNode : public LazyFunction {
     std::destroy_at(s);
   }
 
+  /**
+   * Only nodes that are expensive to evaluate and whose outputs only depend on their inputs and
+   * the node settings use the output cache. Other nodes would mostly add overhead.
+   */
+  static bool node_supports_output_cache(const bNode &node)
+  {
+    switch (node.typeinfo->type) {
+      case GEO_NODE_CONVEX_HULL:
+      case GEO_NODE_DISTRIBUTE_POINTS_ON_FACES:
+      case GEO_NODE_MESH_BOOLEAN:
+      case GEO_NODE_SUBDIVISION_SURFACE:
+        return true;
+      default:
+        return false;
+    }
+  }
+
   static const Object *get_self_object(const GeoNodesLFUserData &user_data)
   {
     if (user_data.call_data->modifier_data) {
@@ -317,16 +355,36 @@ class LazyFunctionForGeometryNode : public LazyFunction {
       return;
     }
 
-    GeoNodeExecParams geo_params{
-        node_,
-        params,
-        context,
-        own_lf_graph_info_.mapping.lf_input_index_for_output_bsocket_usage,
-        own_lf_graph_info_.mapping.lf_input_index_for_attribute_propagation_to_output,
-        get_output_attribute_id};
+    NodeOutputCache *output_cache = nullptr;
+    if (use_output_cache_ && user_data->call_data->modifier_data) {
+      output_cache = user_data->call_data->modifier_data->node_output_cache;
+    }
+    const NodeOutputCache::Key output_cache_key{user_data->compute_context->hash(),
+                                                node_.identifier};
+    if (output_cache != nullptr) {
+      if (this->try_load_outputs_from_cache(*output_cache, output_cache_key, params)) {
+        return;
+      }
+    }
+
+    auto execute_node = [&](lf::Params &exec_params) {
+      GeoNodeExecParams geo_params{
+          node_,
+          exec_params,
+          context,
+          own_lf_graph_info_.mapping.lf_input_index_for_output_bsocket_usage,
+          own_lf_graph_info_.mapping.lf_input_index_for_attribute_propagation_to_output,
+          get_output_attribute_id};
+      node_.typeinfo->geometry_node_execute(geo_params);
+    };
 
     geo_eval_log::TimePoint start_time = geo_eval_log::Clock::now();
-    node_.typeinfo->geometry_node_execute(geo_params);
+    if (output_cache != nullptr) {
+      this->execute_and_cache_outputs(*output_cache, output_cache_key, params, execute_node);
+    }
+    else {
+      execute_node(params);
+    }
     geo_eval_log::TimePoint end_time = geo_eval_log::Clock::now();
 
     if (geo_eval_log::GeoTreeLogger *tree_logger = local_user_data.try_get_tree_logger(*user_data))
@@ -336,6 +394,89 @@ class LazyFunctionForGeometryNode : public LazyFunction {
     }
   }
 
+  bool try_load_outputs_from_cache(NodeOutputCache &cache,
+                                   const NodeOutputCache::Key &key,
+                                   lf::Params &params) const
+  {
+    Array<GPointer> inputs(inputs_.size());
+    for (const int i : inputs_.index_range()) {
+      inputs[i] = {inputs_[i].type, params.try_get_input_data_ptr(i)};
+    }
+    /* Only load outputs that are used and have not been set already. */
+    Array<void *> outputs(outputs_.size(), nullptr);
+    for (const int i : outputs_.index_range()) {
+      if (params.get_output_usage(i) != lf::ValueUsage::Unused && !params.output_was_set(i)) {
+        outputs[i] = params.get_output_data_ptr(i);
+      }
+    }
+    if (!cache.try_load(key, output_cache_version_, inputs, outputs)) {
+      return false;
+    }
+    for (const int i : outputs_.index_range()) {
+      if (outputs[i] != nullptr) {
+        params.output_set(i);
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Execute the node with separate output buffers, so that the computed outputs can be added to
+   * the cache before they are passed on.
+   */
+  void execute_and_cache_outputs(NodeOutputCache &cache,
+                                 const NodeOutputCache::Key &key,
+                                 lf::Params &params,
+                                 const FunctionRef<void(lf::Params &)> execute_fn) const
+  {
+    Array<GMutablePointer> inputs(inputs_.size());
+    Array<std::optional<lf::ValueUsage>> input_usages(inputs_.size());
+    for (const int i : inputs_.index_range()) {
+      inputs[i] = {inputs_[i].type, params.try_get_input_data_ptr(i)};
+    }
+    /* Copy the inputs before the node is executed, because it moves them out of the
+     * parameters. */
+    std::optional<NodeOutputCache::InputValues> cached_inputs = cache.snapshot_inputs(
+        output_cache_version_, Array<GPointer>(inputs.as_span()));
+    if (!cached_inputs) {
+      execute_fn(params);
+      return;
+    }
+
+    LinearAllocator<> allocator;
+    Array<GMutablePointer> outputs(outputs_.size());
+    Array<lf::ValueUsage> output_usages(outputs_.size());
+    Array<bool> set_outputs(outputs_.size());
+    for (const int i : outputs_.index_range()) {
+      const CPPType &type = *outputs_[i].type;
+      outputs[i] = {type, allocator.allocate(type.size(), type.alignment())};
+      output_usages[i] = params.get_output_usage(i);
+      /* Outputs for anonymous attributes are set before the node is executed. */
+      set_outputs[i] = params.output_was_set(i);
+    }
+
+    lf::BasicParams exec_params{*this, inputs, outputs, input_usages, output_usages, set_outputs};
+    execute_fn(exec_params);
+
+    Array<GPointer> computed_outputs(outputs_.size());
+    for (const int i : outputs_.index_range()) {
+      if (set_outputs[i] && !params.output_was_set(i)) {
+        computed_outputs[i] = outputs[i];
+      }
+    }
+    cache.store(key, std::move(*cached_inputs), computed_outputs);
+
+    for (const int i : outputs_.index_range()) {
+      if (computed_outputs[i].get() == nullptr) {
+        continue;
+      }
+      const CPPType &type = *outputs_[i].type;
+      type.move_construct(outputs[i].get(), params.get_output_data_ptr(i));
+      type.destruct(outputs[i].get());
+      params.output_set(i);
+    }
+  }
+
   /**
    * Output the given anonymous attribute id as a field.
    */
@@ -2056,11 +2197,20 @@ class LazyFunctionForRepeatZone : public LazyFunction {
 class GeometryNodesLazyFunctionLogger : public lf::GraphExecutor::Logger {
  private:
   const GeometryNodesLazyFunctionGraphInfo &lf_graph_info_;
+  /** Node that every lazy-function node was created for, indexed by #lf::Node::index_in_graph. */
+  Array<const bNode *> bnode_by_lf_node_;
 
  public:
-  GeometryNodesLazyFunctionLogger(const GeometryNodesLazyFunctionGraphInfo &lf_graph_info)
-      : lf_graph_info_(lf_graph_info)
+  GeometryNodesLazyFunctionLogger(const GeometryNodesLazyFunctionGraphInfo &lf_graph_info,
+                                  const lf::Graph &lf_graph)
+      : lf_graph_info_(lf_graph_info), bnode_by_lf_node_(lf_graph.nodes().size(), nullptr)
   {
+    for (const lf::Node *lf_node : lf_graph.nodes()) {
+      if (lf_node->is_function()) {
+        bnode_by_lf_node_[lf_node->index_in_graph()] = this->find_bnode_in_mapping(
+            static_cast<const lf::FunctionNode &>(*lf_node));
+      }
+    }
   }
 
   void log_socket_value(const lf::Socket &lf_socket,
@@ -2139,6 +2289,30 @@ class GeometryNodesLazyFunctionLogger : public lf::GraphExecutor::Logger {
     }
   }
 
+  bool is_node_overhead_logged(const lf::Context &context) const override
+  {
+    const auto &user_data = *static_cast<GeoNodesLFUserData *>(context.user_data);
+    const auto &local_user_data = *static_cast<GeoNodesLFLocalUserData *>(context.local_user_data);
+    return local_user_data.try_get_tree_logger(user_data) != nullptr;
+  }
+
+  void log_node_overhead(const lf::FunctionNode &node,
+                         const std::chrono::nanoseconds overhead,
+                         const lf::Context &context) const override
+  {
+    const auto &user_data = *static_cast<GeoNodesLFUserData *>(context.user_data);
+    const auto &local_user_data = *static_cast<GeoNodesLFLocalUserData *>(context.local_user_data);
+    geo_eval_log::GeoTreeLogger *tree_logger = local_user_data.try_get_tree_logger(user_data);
+    if (tree_logger == nullptr) {
+      return;
+    }
+    const bNode *bnode = this->find_bnode(node);
+    if (bnode == nullptr) {
+      return;
+    }
+    tree_logger->node_overheads.append(*tree_logger->allocator, {bnode->identifier, overhead});
+  }
+
   void add_thread_id_debug_message(const lf::FunctionNode &node, const lf::Context &context) const
   {
     static std::atomic<int> thread_id_source = 0;
@@ -2151,27 +2325,37 @@ class GeometryNodesLazyFunctionLogger : public lf::GraphExecutor::Logger {
     if (tree_logger == nullptr) {
       return;
     }
+    const bNode *bnode = this->find_bnode(node);
+    if (bnode == nullptr) {
+      return;
+    }
+    tree_logger->debug_messages.append(*tree_logger->allocator,
+                                       {bnode->identifier, thread_id_str});
+  }
+
+  const bNode *find_bnode(const lf::FunctionNode &node) const
+  {
+    return bnode_by_lf_node_[node.index_in_graph()];
+  }
 
-    /* Find corresponding node based on the socket mapping. */
-    auto check_sockets = [&](const Span<const lf::Socket *> lf_sockets) {
+  /** Find corresponding node based on the socket mapping. */
+  const bNode *find_bnode_in_mapping(const lf::FunctionNode &node) const
+  {
+    auto check_sockets = [&](const Span<const lf::Socket *> lf_sockets) -> const bNode * {
       for (const lf::Socket *lf_socket : lf_sockets) {
         const Span<const bNodeSocket *> bsockets =
             lf_graph_info_.mapping.bsockets_by_lf_socket_map.lookup(lf_socket);
         if (!bsockets.is_empty()) {
-          const bNodeSocket &bsocket = *bsockets[0];
-          const bNode &bnode = bsocket.owner_node();
-          tree_logger->debug_messages.append(*tree_logger->allocator,
-                                             {bnode.identifier, thread_id_str});
-          return true;
+          return &bsockets[0]->owner_node();
         }
       }
-      return false;
+      return nullptr;
     };
 
-    if (check_sockets(node.inputs().cast<const lf::Socket *>())) {
-      return;
+    if (const bNode *bnode = check_sockets(node.inputs().cast<const lf::Socket *>())) {
+      return bnode;
     }
-    check_sockets(node.outputs().cast<const lf::Socket *>());
+    return check_sockets(node.outputs().cast<const lf::Socket *>());
   }
 };
 
@@ -2454,7 +2638,8 @@ struct GeometryNodesLazyFunctionBuilder {
 
     lf_graph.update_node_indices();
 
-    auto &logger = scope_.construct<GeometryNodesLazyFunctionLogger>(*lf_graph_info_);
+    auto &logger = scope_.construct<GeometryNodesLazyFunctionLogger>(*lf_graph_info_,
+                                                                    lf_graph);
     auto &side_effect_provider = scope_.construct<GeometryNodesLazyFunctionSideEffectProvider>();
 
     const auto &lf_graph_fn = scope_.construct<lf::GraphExecutor>(lf_graph,
@@ -2582,7 +2767,8 @@ struct GeometryNodesLazyFunctionBuilder {
 
     lf_body_graph.update_node_indices();
 
-    auto &logger = scope_.construct<GeometryNodesLazyFunctionLogger>(*lf_graph_info_);
+    auto &logger = scope_.construct<GeometryNodesLazyFunctionLogger>(*lf_graph_info_,
+                                                                    lf_body_graph);
     auto &side_effect_provider = scope_.construct<GeometryNodesLazyFunctionSideEffectProvider>();
 
     body_fn.function = &scope_.construct<lf::GraphExecutor>(lf_body_graph,
@@ -2794,7 +2980,7 @@ struct GeometryNodesLazyFunctionBuilder {
         lf_graph_info_->graph,
         std::move(lf_graph_inputs),
         std::move(lf_graph_outputs),
-        &scope_.construct<GeometryNodesLazyFunctionLogger>(*lf_graph_info_),
+        &scope_.construct<GeometryNodesLazyFunctionLogger>(*lf_graph_info_, lf_graph_info_->graph),
         &scope_.construct<GeometryNodesLazyFunctionSideEffectProvider>(),
         nullptr);
   }
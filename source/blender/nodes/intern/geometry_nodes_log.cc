@@ -303,6 +303,10 @@ void GeoTreeLog::ensure_node_run_time()
       this->nodes.lookup_or_add_default_as(timings.node_id).run_time += duration;
       this->run_time_sum += duration;
     }
+    for (const GeoTreeLogger::NodeOverhead &overhead : tree_logger->node_overheads) {
+      this->nodes.lookup_or_add_default_as(overhead.node_id).overhead += overhead.duration;
+      this->overhead_sum += overhead.duration;
+    }
   }
   for (const ComputeContextHash &child_hash : children_hashes_) {
     GeoTreeLog &child_log = modifier_log_->get_tree_log(child_hash);
@@ -312,9 +316,12 @@ void GeoTreeLog::ensure_node_run_time()
     child_log.ensure_node_run_time();
     const std::optional<int32_t> &parent_node_id = child_log.tree_loggers_[0]->parent_node_id;
     if (parent_node_id.has_value()) {
-      this->nodes.lookup_or_add_default(*parent_node_id).run_time += child_log.run_time_sum;
+      GeoNodeLog &parent_node_log = this->nodes.lookup_or_add_default(*parent_node_id);
+      parent_node_log.run_time += child_log.run_time_sum;
+      parent_node_log.overhead += child_log.overhead_sum;
     }
     this->run_time_sum += child_log.run_time_sum;
+    this->overhead_sum += child_log.overhead_sum;
   }
   reduced_node_run_times_ = true;
 }
@@ -0,0 +1,477 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include <variant>
+
+#include "NOD_geometry_nodes_output_cache.hh"
+
+#include "BLI_listbase.h"
+#include "BLI_math_matrix_types.hh"
+#include "BLI_string.h"
+
+#include "BKE_anonymous_attribute_id.hh"
+#include "BKE_customdata.hh"
+#include "BKE_geometry_set.hh"
+#include "BKE_instances.hh"
+#include "BKE_node_socket_value.hh"
+
+#include "DNA_curves_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_object_types.h"
+#include "DNA_pointcloud_types.h"
+
+namespace blender::nodes {
+
+using bke::AnonymousAttributeSet;
+using bke::GeometryComponent;
+using bke::GeometrySet;
+using bke::SocketValueVariant;
+
+/** An input or output value of a node that is kept in the cache. */
+using CachedValue = std::variant<std::monostate,
+                                 bool,
+                                 GeometrySet,
+                                 Vector<GeometrySet>,
+                                 SocketValueVariant,
+                                 AnonymousAttributeSet>;
+
+struct NodeOutputCache::Entry {
+  uint64_t version;
+  Vector<CachedValue> inputs;
+  /** Outputs that have not been computed are #std::monostate. */
+  Vector<CachedValue> outputs;
+  /** Approximate number of bytes kept alive by this entry. */
+  int64_t memory;
+  uint64_t last_used;
+};
+
+NodeOutputCache::NodeOutputCache() = default;
+NodeOutputCache::~NodeOutputCache() = default;
+
+/* -------------------------------------------------------------------- */
+/** \name Geometry Comparison
+ *
+ * Geometries are compared by the identity of their data arrays. This is only correct because the
+ * cache keeps a reference to the compared arrays, so they can't be freed or modified in place.
+ * \{ */
+
+static bool custom_data_equal(const CustomData &a, const CustomData &b)
+{
+  if (a.totlayer != b.totlayer) {
+    return false;
+  }
+  for (const int i : IndexRange(a.totlayer)) {
+    const CustomDataLayer &layer_a = a.layers[i];
+    const CustomDataLayer &layer_b = b.layers[i];
+    if (layer_a.type != layer_b.type || layer_a.data != layer_b.data ||
+        layer_a.sharing_info != layer_b.sharing_info || !STREQ(layer_a.name, layer_b.name))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool vertex_group_names_equal(const ListBase &a, const ListBase &b)
+{
+  const bDeformGroup *group_a = static_cast<const bDeformGroup *>(a.first);
+  const bDeformGroup *group_b = static_cast<const bDeformGroup *>(b.first);
+  for (; group_a && group_b; group_a = group_a->next, group_b = group_b->next) {
+    if (!STREQ(group_a->name, group_b->name)) {
+      return false;
+    }
+  }
+  return group_a == nullptr && group_b == nullptr;
+}
+
+static bool materials_equal(const Material *const *mat_a,
+                            const short totcol_a,
+                            const Material *const *mat_b,
+                            const short totcol_b)
+{
+  return Span(mat_a, totcol_a) == Span(mat_b, totcol_b);
+}
+
+static bool meshes_equal(const Mesh &a, const Mesh &b)
+{
+  return a.verts_num == b.verts_num && a.edges_num == b.edges_num && a.faces_num == b.faces_num &&
+         a.corners_num == b.corners_num && a.face_offset_indices == b.face_offset_indices &&
+         custom_data_equal(a.vert_data, b.vert_data) &&
+         custom_data_equal(a.edge_data, b.edge_data) &&
+         custom_data_equal(a.face_data, b.face_data) &&
+         custom_data_equal(a.corner_data, b.corner_data) &&
+         vertex_group_names_equal(a.vertex_group_names, b.vertex_group_names) &&
+         materials_equal(a.mat, a.totcol, b.mat, b.totcol);
+}
+
+static bool pointclouds_equal(const PointCloud &a, const PointCloud &b)
+{
+  return a.totpoint == b.totpoint && custom_data_equal(a.pdata, b.pdata) &&
+         materials_equal(a.mat, a.totcol, b.mat, b.totcol);
+}
+
+static bool curves_equal(const Curves &a, const Curves &b)
+{
+  const ::CurvesGeometry &geometry_a = a.geometry;
+  const ::CurvesGeometry &geometry_b = b.geometry;
+  return geometry_a.point_num == geometry_b.point_num &&
+         geometry_a.curve_num == geometry_b.curve_num &&
+         geometry_a.curve_offsets == geometry_b.curve_offsets &&
+         custom_data_equal(geometry_a.point_data, geometry_b.point_data) &&
+         custom_data_equal(geometry_a.curve_data, geometry_b.curve_data) &&
+         vertex_group_names_equal(geometry_a.vertex_group_names,
+                                  geometry_b.vertex_group_names) &&
+         materials_equal(a.mat, a.totcol, b.mat, b.totcol);
+}
+
+template<typename T>
+static bool ids_equal(const T *a, const T *b, bool (*fn)(const T &a, const T &b))
+{
+  if (a == b) {
+    return true;
+  }
+  if (a == nullptr || b == nullptr) {
+    return false;
+  }
+  return fn(*a, *b);
+}
+
+static bool geometries_equal(const GeometrySet &a, const GeometrySet &b)
+{
+  if (a.name != b.name) {
+    return false;
+  }
+  const Vector<const GeometryComponent *> components_a = a.get_components();
+  if (components_a.size() != b.get_components().size()) {
+    return false;
+  }
+  for (const GeometryComponent *component_a : components_a) {
+    const GeometryComponent::Type type = component_a->type();
+    const GeometryComponent *component_b = b.get_component(type);
+    if (component_b == nullptr) {
+      return false;
+    }
+    if (component_a == component_b) {
+      continue;
+    }
+    switch (type) {
+      case GeometryComponent::Type::Mesh:
+        if (!ids_equal(a.get_mesh(), b.get_mesh(), meshes_equal)) {
+          return false;
+        }
+        break;
+      case GeometryComponent::Type::PointCloud:
+        if (!ids_equal(a.get_pointcloud(), b.get_pointcloud(), pointclouds_equal)) {
+          return false;
+        }
+        break;
+      case GeometryComponent::Type::Curve:
+        if (!ids_equal(a.get_curves(), b.get_curves(), curves_equal)) {
+          return false;
+        }
+        break;
+      default:
+        /* Other components are only equal when they are shared. */
+        return false;
+    }
+  }
+  return true;
+}
+
+static int64_t custom_data_memory(const CustomData &data, const int elements_num)
+{
+  int64_t memory = 0;
+  for (const CustomDataLayer &layer : Span(data.layers, data.totlayer)) {
+    if (layer.data != nullptr) {
+      memory += int64_t(CustomData_sizeof(eCustomDataType(layer.type))) * elements_num;
+    }
+  }
+  return memory;
+}
+
+static int64_t geometry_memory(const GeometrySet &geometry)
+{
+  int64_t memory = 0;
+  if (const Mesh *mesh = geometry.get_mesh()) {
+    memory += custom_data_memory(mesh->vert_data, mesh->verts_num);
+    memory += custom_data_memory(mesh->edge_data, mesh->edges_num);
+    memory += custom_data_memory(mesh->face_data, mesh->faces_num);
+    memory += custom_data_memory(mesh->corner_data, mesh->corners_num);
+    memory += int64_t(mesh->faces_num + 1) * sizeof(int);
+  }
+  if (const PointCloud *pointcloud = geometry.get_pointcloud()) {
+    memory += custom_data_memory(pointcloud->pdata, pointcloud->totpoint);
+  }
+  if (const Curves *curves = geometry.get_curves()) {
+    const ::CurvesGeometry &curves_geometry = curves->geometry;
+    memory += custom_data_memory(curves_geometry.point_data, curves_geometry.point_num);
+    memory += custom_data_memory(curves_geometry.curve_data, curves_geometry.curve_num);
+    memory += int64_t(curves_geometry.curve_num + 1) * sizeof(int);
+  }
+  if (const bke::Instances *instances = geometry.get_instances()) {
+    memory += int64_t(instances->instances_num()) * (sizeof(float4x4) + sizeof(int));
+  }
+  return memory;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Cached Values
+ * \{ */
+
+static bool is_single_value(const SocketValueVariant &value)
+{
+  return !value.is_context_dependent_field() && !value.is_volume_grid();
+}
+
+/**
+ * Make a copy of the value that can be kept in the cache, or none if the value can't be compared
+ * cheaply later on.
+ */
+static std::optional<CachedValue> value_for_cache(const GPointer value)
+{
+  const CPPType &type = *value.type();
+  if (type.is<bool>()) {
+    return *value.get<bool>();
+  }
+  if (type.is<GeometrySet>()) {
+    GeometrySet geometry = *value.get<GeometrySet>();
+    geometry.ensure_owns_direct_data();
+    return geometry;
+  }
+  if (type.is<Vector<GeometrySet>>()) {
+    Vector<GeometrySet> geometries = *value.get<Vector<GeometrySet>>();
+    for (GeometrySet &geometry : geometries) {
+      geometry.ensure_owns_direct_data();
+    }
+    return geometries;
+  }
+  if (type.is<SocketValueVariant>()) {
+    const SocketValueVariant &value_variant = *value.get<SocketValueVariant>();
+    if (!is_single_value(value_variant)) {
+      return std::nullopt;
+    }
+    SocketValueVariant single_value = value_variant;
+    single_value.convert_to_single();
+    return single_value;
+  }
+  if (type.is<AnonymousAttributeSet>()) {
+    return *value.get<AnonymousAttributeSet>();
+  }
+  return std::nullopt;
+}
+
+static bool attribute_sets_equal(const AnonymousAttributeSet &a, const AnonymousAttributeSet &b)
+{
+  if (a.names == b.names) {
+    return true;
+  }
+  if (!a.names || !b.names) {
+    return false;
+  }
+  return *a.names == *b.names;
+}
+
+static bool value_equals(const CachedValue &cached_value, const GPointer value)
+{
+  if (const bool *cached_bool = std::get_if<bool>(&cached_value)) {
+    return *cached_bool == *value.get<bool>();
+  }
+  if (const GeometrySet *geometry = std::get_if<GeometrySet>(&cached_value)) {
+    return geometries_equal(*geometry, *value.get<GeometrySet>());
+  }
+  if (const Vector<GeometrySet> *geometries = std::get_if<Vector<GeometrySet>>(&cached_value)) {
+    const Vector<GeometrySet> &other_geometries = *value.get<Vector<GeometrySet>>();
+    if (geometries->size() != other_geometries.size()) {
+      return false;
+    }
+    for (const int i : geometries->index_range()) {
+      if (!geometries_equal((*geometries)[i], other_geometries[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (const SocketValueVariant *value_variant = std::get_if<SocketValueVariant>(&cached_value)) {
+    const SocketValueVariant &other_value_variant = *value.get<SocketValueVariant>();
+    if (!is_single_value(other_value_variant)) {
+      return false;
+    }
+    SocketValueVariant other_single_value = other_value_variant;
+    other_single_value.convert_to_single();
+    const GPointer single_a = value_variant->get_single_ptr();
+    const GPointer single_b = std::as_const(other_single_value).get_single_ptr();
+    return single_a.type() == single_b.type() &&
+           single_a.type()->is_equal_or_false(single_a.get(), single_b.get());
+  }
+  if (const AnonymousAttributeSet *set = std::get_if<AnonymousAttributeSet>(&cached_value)) {
+    return attribute_sets_equal(*set, *value.get<AnonymousAttributeSet>());
+  }
+  return false;
+}
+
+static int64_t value_memory(const CachedValue &value)
+{
+  if (const GeometrySet *geometry = std::get_if<GeometrySet>(&value)) {
+    return geometry_memory(*geometry);
+  }
+  if (const Vector<GeometrySet> *geometries = std::get_if<Vector<GeometrySet>>(&value)) {
+    int64_t memory = 0;
+    for (const GeometrySet &geometry : *geometries) {
+      memory += geometry_memory(geometry);
+    }
+    return memory;
+  }
+  return 0;
+}
+
+/** \} */
+
+bool NodeOutputCache::is_supported_type(const CPPType &type)
+{
+  return type.is_any<bool,
+                     GeometrySet,
+                     Vector<GeometrySet>,
+                     SocketValueVariant,
+                     AnonymousAttributeSet>();
+}
+
+void NodeOutputCache::set_memory_limit(const int64_t limit)
+{
+  std::lock_guard lock{mutex_};
+  memory_limit_ = limit;
+  this->free_until_below_limit(limit);
+}
+
+void NodeOutputCache::clear()
+{
+  std::lock_guard lock{mutex_};
+  entries_.clear();
+  memory_ = 0;
+}
+
+bool NodeOutputCache::try_load(const Key &key,
+                               const uint64_t version,
+                               const Span<GPointer> inputs,
+                               const Span<void *> r_outputs)
+{
+  std::lock_guard lock{mutex_};
+  const std::unique_ptr<Entry> *entry_ptr = entries_.lookup_ptr(key);
+  if (entry_ptr == nullptr) {
+    return false;
+  }
+  Entry &entry = **entry_ptr;
+  if (entry.version != version) {
+    return false;
+  }
+  BLI_assert(entry.inputs.size() == inputs.size());
+  BLI_assert(entry.outputs.size() == r_outputs.size());
+  for (const int i : inputs.index_range()) {
+    if (!value_equals(entry.inputs[i], inputs[i])) {
+      return false;
+    }
+  }
+  for (const int i : r_outputs.index_range()) {
+    if (r_outputs[i] != nullptr && std::holds_alternative<std::monostate>(entry.outputs[i])) {
+      /* The output is needed now, but was not computed before. */
+      return false;
+    }
+  }
+  for (const int i : r_outputs.index_range()) {
+    if (r_outputs[i] == nullptr) {
+      continue;
+    }
+    std::visit(
+        [&](const auto &value) {
+          using T = std::decay_t<decltype(value)>;
+          if constexpr (!std::is_same_v<T, std::monostate>) {
+            new (r_outputs[i]) T(value);
+          }
+        },
+        entry.outputs[i]);
+  }
+  entry.last_used = ++clock_;
+  return true;
+}
+
+NodeOutputCache::InputValues::InputValues(std::unique_ptr<Entry> entry) : entry_(std::move(entry))
+{
+}
+
+NodeOutputCache::InputValues::InputValues(InputValues &&other) = default;
+
+NodeOutputCache::InputValues::~InputValues() = default;
+
+std::optional<NodeOutputCache::InputValues> NodeOutputCache::snapshot_inputs(
+    const uint64_t version, const Span<GPointer> inputs)
+{
+  {
+    std::lock_guard lock{mutex_};
+    if (memory_limit_ <= 0) {
+      return std::nullopt;
+    }
+  }
+
+  /* Copy the values without locking, because that may have to copy some data. */
+  auto entry = std::make_unique<Entry>();
+  entry->version = version;
+  entry->memory = 0;
+  for (const GPointer input : inputs) {
+    std::optional<CachedValue> value = value_for_cache(input);
+    if (!value) {
+      return std::nullopt;
+    }
+    entry->memory += value_memory(*value);
+    entry->inputs.append(std::move(*value));
+  }
+  return InputValues(std::move(entry));
+}
+
+void NodeOutputCache::store(const Key &key, InputValues inputs, const Span<GPointer> outputs)
+{
+  std::unique_ptr<Entry> entry = std::move(inputs.entry_);
+  BLI_assert(entry->outputs.is_empty());
+  for (const GPointer output : outputs) {
+    if (output.get() == nullptr) {
+      entry->outputs.append(std::monostate());
+      continue;
+    }
+    std::optional<CachedValue> value = value_for_cache(output);
+    if (!value) {
+      return;
+    }
+    entry->memory += value_memory(*value);
+    entry->outputs.append(std::move(*value));
+  }
+
+  std::lock_guard lock{mutex_};
+  if (entry->memory > memory_limit_) {
+    return;
+  }
+  if (const std::unique_ptr<Entry> *old_entry = entries_.lookup_ptr(key)) {
+    memory_ -= (*old_entry)->memory;
+  }
+  entry->last_used = ++clock_;
+  memory_ += entry->memory;
+  entries_.add_overwrite(key, std::move(entry));
+  this->free_until_below_limit(memory_limit_);
+}
+
+void NodeOutputCache::free_until_below_limit(const int64_t limit)
+{
+  while (memory_ > limit && !entries_.is_empty()) {
+    Key least_recently_used{};
+    uint64_t least_recent_use = UINT64_MAX;
+    for (const auto item : entries_.items()) {
+      if (item.value->last_used < least_recent_use) {
+        least_recent_use = item.value->last_used;
+        least_recently_used = item.key;
+      }
+    }
+    memory_ -= entries_.pop(least_recently_used)->memory;
+  }
+}
+
+}  // namespace blender::nodes
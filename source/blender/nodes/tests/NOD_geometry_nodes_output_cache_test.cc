@@ -0,0 +1,180 @@
+/* SPDX-FileCopyrightText: 2024 Blender Authors
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later */
+
+#include "testing/testing.h"
+
+#include "BLI_memory_utils.hh"
+
+#include "BKE_geometry_set.hh"
+#include "BKE_idtype.hh"
+#include "BKE_node_socket_value.hh"
+#include "BKE_pointcloud.hh"
+
+#include "NOD_geometry_nodes_output_cache.hh"
+
+namespace blender::nodes::tests {
+
+using bke::GeometrySet;
+using bke::SocketValueVariant;
+
+class NodeOutputCacheTest : public ::testing::Test {
+ public:
+  static void SetUpTestSuite()
+  {
+    BKE_idtype_init();
+  }
+};
+
+static NodeOutputCache::Key test_key(const int32_t node_id)
+{
+  return {ComputeContextHash{}, node_id};
+}
+
+/** A geometry with the given number of points, each point uses 12 bytes for its position. */
+static GeometrySet test_points(const int points_num)
+{
+  return GeometrySet::from_pointcloud(BKE_pointcloud_new_nomain(points_num));
+}
+
+/** Execute a fake node that outputs its input geometry and the given value plus one. */
+static void execute_and_store(NodeOutputCache &cache,
+                              const NodeOutputCache::Key &key,
+                              const uint64_t version,
+                              GeometrySet &geometry_input,
+                              SocketValueVariant &value_input)
+{
+  std::optional<NodeOutputCache::InputValues> inputs = cache.snapshot_inputs(
+      version, {GPointer(&geometry_input), GPointer(&value_input)});
+  ASSERT_TRUE(inputs.has_value());
+
+  /* Nodes generally move their inputs, the cache has to keep the values from before. */
+  GeometrySet geometry_output = std::move(geometry_input);
+  SocketValueVariant value_output(value_input.get<int>() + 1);
+  value_input = SocketValueVariant(-1);
+
+  cache.store(key, std::move(*inputs), {GPointer(&geometry_output), GPointer(&value_output)});
+}
+
+static bool try_load(NodeOutputCache &cache,
+                     const NodeOutputCache::Key &key,
+                     const uint64_t version,
+                     const GeometrySet &geometry_input,
+                     const SocketValueVariant &value_input,
+                     GeometrySet *r_geometry_output = nullptr,
+                     int *r_value_output = nullptr)
+{
+  /* The outputs are constructed in uninitialized memory by the cache. */
+  TypedBuffer<GeometrySet> geometry_output;
+  TypedBuffer<SocketValueVariant> value_output;
+  if (!cache.try_load(key,
+                      version,
+                      {GPointer(&geometry_input), GPointer(&value_input)},
+                      {geometry_output.ptr(), value_output.ptr()}))
+  {
+    return false;
+  }
+  if (r_geometry_output) {
+    *r_geometry_output = *geometry_output;
+  }
+  if (r_value_output) {
+    *r_value_output = (*value_output).get<int>();
+  }
+  std::destroy_at(geometry_output.ptr());
+  std::destroy_at(value_output.ptr());
+  return true;
+}
+
+TEST_F(NodeOutputCacheTest, Hit)
+{
+  NodeOutputCache cache;
+  cache.set_memory_limit(1024 * 1024);
+
+  const GeometrySet geometry = test_points(10);
+  GeometrySet geometry_input = geometry;
+  SocketValueVariant value_input(3);
+  execute_and_store(cache, test_key(1), 1, geometry_input, value_input);
+
+  GeometrySet geometry_output;
+  int value_output = 0;
+  EXPECT_TRUE(try_load(
+      cache, test_key(1), 1, geometry, SocketValueVariant(3), &geometry_output, &value_output));
+  EXPECT_EQ(value_output, 4);
+  EXPECT_EQ(geometry_output.get_pointcloud(), geometry.get_pointcloud());
+}
+
+TEST_F(NodeOutputCacheTest, MissAfterInputChange)
+{
+  NodeOutputCache cache;
+  cache.set_memory_limit(1024 * 1024);
+
+  const GeometrySet geometry = test_points(10);
+  GeometrySet geometry_input = geometry;
+  SocketValueVariant value_input(3);
+  execute_and_store(cache, test_key(1), 1, geometry_input, value_input);
+
+  EXPECT_FALSE(try_load(cache, test_key(1), 1, geometry, SocketValueVariant(5)));
+  EXPECT_FALSE(try_load(cache, test_key(1), 1, test_points(10), SocketValueVariant(3)));
+  EXPECT_FALSE(try_load(cache, test_key(2), 1, geometry, SocketValueVariant(3)));
+  EXPECT_TRUE(try_load(cache, test_key(1), 1, geometry, SocketValueVariant(3)));
+}
+
+TEST_F(NodeOutputCacheTest, VersionInvalidation)
+{
+  NodeOutputCache cache;
+  cache.set_memory_limit(1024 * 1024);
+
+  const GeometrySet geometry = test_points(10);
+  GeometrySet geometry_input = geometry;
+  SocketValueVariant value_input(3);
+  execute_and_store(cache, test_key(1), 1, geometry_input, value_input);
+
+  /* The node tree changed, so the node has a new version. */
+  EXPECT_FALSE(try_load(cache, test_key(1), 2, geometry, SocketValueVariant(3)));
+
+  geometry_input = geometry;
+  value_input = SocketValueVariant(3);
+  execute_and_store(cache, test_key(1), 2, geometry_input, value_input);
+  EXPECT_TRUE(try_load(cache, test_key(1), 2, geometry, SocketValueVariant(3)));
+  EXPECT_FALSE(try_load(cache, test_key(1), 1, geometry, SocketValueVariant(3)));
+}
+
+TEST_F(NodeOutputCacheTest, LimitEviction)
+{
+  NodeOutputCache cache;
+  /* Each entry uses 2 * 100 * 12 bytes, for the input and the output geometry. */
+  cache.set_memory_limit(4000);
+
+  const GeometrySet geometry_a = test_points(100);
+  const GeometrySet geometry_b = test_points(100);
+  GeometrySet geometry_input = geometry_a;
+  SocketValueVariant value_input(0);
+  execute_and_store(cache, test_key(1), 1, geometry_input, value_input);
+  EXPECT_TRUE(try_load(cache, test_key(1), 1, geometry_a, SocketValueVariant(0)));
+
+  /* Storing another entry frees the least recently used one. */
+  geometry_input = geometry_b;
+  value_input = SocketValueVariant(0);
+  execute_and_store(cache, test_key(2), 1, geometry_input, value_input);
+  EXPECT_FALSE(try_load(cache, test_key(1), 1, geometry_a, SocketValueVariant(0)));
+  EXPECT_TRUE(try_load(cache, test_key(2), 1, geometry_b, SocketValueVariant(0)));
+
+  /* Entries larger than the limit are not stored at all. */
+  GeometrySet large_input = test_points(1000);
+  value_input = SocketValueVariant(0);
+  std::optional<NodeOutputCache::InputValues> inputs = cache.snapshot_inputs(
+      1, {GPointer(&large_input), GPointer(&value_input)});
+  ASSERT_TRUE(inputs.has_value());
+  SocketValueVariant value_output(1);
+  cache.store(test_key(3), std::move(*inputs), {GPointer(&large_input), GPointer(&value_output)});
+  EXPECT_FALSE(try_load(cache, test_key(3), 1, large_input, SocketValueVariant(0)));
+  EXPECT_TRUE(try_load(cache, test_key(2), 1, geometry_b, SocketValueVariant(0)));
+
+  /* Lowering the limit frees entries right away, a limit of zero disables the cache. */
+  cache.set_memory_limit(0);
+  EXPECT_FALSE(try_load(cache, test_key(2), 1, geometry_b, SocketValueVariant(0)));
+  EXPECT_FALSE(
+      cache.snapshot_inputs(1, {GPointer(&geometry_b), GPointer(&value_input)}).has_value());
+}
+
+}  // namespace blender::nodes::tests
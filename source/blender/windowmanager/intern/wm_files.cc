@@ -39,6 +39,7 @@
 #include "BLI_linklist.h"
 #include "BLI_math_time.h"
 #include "BLI_system.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_time.h"
 #include "BLI_timer.h"
@@ -2178,18 +2179,57 @@ bool WM_autosave_is_scheduled(wmWindowManager *wm)
   return wm->autosave_scheduled;
 }
 
+/**
+ * Writes the serialized auto-save file to disk in the background,
+ * so saving doesn't block the interface on slow drives or with large files.
+ */
+static TaskPool *wm_autosave_task_pool = nullptr;
+
+static void wm_autosave_write_task(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  const BlendFileWriteBuffer *buffer = static_cast<const BlendFileWriteBuffer *>(taskdata);
+  /* Error reporting into console. */
+  BLO_write_file_buffer_flush(buffer, nullptr);
+}
+
+static void wm_autosave_write_task_free(TaskPool *__restrict /*pool*/, void *taskdata)
+{
+  BLO_write_file_buffer_free(static_cast<BlendFileWriteBuffer *>(taskdata));
+}
+
+void wm_autosave_write_wait()
+{
+  if (wm_autosave_task_pool == nullptr) {
+    return;
+  }
+  BLI_task_pool_work_and_wait(wm_autosave_task_pool);
+  BLI_task_pool_free(wm_autosave_task_pool);
+  wm_autosave_task_pool = nullptr;
+}
+
 void WM_autosave_write(wmWindowManager *wm, Main *bmain)
 {
   ED_editors_flush_edits(bmain);
 
+  /* The previous auto-save may still be writing, auto-save intervals are long enough for this to
+   * be rare. */
+  wm_autosave_write_wait();
+
   char filepath[FILE_MAX];
   wm_autosave_location(filepath);
   /* Save as regular blend file with recovery information. */
   const int fileflags = (G.fileflags & ~G_FILE_COMPRESS) | G_FILE_RECOVER_WRITE;
 
-  /* Error reporting into console. */
+  /* Only serialize the file here, writing it to disk happens in the background.
+   * Error reporting into console. */
   BlendFileWriteParams params{};
-  BLO_write_file(bmain, filepath, fileflags, &params, nullptr);
+  if (BlendFileWriteBuffer *buffer = BLO_write_file_to_buffer(
+          bmain, filepath, fileflags, &params, nullptr))
+  {
+    wm_autosave_task_pool = BLI_task_pool_create_background(nullptr, TASK_PRIORITY_LOW);
+    BLI_task_pool_push(
+        wm_autosave_task_pool, wm_autosave_write_task, buffer, true, wm_autosave_write_task_free);
+  }
 
   /* Restart auto-save timer. */
   wm_autosave_timer_end(wm);
@@ -2253,6 +2293,8 @@ void wm_autosave_timer(Main *bmain, wmWindowManager *wm, wmTimer * /*wt*/)
 
 void wm_autosave_delete()
 {
+  wm_autosave_write_wait();
+
   char filepath[FILE_MAX];
 
   wm_autosave_location(filepath);
@@ -545,6 +545,9 @@ void WM_exit_ex(bContext *C, const bool do_python_exit, const bool do_user_exit_
    */
   BKE_blender_cli_command_free_all();
 
+  /* Finish writing the auto-save file while the task scheduler is still running. */
+  wm_autosave_write_wait();
+
   BLI_timer_free();
 
   WM_paneltype_clear();
@@ -89,6 +89,8 @@ void wm_autosave_timer(Main *bmain, wmWindowManager *wm, wmTimer *wt);
 void wm_autosave_timer_begin(wmWindowManager *wm);
 void wm_autosave_timer_end(wmWindowManager *wm);
 void wm_autosave_delete();
+/** Wait for an auto-save file that is being written in the background. */
+void wm_autosave_write_wait();
 
 /* `wm_splash_screen.cc` */
 
@@ -26,12 +26,13 @@ def set_view3d_context_override(context_override):
                 context_override["region"] = region
 
 
-def prepare_sculpt_scene(context):
+def prepare_sculpt_scene(context, enter_sculpt_mode=True):
     import bpy
     """
     Prepare a clean state of the scene suitable for benchmarking
 
-    It creates a high-res object and moves it to a sculpt mode.
+    It creates a high-res object and moves it to a sculpt mode, unless
+    `enter_sculpt_mode` is false.
     """
 
     # Ensure the current mode is object, as it might not be the always the case
@@ -67,8 +68,9 @@ def prepare_sculpt_scene(context):
     bpy.ops.object.modifier_apply(modifier="Test")
 
     bpy.ops.object.select_all(action='SELECT')
-    # Move the plane to the sculpt mode.
-    bpy.ops.object.mode_set(mode='SCULPT')
+    if enter_sculpt_mode:
+        # Move the plane to the sculpt mode.
+        bpy.ops.object.mode_set(mode='SCULPT')
 
 
 def generate_stroke(context):
@@ -131,6 +133,22 @@ def _run(args):
     return result
 
 
+def _run_enter_sculpt_mode(args):
+    import bpy
+    import time
+    context = bpy.context
+
+    prepare_sculpt_scene(context, enter_sculpt_mode=False)
+
+    # Entering sculpt mode is dominated by building the PBVH.
+    start = time.time()
+    bpy.ops.object.mode_set(mode='SCULPT')
+    end = time.time()
+
+    result = {'time': end - start}
+    return result
+
+
 class SculptBrushTest(api.Test):
     def __init__(self, filepath):
         self.filepath = filepath
@@ -149,6 +167,25 @@ class SculptBrushTest(api.Test):
         return result
 
 
+class SculptEnterModeTest(api.Test):
+    def __init__(self, filepath):
+        self.filepath = filepath
+
+    def name(self):
+        return self.filepath.stem + "_enter_mode"
+
+    def category(self):
+        return "sculpt"
+
+    def run(self, env, device_id):
+        args = {}
+
+        result, _ = env.run_in_blender(_run_enter_sculpt_mode, args, [self.filepath])
+
+        return result
+
+
 def generate(env):
     filepaths = env.find_blend_files('sculpt/*')
-    return [SculptBrushTest(filepath) for filepath in filepaths]
+    return ([SculptBrushTest(filepath) for filepath in filepaths] +
+            [SculptEnterModeTest(filepath) for filepath in filepaths])